@@ -0,0 +1,96 @@
+#ifndef __FUZZ_COMMON_HPP
+#define __FUZZ_COMMON_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+// Both libFuzzer and the replay driver report an abort as a failure
+static inline void fuzz_check(bool condition, const char* description) {
+	if(condition)
+		return;
+	fprintf(stderr, "Check failed: %s\n", description);
+	abort();
+}
+
+// Feeds the input to a ring of slices, like the USB transfers do.
+// The last slice is padded with zeroes, as only full slices are used.
+struct FuzzRingStream {
+	uint8_t* ring;
+	size_t slice_size;
+	size_t num_slices;
+	const uint8_t* data;
+	size_t size;
+	size_t data_pos;
+	// Absolute positions, in bytes since the start of the stream
+	size_t fed;
+};
+
+static inline void fuzz_ring_init(FuzzRingStream &stream, uint8_t* ring, size_t slice_size, size_t num_slices, const uint8_t* data, size_t size) {
+	stream.ring = ring;
+	stream.slice_size = slice_size;
+	stream.num_slices = num_slices;
+	stream.data = data;
+	stream.size = size;
+	stream.data_pos = 0;
+	stream.fed = 0;
+}
+
+// Slices before the one with read_pos have been given back already
+static inline bool fuzz_ring_feed(FuzzRingStream &stream, size_t read_pos) {
+	if(stream.data_pos >= stream.size)
+		return false;
+	size_t first_used_slice = read_pos / stream.slice_size;
+	if(((stream.fed / stream.slice_size) - first_used_slice) >= stream.num_slices)
+		return false;
+	uint8_t* slice = stream.ring + (((stream.fed / stream.slice_size) % stream.num_slices) * stream.slice_size);
+	size_t copy_size = stream.size - stream.data_pos;
+	if(copy_size > stream.slice_size)
+		copy_size = stream.slice_size;
+	memcpy(slice, stream.data + stream.data_pos, copy_size);
+	memset(slice + copy_size, 0, stream.slice_size - copy_size);
+	stream.data_pos += copy_size;
+	stream.fed += stream.slice_size;
+	return true;
+}
+
+static inline bool fuzz_ring_is_full(FuzzRingStream &stream, size_t read_pos) {
+	return ((stream.fed / stream.slice_size) - (read_pos / stream.slice_size)) >= stream.num_slices;
+}
+
+// A resynchronization must move forward. Finding the synch right where
+// the search started and then losing it again keep the read position
+// where it is, but the next search starts after it, so no more than two
+// steps in a row can do that. The number of steps is also limited by how
+// much data there is, so a loop which moves too slowly is caught too.
+struct FuzzProgressGuard {
+	size_t last_read_pos;
+	int steps_in_place;
+	uint64_t num_steps;
+	uint64_t max_steps;
+};
+
+static inline void fuzz_progress_init(FuzzProgressGuard &guard, size_t size) {
+	guard.last_read_pos = 0;
+	guard.steps_in_place = 0;
+	guard.num_steps = 0;
+	guard.max_steps = ((uint64_t)size) + 1024;
+}
+
+static inline void fuzz_progress_step(FuzzProgressGuard &guard, size_t read_pos) {
+	fuzz_check(read_pos >= guard.last_read_pos, "The read position went back");
+	if(read_pos == guard.last_read_pos)
+		guard.steps_in_place++;
+	else
+		guard.steps_in_place = 0;
+	guard.last_read_pos = read_pos;
+	fuzz_check(guard.steps_in_place <= 2, "Resynchronization did not move forward");
+	guard.num_steps++;
+	fuzz_check(guard.num_steps <= guard.max_steps, "Too many resynchronization steps");
+}
+
+#endif
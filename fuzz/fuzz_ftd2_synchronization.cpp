@@ -0,0 +1,59 @@
+#include "fuzz_common.hpp"
+#include "dscapture_ftd2_synchronization.hpp"
+#include "utils.hpp"
+
+#include <vector>
+
+// Reads the DS stream the same way the FTD2 driver loop does: read a
+// whole frame, and if the synch words are not at its end, only read
+// what is needed to move them there.
+// The first byte turns on the special check, the next two are the size
+// of a frame in words. The real frames are a lot bigger, but they are
+// handled the same way.
+
+#define FUZZ_FTD2_SPECIAL_CHECK 0x01
+#define FUZZ_FTD2_MAX_FRAME_WORDS 0x1000
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	if(size < 3)
+		return 0;
+	bool special_check = data[0] & FUZZ_FTD2_SPECIAL_CHECK;
+	size_t full_size = ((read_le16(data + 1) % FUZZ_FTD2_MAX_FRAME_WORDS) + 1) * 2;
+	const uint8_t* stream = data + 3;
+	size_t stream_size = size - 3;
+
+	// Exactly as big as needed, so reading past the end is caught
+	std::vector<uint32_t> buffers[2];
+	for(int i = 0; i < 2; i++)
+		buffers[i].resize((full_size + sizeof(uint32_t) - 1) / sizeof(uint32_t));
+	int curr_buffer = 0;
+	size_t next_size = full_size;
+	size_t stream_pos = 0;
+	uint64_t num_checks = 0;
+	while((stream_size - stream_pos) >= next_size) {
+		uint8_t* curr_data = (uint8_t*)buffers[curr_buffer].data();
+		memcpy(curr_data + (full_size - next_size), stream + stream_pos, next_size);
+		stream_pos += next_size;
+		int next_buffer = (curr_buffer + 1) % 2;
+		bool is_synced = synchronization_check((uint16_t*)curr_data, full_size, (uint16_t*)buffers[next_buffer].data(), &next_size, special_check);
+		// Reading nothing would never get anywhere
+		fuzz_check((next_size > 0) && (next_size <= full_size), "Bad size for the next read");
+		num_checks++;
+		fuzz_check(num_checks <= ((stream_size / 2) + 1), "Too many synchronization checks");
+		if(is_synced) {
+			size_t real_length = remove_synch_from_final_length(buffers[curr_buffer].data(), full_size);
+			fuzz_check(real_length <= full_size, "Final length bigger than the frame");
+		}
+		curr_buffer = next_buffer;
+	}
+
+	// The libusb side checks without a buffer to resynchronize into
+	if(stream_size >= 2) {
+		std::vector<uint16_t> single(stream_size / 2);
+		memcpy(single.data(), stream, single.size() * 2);
+		size_t offset = 0;
+		synchronization_check(single.data(), single.size() * 2, NULL, &offset, special_check);
+		fuzz_check(offset <= (single.size() * 2), "Synchronization offset past the end");
+	}
+	return 0;
+}
@@ -0,0 +1,44 @@
+#include "fuzz_common.hpp"
+#include "conversions_video_is_twl.hpp"
+#include "utils.hpp"
+
+// Unpacks an IS TWL frame and compares every pixel with one put together
+// straight from the little endian bytes, without the bitfields.
+
+static ISTWLCaptureVideoInputData input;
+static VideoOutputDataRGB output;
+
+static uint8_t to_8_bit_6(uint8_t data) {
+	return (data << 2) | (data >> 4);
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	size_t copy_size = size;
+	if(copy_size > sizeof(input))
+		copy_size = sizeof(input);
+	memset(&input, 0, sizeof(input));
+	memcpy(&input, data, copy_size);
+	convertISTWLVideoToOutput(&input, &output);
+
+	const uint8_t* in_16_bit = (const uint8_t*)input.screen_data;
+	const uint8_t* in_2_bit = input.bit_6_rb_screen_data;
+	const size_t num_screens = 2;
+	for(size_t i = 0; i < HEIGHT_DS; i++) {
+		for(size_t j = 0; j < num_screens; j++) {
+			for(size_t k = 0; k < WIDTH_DS; k++) {
+				size_t in_pixel = (i * num_screens * WIDTH_DS) + (j * WIDTH_DS) + k;
+				uint16_t value = read_le16(in_16_bit + (in_pixel * 2));
+				uint8_t extra_bits = in_2_bit[in_pixel / 4] >> ((in_pixel % 4) * 2);
+				uint8_t r = ((value & 0x1F) << 1) | (extra_bits & 1);
+				uint8_t g = (value >> 5) & 0x3F;
+				uint8_t b = (((value >> 11) & 0x1F) << 1) | ((extra_bits >> 1) & 1);
+				size_t out_pixel = ((num_screens - 1 - j) * (WIDTH_DS * HEIGHT_DS)) + (i * WIDTH_DS) + k;
+				const uint8_t* out = (const uint8_t*)&output.screen_data[out_pixel];
+				fuzz_check(out[0] == to_8_bit_6(r), "Wrong red");
+				fuzz_check(out[1] == to_8_bit_6(g), "Wrong green");
+				fuzz_check(out[2] == to_8_bit_6(b), "Wrong blue");
+			}
+		}
+	}
+	return 0;
+}
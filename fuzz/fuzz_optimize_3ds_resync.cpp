@@ -0,0 +1,123 @@
+#include "fuzz_common.hpp"
+#include "cypress_optimize_3ds_frame_parsing.hpp"
+
+// Walks the Optimize 3DS stream the same way the acquisition callback
+// does: search for the first column while not synchronized, then take
+// whole frames as long as their header is where it should be.
+// The first byte picks the device kind and the video mode.
+
+#define FUZZ_OPTIMIZE_3DS_OLD_FIRMWARE 0x01
+#define FUZZ_OPTIMIZE_3DS_RGB888 0x02
+#define FUZZ_OPTIMIZE_3DS_3D 0x04
+#define FUZZ_OPTIMIZE_3DS_O2DS 0x08
+
+enum FuzzStepResult {
+	FUZZ_STEP_MOVED,
+	FUZZ_STEP_NEEDS_DATA,
+};
+
+struct FuzzOptimize3DSState {
+	bool is_old_firmware;
+	bool is_rgb888;
+	bool should_be_3d;
+	bool is_o2ds;
+	bool synchronized;
+	size_t read_pos;
+	size_t search_pos;
+	int num_frames;
+};
+
+static uint8_t ring[OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE];
+static CaptureReceived frame_buffer;
+
+static FuzzStepResult step_not_synchronized(FuzzOptimize3DSState &state, FuzzRingStream &stream) {
+	size_t slice = state.search_pos / OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE;
+	if((slice * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) >= stream.fed)
+		return FUZZ_STEP_NEEDS_DATA;
+	uint8_t* slice_data = ring + ((slice % NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS) * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE);
+	size_t result = get_pos_first_synch_in_buffer_optimize_3ds(state.is_old_firmware, state.is_rgb888, slice_data, state.search_pos % OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE);
+	if(result >= OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) {
+		// Nothing here. The slice is given back
+		state.search_pos = (slice + 1) * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE;
+		state.read_pos = state.search_pos;
+		return FUZZ_STEP_MOVED;
+	}
+	fuzz_check(result >= (state.search_pos % OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE), "Synch found before the start of the search");
+	state.read_pos = (slice * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) + result;
+	state.synchronized = true;
+	return FUZZ_STEP_MOVED;
+}
+
+static FuzzStepResult step_synchronized(FuzzOptimize3DSState &state, FuzzRingStream &stream) {
+	size_t read_slice_index = (state.read_pos / OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) % NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS;
+	size_t read_slice_pos = state.read_pos % OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE;
+	size_t available_bytes = stream.fed - state.read_pos;
+	bool should_be_3d_data = state.should_be_3d;
+	if(state.is_o2ds)
+		should_be_3d_data = false;
+	bool is_3d_data = should_be_3d_data;
+	size_t video_in_size = (size_t)get_video_in_size_optimize_3ds(state.is_old_firmware, is_3d_data, should_be_3d_data, state.is_rgb888, false);
+	size_t header_packet_size = get_header_size_optimize_3ds_packet(state.is_old_firmware, state.is_rgb888);
+	if(available_bytes >= header_packet_size) {
+		uint8_t tmp_buffer[sizeof(USB5653DSOptimizeOldFirmwareHeaderData)];
+		fuzz_check(header_packet_size <= sizeof(tmp_buffer), "Header bigger than expected");
+		copy_slice_data_to_buffer_optimize_3ds(tmp_buffer, ring, read_slice_index, read_slice_pos, header_packet_size);
+		if(!get_is_pos_first_synch_in_buffer_optimize_3ds(state.is_old_firmware, state.is_rgb888, tmp_buffer, 0)) {
+			state.synchronized = false;
+			state.search_pos = state.read_pos + 2;
+			return FUZZ_STEP_MOVED;
+		}
+		if(get_expect_extra_header_in_buffer_optimize_3ds(state.is_old_firmware, read_le16(tmp_buffer, 1)))
+			video_in_size = (size_t)get_video_in_size_optimize_3ds(state.is_old_firmware, is_3d_data, should_be_3d_data, state.is_rgb888, true);
+		if(get_is_data_2d_only_optimize_3ds(state.is_o2ds, read_le16(tmp_buffer, 1))) {
+			is_3d_data = false;
+			video_in_size = (size_t)get_video_in_size_optimize_3ds(state.is_old_firmware, is_3d_data, should_be_3d_data, state.is_rgb888, true);
+		}
+	}
+	fuzz_check(video_in_size <= sizeof(CaptureReceived), "Frame bigger than the capture buffer");
+	if(available_bytes < video_in_size) {
+		fuzz_check(!fuzz_ring_is_full(stream, state.read_pos), "Waiting for a frame bigger than the ring");
+		return FUZZ_STEP_NEEDS_DATA;
+	}
+	copy_slice_data_to_buffer_optimize_3ds((uint8_t*)&frame_buffer, ring, read_slice_index, read_slice_pos, video_in_size);
+	if(get_is_buffer_fully_synched_optimize_3ds(state.is_old_firmware, &frame_buffer, is_3d_data, should_be_3d_data, state.is_rgb888)) {
+		process_data_buffer_optimize_3ds(state.is_old_firmware, state.is_rgb888, (uint64_t*)&frame_buffer, video_in_size);
+		state.num_frames++;
+	}
+	state.read_pos += video_in_size;
+	return FUZZ_STEP_MOVED;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	if(size < 1)
+		return 0;
+	FuzzOptimize3DSState state;
+	state.is_old_firmware = data[0] & FUZZ_OPTIMIZE_3DS_OLD_FIRMWARE;
+	state.is_rgb888 = data[0] & FUZZ_OPTIMIZE_3DS_RGB888;
+	state.should_be_3d = data[0] & FUZZ_OPTIMIZE_3DS_3D;
+	state.is_o2ds = data[0] & FUZZ_OPTIMIZE_3DS_O2DS;
+	state.synchronized = false;
+	state.read_pos = 0;
+	// The acquisition starts looking two bytes in, too
+	state.search_pos = 2;
+	state.num_frames = 0;
+
+	FuzzRingStream stream;
+	fuzz_ring_init(stream, ring, OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE, NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS, data + 1, size - 1);
+	FuzzProgressGuard guard;
+	fuzz_progress_init(guard, size);
+	while(true) {
+		FuzzStepResult result;
+		if(state.synchronized)
+			result = step_synchronized(state, stream);
+		else
+			result = step_not_synchronized(state, stream);
+		if(result == FUZZ_STEP_MOVED) {
+			fuzz_progress_step(guard, state.read_pos);
+			continue;
+		}
+		if(!fuzz_ring_feed(stream, state.read_pos))
+			break;
+	}
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include "fuzz_common.hpp"
+#include "cypress_partner_ctr_frame_parsing.hpp"
+
+// Walks the Partner CTR command stream the same way the acquisition
+// callback does: search for an input command while not synchronized,
+// then put together frames from the screen and audio commands.
+// The first byte says whether 3D was requested.
+
+#define FUZZ_PARTNER_CTR_3D 0x01
+
+enum FuzzStepResult {
+	FUZZ_STEP_MOVED,
+	FUZZ_STEP_NEEDS_DATA,
+};
+
+struct FuzzPartnerCTRState {
+	bool should_be_3d;
+	bool synchronized;
+	size_t read_pos;
+	size_t search_pos;
+	int num_frames;
+};
+
+static uint8_t ring[PARTNER_CTR_TOTAL_BUFFERS_SIZE];
+static CaptureReceived frame_buffer;
+
+static FuzzStepResult step_not_synchronized(FuzzPartnerCTRState &state, FuzzRingStream &stream) {
+	size_t slice = state.search_pos / PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE;
+	if((slice * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) >= stream.fed)
+		return FUZZ_STEP_NEEDS_DATA;
+	uint8_t* slice_data = ring + ((slice % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS) * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE);
+	size_t result = get_pos_first_synch_in_buffer_partner_ctr(slice_data, state.search_pos % PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE);
+	if(result >= PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) {
+		// Nothing here. The slice is given back
+		state.search_pos = (slice + 1) * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE;
+		state.read_pos = state.search_pos;
+		return FUZZ_STEP_MOVED;
+	}
+	fuzz_check(result >= (state.search_pos % PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE), "Synch found before the start of the search");
+	state.read_pos = (slice * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) + result;
+	state.synchronized = true;
+	return FUZZ_STEP_MOVED;
+}
+
+static FuzzStepResult step_synchronized(FuzzPartnerCTRState &state, FuzzRingStream &stream) {
+	size_t read_slice_index = (state.read_pos / PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS;
+	size_t read_slice_pos = state.read_pos % PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE;
+	size_t available_bytes = stream.fed - state.read_pos;
+	bool is_3d_data = state.should_be_3d;
+	size_t final_data_size = 0;
+	bool synchronized = true;
+	bool is_data_ready = is_valid_frame_partner_ctr_attempt_add_sound(ring, read_slice_index, read_slice_pos, available_bytes, is_3d_data, final_data_size, synchronized);
+	if((!is_data_ready) && (!synchronized)) {
+		state.synchronized = false;
+		state.search_pos = state.read_pos + 2;
+		return FUZZ_STEP_MOVED;
+	}
+	if(!is_data_ready) {
+		fuzz_check(!fuzz_ring_is_full(stream, state.read_pos), "Waiting for a frame bigger than the ring");
+		return FUZZ_STEP_NEEDS_DATA;
+	}
+	fuzz_check(final_data_size > 0, "Empty frame");
+	fuzz_check(final_data_size <= available_bytes, "Frame goes past the available data");
+	fuzz_check(final_data_size <= PARTNER_CTR_MAX_FRAME_SIZE, "Frame bigger than the capture buffer");
+	fuzz_check((!is_3d_data) || state.should_be_3d, "3D frame without asking for 3D");
+	copy_slice_data_to_buffer_partner_ctr((uint8_t*)&frame_buffer, ring, read_slice_index, read_slice_pos, final_data_size);
+	// Same terminator the acquisition puts there
+	write_le16(((uint8_t*)&frame_buffer) + final_data_size, 0xFFFF);
+	state.num_frames++;
+	state.read_pos += final_data_size;
+	return FUZZ_STEP_MOVED;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+	if(size < 1)
+		return 0;
+	FuzzPartnerCTRState state;
+	state.should_be_3d = data[0] & FUZZ_PARTNER_CTR_3D;
+	state.synchronized = false;
+	state.read_pos = 0;
+	// The acquisition starts looking two bytes in, too
+	state.search_pos = 2;
+	state.num_frames = 0;
+
+	FuzzRingStream stream;
+	fuzz_ring_init(stream, ring, PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE, NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS, data + 1, size - 1);
+	FuzzProgressGuard guard;
+	fuzz_progress_init(guard, size);
+	while(true) {
+		FuzzStepResult result;
+		if(state.synchronized)
+			result = step_synchronized(state, stream);
+		else
+			result = step_not_synchronized(state, stream);
+		if(result == FUZZ_STEP_MOVED) {
+			fuzz_progress_step(guard, state.read_pos);
+			continue;
+		}
+		if(!fuzz_ring_feed(stream, state.read_pos))
+			break;
+	}
+	return 0;
+}
@@ -0,0 +1,179 @@
+#include "fuzz_common.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <csignal>
+
+// Used when libFuzzer is not available. It runs the harness on the
+// corpus, and then on a fixed number of mutations of it, so the same
+// command works as a regression test on any compiler.
+// Usage: fuzz_x [-runs=N] [-timeout=S] [-seed=N] files_or_directories...
+
+static std::string curr_input_name;
+static std::atomic<uint64_t> curr_input_id;
+static std::atomic<bool> watchdog_running;
+
+static void abort_handler(int signal) {
+	// Not really async safe, but the process is going away anyway
+	fprintf(stderr, "Failed on input: %s\n", curr_input_name.c_str());
+	std::signal(signal, SIG_DFL);
+	std::raise(signal);
+}
+
+// A resynchronization which never ends shows up as an input that never
+// finishes, so those count as failures too.
+static void watchdog_thread(int timeout_seconds) {
+	uint64_t last_id = curr_input_id;
+	auto last_change = std::chrono::steady_clock::now();
+	while(watchdog_running) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		uint64_t id = curr_input_id;
+		auto now = std::chrono::steady_clock::now();
+		if(id != last_id) {
+			last_id = id;
+			last_change = now;
+			continue;
+		}
+		if(std::chrono::duration_cast<std::chrono::seconds>(now - last_change).count() >= timeout_seconds) {
+			fprintf(stderr, "Timed out after %d seconds\n", timeout_seconds);
+			abort();
+		}
+	}
+}
+
+static bool read_input(const std::filesystem::path &path, std::vector<uint8_t> &out) {
+	std::ifstream file(path, std::ios::binary);
+	if(!file)
+		return false;
+	out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+static void run_input(const std::string &name, const std::vector<uint8_t> &data) {
+	curr_input_name = name;
+	curr_input_id++;
+	// Copied, so reading past the end is caught by the sanitizers
+	uint8_t* copy = new uint8_t[data.size() + 1];
+	if(data.size() > 0)
+		memcpy(copy, data.data(), data.size());
+	LLVMFuzzerTestOneInput(copy, data.size());
+	delete []copy;
+}
+
+static void mutate(std::vector<uint8_t> &data, std::mt19937 &rng) {
+	int num_mutations = 1 + (rng() % 8);
+	for(int i = 0; i < num_mutations; i++) {
+		switch(rng() % 6) {
+			case 0:
+				if(data.size() > 0)
+					data[rng() % data.size()] ^= (uint8_t)(1 << (rng() % 8));
+				break;
+			case 1:
+				if(data.size() > 0)
+					data[rng() % data.size()] = rng() & 0xFF;
+				break;
+			case 2: {
+				size_t pos = data.size() > 0 ? (rng() % data.size()) : 0;
+				size_t len = 1 + (rng() % 16);
+				for(size_t j = 0; j < len; j++)
+					data.insert(data.begin() + pos, rng() & 0xFF);
+				break;
+			}
+			case 3:
+				if(data.size() > 0) {
+					size_t pos = rng() % data.size();
+					size_t len = std::min<size_t>(1 + (rng() % 64), data.size() - pos);
+					data.erase(data.begin() + pos, data.begin() + pos + len);
+				}
+				break;
+			case 4:
+				if(data.size() > 0)
+					data.resize(rng() % data.size());
+				break;
+			default:
+				// Shifting everything by a bit tests the resynchronization
+				if(data.size() > 1) {
+					size_t len = 1 + (rng() % 3);
+					data.insert(data.begin() + 1, len, 0);
+				}
+				break;
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	uint64_t num_runs = 0;
+	int timeout_seconds = 10;
+	uint32_t seed = 0x3D5;
+	std::vector<std::filesystem::path> paths;
+	for(int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if(arg.rfind("-runs=", 0) == 0)
+			num_runs = std::stoull(arg.substr(6));
+		else if(arg.rfind("-timeout=", 0) == 0)
+			timeout_seconds = std::stoi(arg.substr(9));
+		else if(arg.rfind("-seed=", 0) == 0)
+			seed = (uint32_t)std::stoul(arg.substr(6));
+		else if(arg.rfind("-", 0) == 0)
+			std::cout << "Ignoring option " << arg << std::endl;
+		else
+			paths.push_back(arg);
+	}
+
+	std::vector<std::pair<std::string, std::vector<uint8_t>>> corpus;
+	for(const auto &path : paths) {
+		std::vector<std::filesystem::path> files;
+		if(std::filesystem::is_directory(path)) {
+			for(const auto &entry : std::filesystem::directory_iterator(path))
+				if(entry.is_regular_file())
+					files.push_back(entry.path());
+			std::sort(files.begin(), files.end());
+		}
+		else
+			files.push_back(path);
+		for(const auto &file : files) {
+			std::vector<uint8_t> data;
+			if(!read_input(file, data)) {
+				std::cout << "Could not read " << file.string() << std::endl;
+				return 1;
+			}
+			corpus.emplace_back(file.string(), data);
+		}
+	}
+
+	// Broken data makes the parsers print errors. There would be a lot
+	// of them. The checks and the sanitizers do not use std::cerr
+	std::cerr.rdbuf(NULL);
+	std::signal(SIGABRT, abort_handler);
+	curr_input_id = 0;
+	watchdog_running = true;
+	std::thread watchdog(watchdog_thread, timeout_seconds);
+
+	for(const auto &entry : corpus)
+		run_input(entry.first, entry.second);
+	std::mt19937 rng(seed);
+	for(uint64_t i = 0; i < num_runs; i++) {
+		std::vector<uint8_t> data;
+		std::string name = "empty input";
+		if(corpus.size() > 0) {
+			size_t index = rng() % corpus.size();
+			data = corpus[index].second;
+			name = corpus[index].first;
+		}
+		mutate(data, rng);
+		run_input("mutation " + std::to_string(i) + " of " + name + " (seed " + std::to_string(seed) + ")", data);
+	}
+
+	watchdog_running = false;
+	watchdog.join();
+	std::cout << "All " << corpus.size() << " inputs and " << num_runs << " mutations passed" << std::endl;
+	return 0;
+}
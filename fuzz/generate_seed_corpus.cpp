@@ -0,0 +1,276 @@
+#include "cypress_optimize_3ds_frame_parsing.hpp"
+#include "cypress_partner_ctr_frame_parsing.hpp"
+#include "dscapture_ftd2_synchronization.hpp"
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+#include "utils.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+// Writes the seeds in fuzz/corpus. They are put together following the
+// packet layouts the acquisition code expects, so they reach the frame
+// parsing instead of being thrown away by the first check.
+// Dumps of the data a real device sent can be added next to them.
+// Usage: generate_seed_corpus fuzz/corpus
+
+static CaptureReceived frame;
+
+static bool write_seed(const std::filesystem::path &dir, const std::string &name, const std::vector<uint8_t> &data) {
+	std::filesystem::create_directories(dir);
+	std::ofstream file(dir / name, std::ios::binary);
+	if(!file)
+		return false;
+	file.write((const char*)data.data(), data.size());
+	return file.good();
+}
+
+static void append(std::vector<uint8_t> &out, const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+static void write_optimize_header(uint8_t* header, uint16_t column_index, bool extra_header) {
+	write_le16(header, SYNCH_VALUE_OPTIMIZE);
+	write_le16(header + 2, column_index | (extra_header ? 0x8000 : 0));
+}
+
+// Before the 0xA5 xor, for RGB888
+static void write_optimize_old_fw_header(uint8_t* header, size_t info_offset, uint16_t magic, uint16_t column_index) {
+	write_le16(header, (column_index == 1) ? 0 : magic);
+	write_le16(header + info_offset, ((column_index == 0) ? 0x8000 : 0) | (column_index << 4) | 5);
+}
+
+static void append_optimize_565_2d(std::vector<uint8_t> &out, bool extra_header) {
+	memset(&frame, 0, sizeof(frame));
+	USB5653DSOptimizeCaptureReceivedExtraHeader* data = &frame.cypress_optimize_received_565_extra_header;
+	int num_columns = extra_header ? (TOP_WIDTH_3DS + 1) : TOP_WIDTH_3DS;
+	for(int i = 0; i < num_columns; i++)
+		write_optimize_header((uint8_t*)&data->columns_data[i].header_sound, i, extra_header);
+	if(extra_header)
+		append(out, &frame, sizeof(USB5653DSOptimizeCaptureReceivedExtraHeader));
+	else
+		append(out, &frame, sizeof(USB5653DSOptimizeCaptureReceived));
+}
+
+static void append_optimize_888_3d(std::vector<uint8_t> &out) {
+	memset(&frame, 0, sizeof(frame));
+	USB8883DSOptimizeCaptureReceived_3D* data = &frame.cypress_optimize_received_888_3d;
+	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
+		write_optimize_header((uint8_t*)&data->columns_data[i][0].header_sound, i * 2, false);
+		write_optimize_header((uint8_t*)&data->columns_data[i][1].header_sound, (i * 2) + 1, false);
+	}
+	write_optimize_header((uint8_t*)&data->bottom_only_column.header_sound, TOP_WIDTH_3DS * 2, false);
+	append(out, &frame, sizeof(USB8883DSOptimizeCaptureReceived_3D));
+}
+
+// What is sent in 3D mode while the game is only showing 2D
+static void append_optimize_888_3d_forced_2d(std::vector<uint8_t> &out) {
+	memset(&frame, 0, sizeof(frame));
+	USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen* data = &frame.cypress_optimize_received_888_3d_2d;
+	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++)
+		write_optimize_header((uint8_t*)&data->columns_data[i].header_sound, i, true);
+	append(out, &frame, sizeof(USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen));
+}
+
+static void append_optimize_old_fw_565(std::vector<uint8_t> &out) {
+	memset(&frame, 0, sizeof(frame));
+	USB5653DSOptimizeOldFirmwareCaptureReceived* data = &frame.cypress_optimize_old_firmware_received_565;
+	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++)
+		write_optimize_old_fw_header((uint8_t*)&data->columns_data[i].header, 8, SYNCH_VALUE_OPTIMIZE_OLD_FW_565, i);
+	append(out, &frame, sizeof(USB5653DSOptimizeOldFirmwareCaptureReceived));
+}
+
+static void append_optimize_old_fw_888(std::vector<uint8_t> &out) {
+	memset(&frame, 0, sizeof(frame));
+	USB8883DSOptimizeOldFirmwareCaptureReceived* data = &frame.cypress_optimize_old_firmware_received_888;
+	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++)
+		write_optimize_old_fw_header((uint8_t*)&data->columns_data[i].header_sound, 2, SYNCH_VALUE_OPTIMIZE_OLD_FW_888, i);
+	uint8_t* bytes = (uint8_t*)&frame;
+	for(size_t i = 0; i < sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived); i++)
+		bytes[i] ^= 0xA5;
+	append(out, &frame, sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived));
+}
+
+// The search for the first column starts two bytes in, like it does
+// for the devices, so there is always something before it
+static std::vector<uint8_t> optimize_seed(uint8_t flags, size_t garbage_size) {
+	std::vector<uint8_t> out;
+	out.push_back(flags);
+	std::mt19937 rng(flags);
+	for(size_t i = 0; i < garbage_size; i++)
+		out.push_back(rng() & 0xFF);
+	return out;
+}
+
+static bool write_optimize_3ds_seeds(const std::filesystem::path &dir) {
+	// Starts in the middle of a frame, with a header for the wrong column
+	std::vector<uint8_t> new_fw_565 = optimize_seed(0x00, 34);
+	uint8_t wrong_header[sizeof(USB3DSOptimizeHeaderData)];
+	write_optimize_header(wrong_header, 7, false);
+	append(new_fw_565, wrong_header, sizeof(wrong_header));
+	append_optimize_565_2d(new_fw_565, false);
+	append_optimize_565_2d(new_fw_565, false);
+	std::vector<uint8_t> new_fw_565_extra_header = optimize_seed(0x00, 10);
+	append_optimize_565_2d(new_fw_565_extra_header, true);
+	append_optimize_565_2d(new_fw_565_extra_header, false);
+	std::vector<uint8_t> new_fw_888_3d = optimize_seed(0x06, 6);
+	append_optimize_888_3d(new_fw_888_3d);
+	append_optimize_888_3d_forced_2d(new_fw_888_3d);
+	append_optimize_888_3d(new_fw_888_3d);
+	std::vector<uint8_t> o2ds_565 = optimize_seed(0x08, 4);
+	append_optimize_565_2d(o2ds_565, true);
+	append_optimize_565_2d(o2ds_565, true);
+	std::vector<uint8_t> old_fw_565 = optimize_seed(0x01, 18);
+	append_optimize_old_fw_565(old_fw_565);
+	append_optimize_old_fw_565(old_fw_565);
+	std::vector<uint8_t> old_fw_888 = optimize_seed(0x03, 2);
+	append_optimize_old_fw_888(old_fw_888);
+	append_optimize_old_fw_888(old_fw_888);
+
+	return write_seed(dir, "new_fw_565_2d", new_fw_565) && write_seed(dir, "new_fw_565_extra_header", new_fw_565_extra_header) && write_seed(dir, "new_fw_888_3d", new_fw_888_3d) && write_seed(dir, "o2ds_565", o2ds_565) && write_seed(dir, "old_fw_565", old_fw_565) && write_seed(dir, "old_fw_888", old_fw_888);
+}
+
+static void write_partner_ctr_command_header(uint8_t* header, uint16_t command, uint32_t payload_size, uint8_t index_kind, uint16_t index) {
+	write_le16(header, PARTNER_CTR_CAPTURE_BASE_COMMAND);
+	write_le16(header + 2, command);
+	write_le32(header + 4, payload_size);
+	if(command == PARTNER_CTR_CAPTURE_COMMAND_AUDIO)
+		write_le32(header + sizeof(PartnerCTRCaptureCommand), index);
+	else if(command != PARTNER_CTR_CAPTURE_COMMAND_INPUT) {
+		header[sizeof(PartnerCTRCaptureCommand)] = index_kind;
+		write_le16(header + sizeof(PartnerCTRCaptureCommand) + 1, index);
+	}
+}
+
+static void append_partner_ctr_command(std::vector<uint8_t> &out, uint16_t command, size_t header_size, uint32_t payload_size, uint8_t index_kind, uint16_t index) {
+	size_t start = out.size();
+	out.resize(start + header_size + payload_size, 0);
+	uint8_t* header = out.data() + start;
+	write_partner_ctr_command_header(header, command, payload_size, index_kind, index);
+	// Something which is not silence for the audio
+	if(command == PARTNER_CTR_CAPTURE_COMMAND_AUDIO)
+		for(uint32_t i = 0; i < payload_size; i++)
+			header[header_size + i] = (uint8_t)(i * 3);
+}
+
+static void append_partner_ctr_screen(std::vector<uint8_t> &out, uint16_t command, uint8_t index_kind, uint16_t index) {
+	uint32_t width = (command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) ? BOT_WIDTH_3DS : TOP_WIDTH_3DS;
+	append_partner_ctr_command(out, PARTNER_CTR_CAPTURE_COMMAND_INPUT, sizeof(PartnerCTRCaptureCommandHeader0F), 0, 0, 0);
+	append_partner_ctr_command(out, command, sizeof(PartnerCTRCaptureCommandHeaderCxScreen), width * HEIGHT_3DS * sizeof(VideoPixelRGB), index_kind, index);
+}
+
+static void append_partner_ctr_audio(std::vector<uint8_t> &out, uint16_t index) {
+	append_partner_ctr_command(out, PARTNER_CTR_CAPTURE_COMMAND_AUDIO, sizeof(PartnerCTRCaptureCommandHeaderC7), 0x800, 0, index);
+}
+
+static void append_partner_ctr_2d_frame(std::vector<uint8_t> &out, uint16_t index) {
+	append_partner_ctr_screen(out, PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_2D_TOP, index);
+	append_partner_ctr_screen(out, PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_BOTTOM, index);
+}
+
+static void append_partner_ctr_3d_frame(std::vector<uint8_t> &out, uint16_t index) {
+	append_partner_ctr_screen(out, PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_3D_TOP, index);
+	append_partner_ctr_screen(out, PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_3D_TOP, index);
+	append_partner_ctr_screen(out, PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_BOTTOM, index);
+}
+
+static bool write_partner_ctr_seeds(const std::filesystem::path &dir) {
+	// Starts in the middle of a screen
+	std::vector<uint8_t> stream_2d = {0x00, 0x12, 0x34, 0x07, 0xE0, 0xC4, 0x00};
+	for(int i = 0; i < 2; i++) {
+		append_partner_ctr_2d_frame(stream_2d, i);
+		append_partner_ctr_audio(stream_2d, i);
+	}
+	std::vector<uint8_t> stream_3d = {0x01, 0x00, 0x00, 0x00, 0x00};
+	for(int i = 0; i < 2; i++) {
+		append_partner_ctr_3d_frame(stream_3d, i);
+		append_partner_ctr_audio(stream_3d, i);
+	}
+	// The game is not in 3D, while 3D was asked for
+	std::vector<uint8_t> stream_2d_in_3d = {0x01, 0xFF, 0xFF};
+	append_partner_ctr_2d_frame(stream_2d_in_3d, 0);
+	append_partner_ctr_audio(stream_2d_in_3d, 0);
+	append_partner_ctr_audio(stream_2d_in_3d, 1);
+	append_partner_ctr_3d_frame(stream_2d_in_3d, 1);
+
+	// Lots of input commands leading to the same screen, followed by
+	// a long chain of audio commands which ends in broken data.
+	// Every resynchronization attempt walks the chain again
+	std::vector<uint8_t> audio_chains = {0x00, 0x00, 0x00};
+	const uint32_t num_input_commands = 20000;
+	for(uint32_t i = 0; i < num_input_commands; i++) {
+		uint8_t header[sizeof(PartnerCTRCaptureCommandHeader0F)] = {};
+		write_partner_ctr_command_header(header, PARTNER_CTR_CAPTURE_COMMAND_INPUT, (num_input_commands - 1 - i) * sizeof(header), 0, 0);
+		append(audio_chains, header, sizeof(header));
+	}
+	append_partner_ctr_command(audio_chains, PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN, sizeof(PartnerCTRCaptureCommandHeaderCxScreen), 0, PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_2D_TOP, 0);
+	for(int i = 0; i < 16000; i++)
+		append_partner_ctr_command(audio_chains, PARTNER_CTR_CAPTURE_COMMAND_AUDIO, sizeof(PartnerCTRCaptureCommandHeaderC7), 0, 0, i);
+	audio_chains.resize(audio_chains.size() + 64, 0x11);
+
+	return write_seed(dir, "stream_2d", stream_2d) && write_seed(dir, "stream_3d", stream_3d) && write_seed(dir, "stream_2d_in_3d", stream_2d_in_3d) && write_seed(dir, "resync_audio_chains", audio_chains);
+}
+
+static std::vector<uint8_t> ftd2_seed(bool special_check, uint16_t frame_words, size_t garbage_words, size_t data_words, size_t leading_synch_words, int num_frames) {
+	std::vector<uint8_t> out;
+	out.push_back(special_check ? 1 : 0);
+	uint8_t size_bytes[2];
+	write_le16(size_bytes, frame_words - 1);
+	append(out, size_bytes, sizeof(size_bytes));
+	uint8_t word[2];
+	for(size_t i = 0; i < garbage_words; i++) {
+		write_le16(word, (uint16_t)(0x1000 + i));
+		append(out, word, sizeof(word));
+	}
+	for(int i = 0; i < num_frames; i++) {
+		for(size_t j = 0; j < frame_words; j++) {
+			uint16_t value = (uint16_t)((i << 8) + j);
+			if((j < leading_synch_words) || (j >= (leading_synch_words + data_words)))
+				value = FTD2_OLDDS_SYNCH_VALUES;
+			write_le16(word, value);
+			append(out, word, sizeof(word));
+		}
+	}
+	return out;
+}
+
+static bool write_ftd2_seeds(const std::filesystem::path &dir) {
+	return write_seed(dir, "aligned", ftd2_seed(false, 64, 0, 60, 0, 6)) && write_seed(dir, "misaligned", ftd2_seed(false, 64, 23, 60, 0, 6)) && write_seed(dir, "special_check", ftd2_seed(true, 64, 5, 58, 2, 6)) && write_seed(dir, "only_synch", ftd2_seed(false, 16, 0, 0, 0, 4));
+}
+
+static bool write_is_twl_seeds(const std::filesystem::path &dir) {
+	// A repeated random block, so every bit is used but the file still
+	// compresses well
+	std::mt19937 rng(0x7317);
+	std::vector<uint8_t> block(0x1000);
+	for(size_t i = 0; i < block.size(); i++)
+		block[i] = rng() & 0xFF;
+	std::vector<uint8_t> full_frame(sizeof(ISTWLCaptureVideoInputData));
+	for(size_t i = 0; i < full_frame.size(); i++)
+		full_frame[i] = block[i % block.size()];
+	std::vector<uint8_t> truncated_frame(full_frame.begin(), full_frame.begin() + 0x1001);
+	return write_seed(dir, "full_frame", full_frame) && write_seed(dir, "truncated_frame", truncated_frame);
+}
+
+int main(int argc, char **argv) {
+	if(argc < 2) {
+		std::cout << "Usage: " << argv[0] << " corpus_directory" << std::endl;
+		return 1;
+	}
+	std::filesystem::path out_dir = argv[1];
+	bool success = write_optimize_3ds_seeds(out_dir / "fuzz_optimize_3ds_resync");
+	success = success && write_partner_ctr_seeds(out_dir / "fuzz_partner_ctr_commands");
+	success = success && write_ftd2_seeds(out_dir / "fuzz_ftd2_synchronization");
+	success = success && write_is_twl_seeds(out_dir / "fuzz_is_twl_unpack");
+	if(!success) {
+		std::cout << "Could not write the seeds" << std::endl;
+		return 1;
+	}
+	std::cout << "Seeds written to " << out_dir.string() << std::endl;
+	return 0;
+}
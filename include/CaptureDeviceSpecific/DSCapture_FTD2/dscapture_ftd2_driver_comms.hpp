@@ -4,8 +4,7 @@
 #include <vector>
 #include "capture_structs.hpp"
 #include "devicecapture.hpp"
-
-#define FTD2_OLDDS_SYNCH_VALUES 0x4321
+#include "dscapture_ftd2_synchronization.hpp"
 
 void list_devices_ftd2_driver(std::vector<CaptureDevice> &devices_list, std::vector<no_access_recap_data> &no_access_list);
 int ftd2_driver_open_serial(CaptureDevice* device, void** handle);
@@ -0,0 +1,15 @@
+#ifndef __DSCAPTURE_FTD2_SYNCHRONIZATION_HPP
+#define __DSCAPTURE_FTD2_SYNCHRONIZATION_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#define FTD2_OLDDS_SYNCH_VALUES 0x4321
+
+// These only look at the data, so they can be used without a device.
+// On a failed check, next_size is how much must be read to re-synchronize.
+// It is always more than 0 when the data is not empty.
+size_t remove_synch_from_final_length(uint32_t* out_buffer, size_t real_length);
+bool synchronization_check(uint16_t* data_buffer, size_t size, uint16_t* next_data_buffer, size_t* next_size, bool special_check = false);
+
+#endif
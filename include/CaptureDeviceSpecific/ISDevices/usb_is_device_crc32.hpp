@@ -0,0 +1,11 @@
+#ifndef __USB_IS_DEVICE_CRC32_HPP
+#define __USB_IS_DEVICE_CRC32_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+// The CRC32 of the IS TWL Capture packets. MSB first, based on the
+// ccitt32 table, computed eight bytes at a time.
+uint32_t get_crc32_data_comm(const uint8_t* data, size_t size);
+
+#endif
@@ -7,6 +7,10 @@
 int initial_cleanup_twl_capture(const is_device_usb_device* usb_device_desc, is_device_device_handlers* handlers);
 int EndAcquisitionTWLCapture(CaptureData* capture_data, ISDeviceCaptureReceivedData* is_twl_capture_recv_data);
 int EndAcquisitionTWLCapture(const is_device_usb_device* usb_device_desc, is_device_device_handlers* handlers);
+// When the audio or the video wrap around the end of their ring buffer,
+// the device only reports the part up to the end of the ring. The ring's
+// start is not reported either, so the wrapped part is only learned from
+// the next AskFrameLengthPos, with another round trip.
 void is_twl_acquisition_capture_main_loop(CaptureData* capture_data, ISDeviceCaptureReceivedData* is_twl_capture_recv_data);
 
 #endif
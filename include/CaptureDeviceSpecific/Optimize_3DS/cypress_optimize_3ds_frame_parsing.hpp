@@ -0,0 +1,31 @@
+#ifndef __CYPRESS_OPTIMIZE_3DS_FRAME_PARSING_HPP
+#define __CYPRESS_OPTIMIZE_3DS_FRAME_PARSING_HPP
+
+#include "utils.hpp"
+#include "capture_structs.hpp"
+
+#define SYNCH_VALUE_OPTIMIZE 0xCC33
+#define SYNCH_VALUE_OPTIMIZE_OLD_FW_565 0xF800
+#define SYNCH_VALUE_OPTIMIZE_OLD_FW_888 0xFF00
+
+#define OPTIMIZE_3DS_TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE 0x100000
+#define OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE 0x4000
+#define NUM_OPTIMIZE_3DS_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS (OPTIMIZE_3DS_TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE / OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE)
+
+#define NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS (3 * NUM_OPTIMIZE_3DS_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS)
+
+#define OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE (NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE)
+
+// The data is in a ring of OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE bytes, split in
+// slices. These only look at the data, so they can be used without a device.
+uint64_t get_video_in_size_optimize_3ds(bool is_old_firmware, bool is_3d, bool should_be_3d, bool is_rgb888, bool has_extra_header);
+size_t get_header_size_optimize_3ds_packet(bool is_old_firmware, bool is_rgb888);
+bool get_expect_extra_header_in_buffer_optimize_3ds(bool is_old_firmware, uint16_t value);
+bool get_is_data_2d_only_optimize_3ds(bool is_o2ds, uint16_t value);
+bool get_is_pos_first_synch_in_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, size_t pos_to_check);
+size_t get_pos_first_synch_in_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, size_t start_pos);
+bool get_is_buffer_fully_synched_optimize_3ds(bool is_old_firmware, CaptureReceived* buffer, bool is_3d, bool should_be_3d, bool is_rgb888);
+void copy_slice_data_to_buffer_optimize_3ds(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size);
+void process_data_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint64_t* data, size_t size);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef __CYPRESS_PARTNER_CTR_FRAME_PARSING_HPP
+#define __CYPRESS_PARTNER_CTR_FRAME_PARSING_HPP
+
+#include "utils.hpp"
+#include "capture_structs.hpp"
+
+#define PARTNER_CTR_CAPTURE_BASE_COMMAND 0xE007
+#define PARTNER_CTR_CAPTURE_COMMAND_INPUT 0x000F
+#define PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN 0x00C4
+#define PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN 0x00C5
+#define PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN 0x00C6
+#define PARTNER_CTR_CAPTURE_COMMAND_AUDIO 0x00C7
+
+#define PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_2D_TOP 0x04
+#define PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_3D_TOP 0x05
+#define PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_BOTTOM 0x06
+
+#define PARTNER_CTR_TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE 0x100000
+#define PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE 0x10000
+#define NUM_PARTNER_CTR_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS (PARTNER_CTR_TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE / PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE)
+
+#define NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS (3 * NUM_PARTNER_CTR_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS)
+
+#define PARTNER_CTR_TOTAL_BUFFERS_SIZE (NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE)
+
+// Leave space for the 0xFFFF terminator
+#define PARTNER_CTR_MAX_FRAME_SIZE (sizeof(CaptureReceived) - 2)
+
+// The data is in a ring of PARTNER_CTR_TOTAL_BUFFERS_SIZE bytes, split in
+// slices. These only look at the data, so they can be used without a device.
+size_t get_pos_first_synch_in_buffer_partner_ctr(uint8_t* buffer, size_t start_pos);
+void copy_slice_data_to_buffer_partner_ctr(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size);
+bool is_valid_frame_partner_ctr_attempt_add_sound(uint8_t* data, size_t slice_index, size_t start_pos, size_t available_bytes, bool &enabled_3d, size_t &out_end_pos, bool &synchronized);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef __RECORDING_PLAYBACK_ACQUISITION_HPP
+#define __RECORDING_PLAYBACK_ACQUISITION_HPP
+
+#include <vector>
+#include "utils.hpp"
+#include "hw_defs.hpp"
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+#include "devicecapture.hpp"
+
+// Each buffer holds a small header with the format of the frame,
+// then the already converted video, then the audio samples (LE).
+#define PLAYBACK_FRAME_HEADER_SIZE 16
+
+void set_playback_recording(std::string path, double speed, double start_seconds);
+void list_devices_playback(std::vector<CaptureDevice> &devices_list, std::vector<no_access_recap_data> &no_access_list);
+bool playback_connect(bool print_failed, CaptureData* capture_data, CaptureDevice* device);
+uint64_t playback_get_video_in_size(CaptureData* capture_data, InputVideoDataType video_data_type);
+size_t playback_get_capture_buffer_slot_size();
+uint16_t playback_get_frame_format(CaptureReceived* buffer);
+void playback_acquisition_main_loop(CaptureData* capture_data);
+void playback_acquisition_cleanup(CaptureData* capture_data);
+
+#endif
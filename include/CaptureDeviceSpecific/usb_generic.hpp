@@ -1,18 +1,36 @@
 #ifndef __USB_GENERIC_HPP
 #define __USB_GENERIC_HPP
 
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+struct CaptureDevice;
+
 #ifdef USE_LIBUSB
 #include <libusb.h>
 libusb_context* get_usb_ctx();
+
+// Avoids probing again devices which were already probed, while listing.
+// Entries are keyed by bus path and probe_id (the caller's descriptor).
+// A hit still opens the device and claims claim_interface. If that fails,
+// the entry is dropped, and the caller must probe the device fully.
+bool usb_device_cache_lookup(libusb_device* usb_device, const void* probe_id, int claim_interface, std::vector<CaptureDevice> &devices_list);
+void usb_device_cache_store(libusb_device* usb_device, const void* probe_id, const std::vector<CaptureDevice> &devices_list, size_t first_new_device);
 #endif
 
 void usb_init();
 void usb_close();
 bool usb_is_initialized();
+void usb_device_cache_clear();
 void libusb_check_and_detach_kernel_driver(void* handle, int interface);
 int libusb_check_and_set_configuration(void* handle, int wanted_configuration);
 
 void libusb_register_to_event_thread();
 void libusb_unregister_from_event_thread();
 
+void usb_device_watch_start();
+void usb_device_watch_stop();
+bool usb_device_watch_get_change_id(uint64_t* change_id);
+
 #endif
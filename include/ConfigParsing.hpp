@@ -0,0 +1,13 @@
+#ifndef __CONFIGPARSING_HPP
+#define __CONFIGPARSING_HPP
+
+#include <string>
+#include "display_structs.hpp"
+
+// The parts of the config files which don't need a window.
+// These throw, like std::stoi does, if a value can't be read.
+bool load_screen_info(std::string key, std::string value, std::string base, ScreenInfo &info);
+std::string save_screen_info(std::string base, const ScreenInfo &info);
+bool load_shared_data_value(const std::string &key, const std::string &value, SharedData* shared_data);
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef __CONFIGSNAPSHOT_HPP
+#define __CONFIGSNAPSHOT_HPP
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "display_structs.hpp"
+#include "capture_structs.hpp"
+
+// Binary copies of what parsing a config file results in, saved next to it.
+// The text file is still what matters. A snapshot is only used if the file's
+// modification time and size are the same, or if its contents hash the same.
+// Snapshots from other versions of the program are ignored.
+#define CONFIG_SNAPSHOT_VERSION 1
+#define CONFIG_SNAPSHOT_EXTENSION ".snap"
+
+struct ConfigSourceState {
+	int64_t write_time;
+	uint64_t file_size;
+	uint64_t content_hash;
+};
+
+struct LayoutConfigSnapshot {
+	// The parsing starts from the defaults, which depend on this
+	bool mono_app_mode;
+	ScreenInfo top_info;
+	ScreenInfo bottom_info;
+	ScreenInfo joint_info;
+	bool interleaved_3d;
+	bool do_ratio_cycling;
+	bool last_connected_ds;
+	bool requested_3d;
+	CaptureScreensType is_capture_type;
+	CaptureSpeedsType is_capture_speed;
+	int is_battery_percentage;
+	bool is_ac_adapter_connected;
+	int partner_ctr_battery_percentage;
+	bool partner_ctr_ac_adapter_connected;
+	bool partner_ctr_ac_adapter_charging;
+	bool request_low_bw_format;
+	bool request_low_bw_format_old_2ds;
+	bool devices_allowed_scan[CC_POSSIBLE_DEVICES_END];
+	// Audio goes through its own setters again, as they have side effects
+	std::vector<std::pair<std::string, std::string>> audio_values;
+};
+
+uint64_t get_config_content_hash(const std::string &content);
+// Gets the modification time and the size. The hash is left to the caller.
+bool get_config_source_state(const std::string &path, ConfigSourceState &state);
+bool is_config_source_unchanged(const ConfigSourceState &snapshot_state, const ConfigSourceState &file_state);
+bool save_layout_config_snapshot(const std::string &path, const ConfigSourceState &source_state, const LayoutConfigSnapshot &snapshot);
+bool load_layout_config_snapshot(const std::string &path, ConfigSourceState &source_state, LayoutConfigSnapshot &snapshot);
+bool save_shared_config_snapshot(const std::string &path, const ConfigSourceState &source_state, const SharedData &shared_data);
+bool load_shared_config_snapshot(const std::string &path, ConfigSourceState &source_state, SharedData &shared_data);
+
+#endif
@@ -3,14 +3,24 @@
 
 #include <chrono>
 #include "event_structs.hpp"
-#include "libgpiod_compat.h"
+#include "ExtraButtonsLine.hpp"
+#include "utils.hpp"
+
+#define EXTRA_BUTTONS_EVENTS_QUEUE_SIZE 64
+// Only used if the input thread cannot be woken up when closing
+#define EXTRA_BUTTONS_MAX_EVENT_WAIT_MS 100
+
+typedef LockFreeQueue<SFEvent, EXTRA_BUTTONS_EVENTS_QUEUE_SIZE> ExtraButtonsEventsQueue;
 
 class ExtraButton {
 public:
-	void initialize(int id, sf::Keyboard::Key corresponding_key, bool is_power, float first_re_press_time, float later_re_press_time, bool use_pud_up, std::string name);
+	void initialize(int id, sf::Keyboard::Key corresponding_key, bool is_power, float first_re_press_time, float later_re_press_time, bool use_pud_up, bool use_events, std::string name);
 	std::string get_name();
 	bool is_button_x(sf::Keyboard::Key corresponding_key);
-	void poll(std::queue<SFEvent> &events_queue);
+	void poll(ExtraButtonsEventsQueue &events_queue);
+	int get_event_fd();
+	int get_event_wait_timeout_ms();
+	void process_events();
 	void end();
 private:
 	bool initialized = false;
@@ -18,15 +28,15 @@ private:
 	sf::Keyboard::Key corresponding_key;
 	bool is_power;
 	bool started;
+	bool last_sent_pressed;
 	bool after_first;
 	float first_re_press_time;
 	float later_re_press_time;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_press_time;
 	bool is_time_valid;
 	std::string name;
-	#ifdef RASPI
-	gpiod_line *gpioline_ptr;
-	#endif
+	ExtraButtonLineSource* line_source = NULL;
+	ExtraButtonDebouncer debouncer;
 
 	bool is_pressed();
 	bool is_valid();
@@ -0,0 +1,71 @@
+#ifndef __EXTRABUTTONSLINE_HPP
+#define __EXTRABUTTONSLINE_HPP
+
+#include <cstdint>
+#include <queue>
+#include "utils.hpp"
+
+// Edges closer than this to the last accepted one are bounces
+#define EXTRA_BUTTONS_DEBOUNCE_NS 10000000
+
+// Where a button reads its line from. On a Pi, that is a GPIO line.
+// The buttons are pressed when their line is low.
+class ExtraButtonLineSource {
+public:
+	virtual ~ExtraButtonLineSource() {}
+	// Without edge events, the line must be polled
+	virtual bool has_events() = 0;
+	virtual bool is_low() = 0;
+	// -1 if there is nothing to wait on
+	virtual int get_event_fd() = 0;
+	// Returns false once there are no more queued edges
+	virtual bool read_edge(uint64_t &edge_ns, bool &is_falling) = 0;
+	// Monotonic, in the same clock as the edges
+	virtual uint64_t get_time_ns() = 0;
+};
+
+// NULL if the line can't be found or used
+ExtraButtonLineSource* open_gpio_extra_button_line(int id, bool use_pud_up, bool use_events);
+
+// Turns the edges of a line into a debounced pressed state.
+// The first edge is taken right away, then the bouncing is ignored.
+// Once things settle down, the line is read again, in case the
+// bouncing stopped on the other state.
+class ExtraButtonDebouncer {
+public:
+	void reset(bool pressed);
+	bool is_pressed();
+	void process_events(ExtraButtonLineSource* line_source);
+	// When the line should be read again. -1 if it doesn't need to be.
+	int get_resync_timeout_ms(ExtraButtonLineSource* line_source);
+private:
+	bool pressed = false;
+	bool has_last_edge = false;
+	bool needs_resync = false;
+	uint64_t last_edge_ns = 0;
+	uint64_t last_edge_local_ns = 0;
+};
+
+// The focused window takes the queued events. If no window does,
+// pass NULL, and they are dropped. Otherwise, they would be replayed
+// later on as stale presses.
+template <class T, size_t N> void take_extra_button_events(LockFreeQueue<T, N> &source, std::queue<T>* target) {
+	T event_data;
+	while(source.pop(event_data))
+		if(target != NULL)
+			target->push(event_data);
+}
+
+// For when a window stops processing its events early, like when
+// the menu changes. The other events are kept, in order.
+template <class T, class F> void drop_unprocessed_extra_button_events(std::queue<T> &events_queue, F is_extra) {
+	size_t num_events = events_queue.size();
+	for(size_t i = 0; i < num_events; i++) {
+		T event_data = events_queue.front();
+		events_queue.pop();
+		if(!is_extra(event_data))
+			events_queue.push(event_data);
+	}
+}
+
+#endif
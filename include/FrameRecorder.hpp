@@ -0,0 +1,156 @@
+#ifndef __FRAMERECORDER_HPP
+#define __FRAMERECORDER_HPP
+
+#include <string>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cstdio>
+#include <vector>
+#include "utils.hpp"
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+
+// Recordings are a file header followed by a stream of records.
+// Each record has a fixed size header, then its payload.
+// Everything is stored in Little Endian.
+#define RECORDING_FILE_MAGIC "CC3DSREC"
+#define RECORDING_FILE_MAGIC_SIZE 8
+#define RECORDING_FILE_VERSION 2
+#define RECORDING_FILE_HEADER_SIZE 16
+#define RECORDING_RECORD_HEADER_SIZE 32
+#define RECORDING_DEVICE_INFO_SIZE 128
+#define RECORDING_DEVICE_INFO_NAME_SIZE 64
+
+// Video frames are stored as the difference from the previous one.
+// Every so often one is stored whole, so playback can seek.
+#define RECORDING_KEYFRAME_INTERVAL 60
+#define RECORDING_NUM_VIDEO_SLOTS 8
+#define RECORDING_NUM_AUDIO_SLOTS 32
+#define RECORDING_WRITE_BLOCK_SIZE (4 * 1024 * 1024)
+
+// The difference data is then Huffman coded, one byte per symbol.
+// The payload starts with the 4 bits code lengths of all the symbols,
+// then the size of the decoded data, then the codes.
+#define RECORDING_ENTROPY_NUM_SYMBOLS 256
+#define RECORDING_ENTROPY_MAX_CODE_LENGTH 12
+#define RECORDING_ENTROPY_HEADER_SIZE ((RECORDING_ENTROPY_NUM_SYMBOLS / 2) + 4)
+
+// When a recording is closed properly, it ends with an index of the
+// keyframes, followed by a trailer pointing to the index record.
+#define RECORDING_INDEX_ENTRY_SIZE 16
+#define RECORDING_FILE_TRAILER_MAGIC "CC3DSIDX"
+#define RECORDING_FILE_TRAILER_SIZE 16
+
+enum RecordingRecordType { RECORDING_RECORD_DEVICE_INFO, RECORDING_RECORD_VIDEO, RECORDING_RECORD_AUDIO, RECORDING_RECORD_INDEX };
+
+#define RECORDING_FLAG_KEYFRAME 1
+#define RECORDING_FLAG_COMPRESSED 2
+#define RECORDING_FLAG_ENTROPY_CODED 4
+
+// Video format is the InputVideoDataType, plus these
+#define RECORDING_VIDEO_FORMAT_3D 0x100
+#define RECORDING_VIDEO_FORMAT_INTERLEAVED_3D 0x200
+#define RECORDING_VIDEO_FORMAT_TYPE_MASK 0xFF
+
+struct RecordingRecordHeader {
+	RecordingRecordType type;
+	uint16_t flags;
+	uint16_t format;
+	uint32_t payload_size;
+	uint32_t raw_size;
+	uint64_t time_us;
+	uint64_t index;
+};
+
+struct RecordingIndexEntry {
+	uint64_t time_us;
+	uint64_t offset;
+};
+
+void write_recording_record_header(uint8_t* data, const RecordingRecordHeader &header);
+bool read_recording_record_header(const uint8_t* data, RecordingRecordHeader &header);
+void write_recording_device_info(uint8_t* data, const CaptureDevice &device);
+void read_recording_device_info(const uint8_t* data, CaptureDevice &device);
+size_t get_recording_video_raw_size(InputVideoDataType video_data_type);
+uint16_t get_recording_video_format(InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d);
+size_t get_recording_max_compressed_size(size_t raw_size);
+size_t encode_recording_delta(const uint8_t* curr, const uint8_t* prev, size_t size, uint8_t* out);
+bool decode_recording_delta(const uint8_t* in, size_t in_size, uint8_t* frame, size_t size);
+size_t encode_recording_entropy(const uint8_t* in, size_t size, uint8_t* out);
+bool decode_recording_entropy(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_max_size, size_t &out_size);
+void write_recording_index(uint8_t* data, const std::vector<RecordingIndexEntry> &index);
+void read_recording_index(const uint8_t* data, size_t size, std::vector<RecordingIndexEntry> &index);
+
+class FrameRecorder {
+public:
+	FrameRecorder();
+	~FrameRecorder();
+	bool start(std::string path, bool compress);
+	void stop();
+	bool is_recording();
+	void push_device_info(CaptureDevice* device);
+	void push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d);
+	void push_audio(std::int16_t* samples, uint64_t n_samples, AudioSampleRate sample_rate);
+	uint64_t get_num_dropped();
+
+private:
+	struct VideoSlot {
+		VideoOutputData* data;
+		InputVideoDataType video_data_type;
+		bool is_3d;
+		bool interleaved_3d;
+		uint64_t time_us;
+	};
+	struct AudioSlot {
+		std::int16_t* samples;
+		uint64_t n_samples;
+		AudioSampleRate sample_rate;
+		uint64_t time_us;
+	};
+
+	volatile bool running = false;
+	bool compress = true;
+	FILE* out_file = NULL;
+	std::mutex access_mutex;
+	std::condition_variable_any work_condition;
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+	bool has_device_info = false;
+	CaptureDevice device_info;
+	LockFreeQueue<VideoSlot, RECORDING_NUM_VIDEO_SLOTS + 1> video_queue;
+	LockFreeQueue<VideoOutputData*, RECORDING_NUM_VIDEO_SLOTS + 1> free_video_buffers;
+	LockFreeQueue<AudioSlot, RECORDING_NUM_AUDIO_SLOTS + 1> audio_queue;
+	LockFreeQueue<std::int16_t*, RECORDING_NUM_AUDIO_SLOTS + 1> free_audio_buffers;
+	VideoOutputData* video_buffers_memory = NULL;
+	std::int16_t* audio_buffers_memory = NULL;
+	std::thread io_thread_handle;
+	std::atomic<uint64_t> num_dropped = 0;
+
+	// Only touched by the I/O thread
+	uint8_t* prev_frame = NULL;
+	uint8_t* delta_buffer = NULL;
+	uint8_t* compressed_buffer = NULL;
+	uint8_t* write_block = NULL;
+	size_t write_block_pos = 0;
+	uint64_t file_pos = 0;
+	std::vector<RecordingIndexEntry> keyframes_index;
+	uint64_t video_index = 0;
+	uint64_t audio_index = 0;
+	int frames_since_keyframe = 0;
+	uint16_t last_video_format = 0;
+	bool write_failed = false;
+
+	uint64_t get_time_us();
+	void io_thread();
+	bool write_pending();
+	void write_video(VideoSlot &slot);
+	void write_audio(AudioSlot &slot);
+	void write_index();
+	uint64_t get_write_pos();
+	void write_record(RecordingRecordHeader &header, const uint8_t* payload);
+	void append_data(const uint8_t* data, size_t size);
+	void flush_write_block(bool is_final);
+	void free_memory();
+};
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef __FRAMESHAREDMEMORY_HPP
+#define __FRAMESHAREDMEMORY_HPP
+
+#include <string>
+#include <chrono>
+#include "utils.hpp"
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+
+// Lets other programs on the same machine read the converted frames.
+// The shared memory holds a header, then a ring of frame slots.
+// The sizes and sequence numbers are in the machine's endianness.
+// The device info and the frame format use the recordings' encoding.
+#define SHARED_MEMORY_MAGIC "CC3DSSHM"
+#define SHARED_MEMORY_MAGIC_SIZE 8
+#define SHARED_MEMORY_VERSION 1
+#define SHARED_MEMORY_HEADER_SIZE 4096
+#define SHARED_MEMORY_SLOT_HEADER_SIZE 64
+#define SHARED_MEMORY_SLOT_ALIGNMENT 4096
+#define SHARED_MEMORY_NUM_SLOTS 4
+#define SHARED_MEMORY_DEFAULT_NAME "cc3dsfs"
+
+// Header layout
+#define SHARED_MEMORY_VERSION_POS 8
+#define SHARED_MEMORY_HEADER_SIZE_POS 12
+#define SHARED_MEMORY_NUM_SLOTS_POS 16
+#define SHARED_MEMORY_SLOT_SIZE_POS 20
+#define SHARED_MEMORY_SLOT_HEADER_SIZE_POS 24
+// Sequence number of the last published frame. 0 means none.
+#define SHARED_MEMORY_LAST_SEQUENCE_POS 32
+// Odd while the device info is being updated
+#define SHARED_MEMORY_DEVICE_INFO_SEQUENCE_POS 40
+#define SHARED_MEMORY_DEVICE_INFO_POS 64
+
+// Slot header layout.
+// The sequence is 0 while the slot is being written to.
+// Readers should check it did not change after copying the data.
+#define SHARED_MEMORY_SLOT_SEQUENCE_POS 0
+#define SHARED_MEMORY_SLOT_FORMAT_POS 8
+#define SHARED_MEMORY_SLOT_DATA_SIZE_POS 12
+#define SHARED_MEMORY_SLOT_TIME_POS 16
+
+class FrameSharedMemory {
+public:
+	FrameSharedMemory();
+	~FrameSharedMemory();
+	bool start(std::string name);
+	void stop();
+	bool is_active();
+	void push_device_info(CaptureDevice* device);
+	void push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d);
+
+private:
+	bool active = false;
+	std::string name = "";
+	uint8_t* memory = NULL;
+	size_t memory_size = 0;
+	size_t slot_size = 0;
+	uint64_t sequence = 0;
+	uint64_t device_info_sequence = 0;
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+	#ifdef _WIN32
+	void* mapping_handle = NULL;
+	#endif
+
+	uint8_t* get_slot(uint64_t sequence);
+	bool map_memory();
+	void unmap_memory();
+};
+
+#endif
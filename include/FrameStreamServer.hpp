@@ -0,0 +1,89 @@
+#ifndef __FRAMESTREAMSERVER_HPP
+#define __FRAMESTREAMSERVER_HPP
+
+#include <string>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include "utils.hpp"
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+#include "FrameRecorder.hpp"
+
+// Streams the converted frames and the audio to local clients.
+// Clients get the same data a raw recording would hold,
+// so what they receive can be saved and played back as is.
+// Clients which are too slow lose their oldest queued frames.
+// The device info records are always kept.
+#define STREAM_SERVER_MAX_CLIENTS 8
+#define STREAM_SERVER_MAX_QUEUED_VIDEO 2
+#define STREAM_SERVER_MAX_QUEUED_PACKETS 64
+// Each client may hold its queued frames, plus the one it is sending.
+// One more is needed for the frame being filled.
+#define STREAM_SERVER_VIDEO_POOL_SIZE (STREAM_SERVER_MAX_QUEUED_VIDEO + 2)
+#define STREAM_SERVER_POLL_TIMEOUT_MS 10
+#define STREAM_SERVER_LISTEN_BACKLOG 4
+
+#ifdef _WIN32
+typedef uintptr_t StreamSocket;
+#else
+typedef int StreamSocket;
+#endif
+
+class FrameStreamServer {
+public:
+	FrameStreamServer();
+	~FrameStreamServer();
+	// A number is a TCP port on localhost, anything else the path of a Unix socket
+	bool start(std::string address);
+	void stop();
+	bool is_running();
+	bool has_clients();
+	void push_device_info(CaptureDevice* device);
+	void push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d);
+	void push_audio(std::int16_t* samples, uint64_t n_samples, AudioSampleRate sample_rate);
+
+private:
+	struct Packet {
+		std::vector<uint8_t> data;
+		bool is_video;
+		bool can_drop;
+	};
+	struct Client {
+		StreamSocket socket;
+		std::deque<std::shared_ptr<Packet>> queue;
+		size_t front_sent;
+		bool closed;
+	};
+
+	volatile bool running = false;
+	std::string unix_path = "";
+	StreamSocket listen_socket;
+	std::mutex access_mutex;
+	std::vector<Client*> clients;
+	// Lets the push functions skip all the work when nobody is listening
+	std::atomic<size_t> num_clients = 0;
+	std::shared_ptr<Packet> file_header_packet;
+	std::shared_ptr<Packet> device_info_packet;
+	std::vector<std::shared_ptr<Packet>> video_packet_pool;
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+	std::thread io_thread_handle;
+	std::atomic<uint64_t> num_dropped = 0;
+	uint64_t video_index = 0;
+	uint64_t audio_index = 0;
+
+	uint64_t get_time_us();
+	std::shared_ptr<Packet> get_video_packet();
+	std::shared_ptr<Packet> create_packet(RecordingRecordType type, uint16_t flags, uint16_t format, uint32_t payload_size, uint64_t index, bool is_video);
+	void io_thread();
+	void accept_clients();
+	void enqueue(Client* client, std::shared_ptr<Packet> &packet);
+	void flush_client(Client* client);
+	void send_to_clients(std::shared_ptr<Packet> &packet);
+	void remove_closed_clients();
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef __IDLESTATE_HPP
+#define __IDLESTATE_HPP
+
+#include <chrono>
+#include "utils.hpp"
+
+// With nothing connected and no input for a while, the program goes idle.
+// The main loop decides when that happens. The threads which wait for
+// something back off from that same moment, each with its own limits.
+#define IDLE_ENTER_TIME 5.0
+#define IDLE_REDRAW_PERIOD 0.5
+// In seconds. Not idle, both loops run as often as the USB checks.
+#define IDLE_MIN_WAIT (1.0 / USB_CHECKS_PER_SECOND)
+#define IDLE_MAIN_LOOP_MAX_WAIT 0.05
+#define IDLE_CAPTURE_MAX_WAIT 0.25
+
+// Lets the idle state run on a fake clock
+class IdleClock {
+public:
+	virtual ~IdleClock() {}
+	virtual double now() = 0;
+};
+
+class SteadyIdleClock : public IdleClock {
+public:
+	SteadyIdleClock();
+	double now();
+private:
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+};
+
+class IdleState {
+public:
+	IdleState(IdleClock* clock = NULL);
+	~IdleState();
+	void activity();
+	bool is_idle();
+	// While idle, only redraw every so often, for notifications and the like
+	bool should_draw();
+
+private:
+	IdleClock* clock;
+	bool owns_clock;
+	double last_activity_time;
+	double last_draw_time;
+};
+
+// Waits min_wait while not idle. Once idle, each wait doubles, up to max_wait.
+class IdleBackoff {
+public:
+	IdleBackoff(double min_wait, double max_wait);
+	double get_wait(bool is_idle);
+
+private:
+	double min_wait;
+	double max_wait;
+	double curr_wait;
+};
+
+// One pass of the main loop. Being connected, or reloading, is activity.
+// The idle state is published for the capture thread. Returns how long
+// to sleep for, in seconds, when there is nothing connected.
+double idle_main_loop_step(IdleState &idle_state, IdleBackoff &backoff, bool is_busy, volatile bool &published_idle);
+// One pass of the capture thread, with nothing connected.
+// Returns how long to wait for a connection, in seconds.
+double idle_capture_loop_step(IdleBackoff &backoff, volatile bool &published_idle);
+
+#endif
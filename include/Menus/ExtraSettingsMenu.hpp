@@ -17,13 +17,31 @@ enum ExtraSettingsMenuOutAction{
 	EXTRA_SETTINGS_MENU_USB_CONFLICT_RESOLUTION,
 	EXTRA_SETTINGS_MENU_RESET_SETTINGS,
 	EXTRA_SETTINGS_MENU_CHANGE_PERIODIC_CONNECTION_TRY,
+	EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_DEC,
+	EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_INC,
+	EXTRA_SETTINGS_MENU_CAPTURE_CPU_DEC,
+	EXTRA_SETTINGS_MENU_CAPTURE_CPU_INC,
+	EXTRA_SETTINGS_MENU_AUDIO_PRIORITY_DEC,
+	EXTRA_SETTINGS_MENU_AUDIO_PRIORITY_INC,
+	EXTRA_SETTINGS_MENU_AUDIO_CPU_DEC,
+	EXTRA_SETTINGS_MENU_AUDIO_CPU_INC,
+	EXTRA_SETTINGS_MENU_DISPLAY_PRIORITY_DEC,
+	EXTRA_SETTINGS_MENU_DISPLAY_PRIORITY_INC,
+	EXTRA_SETTINGS_MENU_DISPLAY_CPU_DEC,
+	EXTRA_SETTINGS_MENU_DISPLAY_CPU_INC,
+	EXTRA_SETTINGS_MENU_USB_EVENTS_PRIORITY_DEC,
+	EXTRA_SETTINGS_MENU_USB_EVENTS_PRIORITY_INC,
+	EXTRA_SETTINGS_MENU_USB_EVENTS_CPU_DEC,
+	EXTRA_SETTINGS_MENU_USB_EVENTS_CPU_INC,
 };
 
 class ExtraSettingsMenu : public OptionSelectionMenu {
 public:
 	ExtraSettingsMenu(TextRectanglePool* text_pool);
 	~ExtraSettingsMenu();
-	void prepare(float scaling_factor, int view_size_x, int view_size_y, bool periodic_connection_try);
+	void prepare(float scaling_factor, int view_size_x, int view_size_y, bool periodic_connection_try, const ThreadSchedulingSettings* thread_scheduling);
+	// Which thread and setting a thread scheduling action changes
+	static bool get_thread_scheduling_change(ExtraSettingsMenuOutAction action, ThreadSchedulingType &type, bool &is_cpu, bool &is_inc);
 	static int get_total_possible_selectable_inserted(ScreenType s_type, bool is_fullscreen, bool is_mono_app);
 	void insert_data(ScreenType s_type, bool is_fullscreen, bool is_mono_app);
 	ExtraSettingsMenuOutAction selected_index = ExtraSettingsMenuOutAction::EXTRA_SETTINGS_MENU_NO_ACTION;
@@ -31,6 +49,7 @@ public:
 protected:
 	void set_output_option(int index, int action);
 	bool is_option_selectable(int index, int action);
+	bool is_option_inc_dec(int index);
 	size_t get_num_options();
 	std::string get_string_option(int index, int action);
 	void class_setup();
@@ -18,7 +18,7 @@ class StatusMenu : public OptionSelectionMenu {
 public:
 	StatusMenu(TextRectanglePool* text_pool);
 	~StatusMenu();
-	void prepare(float scaling_factor, int view_size_x, int view_size_y, double in_fps, double poll_fps, double draw_fps, CaptureStatus* capture_status);
+	void prepare(float scaling_factor, int view_size_x, int view_size_y, const FrameTimeStats &in_stats, const FrameTimeStats &poll_stats, const FrameTimeStats &draw_stats, const PresentationMissStats &bfi_stats, CaptureStatus* capture_status);
 	void insert_data();
 	StatusMenuOutAction selected_index = StatusMenuOutAction::STATUS_MENU_NO_ACTION;
 	void reset_output_option();
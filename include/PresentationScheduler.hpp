@@ -0,0 +1,61 @@
+#ifndef __PRESENTATIONSCHEDULER_HPP
+#define __PRESENTATIONSCHEDULER_HPP
+
+#include <chrono>
+#include "utils.hpp"
+#include "display_structs.hpp"
+
+// Waits for absolute deadlines, counted from the start of the frame.
+// Sleeps until a bit before each deadline, then spins for the rest,
+// so the sleep's inaccuracy does not add up between sub-frames.
+// The misses are measured once a sub-frame was handed to the display,
+// not when the wait ends, so slow draws and blocking swaps count, too.
+#define PRESENTATION_SPIN_TIME 0.002
+#define PRESENTATION_MISS_LOG_SIZE 256
+
+// Lets the scheduler run on a fake clock
+class PresentationClock {
+public:
+	virtual ~PresentationClock() {}
+	virtual double now() = 0;
+	virtual void sleep(double seconds) = 0;
+};
+
+class SteadyPresentationClock : public PresentationClock {
+public:
+	SteadyPresentationClock();
+	double now();
+	void sleep(double seconds);
+private:
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+};
+
+class PresentationScheduler {
+public:
+	PresentationScheduler(PresentationClock* clock = NULL);
+	~PresentationScheduler();
+	// slot_time is how long each sub-frame has. Sub-frames shown
+	// later than that after their deadline are counted as late.
+	void start_frame(double slot_time);
+	// Returns how late it woke up, in seconds
+	double wait_until(double offset);
+	// Call after display(). Returns how long after the deadline it was shown.
+	double presented();
+	PresentationMissStats get_stats();
+
+private:
+	PresentationClock* clock;
+	bool owns_clock;
+	double base_time = 0.0;
+	double slot_time = 0.0;
+	double curr_deadline = 0.0;
+	// How far every recent sub-frame missed its deadline
+	double miss_log[PRESENTATION_MISS_LOG_SIZE];
+	size_t miss_log_pos = 0;
+	size_t miss_log_size = 0;
+	SeqLockValue<PresentationMissStats> stats;
+
+	void log_miss(double miss);
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef __SHADERSLOADING_HPP
+#define __SHADERSLOADING_HPP
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include "shaders_list.hpp"
+
+struct shader_and_data {
+	shader_and_data(shader_list_enum value) : shader(sf::Shader()), is_valid(false), shader_enum(value) {}
+
+	sf::Shader shader;
+	bool is_valid;
+	shader_list_enum shader_enum;
+};
+
+// One entry per shader in the list, not compiled yet
+void prepare_shaders(std::vector<shader_and_data> &shaders);
+void compile_shaders(std::vector<shader_and_data> &shaders);
+
+// The shaders are shared by all the windows. They are compiled, and drawn
+// with once so the driver finishes preparing them, in a separate thread.
+// Whatever needs them first waits for that to be done. The warm-up of the
+// shaders which are left is skipped then, so that the first frame is not
+// later than if the shaders had been compiled right away.
+class ShadersLoading {
+public:
+	void start(std::vector<shader_and_data>* shaders);
+	void wait();
+	double get_compile_time();
+	double get_warm_up_time();
+	int get_num_warmed_up();
+	std::chrono::time_point<std::chrono::steady_clock> get_done_time();
+
+private:
+	std::vector<shader_and_data>* shaders = NULL;
+	std::thread loading_thread;
+	std::atomic<bool> loading = false;
+	std::atomic<bool> stop_warm_up = false;
+	std::mutex loading_mutex;
+	int num_warmed_up = 0;
+	std::chrono::time_point<std::chrono::steady_clock> start_time;
+	std::chrono::time_point<std::chrono::steady_clock> compiled_time;
+	std::chrono::time_point<std::chrono::steady_clock> done_time;
+
+	void loading_thread_function();
+};
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef __THREADSCHEDULING_HPP
+#define __THREADSCHEDULING_HPP
+
+#include <string>
+#include "display_structs.hpp"
+
+// Priority and CPU affinity of the latency sensitive threads.
+// Realtime uses SCHED_RR where the process is allowed to, and falls back
+// to High (a lower nice value) and then to Default when it is not.
+#define THREAD_SCHEDULING_ANY_CPU (-1)
+#define THREAD_SCHEDULING_HIGH_NICE_DELTA (-10)
+
+// Call once from the main thread, before any other thread starts
+void init_thread_scheduling();
+void register_current_thread_scheduling(ThreadSchedulingType type);
+void unregister_current_thread_scheduling();
+void set_thread_scheduling_settings(const ThreadSchedulingSettings* settings);
+void reset_thread_scheduling_settings(ThreadSchedulingSettings* settings);
+void sanitize_thread_scheduling_settings(ThreadSchedulingSettings* settings);
+int get_num_thread_scheduling_cpus();
+// What the running threads actually got, which may be less than what was asked
+ThreadPriorityClass get_applied_thread_priority_class(ThreadSchedulingType type);
+bool is_thread_affinity_applied(ThreadSchedulingType type);
+std::string get_thread_scheduling_type_name(ThreadSchedulingType type);
+std::string get_thread_scheduling_cfg_name(ThreadSchedulingType type);
+std::string get_thread_priority_class_name(ThreadPriorityClass priority_class);
+
+#endif
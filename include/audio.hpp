@@ -2,22 +2,25 @@
 #define __AUDIO_HPP
 
 #include <SFML/Audio.hpp>
-#include <queue>
+#include <atomic>
 #include "audio_data.hpp"
+#include "hw_defs.hpp"
 #include "utils.hpp"
 
-struct Sample {
-	Sample(int16_t *bytes, uint64_t size, double time) : bytes(bytes), size(size), time(time) {}
-
-	int16_t *bytes;
+// Chunks never wrap around the ring, so the ones queued back to back
+// can be handed to SFML as they are.
+struct AudioChunk {
+	uint64_t start_pos;
 	uint64_t size;
 	double time;
 };
 
+#define AUDIO_RING_NUM_CHUNKS ((MAX_MAX_AUDIO_LATENCY * 2) + 2)
+#define AUDIO_RING_SIZE (MAX_SAMPLES_IN * AUDIO_RING_NUM_CHUNKS)
+
 class Audio : public sf::SoundStream {
 public:
 	volatile bool restart = false;
-	std::queue<Sample> samples;
 	ConsumerMutex samples_wait;
 
 	Audio(AudioData *audio_data);
@@ -28,6 +31,9 @@ public:
 	AudioSampleRate get_current_sample_rate();
 	void change_sample_rate(AudioSampleRate target);
 	bool hasTooMuchTimeElapsed();
+	std::int16_t* get_free_chunk();
+	void push_chunk(uint64_t n_samples, double time);
+	size_t get_num_queued_chunks();
 
 private:
 	AudioData *audio_data;
@@ -36,6 +42,9 @@ private:
 	volatile bool terminate = false;
 	int num_consecutive_fast_seek;
 	std::int16_t *buffer;
+	LockFreeQueue<AudioChunk, MAX_MAX_AUDIO_LATENCY + 2> chunks;
+	uint64_t write_pos = 0;
+	std::atomic<uint64_t> release_pos = 0;
 	std::chrono::time_point<std::chrono::high_resolution_clock> clock_time_start;
 	std::chrono::time_point<std::chrono::high_resolution_clock> inside_clock_time_start;
 	AudioSampleRate current_sample_rate = SAMPLE_RATE_INVALID;
@@ -4,6 +4,7 @@
 #include "utils.hpp"
 #include "hw_defs.hpp"
 #include <mutex>
+#include <atomic>
 #include <string>
 #include "audio_data.hpp"
 
@@ -24,7 +25,7 @@
 
 #define OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE 0x200
 
-enum CaptureConnectionType { CAPTURE_CONN_FTD3, CAPTURE_CONN_USB, CAPTURE_CONN_FTD2, CAPTURE_CONN_IS_NITRO, CAPTURE_CONN_CYPRESS_NISETRO, CAPTURE_CONN_CYPRESS_OPTIMIZE, CAPTURE_CONN_PARTNER_CTR };
+enum CaptureConnectionType { CAPTURE_CONN_FTD3, CAPTURE_CONN_USB, CAPTURE_CONN_FTD2, CAPTURE_CONN_IS_NITRO, CAPTURE_CONN_CYPRESS_NISETRO, CAPTURE_CONN_CYPRESS_OPTIMIZE, CAPTURE_CONN_PARTNER_CTR, CAPTURE_CONN_PLAYBACK };
 enum InputVideoDataType { VIDEO_DATA_RGB, VIDEO_DATA_BGR, VIDEO_DATA_RGB16, VIDEO_DATA_BGR16 };
 enum CaptureScreensType { CAPTURE_SCREENS_BOTH, CAPTURE_SCREENS_TOP, CAPTURE_SCREENS_BOTTOM, CAPTURE_SCREENS_ENUM_END };
 enum CaptureSpeedsType { CAPTURE_SPEEDS_FULL, CAPTURE_SPEEDS_HALF, CAPTURE_SPEEDS_THIRD, CAPTURE_SPEEDS_QUARTER, CAPTURE_SPEEDS_ENUM_END };
@@ -38,6 +39,13 @@ enum CaptureReaderType { CAPTURE_READER_VIDEO, CAPTURE_READER_AUDIO, CAPTURE_REA
 #define NUM_CONCURRENT_DATA_BUFFER_WRITERS 5
 #define NUM_CONCURRENT_DATA_BUFFER_READERS ((int)CAPTURE_READER_ENUM_END)
 #define NUM_CONCURRENT_DATA_BUFFERS (NUM_CONCURRENT_DATA_BUFFER_READERS + 1 + NUM_CONCURRENT_DATA_BUFFER_WRITERS)
+// More buffers can be requested, to have more headroom with slow readers
+#define MAX_CONCURRENT_DATA_BUFFERS 16
+#define DATA_BUFFER_SLOT_ALIGNMENT 4096
+
+// Requested number of USB transfers kept in flight. 0 is auto.
+#define AUTO_TRANSFERS_IN_FLIGHT 0
+#define MIN_TRANSFERS_IN_FLIGHT 2
 
 #pragma pack(push, 1)
 
@@ -453,6 +461,40 @@ struct CaptureStatusDeviceSpecific {
 	CaptureStatusPartnerCTR partner_ctr_status;
 };
 
+// How many transfers a backend should keep in flight.
+// In auto mode, more are used when frames arrive late, and then fewer
+// again after a while without issues, to keep the latency low.
+// Only the FTD3 (libusb), FTD2 (libusb), IS and Nisetro backends use it.
+// The Optimize and Partner CTR rings are sized in bytes, not in frames.
+class TransfersInFlight {
+public:
+	TransfersInFlight();
+	void set_requested(int requested);
+	int get_requested();
+	void set_device_profile(int device_requested, int auto_start);
+	bool get_device_profile(int &device_requested, int &auto_start);
+	void reset(int max_in_flight);
+	int get();
+	void frame_done(double frame_time);
+private:
+	std::atomic<int> requested;
+	std::atomic<int> device_requested;
+	std::atomic<int> curr;
+	int auto_start;
+	bool is_used;
+	int max_in_flight;
+	double average_frame_time;
+	int num_frames;
+	int on_time_frames;
+};
+
+// What the other threads need to know about the capture, once per frame
+struct CaptureStatusSnapshot {
+	bool connected;
+	int cooldown_curr_in;
+	bool enabled_3d;
+};
+
 struct CaptureStatus {
 	CaptureDevice device;
 	std::string graphical_error_text;
@@ -463,29 +505,103 @@ struct CaptureStatus {
 	volatile bool connected = false;
 	volatile bool running = true;
 	volatile bool close_success = true;
+	// Set by the main loop, for the threads which back off while idle
+	volatile bool idle = false;
 	bool requested_3d = false;
 	CaptureStatusDeviceSpecific device_specific_status;
+	TransfersInFlight transfers_in_flight;
+	SeqLockValue<CaptureStatusSnapshot> snapshot;
 	// Needed for possible compatibility issues
 	bool devices_allowed_scan[CC_POSSIBLE_DEVICES_END];
 	ConsumerMutex video_wait;
 	ConsumerMutex audio_wait;
+	// Wakes up the idle capture thread once a device is connected
+	ConsumerMutex connection_wait;
 };
 
 struct CaptureDataSingleBuffer {
 	CaptureScreensType capture_type;
 	uint64_t read;
 	size_t unused_offset;
-	CaptureReceived capture_buf;
+	CaptureReceived* capture_buf;
+	// Recovered from the device clock. Use it for pacing and audio.
 	double time_in_buf;
+	// As measured by the backend. Use it for the input FPS statistics.
+	double raw_time_in_buf;
+	// Set by the backends which get a frame counter from the device
+	bool has_device_frame_counter;
+	uint32_t device_frame_counter;
 	uint32_t inner_index;
 	bool is_3d;
 	bool should_be_3d;
 	InputVideoDataType buffer_video_data_type;
 };
 
+// Used by both FrameClockRecovery and FramePeriodEstimator
+bool fit_frame_period(const double* frame_indexes, const double* times, int window_size, int curr_pos, int num_samples, double &out_period);
+
+#define FRAME_CLOCK_WINDOW_SIZE 120
+#define FRAME_CLOCK_MIN_SAMPLES 16
+// Bigger jumps mean the source stopped. Start from scratch
+#define FRAME_CLOCK_MAX_FRAMES_JUMP 8
+
+// Fits a line over the arrival times of the last frames, to remove
+// the host scheduling jitter and track the real frame period.
+class FrameClockRecovery {
+public:
+	FrameClockRecovery();
+	void reset();
+	double update(double host_frame_time, bool has_device_frame_counter, uint32_t device_frame_counter);
+private:
+	double arrival_times[FRAME_CLOCK_WINDOW_SIZE];
+	double frame_indexes[FRAME_CLOCK_WINDOW_SIZE];
+	int num_samples;
+	int curr_pos;
+	double curr_arrival_time;
+	double curr_frame_index;
+	double period;
+	bool has_last_device_frame_counter;
+	uint32_t last_device_frame_counter;
+};
+
+#define FRAME_PERIOD_WINDOW_SIZE 64
+#define FRAME_PERIOD_MIN_FRAMES 4
+// Reads further apart than this don't say when the counter changed.
+// Once the period is known, half of it is used instead.
+#define FRAME_PERIOD_MAX_READ_GAP 0.008
+
+// Tracks the period of a device's frame counter, from the reads of it.
+// Each change is placed between the read which saw it and the one before.
+// The period comes from many frames, so the error of each read gets spread.
+class FramePeriodEstimator {
+public:
+	FramePeriodEstimator(uint32_t counter_mask = 0xFF);
+	void reset();
+	void add_read(double time, uint32_t counter);
+	bool has_period();
+	double get_period();
+private:
+	uint32_t counter_mask;
+	double change_times[FRAME_PERIOD_WINDOW_SIZE];
+	double frame_indexes[FRAME_PERIOD_WINDOW_SIZE];
+	int num_samples;
+	int curr_pos;
+	bool has_last_read;
+	double last_read_time;
+	uint32_t last_counter;
+	double curr_frame_index;
+	double period;
+
+	void update_period();
+};
+
 class CaptureDataBuffers {
 public:
 	CaptureDataBuffers();
+	~CaptureDataBuffers();
+	void SetNumBuffers(int num_buffers);
+	bool AllocateBuffers(size_t slot_size);
+	size_t GetSlotSize();
 	CaptureDataSingleBuffer* GetReaderBuffer(CaptureReaderType reader_type);
 	void ReleaseReaderBuffer(CaptureReaderType reader_type);
 	void WriteToBuffer(CaptureReceived* buffer, uint64_t read, double time_in_buf, CaptureDevice* device, CaptureScreensType capture_type, size_t offset, int index, bool is_3d = false, bool should_be_3d = false);
@@ -499,10 +615,18 @@ private:
 	int last_curr_in;
 	int curr_writer_pos[NUM_CONCURRENT_DATA_BUFFER_WRITERS];
 	int curr_reader_pos[NUM_CONCURRENT_DATA_BUFFER_READERS];
-	bool is_being_written_to[NUM_CONCURRENT_DATA_BUFFERS];
-	int num_readers[NUM_CONCURRENT_DATA_BUFFERS];
-	bool has_read_data[NUM_CONCURRENT_DATA_BUFFERS][NUM_CONCURRENT_DATA_BUFFER_READERS];
-	CaptureDataSingleBuffer buffers[NUM_CONCURRENT_DATA_BUFFERS];
+	bool is_being_written_to[MAX_CONCURRENT_DATA_BUFFERS];
+	int num_readers[MAX_CONCURRENT_DATA_BUFFERS];
+	bool has_read_data[MAX_CONCURRENT_DATA_BUFFERS][NUM_CONCURRENT_DATA_BUFFER_READERS];
+	CaptureDataSingleBuffer buffers[MAX_CONCURRENT_DATA_BUFFERS];
+	int requested_num_buffers;
+	int num_buffers;
+	// Single allocation, split in num_buffers slots of slot_size bytes
+	uint8_t* arena;
+	size_t arena_size;
+	size_t slot_size;
+	FrameClockRecovery frame_clock;
+	void FreeArena();
 };
 
 struct CaptureData {
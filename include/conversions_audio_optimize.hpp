@@ -0,0 +1,38 @@
+#ifndef __CONVERSIONS_AUDIO_OPTIMIZE_HPP
+#define __CONVERSIONS_AUDIO_OPTIMIZE_HPP
+
+#include "capture_structs.hpp"
+
+static inline bool usb_OptimizeHasExtraHeaderSoundData(USB3DSOptimizeHeaderSoundData* header_sound_data) {
+	// The macos compiler requires this... :/
+	uint16_t base_data = read_le16((uint8_t*)&header_sound_data->header_info.column_info);
+	USB3DSOptimizeColumnInfo column_info;
+	column_info.has_extra_header_data_2d_only = (base_data >> 15) & 1;
+	return column_info.has_extra_header_data_2d_only;
+}
+
+static inline USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3D(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888) {
+		int target_column = column / 2;
+		if((column % 2) == 0)
+			return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].top_r_screen_column.header_sound;
+		return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].bot_top_l_screens_column.header_sound;
+	}
+	return &buffer->cypress_optimize_received_888_3d.columns_data[column / 2][column % 2].header_sound;
+}
+
+static inline std::int16_t mix_audio_samples_mono(std::int16_t sample_l, std::int16_t sample_r) {
+	int sum = ((int)sample_l) + sample_r;
+	// >> is apparently implementation-dependent. Do it like this...
+	int sign_mult = 1;
+	if(sum < 0)
+		sign_mult = -1;
+	int abs_sum = sum * sign_mult;
+	if(abs_sum >= 32768)
+		abs_sum += 1;
+	return sign_mult * (abs_sum / 2);
+}
+
+void copyAudioOptimize3DSToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888, bool is_data_3d, bool is_forced_2d, bool force_check_extra_header, bool is_mono);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef __CONVERSIONS_VIDEO_IS_TWL_HPP
+#define __CONVERSIONS_VIDEO_IS_TWL_HPP
+
+#include "capture_structs.hpp"
+#include "display_structs.hpp"
+
+// Joins the 16 bit pixels and the extra red and blue bits into RGB888.
+// The bottom screen goes first in the output.
+void convertISTWLVideoToOutput(ISTWLCaptureVideoInputData* data, VideoOutputDataRGB* p_out);
+
+#endif
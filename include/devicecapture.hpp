@@ -20,6 +20,8 @@ void capture_init();
 void capture_close();
 
 bool connect(bool print_failed, CaptureData* capture_data, FrontendData* frontend_data, bool* force_cc_disables, bool auto_connect_to_first = false);
+void start_background_device_listing(CaptureData* capture_data, bool* force_cc_disables);
+bool is_background_device_listing_done();
 void captureCall(CaptureData* capture_data);
 void capture_error_print(bool print_failed, CaptureData* capture_data, std::string error_string);
 void capture_error_print(bool print_failed, CaptureData* capture_data, std::string graphical_string, std::string detailed_string);
@@ -45,4 +47,7 @@ void sanitize_capture_optimize_old_fw_config(CaptureOptimizeOldFirmwareConfig* c
 void setup_reconnection_device(void* info);
 bool wait_reconnection_device(void* info);
 void end_reconnection_device(void* info);
+bool get_device_list_change_id(uint64_t* change_id);
+void publish_capture_status_snapshot(CaptureStatus* capture_status);
+CaptureStatusSnapshot get_capture_status_snapshot(CaptureStatus* capture_status);
 #endif
@@ -94,6 +94,23 @@ struct DisplayData {
 	bool do_ratio_cycling;
 };
 
+struct FrameTimeStats {
+	double fps;
+	double p50_time;
+	double p95_time;
+	double p99_time;
+	double max_time;
+	uint32_t dropped_frames;
+};
+
+struct PresentationMissStats {
+	double last_miss;
+	double avg_miss;
+	double max_miss;
+	uint32_t num_late;
+	uint32_t num_deadlines;
+};
+
 struct ExtraButtonShortcuts {
 	const WindowCommand *enter_shortcut;
 	const WindowCommand *page_up_shortcut;
@@ -108,8 +125,18 @@ struct InputData {
 	ExtraButtonShortcuts extra_button_shortcuts;
 };
 
+enum ThreadSchedulingType { THREAD_SCHEDULING_CAPTURE, THREAD_SCHEDULING_AUDIO, THREAD_SCHEDULING_DISPLAY, THREAD_SCHEDULING_USB_EVENTS, THREAD_SCHEDULING_TYPE_END };
+enum ThreadPriorityClass { THREAD_PRIORITY_CLASS_DEFAULT, THREAD_PRIORITY_CLASS_HIGH, THREAD_PRIORITY_CLASS_REALTIME, THREAD_PRIORITY_CLASS_END };
+
+struct ThreadSchedulingSettings {
+	ThreadPriorityClass priority_class;
+	// Negative means any CPU
+	int cpu;
+};
+
 struct SharedData {
 	InputData input_data;
+	ThreadSchedulingSettings thread_scheduling[THREAD_SCHEDULING_TYPE_END];
 	volatile bool periodic_connection_try = false;
 };
 
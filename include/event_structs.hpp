@@ -17,6 +17,7 @@ struct SFEvent {
 	SFEvent(bool pressed, sf::Mouse::Button mouse_button, sf::Vector2i mouse_position) : type(pressed ? EVENT_MOUSE_BTN_PRESSED : EVENT_MOUSE_BTN_RELEASED), mouse_button(mouse_button), mouse_x(mouse_position.x), mouse_y(mouse_position.y) {}
 	SFEvent(sf::Vector2i mouse_position) : type(EVENT_MOUSE_MOVED), mouse_x(mouse_position.x), mouse_y(mouse_position.y) {}
 	SFEvent(EventType type) : type(type) {}
+	SFEvent() : type(EVENT_NONE) {}
 
 	EventType type;
 	sf::Keyboard::Key code;
@@ -40,9 +41,13 @@ void joystick_axis_poll(std::queue<SFEvent> &events_queue);
 void joystick_print_all(bool start);
 JoystickDirection get_joystick_direction(uint32_t joystickId, sf::Joystick::Axis axis, float position);
 JoystickAction get_joystick_action(uint32_t joystickId, uint32_t joy_button);
-void init_extra_buttons_poll(int page_up_id, int page_down_id, int enter_id, int power_id, bool use_pud_up);
+void init_extra_buttons_poll(int page_up_id, int page_down_id, int enter_id, int power_id, bool use_pud_up, bool use_events);
 void end_extra_buttons_poll();
 void extra_buttons_poll(std::queue<SFEvent> &events_queue);
+void extra_buttons_flush();
+void extra_buttons_thread_poll();
+void extra_buttons_thread_wait(int poll_period_ms);
+void extra_buttons_thread_wake();
 std::string get_extra_button_name(sf::Keyboard::Key corresponding_key);
 bool are_extra_buttons_usable();
 
@@ -45,8 +45,10 @@
 #include "OptimizeSerialKeyAddMenu.hpp"
 #include "OptimizeOldFWConfigMenu.hpp"
 #include "display_structs.hpp"
+#include "ConfigParsing.hpp"
 #include "event_structs.hpp"
 #include "shaders_list.hpp"
+#include "PresentationScheduler.hpp"
 
 // SFML currently does not have a define for the maximum amount of fingers...
 // Make one to "fix this", though it will need code to reject extra
@@ -58,9 +60,16 @@ struct HeldTime {
 	bool started;
 };
 
-struct FPSArray {
-	double *data;
-	int index;
+// Two halves, so old data gets replaced without a sudden reset
+struct FrameTimeHistogram {
+	uint32_t *buckets[2];
+	uint32_t num_samples[2];
+	uint32_t num_empty_samples[2];
+	double rate_sum[2];
+	double max_time[2];
+	uint32_t dropped_frames[2];
+	int curr_half;
+	double reference_time;
 };
 
 struct OutTextData {
@@ -81,12 +90,13 @@ public:
 	void build();
 	void reload();
 	void poll(bool do_everything = true);
+	bool has_polled_events();
 	void close();
 	void display_call(bool is_main_thread);
 	void display_thread();
 	void end();
 	void after_thread_join();
-	void draw(double frame_time, VideoOutputData* out_buf, InputVideoDataType video_data_type, bool update_rendered_buffer);
+	void draw(double frame_time, double raw_frame_time, VideoOutputData* out_buf, InputVideoDataType video_data_type, bool update_rendered_buffer);
 	void setup_connection_menu(std::vector<CaptureDevice> *devices_list, bool reset_data = true);
 	void setup_reconnection_menu(bool reset_data = true);
 	int check_connection_menu_result();
@@ -110,6 +120,7 @@ public:
 private:
 	enum PossibleShaderTypes { BASE_INPUT_SHADER_TYPE, BASE_FINAL_OUTPUT_SHADER_TYPE, COLOR_PROCESSING_SHADER_TYPE };
 	enum PossibleSoftwareConvTypes { NO_SOFTWARE_CONV, TO_RGB_SOFTWARE_CONV, TO_RGBA_SOFTWARE_CONV };
+	enum DirtyScreenRegion { TOP_DIRTY_REGION, TOP_SECOND_DIRTY_REGION, BOTTOM_DIRTY_REGION, NUM_DIRTY_REGIONS };
 	struct ScreenOperations {
 		bool call_create;
 		bool call_close;
@@ -128,6 +139,44 @@ private:
 		const PARData *par;
 		bool divide_3d_par;
 	};
+	struct TextureUpdateRegion {
+		sf::Texture* target_texture;
+		size_t pos_x_data;
+		size_t pos_y_data;
+		size_t pos_x_conv;
+		size_t pos_y_conv;
+		size_t full_width;
+		size_t full_height;
+		size_t width;
+		size_t height;
+	};
+	struct DirtyRegionData {
+		bool is_valid;
+		bool is_dirty;
+		uint64_t hash;
+		size_t pos_y_data;
+		size_t width;
+		size_t height;
+		InputVideoDataType video_data_type;
+		int num_same_frames;
+		uint32_t generation;
+	};
+	struct ProcessedScreenData {
+		bool is_valid;
+		uint64_t generation;
+		sf::IntRect in_texture_rect;
+		sf::IntRect out_texture_rect;
+		sf::Vector2f in_size;
+		sf::Vector2f in_position;
+		sf::Angle in_rotation;
+		sf::Vector2f in_scale;
+		bool actually_draw;
+		bool is_blurred;
+		int base_shader;
+		int color_correction;
+		sf::RenderTexture* result_tex;
+		sf::RenderTexture* result_backup_tex;
+	};
 	OutTextData own_out_text_data;
 	InputVideoDataType curr_video_data_type;
 	InputVideoDataType last_update_texture_data_type;
@@ -146,6 +195,7 @@ private:
 	bool last_connected_status;
 	int last_title_check_id;
 	bool last_enabled_3d;
+	CaptureStatusSnapshot loaded_capture_status;
 	bool last_interleaved_3d;
 	bool m_prepare_open;
 	bool m_prepare_quit;
@@ -228,10 +278,11 @@ private:
 	std::vector<bool> possible_buttons_extras;
 	int chosen_button;
 	std::vector<const WindowCommand*> possible_actions;
-	FPSArray in_fps;
-	FPSArray draw_fps;
+	FrameTimeHistogram in_fps;
+	FrameTimeHistogram draw_fps;
+	PresentationScheduler bfi_scheduler;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_draw_time;
-	FPSArray poll_fps;
+	FrameTimeHistogram poll_fps;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_poll_time;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_menu_change_time;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_data_format_change_time;
@@ -253,8 +304,12 @@ private:
 	volatile bool is_thread_done;
 
 	bool was_last_frame_null;
+	bool was_open_last_poll;
+	bool polled_events;
 	sf::RectangleShape m_in_rect_top, m_in_rect_bot, m_in_rect_top_right;
 	out_rect_data m_out_rect_top, m_out_rect_bot, m_out_rect_top_right;
+	DirtyRegionData dirty_regions[NUM_DIRTY_REGIONS];
+	ProcessedScreenData processed_top, processed_bot, processed_top_right;
 	ScreenType m_stype;
 
 	const ShaderColorEmulationData* sent_shader_color_data;
@@ -301,6 +356,7 @@ private:
 	void vsync_change();
 	void blur_change();
 	void fast_poll_change();
+	void thread_scheduling_change(ThreadSchedulingType type, bool is_cpu, bool positive);
 	void padding_change();
 	void game_crop_enable_change();
 	void request_3d_change();
@@ -357,7 +413,13 @@ private:
 	void opengl_error_out(std::string error_base, std::string error_str);
 	void opengl_error_check(std::string error_base);
 	bool single_update_texture(unsigned int m_texture, InputVideoDataType video_data_type, size_t pos_x_data, size_t pos_y_data, size_t width, size_t height, bool manually_converted);
+	TextureUpdateRegion get_texture_update_region(bool do_full, bool is_top = false, bool is_second = false);
 	void execute_single_update_texture(bool &manually_converted, bool do_full, bool is_top = false, bool is_second = false);
+	void reset_dirty_regions();
+	bool check_dirty_region(DirtyScreenRegion region, bool is_top, bool is_second);
+	bool is_dirty_region_static(DirtyScreenRegion region);
+	bool is_screen_static(bool is_top);
+	uint64_t get_screen_generation(bool is_top);
 	void update_texture();
 	int _choose_base_input_shader(bool is_top);
 	int _choose_color_emulation_shader(bool is_top);
@@ -366,7 +428,7 @@ private:
 	void apply_shader_to_texture(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, PossibleShaderTypes shader_type, bool is_top);
 	bool apply_shaders_to_input(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, const sf::RectangleShape &final_in_rect, bool is_top);
 	void pre_texture_conversion_processing();
-	void post_texture_conversion_processing(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, const sf::RectangleShape &in_rect, bool actually_draw, bool is_top, bool is_debug);
+	void post_texture_conversion_processing(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, const sf::RectangleShape &in_rect, bool actually_draw, bool is_top, bool is_debug, ProcessedScreenData &processed_data);
 	void draw_rect_to_window(const sf::RectangleShape &out_rect, bool is_top);
 	void window_bg_processing();
 	void display_data_to_window(bool actually_draw, bool is_debug = false);
@@ -453,9 +515,10 @@ struct FrontendData {
 void ConsumeOutText(OutTextData &out_text_data, bool update_consumed = true);
 void UpdateOutText(OutTextData &out_text_data, std::string full_text, std::string small_text, TextKind kind);
 
-void FPSArrayInit(FPSArray *array);
-void FPSArrayDestroy(FPSArray *array);
-void FPSArrayInsertElement(FPSArray *array, double frame_time);
+void FrameTimeHistogramInit(FrameTimeHistogram *histogram);
+void FrameTimeHistogramDestroy(FrameTimeHistogram *histogram);
+void FrameTimeHistogramInsertElement(FrameTimeHistogram *histogram, double frame_time);
+FrameTimeStats FrameTimeHistogramGetStats(FrameTimeHistogram *histogram);
 
 void insert_basic_crops(std::vector<const CropData*> &crop_vector, ScreenType s_type, bool is_ds, bool allow_game_specific);
 void insert_basic_pars(std::vector<const PARData*> &par_vector);
@@ -469,8 +532,6 @@ void reset_fullscreen_info(ScreenInfo &info);
 void sanitize_enabled_info(ScreenInfo &top_bot_info, ScreenInfo &top_info, ScreenInfo &bot_info);
 void override_set_data_to_screen_info(override_win_data &override_win, ScreenInfo &info);
 void reset_screen_info(ScreenInfo &info);
-bool load_screen_info(std::string key, std::string value, std::string base, ScreenInfo &info);
-std::string save_screen_info(std::string base, const ScreenInfo &info);
 
 const PARData* get_base_par();
 void get_par_size(int &width, int &height, float multiplier_factor, const PARData *correction_factor, bool divide_3d_par);
@@ -479,7 +540,7 @@ void get_par_size(float &width, float &height, float multiplier_factor, const PA
 SecondScreen3DRelativePosition get_second_screen_pos(ScreenInfo* info, ScreenType stype);
 
 bool should_do_output(FrontendData* frontend_data);
-void update_output(FrontendData* frontend_data, double frame_time = 0.0, VideoOutputData *out_buf = NULL, InputVideoDataType video_data_type = VIDEO_DATA_RGB, bool update_rendered_buffer = true);
+void update_output(FrontendData* frontend_data, double frame_time = 0.0, double raw_frame_time = 0.0, VideoOutputData *out_buf = NULL, InputVideoDataType video_data_type = VIDEO_DATA_RGB, bool update_rendered_buffer = true);
 void update_connected_3ds_ds(FrontendData* frontend_data, const CaptureDevice &old_cc_device, const CaptureDevice &new_cc_device);
 void update_connected_specific_settings(FrontendData* frontend_data, const CaptureDevice &cc_device);
 
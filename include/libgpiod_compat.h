@@ -13,21 +13,35 @@
 
 #ifdef LIBGPIOD3
 
+#include <time.h>
+
 #define GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP GPIOD_LINE_BIAS_PULL_UP
 #define GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN GPIOD_LINE_BIAS_PULL_DOWN
+#define GPIOD_LINE_EVENT_RISING_EDGE GPIOD_EDGE_EVENT_RISING_EDGE
+#define GPIOD_LINE_EVENT_FALLING_EDGE GPIOD_EDGE_EVENT_FALLING_EDGE
 
 // Extra struct needed due to how libgpiod3 is written... :/
 struct gpiod_line {
 	struct gpiod_line_request* request;
 	struct gpiod_chip* chip;
+	struct gpiod_edge_event_buffer* event_buffer;
 	int offset;
 };
 
+struct gpiod_line_event {
+	struct timespec ts;
+	int event_type;
+};
+
 struct gpiod_line* gpiod_line_find(const char *line_name);
 void gpiod_line_close_chip(struct gpiod_line* in);
 void gpiod_line_release(struct gpiod_line* in);
-void gpiod_line_request_input_flags(struct gpiod_line* in, const char *consumer, gpiod_line_bias);
+int gpiod_line_request_input_flags(struct gpiod_line* in, const char *consumer, gpiod_line_bias);
+int gpiod_line_request_both_edges_events_flags(struct gpiod_line* in, const char *consumer, gpiod_line_bias);
 int gpiod_line_get_value(struct gpiod_line* in);
+int gpiod_line_event_wait(struct gpiod_line* in, const struct timespec *timeout);
+int gpiod_line_event_read(struct gpiod_line* in, struct gpiod_line_event *event);
+int gpiod_line_event_get_fd(struct gpiod_line* in);
 
 #endif
 #endif
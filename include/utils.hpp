@@ -4,6 +4,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
 
 #ifdef SFML_SYSTEM_ANDROID
 #define ANDROID_COMPILATION
@@ -105,6 +108,7 @@ public:
 	ConsumerMutex();
 	void lock();
 	bool timed_lock();
+	bool timed_lock(double max_wait_s);
 	bool try_lock();
 	void unlock();
 	void update_time_multiplier(float time_multiplier);
@@ -118,6 +122,92 @@ private:
 	float time_multiplier = 1.0f;
 };
 
+// Single producer, single consumer. New elements are dropped when full.
+template <class T, size_t N> class LockFreeQueue {
+public:
+	bool push(const T &element) {
+		size_t curr_write_pos = this->write_pos.load(std::memory_order_relaxed);
+		size_t next_write_pos = (curr_write_pos + 1) % N;
+		if(next_write_pos == this->read_pos.load(std::memory_order_acquire))
+			return false;
+		this->data[curr_write_pos] = element;
+		this->write_pos.store(next_write_pos, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T &element) {
+		size_t curr_read_pos = this->read_pos.load(std::memory_order_relaxed);
+		if(curr_read_pos == this->write_pos.load(std::memory_order_acquire))
+			return false;
+		element = this->data[curr_read_pos];
+		this->read_pos.store((curr_read_pos + 1) % N, std::memory_order_release);
+		return true;
+	}
+
+	bool peek(T &element) {
+		size_t curr_read_pos = this->read_pos.load(std::memory_order_relaxed);
+		if(curr_read_pos == this->write_pos.load(std::memory_order_acquire))
+			return false;
+		element = this->data[curr_read_pos];
+		return true;
+	}
+
+	bool empty() {
+		return this->read_pos.load(std::memory_order_acquire) == this->write_pos.load(std::memory_order_acquire);
+	}
+
+	size_t size() {
+		size_t curr_read_pos = this->read_pos.load(std::memory_order_acquire);
+		size_t curr_write_pos = this->write_pos.load(std::memory_order_acquire);
+		return (curr_write_pos + N - curr_read_pos) % N;
+	}
+
+private:
+	T data[N];
+	std::atomic<size_t> write_pos = 0;
+	std::atomic<size_t> read_pos = 0;
+};
+
+// Readers never block and never see a partially written value.
+// Writers must not run concurrently with each other.
+// The value is kept in relaxed atomic words, so the copies done while
+// a write may be in progress are not data races.
+template <class T> class SeqLockValue {
+	static_assert(std::is_trivially_copyable_v<T>, "SeqLockValue needs a trivially copyable type");
+public:
+	void write(const T &value) {
+		uint32_t in_words[NUM_WORDS] = {};
+		memcpy(in_words, &value, sizeof(T));
+		uint32_t curr_sequence = this->sequence.load(std::memory_order_relaxed);
+		this->sequence.store(curr_sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		for(size_t i = 0; i < NUM_WORDS; i++)
+			this->words[i].store(in_words[i], std::memory_order_relaxed);
+		this->sequence.store(curr_sequence + 2, std::memory_order_release);
+	}
+
+	T read() {
+		uint32_t out_words[NUM_WORDS];
+		uint32_t start_sequence;
+		uint32_t end_sequence;
+		do {
+			start_sequence = this->sequence.load(std::memory_order_acquire);
+			for(size_t i = 0; i < NUM_WORDS; i++)
+				out_words[i] = this->words[i].load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			end_sequence = this->sequence.load(std::memory_order_relaxed);
+		} while((start_sequence & 1) || (start_sequence != end_sequence));
+		T value;
+		memcpy(&value, out_words, sizeof(T));
+		return value;
+	}
+
+private:
+	static constexpr size_t NUM_WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+	std::atomic<uint32_t> words[NUM_WORDS] = {};
+	std::atomic<uint32_t> sequence = 0;
+};
+
 class SharedConsumerMutex {
 public:
 	SharedConsumerMutex(int num_elements);
@@ -1,21 +1,108 @@
 #include "capture_structs.hpp"
 #include <string.h>
+#include <new>
+#include <thread>
+#include <chrono>
 
 CaptureDataBuffers::CaptureDataBuffers() {
 	last_curr_in = 0;
+	requested_num_buffers = NUM_CONCURRENT_DATA_BUFFERS;
+	num_buffers = 0;
+	arena = NULL;
+	arena_size = 0;
+	slot_size = 0;
 	for(int i = 0; i < NUM_CONCURRENT_DATA_BUFFER_WRITERS; i++) {
 		curr_writer_pos[i] = -1;
 	}
 	for(int i = 0; i < NUM_CONCURRENT_DATA_BUFFER_READERS; i++)
 		curr_reader_pos[i] = -1;
-	for(int i = 0; i < NUM_CONCURRENT_DATA_BUFFERS; i++) {
+	for(int i = 0; i < MAX_CONCURRENT_DATA_BUFFERS; i++) {
 		is_being_written_to[i] = false;
 		num_readers[i] = 0;
+		buffers[i].capture_buf = NULL;
+		buffers[i].has_device_frame_counter = false;
 		for(int j = 0; j < NUM_CONCURRENT_DATA_BUFFER_READERS; j++)
 			has_read_data[i][j] = true;
 	}
 }
 
+CaptureDataBuffers::~CaptureDataBuffers() {
+	this->FreeArena();
+}
+
+void CaptureDataBuffers::FreeArena() {
+	if(this->arena != NULL)
+		::operator delete[](this->arena, std::align_val_t(DATA_BUFFER_SLOT_ALIGNMENT));
+	this->arena = NULL;
+	this->arena_size = 0;
+}
+
+// Less buffers than the default would starve the writers of some devices
+void CaptureDataBuffers::SetNumBuffers(int num_buffers) {
+	if(num_buffers < NUM_CONCURRENT_DATA_BUFFERS)
+		num_buffers = NUM_CONCURRENT_DATA_BUFFERS;
+	if(num_buffers > MAX_CONCURRENT_DATA_BUFFERS)
+		num_buffers = MAX_CONCURRENT_DATA_BUFFERS;
+	this->requested_num_buffers = num_buffers;
+}
+
+size_t CaptureDataBuffers::GetSlotSize() {
+	return this->slot_size;
+}
+
+// Must only be called while no capture is running.
+// Sizes the slots for the device which is being connected.
+bool CaptureDataBuffers::AllocateBuffers(size_t slot_size) {
+	slot_size = ((slot_size + DATA_BUFFER_SLOT_ALIGNMENT - 1) / DATA_BUFFER_SLOT_ALIGNMENT) * DATA_BUFFER_SLOT_ALIGNMENT;
+	if(slot_size == 0)
+		return false;
+	access_mutex.lock();
+	// Readers may still be finishing with data from the previous device
+	bool readers_done = false;
+	while(!readers_done) {
+		readers_done = true;
+		for(int i = 0; i < MAX_CONCURRENT_DATA_BUFFERS; i++)
+			if(num_readers[i] > 0)
+				readers_done = false;
+		if(!readers_done) {
+			access_mutex.unlock();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			access_mutex.lock();
+		}
+	}
+	size_t new_arena_size = slot_size * this->requested_num_buffers;
+	if(new_arena_size != this->arena_size) {
+		this->FreeArena();
+		this->arena = (uint8_t*)::operator new[](new_arena_size, std::align_val_t(DATA_BUFFER_SLOT_ALIGNMENT), std::nothrow);
+		if(this->arena == NULL) {
+			this->num_buffers = 0;
+			this->slot_size = 0;
+			for(int i = 0; i < MAX_CONCURRENT_DATA_BUFFERS; i++)
+				buffers[i].capture_buf = NULL;
+			access_mutex.unlock();
+			return false;
+		}
+		this->arena_size = new_arena_size;
+	}
+	this->num_buffers = this->requested_num_buffers;
+	this->slot_size = slot_size;
+	for(int i = 0; i < MAX_CONCURRENT_DATA_BUFFERS; i++) {
+		buffers[i].capture_buf = NULL;
+		if(i < this->num_buffers)
+			buffers[i].capture_buf = (CaptureReceived*)(this->arena + (i * slot_size));
+		is_being_written_to[i] = false;
+		// Nothing to read, until new data arrives
+		for(int j = 0; j < NUM_CONCURRENT_DATA_BUFFER_READERS; j++)
+			has_read_data[i][j] = true;
+	}
+	for(int i = 0; i < NUM_CONCURRENT_DATA_BUFFER_WRITERS; i++)
+		curr_writer_pos[i] = -1;
+	last_curr_in = 0;
+	this->frame_clock.reset();
+	access_mutex.unlock();
+	return true;
+}
+
 static int reader_to_index(CaptureReaderType reader_type) {
 	switch(reader_type) {
 		case CAPTURE_READER_VIDEO:
@@ -56,7 +143,7 @@ CaptureDataSingleBuffer* CaptureDataBuffers::GetWriterBuffer(int index) {
 		return &buffers[curr_writer_pos[index]];
 	CaptureDataSingleBuffer* retval = NULL;
 	access_mutex.lock();
-	for(int i = 0; i < NUM_CONCURRENT_DATA_BUFFERS; i++)
+	for(int i = 0; i < this->num_buffers; i++)
 		if((num_readers[i] == 0) && (i != last_curr_in) && (!is_being_written_to[i])) {
 			retval = &buffers[i];
 			is_being_written_to[i] = true;
@@ -104,17 +191,23 @@ void CaptureDataBuffers::WriteToBuffer(CaptureReceived* buffer, uint64_t read, d
 	// How did we end here?!
 	if(target == NULL)
 		return;
+	if((read - offset) > this->slot_size)
+		read = this->slot_size + offset;
 	if(buffer != NULL) {
-		memcpy(&target->capture_buf, ((uint8_t*)buffer) + offset, (size_t)(read - offset));
+		memcpy(target->capture_buf, ((uint8_t*)buffer) + offset, (size_t)(read - offset));
 		// Make sure to also copy the extra needed data, if any
 		if((device->cc_type == CAPTURE_CONN_USB) && (!device->is_3ds))
-			memcpy(&target->capture_buf.usb_received_old_ds.frameinfo, &buffer->usb_received_old_ds.frameinfo, sizeof(buffer->usb_received_old_ds.frameinfo));
+			memcpy(&target->capture_buf->usb_received_old_ds.frameinfo, &buffer->usb_received_old_ds.frameinfo, sizeof(buffer->usb_received_old_ds.frameinfo));
 		target->unused_offset = 0;
 	}
 	else
 		target->unused_offset = offset;
 	target->read = read - offset;
-	target->time_in_buf = time_in_buf;
+	target->raw_time_in_buf = time_in_buf;
+	access_mutex.lock();
+	target->time_in_buf = this->frame_clock.update(time_in_buf, target->has_device_frame_counter, target->device_frame_counter);
+	access_mutex.unlock();
+	target->has_device_frame_counter = false;
 	target->capture_type = capture_type;
 	target->is_3d = is_3d;
 	target->should_be_3d = should_be_3d;
@@ -133,3 +226,262 @@ void CaptureDataBuffers::WriteToBuffer(CaptureReceived* buffer, uint64_t read, d
 void CaptureDataBuffers::WriteToBuffer(CaptureReceived* buffer, uint64_t read, double time_in_buf, CaptureDevice* device, int index, bool is_3d, bool should_be_3d) {
 	return this->WriteToBuffer(buffer, read, time_in_buf, device, CAPTURE_SCREENS_BOTH, 0, index, is_3d, should_be_3d);
 }
+
+// Least squares fit of the times over the frame indexes, for the last
+// num_samples entries of a ring buffer which ends right before curr_pos.
+bool fit_frame_period(const double* frame_indexes, const double* times, int window_size, int curr_pos, int num_samples, double &out_period) {
+	if(num_samples < 2)
+		return false;
+	// Relative to the oldest sample, for precision
+	int oldest_pos = (curr_pos + window_size - num_samples) % window_size;
+	double base_x = frame_indexes[oldest_pos];
+	double base_y = times[oldest_pos];
+	double sum_x = 0.0;
+	double sum_y = 0.0;
+	double sum_xx = 0.0;
+	double sum_xy = 0.0;
+	for(int i = 0; i < num_samples; i++) {
+		int pos = (oldest_pos + i) % window_size;
+		double x = frame_indexes[pos] - base_x;
+		double y = times[pos] - base_y;
+		sum_x += x;
+		sum_y += y;
+		sum_xx += x * x;
+		sum_xy += x * y;
+	}
+	double denominator = (num_samples * sum_xx) - (sum_x * sum_x);
+	if(denominator <= 0.0)
+		return false;
+	double new_period = ((num_samples * sum_xy) - (sum_x * sum_y)) / denominator;
+	if(new_period <= 0.0)
+		return false;
+	out_period = new_period;
+	return true;
+}
+
+FrameClockRecovery::FrameClockRecovery() {
+	this->reset();
+}
+
+void FrameClockRecovery::reset() {
+	this->num_samples = 0;
+	this->curr_pos = 0;
+	this->curr_arrival_time = 0.0;
+	this->curr_frame_index = 0.0;
+	this->period = 0.0;
+	this->has_last_device_frame_counter = false;
+	this->last_device_frame_counter = 0;
+}
+
+// Returns the smoothed time between this frame and the previous one
+double FrameClockRecovery::update(double host_frame_time, bool has_device_frame_counter, uint32_t device_frame_counter) {
+	if(host_frame_time <= 0.0)
+		return host_frame_time;
+	int frames_elapsed = 1;
+	bool found_frames_elapsed = false;
+	if(has_device_frame_counter && this->has_last_device_frame_counter) {
+		uint32_t counter_diff = device_frame_counter - this->last_device_frame_counter;
+		if((counter_diff >= 1) && (counter_diff <= FRAME_CLOCK_MAX_FRAMES_JUMP)) {
+			frames_elapsed = (int)counter_diff;
+			found_frames_elapsed = true;
+		}
+	}
+	this->has_last_device_frame_counter = has_device_frame_counter;
+	this->last_device_frame_counter = device_frame_counter;
+	// No counter from the device. Guess how many frames were lost
+	if((!found_frames_elapsed) && (this->period > 0.0)) {
+		frames_elapsed = (int)((host_frame_time / this->period) + 0.5);
+		if(frames_elapsed < 1)
+			frames_elapsed = 1;
+	}
+	if(frames_elapsed > FRAME_CLOCK_MAX_FRAMES_JUMP) {
+		bool had_counter = this->has_last_device_frame_counter;
+		this->reset();
+		this->has_last_device_frame_counter = had_counter;
+		this->last_device_frame_counter = device_frame_counter;
+		return host_frame_time;
+	}
+
+	this->curr_arrival_time += host_frame_time;
+	this->curr_frame_index += frames_elapsed;
+	this->arrival_times[this->curr_pos] = this->curr_arrival_time;
+	this->frame_indexes[this->curr_pos] = this->curr_frame_index;
+	this->curr_pos = (this->curr_pos + 1) % FRAME_CLOCK_WINDOW_SIZE;
+	if(this->num_samples < FRAME_CLOCK_WINDOW_SIZE)
+		this->num_samples += 1;
+	if(this->num_samples < FRAME_CLOCK_MIN_SAMPLES)
+		return host_frame_time;
+
+	double new_period = 0.0;
+	if(!fit_frame_period(this->frame_indexes, this->arrival_times, FRAME_CLOCK_WINDOW_SIZE, this->curr_pos, this->num_samples, new_period))
+		return host_frame_time;
+	this->period = new_period;
+	return this->period * frames_elapsed;
+}
+
+FramePeriodEstimator::FramePeriodEstimator(uint32_t counter_mask) {
+	this->counter_mask = counter_mask;
+	this->reset();
+}
+
+// Needed whenever the counter may have jumped, or was reset
+void FramePeriodEstimator::reset() {
+	this->num_samples = 0;
+	this->curr_pos = 0;
+	this->has_last_read = false;
+	this->last_read_time = 0.0;
+	this->last_counter = 0;
+	this->curr_frame_index = 0.0;
+	this->period = 0.0;
+}
+
+void FramePeriodEstimator::add_read(double time, uint32_t counter) {
+	counter &= this->counter_mask;
+	if(!this->has_last_read) {
+		this->has_last_read = true;
+		this->last_read_time = time;
+		this->last_counter = counter;
+		return;
+	}
+	uint32_t counter_diff = (counter - this->last_counter) & this->counter_mask;
+	double read_gap = time - this->last_read_time;
+	this->last_read_time = time;
+	if(counter_diff == 0)
+		return;
+	this->last_counter = counter;
+	this->curr_frame_index += counter_diff;
+	double max_read_gap = FRAME_PERIOD_MAX_READ_GAP;
+	if(this->has_period())
+		max_read_gap = this->period / 2;
+	if((read_gap < 0.0) || (read_gap > max_read_gap))
+		return;
+	this->change_times[this->curr_pos] = time - (read_gap / 2);
+	this->frame_indexes[this->curr_pos] = this->curr_frame_index;
+	this->curr_pos = (this->curr_pos + 1) % FRAME_PERIOD_WINDOW_SIZE;
+	if(this->num_samples < FRAME_PERIOD_WINDOW_SIZE)
+		this->num_samples += 1;
+	this->update_period();
+}
+
+void FramePeriodEstimator::update_period() {
+	if(this->num_samples < 2)
+		return;
+	int oldest_pos = (this->curr_pos + FRAME_PERIOD_WINDOW_SIZE - this->num_samples) % FRAME_PERIOD_WINDOW_SIZE;
+	int newest_pos = (this->curr_pos + FRAME_PERIOD_WINDOW_SIZE - 1) % FRAME_PERIOD_WINDOW_SIZE;
+	if((this->frame_indexes[newest_pos] - this->frame_indexes[oldest_pos]) < FRAME_PERIOD_MIN_FRAMES)
+		return;
+	double new_period = 0.0;
+	if(fit_frame_period(this->frame_indexes, this->change_times, FRAME_PERIOD_WINDOW_SIZE, this->curr_pos, this->num_samples, new_period))
+		this->period = new_period;
+}
+
+bool FramePeriodEstimator::has_period() {
+	return this->period > 0.0;
+}
+
+double FramePeriodEstimator::get_period() {
+	return this->period;
+}
+
+#define TRANSFERS_IN_FLIGHT_WARMUP_FRAMES 8
+#define TRANSFERS_IN_FLIGHT_LATE_MULTIPLIER 1.5
+// Past this, the console likely just stopped sending frames
+#define TRANSFERS_IN_FLIGHT_STOPPED_MULTIPLIER 4.0
+#define TRANSFERS_IN_FLIGHT_SHRINK_FRAMES 600
+
+static int sanitize_transfers_in_flight(int requested) {
+	if(requested < 0)
+		requested = AUTO_TRANSFERS_IN_FLIGHT;
+	if(requested > NUM_CONCURRENT_DATA_BUFFER_WRITERS)
+		requested = NUM_CONCURRENT_DATA_BUFFER_WRITERS;
+	if((requested != AUTO_TRANSFERS_IN_FLIGHT) && (requested < MIN_TRANSFERS_IN_FLIGHT))
+		requested = MIN_TRANSFERS_IN_FLIGHT;
+	return requested;
+}
+
+TransfersInFlight::TransfersInFlight() {
+	this->requested = AUTO_TRANSFERS_IN_FLIGHT;
+	this->max_in_flight = NUM_CONCURRENT_DATA_BUFFER_WRITERS;
+	this->set_device_profile(AUTO_TRANSFERS_IN_FLIGHT, AUTO_TRANSFERS_IN_FLIGHT);
+	this->reset(this->max_in_flight);
+	this->is_used = false;
+}
+
+// From the command line. It wins over the device profile.
+void TransfersInFlight::set_requested(int requested) {
+	this->requested = sanitize_transfers_in_flight(requested);
+}
+
+int TransfersInFlight::get_requested() {
+	return this->requested;
+}
+
+// Called when connecting, before the capture thread starts
+void TransfersInFlight::set_device_profile(int device_requested, int auto_start) {
+	this->device_requested = sanitize_transfers_in_flight(device_requested);
+	this->auto_start = sanitize_transfers_in_flight(auto_start);
+	this->is_used = false;
+}
+
+// Returns false if the backend of the device does not use this.
+// auto_start is where auto mode settled, to start from it next time.
+bool TransfersInFlight::get_device_profile(int &device_requested, int &auto_start) {
+	device_requested = this->device_requested;
+	auto_start = this->curr;
+	return this->is_used;
+}
+
+// Called by the backends before they start capturing
+void TransfersInFlight::reset(int max_in_flight) {
+	if(max_in_flight < 1)
+		max_in_flight = 1;
+	this->max_in_flight = max_in_flight;
+	// Start from the most robust option, then go down.
+	// Unless a previous run of this device already found a better value.
+	this->curr = max_in_flight;
+	if((this->auto_start != AUTO_TRANSFERS_IN_FLIGHT) && (this->auto_start < max_in_flight))
+		this->curr = this->auto_start;
+	this->is_used = true;
+	this->average_frame_time = 0.0;
+	this->num_frames = 0;
+	this->on_time_frames = 0;
+}
+
+int TransfersInFlight::get() {
+	int value = this->curr;
+	if(this->requested != AUTO_TRANSFERS_IN_FLIGHT)
+		value = this->requested;
+	else if(this->device_requested != AUTO_TRANSFERS_IN_FLIGHT)
+		value = this->device_requested;
+	if(value > this->max_in_flight)
+		value = this->max_in_flight;
+	if(value < 1)
+		value = 1;
+	return value;
+}
+
+void TransfersInFlight::frame_done(double frame_time) {
+	if(frame_time <= 0.0)
+		return;
+	if(this->num_frames < TRANSFERS_IN_FLIGHT_WARMUP_FRAMES) {
+		this->num_frames += 1;
+		this->average_frame_time += (frame_time - this->average_frame_time) / this->num_frames;
+		return;
+	}
+	bool is_late = frame_time > (this->average_frame_time * TRANSFERS_IN_FLIGHT_LATE_MULTIPLIER);
+	if(frame_time > (this->average_frame_time * TRANSFERS_IN_FLIGHT_STOPPED_MULTIPLIER))
+		return;
+	if(!is_late) {
+		this->average_frame_time = (this->average_frame_time * 0.95) + (frame_time * 0.05);
+		this->on_time_frames += 1;
+		if(this->on_time_frames >= TRANSFERS_IN_FLIGHT_SHRINK_FRAMES) {
+			this->on_time_frames = 0;
+			if(this->curr > MIN_TRANSFERS_IN_FLIGHT)
+				this->curr -= 1;
+		}
+		return;
+	}
+	this->on_time_frames = 0;
+	if(this->curr < this->max_in_flight)
+		this->curr += 1;
+}
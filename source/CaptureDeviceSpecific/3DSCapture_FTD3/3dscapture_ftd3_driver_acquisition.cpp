@@ -38,7 +38,7 @@ static bool fast_capture_call_init_async_transfers(FTD3XXReceivedDataBuffer* rec
 	void* handle = ((ftd3_device_device_handlers*)capture_data->handle)->driver_handle;
 	for(inner_curr_in = 0; inner_curr_in < FTD3_CONCURRENT_BUFFERS - 1; ++inner_curr_in) {
 		CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(inner_curr_in);
-		uint8_t* buffer = (uint8_t*)&data_buf->capture_buf;
+		uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
 		received_buffer[inner_curr_in].is_3d = could_use_3d && stored_3d_status;
 		FT_STATUS ftStatus = FT_ASYNC_CALL(handle, fifo_channel, buffer, (ULONG)ftd3_get_capture_size(received_buffer[inner_curr_in].is_3d), &received_buffer[inner_curr_in].read_buffer, &received_buffer[inner_curr_in].overlap);
 		if(ftStatus != FT_IO_PENDING) {
@@ -91,7 +91,7 @@ static void fast_capture_call(FTD3XXReceivedDataBuffer* received_buffer, Capture
 		}
 
 		CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(inner_curr_in);
-		uint8_t* buffer = (uint8_t*)&data_buf->capture_buf;
+		uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
 		received_buffer[inner_curr_in].is_3d = could_use_3d && stored_3d_status;
 		ftStatus = FT_ASYNC_CALL(handle, fifo_channel, buffer, (ULONG)ftd3_get_capture_size(received_buffer[inner_curr_in].is_3d), &received_buffer[inner_curr_in].read_buffer, &received_buffer[inner_curr_in].overlap);
 		if(ftStatus != FT_IO_PENDING) {
@@ -128,7 +128,7 @@ static bool safe_capture_call(FTD3XXReceivedDataBuffer* received_buffer, Capture
 		}
 
 		CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(0);
-		uint8_t* buffer = (uint8_t*)&data_buf->capture_buf;
+		uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
 		received_buffer->is_3d = could_use_3d && stored_3d_status;
 		#ifdef _WIN32
 		FT_STATUS ftStatus = FT_ReadPipeEx(handle, fifo_channel, buffer, (ULONG)ftd3_get_capture_size(received_buffer->is_3d), &received_buffer->read_buffer, NULL);
@@ -52,7 +52,7 @@ static void ftd3_libusb_read_frame_request(CaptureData* capture_data, FTD3Libusb
 	ftd3_libusb_capture_recv_data->index = index;
 	ftd3_libusb_capture_recv_data->cb_data.function = ftd3_libusb_read_frame_cb;
 	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(ftd3_libusb_capture_recv_data->internal_index);
-	uint8_t* buffer = (uint8_t*)&data_buf->capture_buf;
+	uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
 	ftd3_libusb_capture_recv_data->is_3d = is_3d;
 	ftd3_libusb_async_in_start((ftd3_device_device_handlers*)capture_data->handle, pipe, (uint32_t)(MAX_TIME_WAIT * 1000), buffer, (int)ftd3_get_capture_size(is_3d), &ftd3_libusb_capture_recv_data->cb_data);
 }
@@ -126,7 +126,8 @@ static void wait_one_ftd3_libusb_buffer_free(FTD3LibusbCaptureReceivedData* ftd3
 	bool done = false;
 	const auto start_time = std::chrono::high_resolution_clock::now();
 	while(!done) {
-		for(int i = 0; i < FTD3_CONCURRENT_BUFFERS; i++) {
+		int num_in_flight = ftd3_libusb_capture_recv_data[0].capture_data->status.transfers_in_flight.get();
+		for(int i = 0; i < num_in_flight; i++) {
 			if(!ftd3_libusb_capture_recv_data[i].in_use)
 				done = true;
 		}
@@ -145,7 +146,8 @@ static FTD3LibusbCaptureReceivedData* ftd3_libusb_get_free_buffer(FTD3LibusbCapt
 	wait_one_ftd3_libusb_buffer_free(ftd3_libusb_capture_recv_data);
 	if(get_ftd3_libusb_status(ftd3_libusb_capture_recv_data) < 0)
 		return NULL;
-	for(int i = 0; i < FTD3_CONCURRENT_BUFFERS; i++)
+	int num_in_flight = ftd3_libusb_capture_recv_data[0].capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		if(!ftd3_libusb_capture_recv_data[i].in_use) {
 			ftd3_libusb_capture_recv_data[i].is_buffer_free_shared_mutex->specific_try_lock(i);
 			ftd3_libusb_capture_recv_data[i].in_use = true;
@@ -164,7 +166,9 @@ static void ftd3_libusb_capture_main_loop_processing(FTD3LibusbCaptureReceivedDa
 	if(!result_3d_setup)
 		return;
 
-	for(int i = 0; i < FTD3_CONCURRENT_BUFFERS; i++)
+	capture_data->status.transfers_in_flight.reset(FTD3_CONCURRENT_BUFFERS);
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		ftd3_libusb_read_frame_request(capture_data, ftd3_libusb_get_free_buffer(ftd3_libusb_capture_recv_data), index++, pipe, could_use_3d && stored_3d_status);
 
 	while(capture_data->status.connected && capture_data->status.running) {
@@ -181,7 +185,8 @@ static void ftd3_libusb_capture_main_loop_processing(FTD3LibusbCaptureReceivedDa
 				return;
 
 			*ftd3_libusb_capture_recv_data->pause_output = false;
-			for(int i = 0; i < FTD3_CONCURRENT_BUFFERS; i++)
+			num_in_flight = capture_data->status.transfers_in_flight.get();
+			for(int i = 0; i < num_in_flight; i++)
 				ftd3_libusb_read_frame_request(capture_data, ftd3_libusb_get_free_buffer(ftd3_libusb_capture_recv_data), index++, pipe, could_use_3d && stored_3d_status);
 
 			*ftd3_libusb_capture_recv_data[0].clock_start = std::chrono::high_resolution_clock::now();
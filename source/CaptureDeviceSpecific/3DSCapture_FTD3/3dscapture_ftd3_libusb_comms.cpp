@@ -252,6 +252,8 @@ static void read_strings(libusb_device_handle *handle, libusb_device_descriptor
 
 static int ftd3_libusb_insert_device(std::vector<CaptureDevice> &devices_list, libusb_device *usb_device, libusb_device_descriptor *usb_descriptor, int &curr_serial_extra_id, const std::vector<std::string> &valid_descriptions) {
 	libusb_device_handle *handle = NULL;
+	if(usb_device_cache_lookup(usb_device, &valid_descriptions, FTD3_COMMAND_INTERFACE, devices_list))
+		return LIBUSB_SUCCESS;
 	int result = libusb_open(usb_device, &handle);
 	if((result < 0) || (handle == NULL))
 		return result;
@@ -276,8 +278,13 @@ static int ftd3_libusb_insert_device(std::vector<CaptureDevice> &devices_list, l
 	libusb_speed read_speed = (libusb_speed)libusb_get_device_speed(usb_device);
 	if((read_speed >= LIBUSB_SPEED_SUPER) || (usb_descriptor->bcdUSB >= 0x300))
 		usb_speed = 0x300;
-	if(result_setup)
+	if(result_setup) {
+		size_t first_new_device = devices_list.size();
+		int old_serial_extra_id = curr_serial_extra_id;
 		ftd3_insert_device(devices_list, (std::string)(serial), curr_serial_extra_id, usb_speed, false);
+		if(curr_serial_extra_id == old_serial_extra_id)
+			usb_device_cache_store(usb_device, &valid_descriptions, devices_list, first_new_device);
+	}
 	if(claimed_cmd)
 		libusb_release_interface(handle, FTD3_COMMAND_INTERFACE);
 	if(claimed_bulk)
@@ -81,6 +81,7 @@ void data_output_update(int inner_index, size_t read_data, CaptureData* capture_
 	const std::chrono::duration<double> diff = curr_time - base_time;
 	base_time = curr_time;
 	capture_data->data_buffers.WriteToBuffer(NULL, read_data, diff.count(), &capture_data->status.device, inner_index, is_3d);
+	capture_data->status.transfers_in_flight.frame_done(diff.count());
 
 	if(capture_data->status.cooldown_curr_in)
 		capture_data->status.cooldown_curr_in = capture_data->status.cooldown_curr_in - 1;
@@ -146,6 +146,8 @@ static int cypress_libusb_insert_device(std::vector<CaptureDevice> &devices_list
 	uint16_t masked_wanted_bcd_device = usb_device_desc->bcd_device_mask & usb_device_desc->bcd_device_wanted_value;
 	if(masked_wanted_bcd_device != (usb_descriptor->bcdDevice & usb_device_desc->bcd_device_mask))
 		return LIBUSB_ERROR_NOT_FOUND;
+	if(usb_device_cache_lookup(usb_device, usb_device_desc, usb_device_desc->default_interface, devices_list))
+		return LIBUSB_SUCCESS;
 	int result = libusb_open(usb_device, &handle);
 	if((result < 0) || (handle == NULL))
 		return result;
@@ -156,8 +158,13 @@ static int cypress_libusb_insert_device(std::vector<CaptureDevice> &devices_list
 	bool executed_setup = false;
 	bool result_setup = cypress_libusb_setup_connection(handle, usb_device_desc, &claimed, executed_setup);
 	if(result_setup) {
+		size_t first_new_device = devices_list.size();
+		int old_serial_extra_id = curr_serial_extra_id;
 		std::string device_serial_number = read_real_serial(handle, usb_descriptor, usb_device_desc, serial, curr_serial_extra_id, &claimed, executed_setup);
 		cypress_insert_device(devices_list, usb_device_desc, device_serial_number);
+		// Made up serials depend on the listing order. They cannot be cached.
+		if(curr_serial_extra_id == old_serial_extra_id)
+			usb_device_cache_store(usb_device, usb_device_desc, devices_list, first_new_device);
 	}
 	if(claimed)
 		libusb_release_interface(handle, usb_device_desc->default_interface);
@@ -33,7 +33,7 @@ static void data_output_update(int curr_data_buffer_index, CaptureData* capture_
 	const std::chrono::duration<double> diff = curr_time - base_time;
 	base_time = curr_time;
 	CaptureDataSingleBuffer* curr_full_data_buf = capture_data->data_buffers.GetWriterBuffer(curr_data_buffer_index);
-	CaptureReceived* buffer = &curr_full_data_buf->capture_buf;
+	CaptureReceived* buffer = curr_full_data_buf->capture_buf;
 	size_t buffer_real_len = remove_synch_from_final_length((uint32_t*)buffer, read_amount);
 	size_t initial_offset = get_initial_offset_buffer((uint16_t*) buffer, buffer_real_len);
 	capture_data->data_buffers.WriteToBuffer(NULL, buffer_real_len, diff.count(), &capture_data->status.device, initial_offset, curr_data_buffer_index);
@@ -64,7 +64,7 @@ void ftd2_capture_main_loop_driver(CaptureData* capture_data) {
 	while (capture_data->status.connected && capture_data->status.running) {
 		curr_data_buffer_index = next_data_buffer_index;
 		CaptureDataSingleBuffer* curr_full_data_buf = capture_data->data_buffers.GetWriterBuffer(curr_data_buffer_index);
-		CaptureReceived* curr_data_buffer = &curr_full_data_buf->capture_buf;
+		CaptureReceived* curr_data_buffer = curr_full_data_buf->capture_buf;
 		retval = ftd2_read(capture_data->handle, is_ftd2_libusb, ((uint8_t*)curr_data_buffer) + (full_size - next_size), next_size, &bytesIn);
 		if(ftd2_is_error(retval, is_ftd2_libusb)) {
 			capture_error_print(true, capture_data, "Disconnected: Read failed");
@@ -74,7 +74,7 @@ void ftd2_capture_main_loop_driver(CaptureData* capture_data) {
 			continue;
 		next_data_buffer_index = (curr_data_buffer_index + 1) % NUM_CAPTURE_RECEIVED_DATA_BUFFERS;
 		CaptureDataSingleBuffer* next_full_data_buf = capture_data->data_buffers.GetWriterBuffer(next_data_buffer_index);
-		CaptureReceived* next_data_buffer = &next_full_data_buf->capture_buf;
+		CaptureReceived* next_data_buffer = next_full_data_buf->capture_buf;
 		bool has_synch_failed = !synchronization_check((uint16_t*)curr_data_buffer, full_size, (uint16_t*)next_data_buffer, &next_size, true);
 		if(has_synch_failed) {
 			continue;
@@ -69,7 +69,8 @@ static void wait_all_ftd2_libusb_buffers_free(FTD2CaptureReceivedData* received_
 static void wait_one_ftd2_libusb_buffer_free(FTD2CaptureReceivedData* received_data_buffers) {
 	bool done = false;
 	while(!done) {
-		for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++) {
+		int num_in_flight = received_data_buffers[0].capture_data->status.transfers_in_flight.get();
+		for(int i = 0; i < num_in_flight; i++) {
 			if(!received_data_buffers[i].in_use)
 				done = true;
 		}
@@ -86,7 +87,8 @@ static FTD2CaptureReceivedData* ftd2_libusb_get_free_buffer(FTD2CaptureReceivedD
 	wait_one_ftd2_libusb_buffer_free(received_data_buffers);
 	if(*received_data_buffers[0].status < 0)
 		return NULL;
-	for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++)
+	int num_in_flight = received_data_buffers[0].capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		if(!received_data_buffers[i].in_use) {
 			received_data_buffers[i].is_buffer_free_shared_mutex->specific_try_lock(i);
 			received_data_buffers[i].in_use = true;
@@ -99,7 +101,7 @@ static void ftd2_libusb_start_read(FTD2CaptureReceivedData* received_data_buffer
 	if(received_data_buffer == NULL)
 		return;
 	CaptureDataSingleBuffer* full_data_buf = received_data_buffer->capture_data->data_buffers.GetWriterBuffer(received_data_buffer->cb_data.internal_index);
-	CaptureReceived* data_buffer = &full_data_buf->capture_buf;
+	CaptureReceived* data_buffer = full_data_buf->capture_buf;
 	received_data_buffer->buffer_raw = (uint8_t*)&data_buffer->ftd2_received_old_ds_normal_plus_raw.raw_data;
 	received_data_buffer->buffer_target = (uint32_t*)data_buffer;
 	received_data_buffer->index = index;
@@ -188,6 +190,7 @@ static void output_to_thread(CaptureData* capture_data, int internal_index, uint
 	// Copy data to buffer, with special memcpy which accounts for ftd2 header data and skips synch bytes
 	size_t real_length = ftd2_libusb_copy_buffer_to_target_and_skip_synch(buffer_raw, buffer_target, read_length, sync_offset);
 	capture_data->data_buffers.WriteToBuffer(NULL, real_length, diff.count(), &capture_data->status.device, internal_index);
+	capture_data->status.transfers_in_flight.frame_done(diff.count());
 
 	if(capture_data->status.cooldown_curr_in)
 		capture_data->status.cooldown_curr_in = capture_data->status.cooldown_curr_in - 1;
@@ -309,7 +312,9 @@ void ftd2_capture_main_loop_libusb(CaptureData* capture_data) {
 		is_done = true;
 	}
 
-	for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++)
+	capture_data->status.transfers_in_flight.reset(NUM_CAPTURE_RECEIVED_DATA_BUFFERS);
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		ftd2_libusb_start_read(ftd2_libusb_get_free_buffer(received_data_buffers), index++, full_size);
 
 
@@ -139,13 +139,26 @@ void list_devices_ftd2_libusb(std::vector<CaptureDevice> &devices_list, std::vec
 	const vid_pid_descriptor* curr_descriptor;
 
 	for(ssize_t i = 0; i < num_devices; i++) {
-		int retval = check_single_device_valid_ftd2_libusb(usb_devices[i], description, SerialNumber, &curr_descriptor);
-		if(retval < 0) {
-			if(retval == LIBUSB_ERROR_ACCESS)
-				perm_error = true;
+		libusb_device_descriptor desc = {0};
+		if(libusb_get_device_descriptor(usb_devices[i], &desc) < 0)
 			continue;
+		const void* probe_id = get_device_descriptor(desc.idVendor, desc.idProduct);
+		if(probe_id == NULL)
+			continue;
+		std::vector<CaptureDevice> new_devices;
+		if(!usb_device_cache_lookup(usb_devices[i], probe_id, DEFAULT_INTERFACE, new_devices)) {
+			int retval = check_single_device_valid_ftd2_libusb(usb_devices[i], description, SerialNumber, &curr_descriptor);
+			if(retval < 0) {
+				if(retval == LIBUSB_ERROR_ACCESS)
+					perm_error = true;
+				continue;
+			}
+			insert_device_ftd2_shared(new_devices, description, 1, std::string(SerialNumber), (void*)curr_descriptor, std::string(description), "l");
+			usb_device_cache_store(usb_devices[i], probe_id, new_devices, 0);
 		}
-		std::string serial_number = std::string(SerialNumber);
+		if(new_devices.size() <= 0)
+			continue;
+		std::string serial_number = new_devices[0].serial_number;
 		bool is_already_inserted = false;
 		for(size_t j = 0; j < devices_list.size(); j++) {
 			if((devices_list[j].cc_type == CAPTURE_CONN_FTD2) && (devices_list[j].serial_number == serial_number)) {
@@ -155,7 +168,8 @@ void list_devices_ftd2_libusb(std::vector<CaptureDevice> &devices_list, std::vec
 		}
 		if(is_already_inserted && (!insert_anyway))
 			continue;
-		insert_device_ftd2_shared(devices_list, description, debug_multiplier, serial_number, (void*)curr_descriptor, std::string(description), "l");
+		for(int u = 0; u < debug_multiplier; u++)
+			devices_list.insert(devices_list.end(), new_devices.begin(), new_devices.end());
 	}
 	if(perm_error)
 		no_access_list.emplace_back("ftd2_libusb");
@@ -0,0 +1,48 @@
+#include "dscapture_ftd2_synchronization.hpp"
+
+#include <cstring>
+
+bool synchronization_check(uint16_t* data_buffer, size_t size, uint16_t* next_data_buffer, size_t* next_size, bool special_check) {
+	size_t size_words = size / 2;
+	*next_size = size;
+	// Short reads happen. Nothing to check, and nothing to output
+	if(size_words == 0)
+		return false;
+	if((data_buffer[0] != FTD2_OLDDS_SYNCH_VALUES) && (data_buffer[size_words - 1] == FTD2_OLDDS_SYNCH_VALUES))
+		return true;
+	if(special_check && (data_buffer[0] == FTD2_OLDDS_SYNCH_VALUES) && (data_buffer[size_words - 1] == FTD2_OLDDS_SYNCH_VALUES))
+		return true;
+
+	//check sync
+	size_t samples = 0;
+
+	// Find the first spot the padding is present
+	while((samples < size_words) && (data_buffer[samples] != FTD2_OLDDS_SYNCH_VALUES))
+		samples++;
+	while((samples < size_words) && (data_buffer[samples] == FTD2_OLDDS_SYNCH_VALUES))
+		samples++;
+
+	// Schedule a read to re-synchronize
+	if(next_data_buffer != NULL) {
+		memset(next_data_buffer, 0, size_words * 2);
+		memcpy(next_data_buffer, &data_buffer[samples], (size_words - samples) * 2);
+	}
+	*next_size = samples * 2;
+	return false;
+}
+
+size_t remove_synch_from_final_length(uint32_t* out_buffer, size_t real_length) {
+	// Ignore synch for final length
+	uint32_t check_value = FTD2_OLDDS_SYNCH_VALUES | (FTD2_OLDDS_SYNCH_VALUES << 16);
+	size_t check_size = sizeof(uint32_t);
+	while((real_length >= check_size) && (out_buffer[(real_length / check_size) - 1] == check_value))
+		real_length -= check_size;
+	check_value = FTD2_OLDDS_SYNCH_VALUES;
+	uint16_t* u16_buffer = (uint16_t*)out_buffer;
+	check_size = sizeof(uint16_t);
+	while((real_length >= check_size) && (u16_buffer[(real_length / check_size) - 1] == check_value))
+		real_length -= check_size;
+	if((real_length > 0) && (real_length < check_size) && (u16_buffer[0] == check_value))
+		real_length = 0;
+	return real_length;
+}
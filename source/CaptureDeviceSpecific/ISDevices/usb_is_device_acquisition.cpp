@@ -221,6 +221,7 @@ void output_to_thread(CaptureData* capture_data, int internal_index, CaptureScre
 	const std::chrono::duration<double> diff = curr_time - (*clock_start);
 	*clock_start = curr_time;
 	capture_data->data_buffers.WriteToBuffer(NULL, read_size, diff.count(), &capture_data->status.device, curr_capture_type, internal_index);
+	capture_data->status.transfers_in_flight.frame_done(diff.count());
 
 	if(capture_data->status.cooldown_curr_in)
 		capture_data->status.cooldown_curr_in = capture_data->status.cooldown_curr_in - 1;
@@ -236,7 +237,7 @@ static void output_to_thread(CaptureData* capture_data, int internal_index, Capt
 int is_device_read_frame_and_output(CaptureData* capture_data, int internal_index, CaptureScreensType curr_capture_type, std::chrono::time_point<std::chrono::high_resolution_clock> &clock_start) {
 	const is_device_usb_device* usb_device_info = (const is_device_usb_device*)capture_data->status.device.descriptor;
 	CaptureDataSingleBuffer* target = capture_data->data_buffers.GetWriterBuffer(internal_index);
-	CaptureReceived* buffer = &target->capture_buf;
+	CaptureReceived* buffer = target->capture_buf;
 	int ret = ReadFrame((is_device_device_handlers*)capture_data->handle, (uint8_t*)buffer, (int)usb_is_device_get_video_in_size(curr_capture_type, usb_device_info->device_type), usb_device_info);
 	if(ret < 0) {
 		capture_data->data_buffers.ReleaseWriterBuffer(internal_index, false);
@@ -256,7 +257,7 @@ void is_device_read_frame_request(CaptureData* capture_data, ISDeviceCaptureRece
 	is_device_capture_recv_data->curr_capture_type = curr_capture_type;
 	is_device_capture_recv_data->cb_data.function = is_device_read_frame_cb;
 	CaptureDataSingleBuffer* target = capture_data->data_buffers.GetWriterBuffer(is_device_capture_recv_data->cb_data.internal_index);
-	CaptureReceived* buffer = &target->capture_buf;
+	CaptureReceived* buffer = target->capture_buf;
 	ReadFrameAsync((is_device_device_handlers*)capture_data->handle, (uint8_t*)buffer, (int)usb_is_device_get_video_in_size(curr_capture_type, usb_device_info->device_type), usb_device_info, &is_device_capture_recv_data->cb_data);
 }
 
@@ -368,7 +369,8 @@ void wait_one_is_device_buffer_free(CaptureData* capture_data, ISDeviceCaptureRe
 	bool done = false;
 	const auto start_time = std::chrono::high_resolution_clock::now();
 	while(!done) {
-		for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++) {
+		int num_in_flight = capture_data->status.transfers_in_flight.get();
+		for(int i = 0; i < num_in_flight; i++) {
 			if(!is_device_capture_recv_data[i].in_use)
 				done = true;
 		}
@@ -391,7 +393,8 @@ ISDeviceCaptureReceivedData* is_device_get_free_buffer(CaptureData* capture_data
 	wait_one_is_device_buffer_free(capture_data, is_device_capture_recv_data);
 	if(get_is_device_status(is_device_capture_recv_data) < 0)
 		return NULL;
-	for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++)
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		if(!is_device_capture_recv_data[i].in_use) {
 			is_device_capture_recv_data[i].is_buffer_free_shared_mutex->specific_try_lock(i);
 			is_device_capture_recv_data[i].in_use = true;
@@ -442,6 +445,7 @@ void is_device_acquisition_main_loop(CaptureData* capture_data) {
 		is_device_capture_recv_data[i].cb_data.is_transfer_data_ready_mutex = &is_transfer_data_ready_shared_mutex;
 		is_device_capture_recv_data[i].cb_data.is_data_ready = false;
 	}
+	capture_data->status.transfers_in_flight.reset(NUM_CAPTURE_RECEIVED_DATA_BUFFERS);
 	SetupISDeviceAsyncThread((is_device_device_handlers*)capture_data->handle, is_device_capture_recv_data, &async_processing_thread, &is_done_thread, &has_data_been_processed);
 	capture_data->status.device_specific_status.is_status.reset_hardware = false;
 	switch(((const is_device_usb_device*)(capture_data->status.device.descriptor))->device_type) {
@@ -3,8 +3,7 @@
 #include "usb_is_device_libusb.hpp"
 #include "usb_is_device_is_driver.hpp"
 #include "is_twl_cap_init_seed_table.h"
-// From web.mit.edu/wwwdev/src/harvest-1.3.pl3/components/gatherer/standard/unbinhex/crc/ccitt32.c
-#include "ccitt32_crc32_table.h"
+#include "usb_is_device_crc32.hpp"
 #include "usb_generic.hpp"
 
 #include <libusb.h>
@@ -274,16 +273,6 @@ static void fix_endianness_header(is_nitro_nec_packet_header* header) {
 	header->address = to_le(header->address);
 }
 
-static uint32_t get_crc32_data_comm(uint8_t* data, size_t size) {
-	uint32_t value = 0xFFFFFFFF;
-	for(size_t i = 0; i < size; i++) {
-		uint8_t inner_value = (value >> 24) ^ data[i];
-		value <<= 8;
-		value ^= read_le32(ccitt32_crc32_table, inner_value);
-	}
-	return ~value;
-}
-
 static void apply_enc_dec_action_value(uint32_t action_value, uint32_t rotating_value, uint8_t* data, size_t size_u16) {
 	int increment = 0;
 	bool is_rot_odd = (rotating_value & 1) == 1;
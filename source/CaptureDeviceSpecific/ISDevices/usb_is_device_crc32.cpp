@@ -0,0 +1,47 @@
+#include "usb_is_device_crc32.hpp"
+#include "utils.hpp"
+
+// From web.mit.edu/wwwdev/src/harvest-1.3.pl3/components/gatherer/standard/unbinhex/crc/ccitt32.c
+#include "ccitt32_crc32_table.h"
+
+#define CRC32_NUM_SLICES 8
+
+// Slice-by-8 tables, derived from the byte table so the results are the same.
+// The CRC is MSB first, so the data is read as Big Endian.
+static uint32_t ccitt32_crc32_slice_tables[CRC32_NUM_SLICES][0x100];
+
+static bool build_ccitt32_crc32_slice_tables() {
+	for(int i = 0; i < 0x100; i++)
+		ccitt32_crc32_slice_tables[0][i] = read_le32(ccitt32_crc32_table, i);
+	for(int i = 1; i < CRC32_NUM_SLICES; i++)
+		for(int j = 0; j < 0x100; j++) {
+			uint32_t prev_value = ccitt32_crc32_slice_tables[i - 1][j];
+			ccitt32_crc32_slice_tables[i][j] = (prev_value << 8) ^ ccitt32_crc32_slice_tables[0][prev_value >> 24];
+		}
+	return true;
+}
+
+uint32_t get_crc32_data_comm(const uint8_t* data, size_t size) {
+	static const bool slice_tables_ready = build_ccitt32_crc32_slice_tables();
+	(void)slice_tables_ready;
+	uint32_t value = 0xFFFFFFFF;
+	size_t i = 0;
+	for(; (i + CRC32_NUM_SLICES) <= size; i += CRC32_NUM_SLICES) {
+		uint32_t first_value = value ^ read_be32(data + i);
+		uint32_t second_value = read_be32(data + i + 4);
+		value = ccitt32_crc32_slice_tables[7][first_value >> 24] ^
+		        ccitt32_crc32_slice_tables[6][(first_value >> 16) & 0xFF] ^
+		        ccitt32_crc32_slice_tables[5][(first_value >> 8) & 0xFF] ^
+		        ccitt32_crc32_slice_tables[4][first_value & 0xFF] ^
+		        ccitt32_crc32_slice_tables[3][second_value >> 24] ^
+		        ccitt32_crc32_slice_tables[2][(second_value >> 16) & 0xFF] ^
+		        ccitt32_crc32_slice_tables[1][(second_value >> 8) & 0xFF] ^
+		        ccitt32_crc32_slice_tables[0][second_value & 0xFF];
+	}
+	for(; i < size; i++) {
+		uint8_t inner_value = (value >> 24) ^ data[i];
+		value <<= 8;
+		value ^= read_le32(ccitt32_crc32_table, inner_value);
+	}
+	return ~value;
+}
@@ -48,13 +48,19 @@ static int is_device_libusb_insert_device(std::vector<CaptureDevice> &devices_li
 		return LIBUSB_ERROR_NOT_FOUND;
 	if((usb_descriptor->iManufacturer != usb_device_desc->manufacturer_id) || (usb_descriptor->iProduct != usb_device_desc->product_id))
 		return LIBUSB_ERROR_NOT_FOUND;
+	if(usb_device_cache_lookup(usb_device, usb_device_desc, usb_device_desc->default_interface, devices_list))
+		return LIBUSB_SUCCESS;
 	int result = libusb_open(usb_device, &handle);
 	if((result < 0) || (handle == NULL))
 		return result;
 	if(is_device_libusb_setup_connection(handle, usb_device_desc)) {
 		is_device_device_handlers handlers;
 		handlers.usb_handle = handle;
+		size_t first_new_device = devices_list.size();
+		int old_serial_extra_id = curr_serial_extra_id;
 		is_device_insert_device(devices_list, &handlers, usb_device_desc, curr_serial_extra_id);
+		if(curr_serial_extra_id == old_serial_extra_id)
+			usb_device_cache_store(usb_device, usb_device_desc, devices_list, first_new_device);
 		libusb_release_interface(handle, usb_device_desc->default_interface);
 	}
 	libusb_close(handle);
@@ -35,7 +35,8 @@ static int StartAcquisitionCapture(CaptureData* capture_data, ISDeviceCaptureRec
 	if(ret < 0)
 		return ret;
 	reset_is_device_status(is_device_capture_recv_data);
-	for(int i = 0; i < NUM_CAPTURE_RECEIVED_DATA_BUFFERS; i++)
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		is_device_read_frame_request(capture_data, is_device_get_free_buffer(capture_data, is_device_capture_recv_data), capture_type, index++);
 	return ret;
 }
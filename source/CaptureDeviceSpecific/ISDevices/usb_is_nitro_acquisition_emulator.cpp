@@ -31,6 +31,29 @@
 #define SLEEP_CHECKS_TIME_MS 20
 
 #define SLEEP_TIME_DIVISOR 8
+// Between the frame counter reads, while the frame time is still unknown
+#define START_READ_SLEEP_MS 1
+
+static double get_frame_counter_read_time() {
+	const std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now().time_since_epoch();
+	return diff.count();
+}
+
+static int GetFrameCounterTracked(is_device_device_handlers* handlers, uint16_t* out_frame_count, FramePeriodEstimator &frame_period, const is_device_usb_device* usb_device_desc) {
+	int ret = GetFrameCounter(handlers, out_frame_count, usb_device_desc);
+	if(ret < 0)
+		return ret;
+	// Sometimes the upper 8 bits aren't updated... Use only the lower 8 bits.
+	frame_period.add_read(get_frame_counter_read_time(), (*out_frame_count) & 0xFF);
+	return ret;
+}
+
+static void start_read_sleep(FramePeriodEstimator &frame_period) {
+	if(frame_period.has_period())
+		default_sleep((float)(frame_period.get_period() * 1000.0 / SLEEP_TIME_DIVISOR));
+	else
+		default_sleep(START_READ_SLEEP_MS);
+}
 
 static int drain_frames(is_device_device_handlers* handlers, int num_frames, int start_frames, CaptureScreensType capture_type, const is_device_usb_device* usb_device_desc) {
 	ISNitroEmulatorVideoInputData* video_in_buffer = new ISNitroEmulatorVideoInputData;
@@ -45,7 +68,7 @@ static int drain_frames(is_device_device_handlers* handlers, int num_frames, int
 	return LIBUSB_SUCCESS;
 }
 
-static int StartAcquisitionEmulator(is_device_device_handlers* handlers, uint16_t &out_frame_count, float &single_frame_time, CaptureScreensType capture_type, CaptureSpeedsType capture_speed, const is_device_usb_device* usb_device_desc) {
+static int StartAcquisitionEmulator(is_device_device_handlers* handlers, uint16_t &out_frame_count, float &single_frame_time, FramePeriodEstimator &frame_period, CaptureScreensType capture_type, CaptureSpeedsType capture_speed, const is_device_usb_device* usb_device_desc) {
 	int ret = 0;
 	ret = DisableLca2(handlers, usb_device_desc);
 	if(ret < 0)
@@ -65,15 +88,17 @@ static int StartAcquisitionEmulator(is_device_device_handlers* handlers, uint16_
 		return ret;
 
 	// Get to the closest next frame
+	frame_period.reset();
 	auto clock_start = std::chrono::high_resolution_clock::now();
 	uint16_t oldFrameCount;
 	uint16_t newFrameCount;
-	ret = GetFrameCounter(handlers, &oldFrameCount, usb_device_desc);
+	ret = GetFrameCounterTracked(handlers, &oldFrameCount, frame_period, usb_device_desc);
 	if(ret < 0)
 		return ret;
 	newFrameCount = oldFrameCount;
 	while(newFrameCount == oldFrameCount) {
-		ret = GetFrameCounter(handlers, &newFrameCount, usb_device_desc);
+		start_read_sleep(frame_period);
+		ret = GetFrameCounterTracked(handlers, &newFrameCount, frame_period, usb_device_desc);
 		if(ret < 0)
 			return ret;
 		const auto curr_time = std::chrono::high_resolution_clock::now();
@@ -87,16 +112,16 @@ static int StartAcquisitionEmulator(is_device_device_handlers* handlers, uint16_
 	// We also do this to measure the time that is needed for each frame...
 	// To do so, a minimum of 4 frames is required (FRAME_BUFFER_SIZE - 1 + 4)
 	clock_start = std::chrono::high_resolution_clock::now();
-	ret = GetFrameCounter(handlers, &oldFrameCount, usb_device_desc);
+	ret = GetFrameCounterTracked(handlers, &oldFrameCount, frame_period, usb_device_desc);
 	if(ret < 0)
 		return ret;
 	uint16_t targetFrameCount = (newFrameCount + FRAME_BUFFER_SIZE + 3) & (~(FRAME_BUFFER_SIZE - 1));
 	while(oldFrameCount != targetFrameCount) {
-		ret = GetFrameCounter(handlers, &oldFrameCount, usb_device_desc);
+		// Short enough not to miss the target frame
+		start_read_sleep(frame_period);
+		ret = GetFrameCounterTracked(handlers, &oldFrameCount, frame_period, usb_device_desc);
 		if(ret < 0)
 			return ret;
-		// Placing a sleep of some kind here would be much better...
-		// Though this is only executed for a small time when first connecting...
 		const auto curr_time = std::chrono::high_resolution_clock::now();
 		const std::chrono::duration<double> diff = curr_time - clock_start;
 		// If too much time has passed, the DS is probably either turned off or sleeping. If so, avoid locking up
@@ -115,6 +140,8 @@ static int StartAcquisitionEmulator(is_device_device_handlers* handlers, uint16_
 	// Determine how much time a single frame takes. We'll use it for sleeps
 	if(frame_diff == 0)
 		single_frame_time = 0;
+	else if(frame_period.has_period())
+		single_frame_time = (float)frame_period.get_period();
 	else
 		single_frame_time = diff.count() / frame_diff;
 
@@ -176,7 +203,7 @@ static void frame_wait(float single_frame_time, std::chrono::time_point<std::chr
 		default_sleep(sleep_time * 1000.0f / SLEEP_TIME_DIVISOR);
 }
 
-static int reset_acquisition_frames(CaptureData* capture_data, uint16_t &curr_frame_counter, uint16_t &last_frame_counter, float &single_frame_time, std::chrono::time_point<std::chrono::high_resolution_clock> &clock_last_reset, CaptureScreensType &curr_capture_type, CaptureScreensType wanted_capture_type, CaptureSpeedsType &curr_capture_speed, CaptureSpeedsType wanted_capture_speed, ISDeviceCaptureReceivedData* is_device_capture_recv_data) {
+static int reset_acquisition_frames(CaptureData* capture_data, uint16_t &curr_frame_counter, uint16_t &last_frame_counter, float &single_frame_time, FramePeriodEstimator &frame_period, std::chrono::time_point<std::chrono::high_resolution_clock> &clock_last_reset, CaptureScreensType &curr_capture_type, CaptureScreensType wanted_capture_type, CaptureSpeedsType &curr_capture_speed, CaptureSpeedsType wanted_capture_speed, ISDeviceCaptureReceivedData* is_device_capture_recv_data) {
 	curr_frame_counter += 1;
 
 	if(curr_frame_counter < FRAME_BUFFER_SIZE)
@@ -232,7 +259,7 @@ static int reset_acquisition_frames(CaptureData* capture_data, uint16_t &curr_fr
 				default_sleep(single_frame_time * 1000.0f / SLEEP_TIME_DIVISOR);
 		}
 		// Check how many frames have passed...
-		ret = GetFrameCounter(handlers, &internalFrameCount, usb_device_desc);
+		ret = GetFrameCounterTracked(handlers, &internalFrameCount, frame_period, usb_device_desc);
 		full_internalFrameCount = internalFrameCount;
 		// Sometimes the upper 8 bits aren't updated... Use only the lower 8 bits.
 		internalFrameCount &= 0xFF;
@@ -265,8 +292,12 @@ static int reset_acquisition_frames(CaptureData* capture_data, uint16_t &curr_fr
 		if(is_lid_closed)
 			frame_diff = 0;
 	}
-	if(frame_diff == 0)
+	if(frame_diff == 0) {
 		single_frame_time = 0;
+		frame_period.reset();
+	}
+	else if(frame_period.has_period())
+		single_frame_time = (float)(frame_period.get_period() * multiplier);
 	else
 		single_frame_time = diff.count() / (frame_diff / ((float)multiplier));
 	clock_last_reset = curr_time;
@@ -281,6 +312,8 @@ static int reset_acquisition_frames(CaptureData* capture_data, uint16_t &curr_fr
 		if(ret < 0)
 			return ret;
 		clock_last_reset = std::chrono::high_resolution_clock::now();
+		// The counter starts over
+		frame_period.reset();
 	}
 	ret = UpdateFrameForwardEnable(handlers, true, false, usb_device_desc);
 	if(ret < 0)
@@ -323,10 +356,11 @@ void is_nitro_acquisition_emulator_main_loop(CaptureData* capture_data, ISDevice
 	uint32_t index = 0;
 	uint16_t last_frame_counter = 0;
 	float single_frame_time = 0;
+	FramePeriodEstimator frame_period;
 	uint16_t curr_frame_counter = 0;
 	CaptureScreensType curr_capture_type = capture_data->status.device_specific_status.is_status.capture_type;
 	CaptureSpeedsType curr_capture_speed = capture_data->status.device_specific_status.is_status.capture_speed;
-	int ret = StartAcquisitionEmulator(handlers, last_frame_counter, single_frame_time, curr_capture_type, curr_capture_speed, usb_device_desc);
+	int ret = StartAcquisitionEmulator(handlers, last_frame_counter, single_frame_time, frame_period, curr_capture_type, curr_capture_speed, usb_device_desc);
 	if (ret < 0) {
 		capture_error_print(true, capture_data, "Capture Start: Failed");
 		return;
@@ -352,7 +386,7 @@ void is_nitro_acquisition_emulator_main_loop(CaptureData* capture_data, ISDevice
 			default_sleep(SLEEP_CHECKS_TIME_MS);
 		}
 		capture_data->status.device_specific_status.is_status.curr_delay = last_frame_counter % FRAME_BUFFER_SIZE;
-		ret = reset_acquisition_frames(capture_data, curr_frame_counter, last_frame_counter, single_frame_time, clock_last_reset, curr_capture_type, capture_data->status.device_specific_status.is_status.capture_type, curr_capture_speed, capture_data->status.device_specific_status.is_status.capture_speed, is_device_capture_recv_data);
+		ret = reset_acquisition_frames(capture_data, curr_frame_counter, last_frame_counter, single_frame_time, frame_period, clock_last_reset, curr_capture_type, capture_data->status.device_specific_status.is_status.capture_type, curr_capture_speed, capture_data->status.device_specific_status.is_status.capture_speed, is_device_capture_recv_data);
 		if(ret < 0) {
 			capture_error_print(true, capture_data, "Disconnected: Frame counter reset error");
 			break;
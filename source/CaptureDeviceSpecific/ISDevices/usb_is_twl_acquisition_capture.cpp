@@ -58,13 +58,11 @@ static int process_frame_and_read(CaptureData* capture_data, int internal_index,
 		audio_address += -audio_diff_from_max;
 		audio_length = max_audio_length;
 	}
-	int audio_processed_diff_from_max = (int)(max_audio_length - audio_length_processed);
-	if(audio_processed_diff_from_max >= 0)
-		audio_processed_diff_from_max = 0;
-	else
+	// The lengths come from the device. Never write past the audio chunks
+	if((audio_length_processed + audio_length) > (size_t)max_audio_length)
 		audio_length_processed = max_audio_length - audio_length;
 	CaptureDataSingleBuffer* target = capture_data->data_buffers.GetWriterBuffer(internal_index);
-	CaptureReceived* capture_buf = &target->capture_buf;
+	CaptureReceived* capture_buf = target->capture_buf;
 	int ret = ReadFrame(handlers, ((uint8_t*)&capture_buf->is_twl_capture_received.audio_capture_in) + audio_length_processed, audio_address, audio_length, usb_device_desc);
 	if(ret < 0)
 		return ret;
@@ -81,6 +79,8 @@ static int process_frame_and_read(CaptureData* capture_data, int internal_index,
 		ret = ReadFrame(handlers, (uint8_t*)&capture_buf->is_twl_capture_received.video_capture_in, video_address, (int)video_processed_size, usb_device_desc);
 		if(ret < 0)
 			return ret;
+		target->has_device_frame_counter = true;
+		target->device_frame_counter = read_le32((uint8_t*)&capture_buf->is_twl_capture_received.video_capture_in.frame);
 		const auto curr_time = std::chrono::high_resolution_clock::now();
 		const std::chrono::duration<float> diff = curr_time - (*clock_start);
 		last_frame_length = diff.count();
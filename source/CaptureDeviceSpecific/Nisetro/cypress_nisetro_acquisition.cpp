@@ -225,7 +225,7 @@ static int find_first_vsync_byte(CaptureReceived* capture_buf, size_t read_size)
 static void cypress_output_to_thread(CaptureData* capture_data, int internal_index, std::chrono::time_point<std::chrono::high_resolution_clock>* clock_start, size_t read_size, size_t* scheduled_special_read, bool* recalibration_request) {
 	// Output to the other threads...
 	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(internal_index);
-	int offset = find_first_vsync_byte(&data_buf->capture_buf, read_size);
+	int offset = find_first_vsync_byte(data_buf->capture_buf, read_size);
 	const cyni_device_usb_device* usb_device_info = (const cyni_device_usb_device*)capture_data->status.device.descriptor;
 	if(offset) {
 		if(offset % get_cy_usb_info(usb_device_info)->max_usb_packet_size)
@@ -239,6 +239,7 @@ static void cypress_output_to_thread(CaptureData* capture_data, int internal_ind
 	const std::chrono::duration<double> diff = curr_time - (*clock_start);
 	*clock_start = curr_time;
 	capture_data->data_buffers.WriteToBuffer(NULL, read_size, diff.count(), &capture_data->status.device, internal_index);
+	capture_data->status.transfers_in_flight.frame_done(diff.count());
 	if (capture_data->status.cooldown_curr_in)
 		capture_data->status.cooldown_curr_in = capture_data->status.cooldown_curr_in - 1;
 	capture_data->status.video_wait.unlock();
@@ -263,7 +264,7 @@ static int cypress_device_read_frame_request(CaptureData* capture_data, CypressN
 		*cypress_device_capture_recv_data->scheduled_special_read = 0;
 	}
 	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(cypress_device_capture_recv_data->cb_data.internal_index);
-	uint8_t* buffer = (uint8_t*)&data_buf->capture_buf;
+	uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
 	return ReadFrameAsync((cy_device_device_handlers*)capture_data->handle, buffer, (int)read_size, usb_device_info, &cypress_device_capture_recv_data->cb_data);
 }
 
@@ -358,7 +359,8 @@ static void wait_one_cypress_device_buffer_free(CaptureData* capture_data, Cypre
 	bool done = false;
 	const auto start_time = std::chrono::high_resolution_clock::now();
 	while(!done) {
-		for(int i = 0; i < NUM_NISETRO_CYPRESS_BUFFERS; i++) {
+		int num_in_flight = capture_data->status.transfers_in_flight.get();
+		for(int i = 0; i < num_in_flight; i++) {
 			if(!cypress_device_capture_recv_data[i].in_use)
 				done = true;
 		}
@@ -394,7 +396,8 @@ static CypressNisetroDeviceCaptureReceivedData* cypress_device_get_free_buffer(C
 	wait_one_cypress_device_buffer_free(capture_data, cypress_device_capture_recv_data);
 	if(get_cypress_device_status(cypress_device_capture_recv_data) < 0)
 		return NULL;
-	for(int i = 0; i < NUM_NISETRO_CYPRESS_BUFFERS; i++)
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++)
 		if(!cypress_device_capture_recv_data[i].in_use) {
 			cypress_device_capture_recv_data[i].is_buffer_free_shared_mutex->specific_try_lock(i);
 			cypress_device_capture_recv_data[i].in_use = true;
@@ -470,7 +473,9 @@ static bool cyni_device_acquisition_loop(CaptureData* capture_data, CypressNiset
 		return false;
 	}
 	CypressSetMaxTransferSize(handlers, get_cy_usb_info(usb_device_desc), (size_t)cyni_device_get_video_in_size(usb_device_desc->device_type));
-	for(int i = 0; i < NUM_NISETRO_CYPRESS_BUFFERS; i++) {
+	capture_data->status.transfers_in_flight.reset(NUM_NISETRO_CYPRESS_BUFFERS);
+	int num_in_flight = capture_data->status.transfers_in_flight.get();
+	for(int i = 0; i < num_in_flight; i++) {
 		CypressNisetroDeviceCaptureReceivedData* chosen_buffer = cypress_device_get_free_buffer(capture_data, cypress_device_capture_recv_data);
 		ret = cypress_device_read_frame_request(capture_data, chosen_buffer, index++);
 		if(ret < 0) {
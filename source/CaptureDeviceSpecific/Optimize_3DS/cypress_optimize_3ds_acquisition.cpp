@@ -5,6 +5,7 @@
 #include "cypress_optimize_3ds_communications.hpp"
 #include "cypress_optimize_3ds_acquisition.hpp"
 #include "cypress_optimize_3ds_acquisition_general.hpp"
+#include "cypress_optimize_3ds_frame_parsing.hpp"
 #include "usb_generic.hpp"
 
 #include <libusb.h>
@@ -25,18 +26,6 @@
 // Such an action is allowed under EU law.
 // No reverse engineering of the original software was done to create this.
 
-#define SYNCH_VALUE_OPTIMIZE 0xCC33
-#define SYNCH_VALUE_OPTIMIZE_OLD_FW_565 0xF800
-#define SYNCH_VALUE_OPTIMIZE_OLD_FW_888 0xFF00
-
-#define TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE 0x100000
-#define SINGLE_RING_BUFFER_SLICE_SIZE 0x4000
-#define NUM_OPTIMIZE_3DS_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS (TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE / SINGLE_RING_BUFFER_SLICE_SIZE)
-
-#define NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS (3 * NUM_OPTIMIZE_3DS_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS)
-
-#define OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE (NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS * SINGLE_RING_BUFFER_SLICE_SIZE)
-
 #define MAX_TIME_WAIT 1.0
 #define CAPTURE_START_AGAIN_NO_KEY_TIME 260.0
 #define CAPTURE_START_FAILING_TIME_SINCE_LAST_PARAM_EDIT 180.0
@@ -226,43 +215,11 @@ bool cyop_device_connect_usb(bool print_failed, CaptureData* capture_data, Captu
 }
 
 uint64_t cyop_device_get_video_in_size(const cyop_device_usb_device* usb_device_info, bool is_3d, bool should_be_3d, InputVideoDataType video_data_type) {
-	bool is_rgb888 = video_data_type == OPTIMIZE_RGB888_FORMAT;
-	if(usb_device_info->is_old_firmware) {
-		if(is_rgb888)
-			return sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived);
-		return sizeof(USB5653DSOptimizeOldFirmwareCaptureReceived);
-	}
-	if(is_rgb888) {
-		if(should_be_3d) {
-			if(is_3d)
-				return sizeof(USB8883DSOptimizeCaptureReceived_3D);
-			return sizeof(USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen);
-		}
-		return sizeof(USB8883DSOptimizeCaptureReceived);
-	}
-	if(is_3d)
-		return sizeof(USB5653DSOptimizeCaptureReceived_3D);
-	return sizeof(USB5653DSOptimizeCaptureReceived);
+	return get_video_in_size_optimize_3ds(usb_device_info->is_old_firmware, is_3d, should_be_3d, video_data_type == OPTIMIZE_RGB888_FORMAT, false);
 }
 
 uint64_t cyop_device_get_video_in_size_extra_header(const cyop_device_usb_device* usb_device_info, bool is_3d, bool should_be_3d, InputVideoDataType video_data_type) {
-	bool is_rgb888 = video_data_type == OPTIMIZE_RGB888_FORMAT;
-	if(usb_device_info->is_old_firmware) {
-		if(is_rgb888)
-			return sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived);
-		return sizeof(USB5653DSOptimizeOldFirmwareCaptureReceived);
-	}
-	if(is_rgb888) {
-		if(should_be_3d) {
-			if(is_3d)
-				return sizeof(USB8883DSOptimizeCaptureReceived_3D);
-			return sizeof(USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen);
-		}
-		return sizeof(USB8883DSOptimizeCaptureReceivedExtraHeader);
-	}
-	if(is_3d)
-		return sizeof(USB5653DSOptimizeCaptureReceived_3D);
-	return sizeof(USB5653DSOptimizeCaptureReceivedExtraHeader);
+	return get_video_in_size_optimize_3ds(usb_device_info->is_old_firmware, is_3d, should_be_3d, video_data_type == OPTIMIZE_RGB888_FORMAT, true);
 }
 
 
@@ -342,9 +299,9 @@ static int cypress_device_read_frame_request(CaptureData* capture_data, CypressO
 	cypress_device_capture_recv_data->index = index;
 	cypress_device_capture_recv_data->cb_data.function = cypress_device_read_frame_cb;
 	//size_t read_size = cyop_device_get_video_in_size(usb_device_info, is_3d, is_3d, video_data_type);
-	size_t read_size = SINGLE_RING_BUFFER_SLICE_SIZE;
+	size_t read_size = OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE;
 	int new_buffer_slice_index = ((*cypress_device_capture_recv_data->last_ring_buffer_slice_allocated) + 1) % NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS;
-	uint8_t* buffer = &cypress_device_capture_recv_data->ring_slice_buffer_arr[new_buffer_slice_index * SINGLE_RING_BUFFER_SLICE_SIZE];
+	uint8_t* buffer = &cypress_device_capture_recv_data->ring_slice_buffer_arr[new_buffer_slice_index * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE];
 	cypress_device_capture_recv_data->is_ring_buffer_slice_data_ready_arr[new_buffer_slice_index] = false;
 	cypress_device_capture_recv_data->is_ring_buffer_slice_data_in_use_arr[new_buffer_slice_index] = true;
 	cypress_device_capture_recv_data->buffer_ring_slice_to_array_ptr[new_buffer_slice_index] = cypress_device_capture_recv_data->cb_data.internal_index;
@@ -388,187 +345,28 @@ static void end_cypress_device_read_frame_cb(CypressOptimize3DSDeviceCaptureRece
 		cypress_device_capture_recv_data->is_buffer_free_shared_mutex->specific_unlock(cypress_device_capture_recv_data->cb_data.internal_index);
 }
 
-static USB3DSOptimizeColumnInfo convert_to_column_info(uint16_t value) {
-	// The macos compiler requires this... :/
-	USB3DSOptimizeColumnInfo column_info;
-	column_info.has_extra_header_data_2d_only = (value >> 15) & 1;
-	column_info.buffer_num = (value >> 14) & 1;
-	column_info.unk = (value >> 10) & 0xF;
-	column_info.column_index = value & 0x3FF;
-	return column_info;
-}
-
-static USB3DSOptimizeOldFirmwareColumnInfo convert_to_column_info_old_fw(uint16_t value) {
-	// The macos compiler requires this... :/
-	USB3DSOptimizeOldFirmwareColumnInfo column_info;
-	column_info.is_first_column = (value >> 15) & 1;
-	column_info.extra_column_data = (value >> 13) & 3;
-	column_info.column_index = (value >> 4) & 0x1FF;
-	column_info.fixed = value & 0x0F;
-	return column_info;
-}
-
 static bool get_expect_extra_header_in_buffer(const cyop_device_usb_device* usb_device_desc, uint16_t value) {
-	if(usb_device_desc->is_old_firmware)
-		return false;
-	return convert_to_column_info(value).has_extra_header_data_2d_only;
+	return get_expect_extra_header_in_buffer_optimize_3ds(usb_device_desc->is_old_firmware, value);
 }
 
 static bool get_is_data_2d_only(const cyop_device_usb_device* usb_device_desc, uint16_t value) {
-	if(usb_device_desc->is_o2ds)
-		return true;
-	return convert_to_column_info(value).has_extra_header_data_2d_only;
-}
-
-static bool is_old_fw_column_magic_valid(USB3DSOptimizeOldFirmwareColumnInfo old_fw_column_info, uint16_t magic, uint16_t expected_magic_value) {
-	if(old_fw_column_info.fixed != 5)
-		return false;
-	if((old_fw_column_info.column_index == 1) && (magic != 0))
-		return false;
-	if((old_fw_column_info.column_index != 1) && (magic != expected_magic_value))
-		return false;
-	if((old_fw_column_info.column_index == 0) && (old_fw_column_info.is_first_column == 0))
-		return false;
-	if((old_fw_column_info.column_index != 0) && (old_fw_column_info.is_first_column != 0))
-		return false;
-	return true;
-}
-
-static bool get_is_pos_column_synch_in_buffer(const cyop_device_usb_device* usb_device_desc, bool is_rgb888, uint8_t* buffer, size_t pos_to_check, uint16_t column_index) {
-	if(usb_device_desc->is_old_firmware) {
-		USB3DSOptimizeOldFirmwareColumnInfo old_fw_column_info = convert_to_column_info_old_fw(read_le16(buffer + pos_to_check + 8));
-		uint16_t magic = read_le16(buffer + pos_to_check);
-		if(is_rgb888) {
-			magic ^= 0xA5A5; // For some reason, all bytes are xorred with 0xA5 for Old FW RGB888...
-			old_fw_column_info = convert_to_column_info_old_fw(read_le16(buffer + pos_to_check + 2) ^ 0xA5A5);
-			// extra_column_data is 1 for rgb888 on 2ds...? Would make sense, as it is 2d only...
-			if(!is_old_fw_column_magic_valid(old_fw_column_info, magic, SYNCH_VALUE_OPTIMIZE_OLD_FW_888))
-				return false;
-			return old_fw_column_info.column_index == column_index;
-		}
-		// extra_column_data is 0 for rgb565...?
-		if(!is_old_fw_column_magic_valid(old_fw_column_info, magic, SYNCH_VALUE_OPTIMIZE_OLD_FW_565))
-			return false;
-		return old_fw_column_info.column_index == column_index;
-	}
-	if(read_le16(buffer + pos_to_check) != SYNCH_VALUE_OPTIMIZE)
-		return false;
-	return convert_to_column_info(read_le16(buffer + pos_to_check + 2)).column_index == column_index;
-}
-
-static bool get_is_pos_column_synch_in_buffer(const cyop_device_usb_device* usb_device_desc, bool is_rgb888, uint8_t* buffer, uint16_t column_index) {
-	return get_is_pos_column_synch_in_buffer(usb_device_desc, is_rgb888, buffer, 0, column_index);
-}
-
-static bool get_is_pos_first_synch_in_buffer(const cyop_device_usb_device* usb_device_desc, bool is_rgb888, uint8_t* buffer, size_t pos_to_check) {
-	return get_is_pos_column_synch_in_buffer(usb_device_desc, is_rgb888, buffer, pos_to_check, 0);
+	return get_is_data_2d_only_optimize_3ds(usb_device_desc->is_o2ds, value);
 }
 
 static bool get_is_pos_first_synch_in_buffer(const cyop_device_usb_device* usb_device_desc, InputVideoDataType video_data_type, uint8_t* buffer, size_t pos_to_check) {
-	return get_is_pos_first_synch_in_buffer(usb_device_desc, video_data_type == OPTIMIZE_RGB888_FORMAT, buffer, pos_to_check);
-}
-
-static bool get_is_buffer_rgb565_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB5653DSOptimizeCaptureReceived* real_buffer = &buffer->cypress_optimize_received_565;
-	USB5653DSOptimizeCaptureReceivedExtraHeader* real_buffer_special = &buffer->cypress_optimize_received_565_extra_header;
-	bool is_special = get_expect_extra_header_in_buffer(usb_device_desc, read_le16((uint8_t*)&real_buffer->columns_data[0].header_sound.header_info.column_info));
-	for(int i = 0; i < TOP_WIDTH_3DS; i++)
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
-			return false;
-	if(is_special && (!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer_special->columns_data[TOP_WIDTH_3DS].header_sound, TOP_WIDTH_3DS)))
-		return false;
-	return true;
-}
-
-static bool get_is_buffer_rgb565_3d_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB5653DSOptimizeCaptureReceived_3D* real_buffer = &buffer->cypress_optimize_received_565_3d;
-	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer->columns_data[i].top_r_screen_column.header_sound, i * 2))
-			return false;
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer->columns_data[i].bot_top_l_screens_column.header_sound, (i * 2) + 1))
-			return false;
-	}
-	if(!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer->bottom_only_column.header_sound, TOP_WIDTH_3DS * 2))
-			return false;
-	return true;
-}
-
-static bool get_is_buffer_rgb565_old_firmware_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB5653DSOptimizeOldFirmwareCaptureReceived* real_buffer = &buffer->cypress_optimize_old_firmware_received_565;
-	for(int i = 0; i < TOP_WIDTH_3DS + 1; i++)
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, false, (uint8_t*)&real_buffer->columns_data[i].header, i)) {
-			return false;
-		}
-	return true;
+	return get_is_pos_first_synch_in_buffer_optimize_3ds(usb_device_desc->is_old_firmware, video_data_type == OPTIMIZE_RGB888_FORMAT, buffer, pos_to_check);
 }
 
-static bool get_is_buffer_rgb888_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB8883DSOptimizeCaptureReceived* real_buffer = &buffer->cypress_optimize_received_888;
-	USB8883DSOptimizeCaptureReceivedExtraHeader* real_buffer_special = &buffer->cypress_optimize_received_888_extra_header;
-	bool is_special = get_expect_extra_header_in_buffer(usb_device_desc, read_le16((uint8_t*)&real_buffer->columns_data[0].header_sound.header_info.column_info));
-	for(int i = 0; i < TOP_WIDTH_3DS; i++)
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
-			return false;
-	if(is_special && (!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer_special->columns_data[TOP_WIDTH_3DS].header_sound, TOP_WIDTH_3DS)))
-		return false;
-	return true;
-}
-
-static bool get_is_buffer_rgb888_3d_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB8883DSOptimizeCaptureReceived_3D* real_buffer = &buffer->cypress_optimize_received_888_3d;
-	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->columns_data[i][0].header_sound, i * 2))
-			return false;
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->columns_data[i][1].header_sound, (i * 2) + 1))
-			return false;
-	}
-	if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->bottom_only_column.header_sound, TOP_WIDTH_3DS * 2))
-		return false;
-	return true;
-}
-
-static bool get_is_buffer_rgb888_3d_2d_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen* real_buffer = &buffer->cypress_optimize_received_888_3d_2d;
-	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++) {
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
-			return false;
-	}
-	return true;
-}
-
-static bool get_is_buffer_rgb888_old_firmware_fully_synced(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer) {
-	USB8883DSOptimizeOldFirmwareCaptureReceived* real_buffer = &buffer->cypress_optimize_old_firmware_received_888;
-	for(int i = 0; i < TOP_WIDTH_3DS + 1; i++)
-		if(!get_is_pos_column_synch_in_buffer(usb_device_desc, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
-			return false;
-	return true;
+static bool get_is_buffer_fully_synched(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer, bool is_3d, bool should_be_3d, InputVideoDataType video_data_type) {
+	return get_is_buffer_fully_synched_optimize_3ds(usb_device_desc->is_old_firmware, buffer, is_3d, should_be_3d, video_data_type == OPTIMIZE_RGB888_FORMAT);
 }
 
-static bool get_is_buffer_fully_synched(const cyop_device_usb_device* usb_device_desc, CaptureReceived* buffer, bool is_3d, bool should_be_3d, InputVideoDataType video_data_type) {
-	bool is_rgb888 = video_data_type == OPTIMIZE_RGB888_FORMAT;
-	if(usb_device_desc->is_old_firmware) {
-		if(is_rgb888)
-			return get_is_buffer_rgb888_old_firmware_fully_synced(usb_device_desc, buffer);
-		return get_is_buffer_rgb565_old_firmware_fully_synced(usb_device_desc, buffer);
-	}
-	if(!is_rgb888) {
-		if(!is_3d)
-			return get_is_buffer_rgb565_fully_synced(usb_device_desc, buffer);
-		return get_is_buffer_rgb565_3d_fully_synced(usb_device_desc, buffer);
-	}
-	if(is_3d)
-		return get_is_buffer_rgb888_3d_fully_synced(usb_device_desc, buffer);
-	if(should_be_3d)
-		return get_is_buffer_rgb888_3d_2d_fully_synced(usb_device_desc, buffer);
-	return get_is_buffer_rgb888_fully_synced(usb_device_desc, buffer);
+static size_t get_header_size_optimize_packet(const cyop_device_usb_device* usb_device_desc, InputVideoDataType video_data_type) {
+	return get_header_size_optimize_3ds_packet(usb_device_desc->is_old_firmware, video_data_type == OPTIMIZE_RGB888_FORMAT);
 }
 
 static size_t get_pos_first_synch_in_buffer(const cyop_device_usb_device* usb_device_desc, InputVideoDataType video_data_type, uint8_t* buffer, size_t start_pos) {
-	for(size_t i = (start_pos / 2); i < (SINGLE_RING_BUFFER_SLICE_SIZE / 2); i++) {
-		if(get_is_pos_first_synch_in_buffer(usb_device_desc, video_data_type, buffer, i * 2))
-			return i * 2;
-	}
-	return SINGLE_RING_BUFFER_SLICE_SIZE + 1;
+	return get_pos_first_synch_in_buffer_optimize_3ds(usb_device_desc->is_old_firmware, video_data_type == OPTIMIZE_RGB888_FORMAT, buffer, start_pos);
 }
 
 static int get_num_consecutive_ready_ring_buffer_slices(CypressOptimize3DSDeviceCaptureReceivedData* cypress_device_capture_recv_data, int start_index) {
@@ -586,39 +384,20 @@ static void unlock_buffers_from_x(CypressOptimize3DSDeviceCaptureReceivedData* c
 		unlock_buffer_slice_index(cypress_device_capture_recv_data, (pos_to_unlock + i) % NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS, reset_slice_data_arr_info);
 }
 
-static void copy_slice_data_to_buffer(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size) {
-	size_t start_byte = ((start_slice_index * SINGLE_RING_BUFFER_SLICE_SIZE) + start_slice_pos) % OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE;
-	if((start_byte + copy_size) <= OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE)
-		memcpy(dst, src + start_byte, copy_size);
-	else {
-		size_t upper_read_size = OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE - start_byte;
-		size_t start_read_size = copy_size - upper_read_size;
-		memcpy(dst, src + start_byte, upper_read_size);
-		memcpy(dst + upper_read_size, src, start_read_size);
-	}
-}
-
 static void process_data_buffer(const cyop_device_usb_device* usb_device_desc, InputVideoDataType video_data_type, uint64_t* data, size_t size) {
-	if(!usb_device_desc->is_old_firmware)
-		return;
-	bool is_rgb888 = video_data_type == OPTIMIZE_RGB888_FORMAT;
-	if(!is_rgb888)
-		return;
-	// Annoying, but needed to simplify code elsewhere...
-	for(size_t i = 0; i < (size / sizeof(uint64_t)); i++)
-		data[i] ^= 0xA5A5A5A5A5A5A5A5;
+	process_data_buffer_optimize_3ds(usb_device_desc->is_old_firmware, video_data_type == OPTIMIZE_RGB888_FORMAT, data, size);
 }
 
 static void cypress_output_to_thread(CaptureData* capture_data, uint8_t *buffer_arr, size_t start_slice_index, size_t start_slice_pos, int internal_index, std::chrono::time_point<std::chrono::high_resolution_clock>* clock_start, size_t read_size, bool is_3d, bool should_be_3d, InputVideoDataType video_data_type) {
 	// Output to the other threads...
 	const cyop_device_usb_device* usb_device_desc = (const cyop_device_usb_device*)capture_data->status.device.descriptor;
 	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(internal_index);
-	copy_slice_data_to_buffer((uint8_t*)&data_buf->capture_buf, buffer_arr, start_slice_index, start_slice_pos, read_size);
-	if(!get_is_buffer_fully_synched(usb_device_desc, &data_buf->capture_buf, is_3d, should_be_3d, video_data_type)) {
+	copy_slice_data_to_buffer_optimize_3ds((uint8_t*)data_buf->capture_buf, buffer_arr, start_slice_index, start_slice_pos, read_size);
+	if(!get_is_buffer_fully_synched(usb_device_desc, data_buf->capture_buf, is_3d, should_be_3d, video_data_type)) {
 		capture_data->data_buffers.ReleaseWriterBuffer(internal_index, false);
 		return;
 	}
-	process_data_buffer(usb_device_desc, video_data_type, (uint64_t*)&data_buf->capture_buf, read_size);
+	process_data_buffer(usb_device_desc, video_data_type, (uint64_t*)data_buf->capture_buf, read_size);
 	const auto curr_time = std::chrono::high_resolution_clock::now();
 	const std::chrono::duration<double> diff = curr_time - (*clock_start);
 	*clock_start = curr_time;
@@ -660,8 +439,8 @@ static bool cypress_device_read_frame_not_synchronized(CypressOptimize3DSDeviceC
 			// Increase by two to prevent looping...
 			if(check_index == original_first_slice_to_check)
 				start_result = first_slice_pos_to_check + 2;
-			size_t result = get_pos_first_synch_in_buffer(usb_device_desc, video_data_type, &cypress_device_capture_recv_data->ring_slice_buffer_arr[check_index * SINGLE_RING_BUFFER_SLICE_SIZE], start_result);
-			if(result >= SINGLE_RING_BUFFER_SLICE_SIZE) {
+			size_t result = get_pos_first_synch_in_buffer(usb_device_desc, video_data_type, &cypress_device_capture_recv_data->ring_slice_buffer_arr[check_index * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE], start_result);
+			if(result >= OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) {
 				unlock_buffer_slice_index(cypress_device_capture_recv_data, check_index, true);
 			}
 			else {
@@ -677,15 +456,6 @@ static bool cypress_device_read_frame_not_synchronized(CypressOptimize3DSDeviceC
 	return true;
 }
 
-static size_t get_header_size_optimize_packet(const cyop_device_usb_device* usb_device_desc, InputVideoDataType video_data_type) {
-	if(!usb_device_desc->is_old_firmware)
-		return sizeof(USB3DSOptimizeHeaderData);
-	bool is_rgb888 = video_data_type == OPTIMIZE_RGB888_FORMAT;
-	if(is_rgb888)
-		return sizeof(USB8883DSOptimizeOldFirmwareHeaderData);
-	return sizeof(USB5653DSOptimizeOldFirmwareHeaderData);
-}
-
 static void cypress_device_read_frame_synchronized(CypressOptimize3DSDeviceCaptureReceivedData* cypress_device_capture_recv_data) {
 	const cyop_device_usb_device* usb_device_desc = (const cyop_device_usb_device*)cypress_device_capture_recv_data->capture_data->status.device.descriptor;
 	volatile int read_slice_index = *cypress_device_capture_recv_data->first_usable_ring_buffer_slice_index;
@@ -697,11 +467,11 @@ static void cypress_device_read_frame_synchronized(CypressOptimize3DSDeviceCaptu
 	bool is_3d_data = should_be_3d_data;
 	InputVideoDataType video_data_type = *cypress_device_capture_recv_data->stored_video_data_type;
 	size_t video_in_size = (size_t)cyop_device_get_video_in_size(usb_device_desc, is_3d_data, should_be_3d_data, video_data_type);
-	size_t curr_consecutive_available_bytes = (num_consecutive_ready_buffers * SINGLE_RING_BUFFER_SLICE_SIZE) - read_slice_pos;
+	size_t curr_consecutive_available_bytes = (num_consecutive_ready_buffers * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) - read_slice_pos;
 	size_t header_packet_size = get_header_size_optimize_packet(usb_device_desc, video_data_type);
 	if(curr_consecutive_available_bytes >= header_packet_size) {
 		uint8_t tmp_buffer[sizeof(USB5653DSOptimizeOldFirmwareHeaderData)];
-		copy_slice_data_to_buffer(tmp_buffer, cypress_device_capture_recv_data->ring_slice_buffer_arr, read_slice_index, read_slice_pos, header_packet_size);
+		copy_slice_data_to_buffer_optimize_3ds(tmp_buffer, cypress_device_capture_recv_data->ring_slice_buffer_arr, read_slice_index, read_slice_pos, header_packet_size);
 		if(!get_is_pos_first_synch_in_buffer(usb_device_desc, video_data_type, tmp_buffer, 0)) {
 			*cypress_device_capture_recv_data->is_synchronized = false;
 			return;
@@ -720,8 +490,8 @@ static void cypress_device_read_frame_synchronized(CypressOptimize3DSDeviceCaptu
 		cypress_output_to_thread(cypress_device_capture_recv_data->capture_data, cypress_device_capture_recv_data->ring_slice_buffer_arr, read_slice_index, read_slice_pos, 0, cypress_device_capture_recv_data->clock_start, video_in_size, is_3d_data, should_be_3d_data, video_data_type);
 		// Keep the ring buffer going.
 		size_t raw_new_pos = read_slice_pos + video_in_size;
-		int new_slice_index = (int)(read_slice_index + (raw_new_pos / SINGLE_RING_BUFFER_SLICE_SIZE));
-		size_t new_slice_pos = raw_new_pos % SINGLE_RING_BUFFER_SLICE_SIZE;
+		int new_slice_index = (int)(read_slice_index + (raw_new_pos / OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE));
+		size_t new_slice_pos = raw_new_pos % OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE;
 		new_slice_index %= NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS;
 		// Fully unlock used buffers
 		unlock_buffers_from_x(cypress_device_capture_recv_data, read_slice_index, (new_slice_index + NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS - read_slice_index) % NUM_TOTAL_OPTIMIZE_3DS_CYPRESS_BUFFERS, true);
@@ -743,7 +513,7 @@ static void cypress_device_read_frame_cb(void* user_data, int transfer_length, i
 	CypressOptimize3DSDeviceCaptureReceivedData* cypress_device_capture_recv_data = (CypressOptimize3DSDeviceCaptureReceivedData*)user_data;
 	if((*cypress_device_capture_recv_data->status) < 0)
 		return end_cypress_device_read_frame_cb(cypress_device_capture_recv_data, true);
-	if((transfer_status != LIBUSB_TRANSFER_COMPLETED) || (transfer_length < SINGLE_RING_BUFFER_SLICE_SIZE)) {
+	if((transfer_status != LIBUSB_TRANSFER_COMPLETED) || (transfer_length < OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE)) {
 		int error = LIBUSB_ERROR_OTHER;
 		if(transfer_status == LIBUSB_TRANSFER_TIMED_OUT)
 			error = LIBUSB_ERROR_TIMEOUT;
@@ -242,6 +242,9 @@ static const cyop_device_usb_device* all_usb_cyop_device_devices_desc[] = {
 	&cypress_optimize_old_old_2ds_instantiated_device,
 };
 
+// Stays one byte at a time. Because of the edited first entry, the table
+// is not linear anymore, so slicing it would give different results.
+// It only ever runs on the EEPROM data anyway.
 static uint32_t calc_crc32_adler(uint8_t* data, size_t size) {
 	uint32_t value = 0xFFFFFFFF;
 	for(size_t i = 0; i < size; i++) {
@@ -0,0 +1,244 @@
+#include "cypress_optimize_3ds_frame_parsing.hpp"
+
+#include <cstring>
+
+// This code was developed by exclusively looking at Wireshark USB packet
+// captures to learn the USB device's protocol.
+// As such, it was developed in a clean room environment, to provide
+// compatibility of the USB device with more (and more modern) hardware.
+// Such an action is allowed under EU law.
+// No reverse engineering of the original software was done to create this.
+
+uint64_t get_video_in_size_optimize_3ds(bool is_old_firmware, bool is_3d, bool should_be_3d, bool is_rgb888, bool has_extra_header) {
+	if(is_old_firmware) {
+		if(is_rgb888)
+			return sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived);
+		return sizeof(USB5653DSOptimizeOldFirmwareCaptureReceived);
+	}
+	if(is_rgb888) {
+		if(should_be_3d) {
+			if(is_3d)
+				return sizeof(USB8883DSOptimizeCaptureReceived_3D);
+			return sizeof(USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen);
+		}
+		if(has_extra_header)
+			return sizeof(USB8883DSOptimizeCaptureReceivedExtraHeader);
+		return sizeof(USB8883DSOptimizeCaptureReceived);
+	}
+	if(is_3d)
+		return sizeof(USB5653DSOptimizeCaptureReceived_3D);
+	if(has_extra_header)
+		return sizeof(USB5653DSOptimizeCaptureReceivedExtraHeader);
+	return sizeof(USB5653DSOptimizeCaptureReceived);
+}
+
+static USB3DSOptimizeColumnInfo convert_to_column_info(uint16_t value) {
+	// The macos compiler requires this... :/
+	USB3DSOptimizeColumnInfo column_info;
+	column_info.has_extra_header_data_2d_only = (value >> 15) & 1;
+	column_info.buffer_num = (value >> 14) & 1;
+	column_info.unk = (value >> 10) & 0xF;
+	column_info.column_index = value & 0x3FF;
+	return column_info;
+}
+
+static USB3DSOptimizeOldFirmwareColumnInfo convert_to_column_info_old_fw(uint16_t value) {
+	// The macos compiler requires this... :/
+	USB3DSOptimizeOldFirmwareColumnInfo column_info;
+	column_info.is_first_column = (value >> 15) & 1;
+	column_info.extra_column_data = (value >> 13) & 3;
+	column_info.column_index = (value >> 4) & 0x1FF;
+	column_info.fixed = value & 0x0F;
+	return column_info;
+}
+
+bool get_expect_extra_header_in_buffer_optimize_3ds(bool is_old_firmware, uint16_t value) {
+	if(is_old_firmware)
+		return false;
+	return convert_to_column_info(value).has_extra_header_data_2d_only;
+}
+
+bool get_is_data_2d_only_optimize_3ds(bool is_o2ds, uint16_t value) {
+	if(is_o2ds)
+		return true;
+	return convert_to_column_info(value).has_extra_header_data_2d_only;
+}
+
+static bool is_old_fw_column_magic_valid(USB3DSOptimizeOldFirmwareColumnInfo old_fw_column_info, uint16_t magic, uint16_t expected_magic_value) {
+	if(old_fw_column_info.fixed != 5)
+		return false;
+	if((old_fw_column_info.column_index == 1) && (magic != 0))
+		return false;
+	if((old_fw_column_info.column_index != 1) && (magic != expected_magic_value))
+		return false;
+	if((old_fw_column_info.column_index == 0) && (old_fw_column_info.is_first_column == 0))
+		return false;
+	if((old_fw_column_info.column_index != 0) && (old_fw_column_info.is_first_column != 0))
+		return false;
+	return true;
+}
+
+static bool get_is_pos_column_synch_in_buffer(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, size_t pos_to_check, uint16_t column_index) {
+	if(is_old_firmware) {
+		USB3DSOptimizeOldFirmwareColumnInfo old_fw_column_info = convert_to_column_info_old_fw(read_le16(buffer + pos_to_check + 8));
+		uint16_t magic = read_le16(buffer + pos_to_check);
+		if(is_rgb888) {
+			magic ^= 0xA5A5; // For some reason, all bytes are xorred with 0xA5 for Old FW RGB888...
+			old_fw_column_info = convert_to_column_info_old_fw(read_le16(buffer + pos_to_check + 2) ^ 0xA5A5);
+			// extra_column_data is 1 for rgb888 on 2ds...? Would make sense, as it is 2d only...
+			if(!is_old_fw_column_magic_valid(old_fw_column_info, magic, SYNCH_VALUE_OPTIMIZE_OLD_FW_888))
+				return false;
+			return old_fw_column_info.column_index == column_index;
+		}
+		// extra_column_data is 0 for rgb565...?
+		if(!is_old_fw_column_magic_valid(old_fw_column_info, magic, SYNCH_VALUE_OPTIMIZE_OLD_FW_565))
+			return false;
+		return old_fw_column_info.column_index == column_index;
+	}
+	if(read_le16(buffer + pos_to_check) != SYNCH_VALUE_OPTIMIZE)
+		return false;
+	return convert_to_column_info(read_le16(buffer + pos_to_check + 2)).column_index == column_index;
+}
+
+static bool get_is_pos_column_synch_in_buffer(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, uint16_t column_index) {
+	return get_is_pos_column_synch_in_buffer(is_old_firmware, is_rgb888, buffer, 0, column_index);
+}
+
+bool get_is_pos_first_synch_in_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, size_t pos_to_check) {
+	return get_is_pos_column_synch_in_buffer(is_old_firmware, is_rgb888, buffer, pos_to_check, 0);
+}
+
+static bool get_is_buffer_rgb565_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB5653DSOptimizeCaptureReceived* real_buffer = &buffer->cypress_optimize_received_565;
+	USB5653DSOptimizeCaptureReceivedExtraHeader* real_buffer_special = &buffer->cypress_optimize_received_565_extra_header;
+	bool is_special = get_expect_extra_header_in_buffer_optimize_3ds(is_old_firmware, read_le16((uint8_t*)&real_buffer->columns_data[0].header_sound.header_info.column_info));
+	for(int i = 0; i < TOP_WIDTH_3DS; i++)
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
+			return false;
+	if(is_special && (!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer_special->columns_data[TOP_WIDTH_3DS].header_sound, TOP_WIDTH_3DS)))
+		return false;
+	return true;
+}
+
+static bool get_is_buffer_rgb565_3d_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB5653DSOptimizeCaptureReceived_3D* real_buffer = &buffer->cypress_optimize_received_565_3d;
+	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer->columns_data[i].top_r_screen_column.header_sound, i * 2))
+			return false;
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer->columns_data[i].bot_top_l_screens_column.header_sound, (i * 2) + 1))
+			return false;
+	}
+	if(!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer->bottom_only_column.header_sound, TOP_WIDTH_3DS * 2))
+			return false;
+	return true;
+}
+
+static bool get_is_buffer_rgb565_old_firmware_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB5653DSOptimizeOldFirmwareCaptureReceived* real_buffer = &buffer->cypress_optimize_old_firmware_received_565;
+	for(int i = 0; i < TOP_WIDTH_3DS + 1; i++)
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, false, (uint8_t*)&real_buffer->columns_data[i].header, i)) {
+			return false;
+		}
+	return true;
+}
+
+static bool get_is_buffer_rgb888_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB8883DSOptimizeCaptureReceived* real_buffer = &buffer->cypress_optimize_received_888;
+	USB8883DSOptimizeCaptureReceivedExtraHeader* real_buffer_special = &buffer->cypress_optimize_received_888_extra_header;
+	bool is_special = get_expect_extra_header_in_buffer_optimize_3ds(is_old_firmware, read_le16((uint8_t*)&real_buffer->columns_data[0].header_sound.header_info.column_info));
+	for(int i = 0; i < TOP_WIDTH_3DS; i++)
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
+			return false;
+	if(is_special && (!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer_special->columns_data[TOP_WIDTH_3DS].header_sound, TOP_WIDTH_3DS)))
+		return false;
+	return true;
+}
+
+static bool get_is_buffer_rgb888_3d_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB8883DSOptimizeCaptureReceived_3D* real_buffer = &buffer->cypress_optimize_received_888_3d;
+	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->columns_data[i][0].header_sound, i * 2))
+			return false;
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->columns_data[i][1].header_sound, (i * 2) + 1))
+			return false;
+	}
+	if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->bottom_only_column.header_sound, TOP_WIDTH_3DS * 2))
+		return false;
+	return true;
+}
+
+static bool get_is_buffer_rgb888_3d_2d_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB8883DSOptimizeCaptureReceived_3D_Forced2DSingleScreen* real_buffer = &buffer->cypress_optimize_received_888_3d_2d;
+	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++) {
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
+			return false;
+	}
+	return true;
+}
+
+static bool get_is_buffer_rgb888_old_firmware_fully_synced(bool is_old_firmware, CaptureReceived* buffer) {
+	USB8883DSOptimizeOldFirmwareCaptureReceived* real_buffer = &buffer->cypress_optimize_old_firmware_received_888;
+	for(int i = 0; i < TOP_WIDTH_3DS + 1; i++)
+		if(!get_is_pos_column_synch_in_buffer(is_old_firmware, true, (uint8_t*)&real_buffer->columns_data[i].header_sound, i))
+			return false;
+	return true;
+}
+
+bool get_is_buffer_fully_synched_optimize_3ds(bool is_old_firmware, CaptureReceived* buffer, bool is_3d, bool should_be_3d, bool is_rgb888) {
+	if(is_old_firmware) {
+		if(is_rgb888)
+			return get_is_buffer_rgb888_old_firmware_fully_synced(is_old_firmware, buffer);
+		return get_is_buffer_rgb565_old_firmware_fully_synced(is_old_firmware, buffer);
+	}
+	if(!is_rgb888) {
+		if(!is_3d)
+			return get_is_buffer_rgb565_fully_synced(is_old_firmware, buffer);
+		return get_is_buffer_rgb565_3d_fully_synced(is_old_firmware, buffer);
+	}
+	if(is_3d)
+		return get_is_buffer_rgb888_3d_fully_synced(is_old_firmware, buffer);
+	if(should_be_3d)
+		return get_is_buffer_rgb888_3d_2d_fully_synced(is_old_firmware, buffer);
+	return get_is_buffer_rgb888_fully_synced(is_old_firmware, buffer);
+}
+
+size_t get_header_size_optimize_3ds_packet(bool is_old_firmware, bool is_rgb888) {
+	if(!is_old_firmware)
+		return sizeof(USB3DSOptimizeHeaderData);
+	if(is_rgb888)
+		return sizeof(USB8883DSOptimizeOldFirmwareHeaderData);
+	return sizeof(USB5653DSOptimizeOldFirmwareHeaderData);
+}
+
+size_t get_pos_first_synch_in_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint8_t* buffer, size_t start_pos) {
+	// The whole header is checked. Do not read past the end of the slice,
+	// as it may be the last one
+	size_t header_packet_size = get_header_size_optimize_3ds_packet(is_old_firmware, is_rgb888);
+	for(size_t i = (start_pos / 2); i <= ((OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE - header_packet_size) / 2); i++) {
+		if(get_is_pos_first_synch_in_buffer_optimize_3ds(is_old_firmware, is_rgb888, buffer, i * 2))
+			return i * 2;
+	}
+	return OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE + 1;
+}
+
+void copy_slice_data_to_buffer_optimize_3ds(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size) {
+	size_t start_byte = ((start_slice_index * OPTIMIZE_3DS_SINGLE_RING_BUFFER_SLICE_SIZE) + start_slice_pos) % OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE;
+	if((start_byte + copy_size) <= OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE)
+		memcpy(dst, src + start_byte, copy_size);
+	else {
+		size_t upper_read_size = OPTIMIZE_3DS_TOTAL_BUFFERS_SIZE - start_byte;
+		size_t start_read_size = copy_size - upper_read_size;
+		memcpy(dst, src + start_byte, upper_read_size);
+		memcpy(dst + upper_read_size, src, start_read_size);
+	}
+}
+
+void process_data_buffer_optimize_3ds(bool is_old_firmware, bool is_rgb888, uint64_t* data, size_t size) {
+	if(!is_old_firmware)
+		return;
+	if(!is_rgb888)
+		return;
+	// Annoying, but needed to simplify code elsewhere...
+	for(size_t i = 0; i < (size / sizeof(uint64_t)); i++)
+		data[i] ^= 0xA5A5A5A5A5A5A5A5;
+}
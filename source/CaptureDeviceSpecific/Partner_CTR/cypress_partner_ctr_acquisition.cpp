@@ -5,6 +5,7 @@
 #include "cypress_partner_ctr_communications.hpp"
 #include "cypress_partner_ctr_acquisition.hpp"
 #include "cypress_partner_ctr_acquisition_general.hpp"
+#include "cypress_partner_ctr_frame_parsing.hpp"
 #include "usb_generic.hpp"
 
 #include <libusb.h>
@@ -22,19 +23,6 @@
 #define BATTERY_TIMEOUT 10.0
 #define SLEEP_RESET_TIME_MS 2000
 
-#define SYNCH_VALUE_PARTNER_CTR PARTNER_CTR_CAPTURE_BASE_COMMAND
-
-#define TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE 0x100000
-#define SINGLE_RING_BUFFER_SLICE_SIZE 0x10000
-#define NUM_PARTNER_CTR_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS (TOTAL_WANTED_CONCURRENTLY_RUNNING_BUFFER_SIZE / SINGLE_RING_BUFFER_SLICE_SIZE)
-
-#define NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS (3 * NUM_PARTNER_CTR_CYPRESS_CONCURRENTLY_RUNNING_BUFFERS)
-
-#define PARTNER_CTR_TOTAL_BUFFERS_SIZE (NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS * SINGLE_RING_BUFFER_SLICE_SIZE)
-
-#define ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA ((size_t)-1)
-#define ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED ((size_t)-2)
-
 #define MAX_TIME_WAIT 1.0
 
 #define PARTNER_CTR_CYPRESS_USB_WINDOWS_DRIVER CYPRESS_WINDOWS_DEFAULT_USB_DRIVER
@@ -181,9 +169,9 @@ static int cypress_device_read_frame_request(CaptureData* capture_data, CypressP
 	cypress_device_capture_recv_data->index = index;
 	cypress_device_capture_recv_data->cb_data.function = cypress_device_read_frame_cb;
 	//size_t read_size = cypart_device_get_video_in_size(is_3d);
-	size_t read_size = SINGLE_RING_BUFFER_SLICE_SIZE;
+	size_t read_size = PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE;
 	int new_buffer_slice_index = ((*cypress_device_capture_recv_data->last_ring_buffer_slice_allocated) + 1) % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS;
-	uint8_t* buffer = &cypress_device_capture_recv_data->ring_slice_buffer_arr[new_buffer_slice_index * SINGLE_RING_BUFFER_SLICE_SIZE];
+	uint8_t* buffer = &cypress_device_capture_recv_data->ring_slice_buffer_arr[new_buffer_slice_index * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE];
 	cypress_device_capture_recv_data->is_ring_buffer_slice_data_ready_arr[new_buffer_slice_index] = false;
 	cypress_device_capture_recv_data->is_ring_buffer_slice_data_in_use_arr[new_buffer_slice_index] = true;
 	cypress_device_capture_recv_data->buffer_ring_slice_to_array_ptr[new_buffer_slice_index] = cypress_device_capture_recv_data->cb_data.internal_index;
@@ -227,52 +215,6 @@ static void end_cypress_device_read_frame_cb(CypressPartnerCTRDeviceCaptureRecei
 		cypress_device_capture_recv_data->is_buffer_free_shared_mutex->specific_unlock(cypress_device_capture_recv_data->cb_data.internal_index);
 }
 
-static PartnerCTRCaptureCommand read_partner_ctr_base_command(uint8_t* data) {
-	PartnerCTRCaptureCommand out_cmd;
-	// Important: Ensure the data after the buffers for a single frame
-	// is stopped by wrong magic value...
-	out_cmd.magic = read_le16(data, 0);
-	out_cmd.command = read_le16(data, 1);
-	out_cmd.payload_size = read_le32(data, 1);
-	return out_cmd;
-}
-
-static size_t get_partner_ctr_size_command_header(PartnerCTRCaptureCommand read_command) {
-	switch (read_command.command) {
-		case PARTNER_CTR_CAPTURE_COMMAND_INPUT:
-			return sizeof(PartnerCTRCaptureCommandHeader0F);
-		case PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN:
-			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
-		case PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN:
-			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
-		case PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN:
-			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
-		case PARTNER_CTR_CAPTURE_COMMAND_AUDIO:
-			return sizeof(PartnerCTRCaptureCommandHeaderC7);
-		default:
-			ActualConsoleOutTextError("Partner CTR Capture: Unknown command found! " + std::to_string(read_command.command));
-			return sizeof(PartnerCTRCaptureCommandHeader0F);
-	}
-}
-
-static bool get_is_pos_synch_in_buffer(uint8_t* buffer, size_t pos_to_check) {
-	PartnerCTRCaptureCommand base_command = read_partner_ctr_base_command(buffer + pos_to_check);
-	return base_command.magic == SYNCH_VALUE_PARTNER_CTR;
-}
-
-static bool get_is_pos_first_synch_in_buffer(uint8_t* buffer, size_t pos_to_check) {
-	PartnerCTRCaptureCommand base_command = read_partner_ctr_base_command(buffer + pos_to_check);
-	return (base_command.magic == SYNCH_VALUE_PARTNER_CTR) && (base_command.command == PARTNER_CTR_CAPTURE_COMMAND_INPUT);
-}
-
-static size_t get_pos_first_synch_in_buffer(uint8_t* buffer, size_t start_pos) {
-	for(size_t i = (start_pos / 2); i < (SINGLE_RING_BUFFER_SLICE_SIZE / 2); i++) {
-		if(get_is_pos_first_synch_in_buffer(buffer, i * 2))
-			return i * 2;
-	}
-	return SINGLE_RING_BUFFER_SLICE_SIZE + 1;
-}
-
 static int get_num_consecutive_ready_ring_buffer_slices(CypressPartnerCTRDeviceCaptureReceivedData* cypress_device_capture_recv_data, int start_index) {
 	for(int i = 0; i < NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS; i++) {
 		int index_check = (start_index + i) % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS;
@@ -288,24 +230,12 @@ static void unlock_buffers_from_x(CypressPartnerCTRDeviceCaptureReceivedData* cy
 		unlock_buffer_slice_index(cypress_device_capture_recv_data, (pos_to_unlock + i) % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS, reset_slice_data_arr_info);
 }
 
-static void copy_slice_data_to_buffer(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size) {
-	size_t start_byte = ((start_slice_index * SINGLE_RING_BUFFER_SLICE_SIZE) + start_slice_pos) % PARTNER_CTR_TOTAL_BUFFERS_SIZE;
-	if((start_byte + copy_size) <= PARTNER_CTR_TOTAL_BUFFERS_SIZE)
-		memcpy(dst, src + start_byte, copy_size);
-	else {
-		size_t upper_read_size = PARTNER_CTR_TOTAL_BUFFERS_SIZE - start_byte;
-		size_t start_read_size = copy_size - upper_read_size;
-		memcpy(dst, src + start_byte, upper_read_size);
-		memcpy(dst + upper_read_size, src, start_read_size);
-	}
-}
-
 static void cypress_output_to_thread(CaptureData* capture_data, uint8_t *buffer_arr, size_t start_slice_index, size_t start_slice_pos, int internal_index, std::chrono::time_point<std::chrono::high_resolution_clock>* clock_start, size_t read_size, bool is_3d, bool should_be_3d) {
 	// Output to the other threads...
 	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer(internal_index);
-	copy_slice_data_to_buffer((uint8_t*)&data_buf->capture_buf, buffer_arr, start_slice_index, start_slice_pos, read_size);
+	copy_slice_data_to_buffer_partner_ctr((uint8_t*)data_buf->capture_buf, buffer_arr, start_slice_index, start_slice_pos, read_size);
 	// Ensure the buffer is ended by non-valid data...
-	write_le16(((uint8_t*)&data_buf->capture_buf) + read_size, 0xFFFF);
+	write_le16(((uint8_t*)data_buf->capture_buf) + read_size, 0xFFFF);
 	const auto curr_time = std::chrono::high_resolution_clock::now();
 	const std::chrono::duration<double> diff = curr_time - (*clock_start);
 	*clock_start = curr_time;
@@ -345,8 +275,8 @@ static bool cypress_device_read_frame_not_synchronized(CypressPartnerCTRDeviceCa
 			// Increase by two to prevent looping...
 			if(check_index == original_first_slice_to_check)
 				start_result = first_slice_pos_to_check + 2;
-			size_t result = get_pos_first_synch_in_buffer(&cypress_device_capture_recv_data->ring_slice_buffer_arr[check_index * SINGLE_RING_BUFFER_SLICE_SIZE], start_result);
-			if(result >= SINGLE_RING_BUFFER_SLICE_SIZE) {
+			size_t result = get_pos_first_synch_in_buffer_partner_ctr(&cypress_device_capture_recv_data->ring_slice_buffer_arr[check_index * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE], start_result);
+			if(result >= PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) {
 				unlock_buffer_slice_index(cypress_device_capture_recv_data, check_index, true);
 			}
 			else {
@@ -362,200 +292,6 @@ static bool cypress_device_read_frame_not_synchronized(CypressPartnerCTRDeviceCa
 	return true;
 }
 
-static PartnerCTRCaptureCommand get_command_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
-	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
-	copy_slice_data_to_buffer(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommand));
-
-	return read_partner_ctr_base_command(tmp_buffer);
-}
-
-static PartnerCTRCaptureCommandHeaderCxScreen get_command_screen_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
-	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommandHeaderCxScreen)];
-	copy_slice_data_to_buffer(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommandHeaderCxScreen));
-
-	PartnerCTRCaptureCommandHeaderCxScreen out_cmd;
-
-	out_cmd.command = read_partner_ctr_base_command(tmp_buffer);
-	out_cmd.index_kind = tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
-	out_cmd.index = read_le16(tmp_buffer + sizeof(PartnerCTRCaptureCommand) + 1);
-	out_cmd.unk = tmp_buffer[sizeof(PartnerCTRCaptureCommand) + 3];
-	for(int i = 0; i < 2; i++)
-		out_cmd.unk2[i] = read_le16(tmp_buffer + sizeof(PartnerCTRCaptureCommand) + 4, i);
-
-	return out_cmd;
-}
-
-static size_t get_pos_next_command_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
-	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
-	copy_slice_data_to_buffer(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommand));
-
-	PartnerCTRCaptureCommand read_command = read_partner_ctr_base_command(tmp_buffer);
-	return curr_pos + get_partner_ctr_size_command_header(read_command) + read_command.payload_size;
-}
-
-static size_t find_pos_partner_ctr_x_screen(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos, size_t available_bytes) {
-	if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
-		return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
-
-	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
-	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
-		return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
-	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
-		return curr_pos;
-
-	while(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_AUDIO) {
-		curr_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, curr_pos);
-
-		if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
-			return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
-
-		read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
-		if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
-			return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
-	}
-
-	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
-		return curr_pos;
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_INPUT)
-		curr_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, curr_pos);
-
-	if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
-		return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
-	read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
-	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
-		return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
-
-	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
-		return curr_pos;
-	ActualConsoleOutTextError("Partner CTR Capture: Unknown command found! " + std::to_string(read_command.command));
-	return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
-}
-
-// Package together a frame
-static bool is_valid_frame_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t available_bytes, bool &enabled_3d, size_t &out_end_pos, bool &synchronized) {
-	bool has_top = false;
-	bool has_top_second = false;
-	bool has_bottom = false;
-	size_t first_screen_pos = 0;
-	size_t second_screen_pos = 0;
-	size_t third_screen_pos = 0;
-	size_t top_screen_pos = 0;
-	out_end_pos = 0;
-
-	first_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, 0, available_bytes);
-	if(first_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
-		return false;
-	if(first_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
-		synchronized = false;
-		return false;
-	}
-	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, first_screen_pos);
-
-	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, first_screen_pos);
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
-		has_top = true;
-		top_screen_pos = first_screen_pos;
-	}
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
-		has_bottom = true;
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
-		has_top_second = true;
-
-	second_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, out_end_pos, available_bytes);
-	if(second_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
-		return false;
-	if(second_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
-		synchronized = false;
-		return false;
-	}
-	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, second_screen_pos);
-
-	read_command = get_command_partner_ctr(data, slice_index, start_pos, second_screen_pos);
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
-		has_top = true;
-		top_screen_pos = second_screen_pos;
-	}
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
-		has_bottom = true;
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
-		has_top_second = true;
-
-	if(enabled_3d && has_top) {
-		if(out_end_pos > available_bytes)
-			return false;
-
-		PartnerCTRCaptureCommandHeaderCxScreen top_screen_command = get_command_screen_partner_ctr(data, slice_index, start_pos, top_screen_pos);
-		// Does this frame support 3D?
-		if((top_screen_command.index_kind == PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_2D_TOP) && (!has_top_second))
-			enabled_3d = false;
-	}
-
-	if(!enabled_3d) {
-		if(!(has_top && has_bottom)) {
-			synchronized = false;
-			return false;
-		}
-		if(out_end_pos > available_bytes)
-			return false;
-
-		return true;
-	}
-
-	third_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, out_end_pos, available_bytes);
-	if(third_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
-		return false;
-	if(third_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
-		synchronized = false;
-		return false;
-	}
-	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, third_screen_pos);
-
-	read_command = get_command_partner_ctr(data, slice_index, start_pos, third_screen_pos);
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
-		has_top = true;
-		top_screen_pos = third_screen_pos;
-	}
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
-		has_bottom = true;
-	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
-		has_top_second = true;
-
-	if(!(has_top && has_bottom && has_top_second)) {
-		synchronized = false;
-		return false;
-	}
-	if(out_end_pos > available_bytes)
-		return false;
-
-	return true;
-}
-
-// Package together a frame by calling is_valid_frame_partner_ctr,
-// then try adding to the end of it audio data, if present and read...
-static bool is_valid_frame_partner_ctr_attempt_add_sound(uint8_t* data, size_t slice_index, size_t start_pos, size_t available_bytes, bool &enabled_3d, size_t &out_end_pos, bool &synchronized) {
-	bool is_valid = is_valid_frame_partner_ctr(data, slice_index, start_pos, available_bytes, enabled_3d, out_end_pos, synchronized);
-	if(!is_valid)
-		return false;
-
-	if((out_end_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
-		return true;
-
-	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, out_end_pos);
-	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
-		return true;
-
-	if(read_command.command != PARTNER_CTR_CAPTURE_COMMAND_AUDIO)
-		return true;
-
-	size_t tentative_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, out_end_pos);
-
-	if(tentative_pos > available_bytes)
-		return true;
-
-	out_end_pos = tentative_pos;
-	return true;
-}
-
 static void cypress_device_read_frame_synchronized(CypressPartnerCTRDeviceCaptureReceivedData* cypress_device_capture_recv_data) {
 	volatile int read_slice_index = *cypress_device_capture_recv_data->first_usable_ring_buffer_slice_index;
 	volatile size_t read_slice_pos = *cypress_device_capture_recv_data->last_used_ring_buffer_slice_pos;
@@ -564,7 +300,7 @@ static void cypress_device_read_frame_synchronized(CypressPartnerCTRDeviceCaptur
 	bool is_3d_data = should_be_3d_data;
 	size_t final_data_size = 0;
 	bool synchronized = true;
-	size_t curr_consecutive_available_bytes = (num_consecutive_ready_buffers * SINGLE_RING_BUFFER_SLICE_SIZE) - read_slice_pos;
+	size_t curr_consecutive_available_bytes = (num_consecutive_ready_buffers * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) - read_slice_pos;
 	bool is_data_ready = is_valid_frame_partner_ctr_attempt_add_sound(cypress_device_capture_recv_data->ring_slice_buffer_arr, read_slice_index, read_slice_pos, curr_consecutive_available_bytes, is_3d_data, final_data_size, synchronized);
 	if((!is_data_ready) && (!synchronized)) {
 		*cypress_device_capture_recv_data->is_synchronized = false;
@@ -575,8 +311,8 @@ static void cypress_device_read_frame_synchronized(CypressPartnerCTRDeviceCaptur
 		cypress_output_to_thread(cypress_device_capture_recv_data->capture_data, cypress_device_capture_recv_data->ring_slice_buffer_arr, read_slice_index, read_slice_pos, 0, cypress_device_capture_recv_data->clock_start, final_data_size, is_3d_data, should_be_3d_data);
 		// Keep the ring buffer going.
 		size_t raw_new_pos = read_slice_pos + final_data_size;
-		int new_slice_index = (int)(read_slice_index + (raw_new_pos / SINGLE_RING_BUFFER_SLICE_SIZE));
-		size_t new_slice_pos = raw_new_pos % SINGLE_RING_BUFFER_SLICE_SIZE;
+		int new_slice_index = (int)(read_slice_index + (raw_new_pos / PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE));
+		size_t new_slice_pos = raw_new_pos % PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE;
 		new_slice_index %= NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS;
 		// Fully unlock used buffers
 		unlock_buffers_from_x(cypress_device_capture_recv_data, read_slice_index, (new_slice_index + NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS - read_slice_index) % NUM_TOTAL_PARTNER_CTR_CYPRESS_BUFFERS, true);
@@ -598,7 +334,7 @@ static void cypress_device_read_frame_cb(void* user_data, int transfer_length, i
 	CypressPartnerCTRDeviceCaptureReceivedData* cypress_device_capture_recv_data = (CypressPartnerCTRDeviceCaptureReceivedData*)user_data;
 	if((*cypress_device_capture_recv_data->status) < 0)
 		return end_cypress_device_read_frame_cb(cypress_device_capture_recv_data, true);
-	if((transfer_status != LIBUSB_TRANSFER_COMPLETED) || (transfer_length < SINGLE_RING_BUFFER_SLICE_SIZE)) {
+	if((transfer_status != LIBUSB_TRANSFER_COMPLETED) || (transfer_length < PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE)) {
 		int error = LIBUSB_ERROR_OTHER;
 		if(transfer_status == LIBUSB_TRANSFER_TIMED_OUT)
 			error = LIBUSB_ERROR_TIMEOUT;
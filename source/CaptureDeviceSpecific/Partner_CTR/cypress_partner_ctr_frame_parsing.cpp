@@ -0,0 +1,298 @@
+#include "cypress_partner_ctr_frame_parsing.hpp"
+
+#include <cstring>
+#include <string>
+
+// This code was developed by exclusively looking at Wireshark USB packet
+// captures to learn the USB device's protocol.
+// As such, it was developed in a clean room environment, to provide
+// compatibility of the USB device with more (and more modern) hardware.
+// Such an action is allowed under EU law.
+// No reverse engineering of the original software was done to create this.
+
+#define SYNCH_VALUE_PARTNER_CTR PARTNER_CTR_CAPTURE_BASE_COMMAND
+
+#define ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA ((size_t)-1)
+#define ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED ((size_t)-2)
+
+// Audio is sent every few screens. A lot more than this in a row means
+// the data is broken. Without a limit, every resynchronization attempt
+// could walk almost a whole frame worth of commands.
+#define PARTNER_CTR_MAX_AUDIO_COMMANDS_IN_A_ROW 32
+
+static PartnerCTRCaptureCommand read_partner_ctr_base_command(uint8_t* data) {
+	PartnerCTRCaptureCommand out_cmd;
+	// Important: Ensure the data after the buffers for a single frame
+	// is stopped by wrong magic value...
+	out_cmd.magic = read_le16(data, 0);
+	out_cmd.command = read_le16(data, 1);
+	out_cmd.payload_size = read_le32(data, 1);
+	return out_cmd;
+}
+
+static size_t get_partner_ctr_size_command_header(PartnerCTRCaptureCommand read_command) {
+	switch (read_command.command) {
+		case PARTNER_CTR_CAPTURE_COMMAND_INPUT:
+			return sizeof(PartnerCTRCaptureCommandHeader0F);
+		case PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN:
+			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
+		case PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN:
+			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
+		case PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN:
+			return sizeof(PartnerCTRCaptureCommandHeaderCxScreen);
+		case PARTNER_CTR_CAPTURE_COMMAND_AUDIO:
+			return sizeof(PartnerCTRCaptureCommandHeaderC7);
+		default:
+			ActualConsoleOutTextError("Partner CTR Capture: Unknown command found! " + std::to_string(read_command.command));
+			return sizeof(PartnerCTRCaptureCommandHeader0F);
+	}
+}
+
+static bool get_is_pos_synch_in_buffer(uint8_t* buffer, size_t pos_to_check) {
+	PartnerCTRCaptureCommand base_command = read_partner_ctr_base_command(buffer + pos_to_check);
+	return base_command.magic == SYNCH_VALUE_PARTNER_CTR;
+}
+
+static bool get_is_pos_first_synch_in_buffer(uint8_t* buffer, size_t pos_to_check) {
+	PartnerCTRCaptureCommand base_command = read_partner_ctr_base_command(buffer + pos_to_check);
+	return (base_command.magic == SYNCH_VALUE_PARTNER_CTR) && (base_command.command == PARTNER_CTR_CAPTURE_COMMAND_INPUT);
+}
+
+size_t get_pos_first_synch_in_buffer_partner_ctr(uint8_t* buffer, size_t start_pos) {
+	// Do not read past the end of the slice. It may be the last one
+	for(size_t i = (start_pos / 2); i <= ((PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE - sizeof(PartnerCTRCaptureCommand)) / 2); i++) {
+		if(get_is_pos_first_synch_in_buffer(buffer, i * 2))
+			return i * 2;
+	}
+	return PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE + 1;
+}
+
+void copy_slice_data_to_buffer_partner_ctr(uint8_t* dst, uint8_t *src, size_t start_slice_index, size_t start_slice_pos, size_t copy_size) {
+	size_t start_byte = ((start_slice_index * PARTNER_CTR_SINGLE_RING_BUFFER_SLICE_SIZE) + start_slice_pos) % PARTNER_CTR_TOTAL_BUFFERS_SIZE;
+	if((start_byte + copy_size) <= PARTNER_CTR_TOTAL_BUFFERS_SIZE)
+		memcpy(dst, src + start_byte, copy_size);
+	else {
+		size_t upper_read_size = PARTNER_CTR_TOTAL_BUFFERS_SIZE - start_byte;
+		size_t start_read_size = copy_size - upper_read_size;
+		memcpy(dst, src + start_byte, upper_read_size);
+		memcpy(dst + upper_read_size, src, start_read_size);
+	}
+}
+
+static PartnerCTRCaptureCommand get_command_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
+	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
+	copy_slice_data_to_buffer_partner_ctr(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommand));
+
+	return read_partner_ctr_base_command(tmp_buffer);
+}
+
+static PartnerCTRCaptureCommandHeaderCxScreen get_command_screen_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
+	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommandHeaderCxScreen)];
+	copy_slice_data_to_buffer_partner_ctr(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommandHeaderCxScreen));
+
+	PartnerCTRCaptureCommandHeaderCxScreen out_cmd;
+
+	out_cmd.command = read_partner_ctr_base_command(tmp_buffer);
+	out_cmd.index_kind = tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
+	out_cmd.index = read_le16(tmp_buffer + sizeof(PartnerCTRCaptureCommand) + 1);
+	out_cmd.unk = tmp_buffer[sizeof(PartnerCTRCaptureCommand) + 3];
+	for(int i = 0; i < 2; i++)
+		out_cmd.unk2[i] = read_le16(tmp_buffer + sizeof(PartnerCTRCaptureCommand) + 4, i);
+
+	return out_cmd;
+}
+
+static size_t get_pos_next_command_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos) {
+	uint8_t tmp_buffer[sizeof(PartnerCTRCaptureCommand)];
+	copy_slice_data_to_buffer_partner_ctr(tmp_buffer, data, slice_index, start_pos + curr_pos, sizeof(PartnerCTRCaptureCommand));
+
+	PartnerCTRCaptureCommand read_command = read_partner_ctr_base_command(tmp_buffer);
+	// Do not let a broken payload size wrap around
+	if(read_command.payload_size > PARTNER_CTR_MAX_FRAME_SIZE)
+		return PARTNER_CTR_MAX_FRAME_SIZE + 1;
+	return curr_pos + get_partner_ctr_size_command_header(read_command) + read_command.payload_size;
+}
+
+static size_t find_pos_partner_ctr_x_screen(uint8_t* data, size_t slice_index, size_t start_pos, size_t curr_pos, size_t available_bytes) {
+	if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
+		return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
+
+	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
+	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
+		return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
+		return curr_pos;
+
+	int num_audio_commands = 0;
+	while(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_AUDIO) {
+		num_audio_commands++;
+		if(num_audio_commands > PARTNER_CTR_MAX_AUDIO_COMMANDS_IN_A_ROW)
+			return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+		curr_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, curr_pos);
+		// A broken payload size would otherwise wait forever for data
+		if(curr_pos > PARTNER_CTR_MAX_FRAME_SIZE)
+			return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+
+		if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
+			return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
+
+		read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
+		if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
+			return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+	}
+
+	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
+		return curr_pos;
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_INPUT)
+		curr_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, curr_pos);
+	if(curr_pos > PARTNER_CTR_MAX_FRAME_SIZE)
+		return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+
+	if((curr_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
+		return ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA;
+	read_command = get_command_partner_ctr(data, slice_index, start_pos, curr_pos);
+	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
+		return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+
+	if((read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) || (read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN))
+		return curr_pos;
+	ActualConsoleOutTextError("Partner CTR Capture: Unknown command found! " + std::to_string(read_command.command));
+	return ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED;
+}
+
+// Package together a frame
+static bool is_valid_frame_partner_ctr(uint8_t* data, size_t slice_index, size_t start_pos, size_t available_bytes, bool &enabled_3d, size_t &out_end_pos, bool &synchronized) {
+	bool has_top = false;
+	bool has_top_second = false;
+	bool has_bottom = false;
+	size_t first_screen_pos = 0;
+	size_t second_screen_pos = 0;
+	size_t third_screen_pos = 0;
+	size_t top_screen_pos = 0;
+	out_end_pos = 0;
+
+	first_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, 0, available_bytes);
+	if(first_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
+		return false;
+	if(first_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
+		synchronized = false;
+		return false;
+	}
+	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, first_screen_pos);
+	if(out_end_pos > PARTNER_CTR_MAX_FRAME_SIZE) {
+		synchronized = false;
+		return false;
+	}
+
+	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, first_screen_pos);
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
+		has_top = true;
+		top_screen_pos = first_screen_pos;
+	}
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
+		has_bottom = true;
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
+		has_top_second = true;
+
+	second_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, out_end_pos, available_bytes);
+	if(second_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
+		return false;
+	if(second_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
+		synchronized = false;
+		return false;
+	}
+	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, second_screen_pos);
+	if(out_end_pos > PARTNER_CTR_MAX_FRAME_SIZE) {
+		synchronized = false;
+		return false;
+	}
+
+	read_command = get_command_partner_ctr(data, slice_index, start_pos, second_screen_pos);
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
+		has_top = true;
+		top_screen_pos = second_screen_pos;
+	}
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
+		has_bottom = true;
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
+		has_top_second = true;
+
+	if(enabled_3d && has_top) {
+		if(out_end_pos > available_bytes)
+			return false;
+
+		PartnerCTRCaptureCommandHeaderCxScreen top_screen_command = get_command_screen_partner_ctr(data, slice_index, start_pos, top_screen_pos);
+		// Does this frame support 3D?
+		if((top_screen_command.index_kind == PARTNER_CTR_CAPTURE_SCREEN_INDEX_KIND_2D_TOP) && (!has_top_second))
+			enabled_3d = false;
+	}
+
+	if(!enabled_3d) {
+		if(!(has_top && has_bottom)) {
+			synchronized = false;
+			return false;
+		}
+		if(out_end_pos > available_bytes)
+			return false;
+
+		return true;
+	}
+
+	third_screen_pos = find_pos_partner_ctr_x_screen(data, slice_index, start_pos, out_end_pos, available_bytes);
+	if(third_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_ENOUGH_DATA)
+		return false;
+	if(third_screen_pos == ERROR_CTR_SCREEN_SEARCH_NOT_SYNCHRONIZED) {
+		synchronized = false;
+		return false;
+	}
+	out_end_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, third_screen_pos);
+	if(out_end_pos > PARTNER_CTR_MAX_FRAME_SIZE) {
+		synchronized = false;
+		return false;
+	}
+
+	read_command = get_command_partner_ctr(data, slice_index, start_pos, third_screen_pos);
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_TOP_SCREEN) {
+		has_top = true;
+		top_screen_pos = third_screen_pos;
+	}
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
+		has_bottom = true;
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_SECOND_TOP_SCREEN)
+		has_top_second = true;
+
+	if(!(has_top && has_bottom && has_top_second)) {
+		synchronized = false;
+		return false;
+	}
+	if(out_end_pos > available_bytes)
+		return false;
+
+	return true;
+}
+
+// Package together a frame by calling is_valid_frame_partner_ctr,
+// then try adding to the end of it audio data, if present and read...
+bool is_valid_frame_partner_ctr_attempt_add_sound(uint8_t* data, size_t slice_index, size_t start_pos, size_t available_bytes, bool &enabled_3d, size_t &out_end_pos, bool &synchronized) {
+	bool is_valid = is_valid_frame_partner_ctr(data, slice_index, start_pos, available_bytes, enabled_3d, out_end_pos, synchronized);
+	if(!is_valid)
+		return false;
+
+	if((out_end_pos + sizeof(PartnerCTRCaptureCommand)) > available_bytes)
+		return true;
+
+	PartnerCTRCaptureCommand read_command = get_command_partner_ctr(data, slice_index, start_pos, out_end_pos);
+	if(read_command.magic != PARTNER_CTR_CAPTURE_BASE_COMMAND)
+		return true;
+
+	if(read_command.command != PARTNER_CTR_CAPTURE_COMMAND_AUDIO)
+		return true;
+
+	size_t tentative_pos = get_pos_next_command_partner_ctr(data, slice_index, start_pos, out_end_pos);
+
+	if((tentative_pos > available_bytes) || (tentative_pos > PARTNER_CTR_MAX_FRAME_SIZE))
+		return true;
+
+	out_end_pos = tentative_pos;
+	return true;
+}
@@ -0,0 +1,417 @@
+#include "recording_playback_acquisition.hpp"
+#include "FrameRecorder.hpp"
+
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Big pauses in the recording are waited in small steps,
+// so a disconnection is noticed quickly
+#define PLAYBACK_MAX_WAIT_STEP_MS 20
+
+struct PlaybackRecording {
+	const uint8_t* data = NULL;
+	size_t size = 0;
+	#ifdef _WIN32
+	HANDLE file_handle = INVALID_HANDLE_VALUE;
+	HANDLE mapping_handle = NULL;
+	#endif
+	size_t first_record_pos = 0;
+	size_t device_info_pos = 0;
+	uint64_t device_info_time_us = 0;
+	size_t start_pos = 0;
+	std::vector<RecordingIndexEntry> index;
+};
+
+static std::string playback_path = "";
+static double playback_speed = 1.0;
+static double playback_start_seconds = 0.0;
+
+void set_playback_recording(std::string path, double speed, double start_seconds) {
+	playback_path = path;
+	playback_speed = speed;
+	playback_start_seconds = start_seconds;
+	if(playback_start_seconds < 0.0)
+		playback_start_seconds = 0.0;
+}
+
+static void unmap_recording(PlaybackRecording* recording) {
+	#ifdef _WIN32
+	if(recording->data != NULL)
+		UnmapViewOfFile(recording->data);
+	if(recording->mapping_handle != NULL)
+		CloseHandle(recording->mapping_handle);
+	if(recording->file_handle != INVALID_HANDLE_VALUE)
+		CloseHandle(recording->file_handle);
+	recording->mapping_handle = NULL;
+	recording->file_handle = INVALID_HANDLE_VALUE;
+	#else
+	if(recording->data != NULL)
+		munmap((void*)recording->data, recording->size);
+	#endif
+	recording->data = NULL;
+	recording->size = 0;
+}
+
+// The whole file is mapped, and the OS pages it in as needed.
+// Nothing gets copied, besides what ends up in the capture buffers.
+static bool map_recording(std::string path, PlaybackRecording* recording) {
+	#ifdef _WIN32
+	recording->file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(recording->file_handle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER file_size;
+	if((!GetFileSizeEx(recording->file_handle, &file_size)) || (file_size.QuadPart <= 0)) {
+		unmap_recording(recording);
+		return false;
+	}
+	recording->mapping_handle = CreateFileMappingA(recording->file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(recording->mapping_handle == NULL) {
+		unmap_recording(recording);
+		return false;
+	}
+	recording->data = (const uint8_t*)MapViewOfFile(recording->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if(recording->data == NULL) {
+		unmap_recording(recording);
+		return false;
+	}
+	recording->size = (size_t)file_size.QuadPart;
+	#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if(fd < 0)
+		return false;
+	struct stat file_stat;
+	if((fstat(fd, &file_stat) != 0) || (file_stat.st_size <= 0)) {
+		close(fd);
+		return false;
+	}
+	size_t size = (size_t)file_stat.st_size;
+	void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after this
+	close(fd);
+	if(data == MAP_FAILED)
+		return false;
+	madvise(data, size, MADV_SEQUENTIAL);
+	recording->data = (const uint8_t*)data;
+	recording->size = size;
+	#endif
+	return true;
+}
+
+static bool read_recording_record_at(PlaybackRecording* recording, size_t pos, RecordingRecordHeader &header) {
+	if((pos > recording->size) || ((recording->size - pos) < RECORDING_RECORD_HEADER_SIZE))
+		return false;
+	if(!read_recording_record_header(recording->data + pos, header))
+		return false;
+	if((recording->size - pos - RECORDING_RECORD_HEADER_SIZE) < header.payload_size)
+		return false;
+	return true;
+}
+
+static bool is_recording_keyframe_at(PlaybackRecording* recording, size_t pos) {
+	RecordingRecordHeader header;
+	if(!read_recording_record_at(recording, pos, header))
+		return false;
+	return (header.type == RECORDING_RECORD_VIDEO) && (header.flags & RECORDING_FLAG_KEYFRAME);
+}
+
+static bool read_recording_file_header(PlaybackRecording* recording) {
+	if(recording->size < RECORDING_FILE_HEADER_SIZE)
+		return false;
+	if(memcmp(recording->data, RECORDING_FILE_MAGIC, RECORDING_FILE_MAGIC_SIZE) != 0)
+		return false;
+	// Version 1 only lacks the entropy coding
+	uint32_t version = read_le32(recording->data + RECORDING_FILE_MAGIC_SIZE);
+	if((version == 0) || (version > RECORDING_FILE_VERSION))
+		return false;
+	recording->first_record_pos = read_le32(recording->data + RECORDING_FILE_MAGIC_SIZE + 4);
+	if(recording->first_record_pos < RECORDING_FILE_HEADER_SIZE)
+		return false;
+	return true;
+}
+
+// Playback only follows the first connected device
+static bool find_recording_device_info(PlaybackRecording* recording, CaptureDevice &device) {
+	size_t pos = recording->first_record_pos;
+	RecordingRecordHeader header;
+	while(read_recording_record_at(recording, pos, header)) {
+		if((header.type == RECORDING_RECORD_DEVICE_INFO) && (header.payload_size >= RECORDING_DEVICE_INFO_SIZE)) {
+			read_recording_device_info(recording->data + pos + RECORDING_RECORD_HEADER_SIZE, device);
+			recording->device_info_pos = pos;
+			recording->device_info_time_us = header.time_us;
+			return true;
+		}
+		if(header.type == RECORDING_RECORD_INDEX)
+			break;
+		pos += RECORDING_RECORD_HEADER_SIZE + header.payload_size;
+	}
+	return false;
+}
+
+static void load_recording_index(PlaybackRecording* recording) {
+	RecordingRecordHeader header;
+	recording->index.clear();
+	if(recording->size >= (recording->first_record_pos + RECORDING_FILE_TRAILER_SIZE)) {
+		const uint8_t* trailer = recording->data + recording->size - RECORDING_FILE_TRAILER_SIZE;
+		uint64_t index_pos = read_le64(trailer + RECORDING_FILE_MAGIC_SIZE);
+		if((memcmp(trailer, RECORDING_FILE_TRAILER_MAGIC, RECORDING_FILE_MAGIC_SIZE) == 0) && (index_pos < recording->size)) {
+			if(read_recording_record_at(recording, (size_t)index_pos, header) && (header.type == RECORDING_RECORD_INDEX)) {
+				read_recording_index(recording->data + index_pos + RECORDING_RECORD_HEADER_SIZE, header.payload_size, recording->index);
+				return;
+			}
+		}
+	}
+	// The recording was not closed properly. Rebuild the index.
+	size_t pos = recording->first_record_pos;
+	while(read_recording_record_at(recording, pos, header)) {
+		if((header.type == RECORDING_RECORD_VIDEO) && (header.flags & RECORDING_FLAG_KEYFRAME))
+			recording->index.push_back({header.time_us, pos});
+		pos += RECORDING_RECORD_HEADER_SIZE + header.payload_size;
+	}
+}
+
+// Finds the last keyframe before the wanted time
+static size_t get_recording_seek_pos(PlaybackRecording* recording, uint64_t wanted_time_us) {
+	auto it = std::upper_bound(recording->index.begin(), recording->index.end(), wanted_time_us, [](uint64_t time_us, const RecordingIndexEntry &entry) { return time_us < entry.time_us; });
+	while(it != recording->index.begin()) {
+		--it;
+		if((it->offset <= recording->device_info_pos) || (it->offset >= recording->size))
+			break;
+		if(is_recording_keyframe_at(recording, (size_t)it->offset))
+			return (size_t)it->offset;
+	}
+	return recording->device_info_pos;
+}
+
+static std::string get_recording_file_name(std::string path) {
+	size_t pos = path.find_last_of("/\\");
+	if(pos == std::string::npos)
+		return path;
+	return path.substr(pos + 1);
+}
+
+void list_devices_playback(std::vector<CaptureDevice> &devices_list, std::vector<no_access_recap_data> &no_access_list) {
+	if(playback_path == "")
+		return;
+	PlaybackRecording recording;
+	if(!map_recording(playback_path, &recording)) {
+		no_access_list.emplace_back(playback_path);
+		return;
+	}
+	CaptureDevice device;
+	if(read_recording_file_header(&recording) && find_recording_device_info(&recording, device)) {
+		device.cc_type = CAPTURE_CONN_PLAYBACK;
+		device.path = playback_path;
+		device.serial_number = get_recording_file_name(playback_path);
+		device.name = "Playback";
+		device.long_name = "Playback - " + device.long_name;
+		if(device.max_samples_in > MAX_SAMPLES_IN)
+			device.max_samples_in = MAX_SAMPLES_IN;
+		devices_list.push_back(device);
+	}
+	else
+		no_access_list.emplace_back(playback_path);
+	unmap_recording(&recording);
+}
+
+bool playback_connect(bool print_failed, CaptureData* capture_data, CaptureDevice* device) {
+	PlaybackRecording* recording = new PlaybackRecording;
+	CaptureDevice read_device;
+	if((!map_recording(device->path, recording)) || (!read_recording_file_header(recording)) || (!find_recording_device_info(recording, read_device))) {
+		unmap_recording(recording);
+		delete recording;
+		capture_error_print(print_failed, capture_data, "Recording not valid");
+		return false;
+	}
+	load_recording_index(recording);
+	recording->start_pos = get_recording_seek_pos(recording, recording->device_info_time_us + (uint64_t)(playback_start_seconds * 1000000.0));
+	// Show the frames the way they were recorded
+	size_t pos = recording->start_pos;
+	RecordingRecordHeader header;
+	while(read_recording_record_at(recording, pos, header) && (header.type != RECORDING_RECORD_INDEX)) {
+		if(header.type == RECORDING_RECORD_VIDEO) {
+			capture_data->status.requested_3d = (header.format & RECORDING_VIDEO_FORMAT_3D) != 0;
+			break;
+		}
+		pos += RECORDING_RECORD_HEADER_SIZE + header.payload_size;
+	}
+	capture_data->handle = (void*)recording;
+	return true;
+}
+
+uint64_t playback_get_video_in_size(CaptureData* capture_data, InputVideoDataType video_data_type) {
+	return PLAYBACK_FRAME_HEADER_SIZE + get_recording_video_raw_size(video_data_type);
+}
+
+size_t playback_get_capture_buffer_slot_size() {
+	return PLAYBACK_FRAME_HEADER_SIZE + get_recording_video_raw_size(VIDEO_DATA_RGB) + (MAX_SAMPLES_IN * sizeof(uint16_t));
+}
+
+uint16_t playback_get_frame_format(CaptureReceived* buffer) {
+	return read_le16((uint8_t*)buffer);
+}
+
+static bool decode_playback_frame(const RecordingRecordHeader &header, const uint8_t* payload, uint8_t* frame, size_t video_size, uint8_t* delta_data, size_t max_delta_size, bool &has_frame) {
+	if(!(header.flags & RECORDING_FLAG_COMPRESSED)) {
+		if(header.payload_size != video_size)
+			return false;
+		memcpy(frame, payload, video_size);
+		has_frame = true;
+		return true;
+	}
+	if(header.flags & RECORDING_FLAG_KEYFRAME) {
+		memset(frame, 0, video_size);
+		has_frame = true;
+	}
+	// Can't apply a difference to nothing...
+	if(!has_frame)
+		return false;
+	size_t delta_size = header.payload_size;
+	if(header.flags & RECORDING_FLAG_ENTROPY_CODED) {
+		if(!decode_recording_entropy(payload, header.payload_size, delta_data, max_delta_size, delta_size)) {
+			has_frame = false;
+			return false;
+		}
+		payload = delta_data;
+	}
+	if(!decode_recording_delta(payload, delta_size, frame, video_size)) {
+		has_frame = false;
+		return false;
+	}
+	return true;
+}
+
+static void playback_wait_until(CaptureData* capture_data, std::chrono::time_point<std::chrono::steady_clock> target) {
+	while(capture_data->status.connected && capture_data->status.running) {
+		auto curr_time = std::chrono::steady_clock::now();
+		if(curr_time >= target)
+			return;
+		auto step_end = curr_time + std::chrono::milliseconds(PLAYBACK_MAX_WAIT_STEP_MS);
+		if(step_end > target)
+			step_end = target;
+		std::this_thread::sleep_until(step_end);
+	}
+}
+
+static void playback_output_frame(CaptureData* capture_data, CaptureDevice* frame_device, const RecordingRecordHeader &header, uint8_t* frame, size_t video_size, uint8_t* audio_data, size_t audio_size, std::chrono::time_point<std::chrono::high_resolution_clock> &clock_start) {
+	CaptureDataSingleBuffer* data_buf = capture_data->data_buffers.GetWriterBuffer();
+	if(data_buf == NULL)
+		return;
+	uint8_t* buffer = (uint8_t*)data_buf->capture_buf;
+	memset(buffer, 0, PLAYBACK_FRAME_HEADER_SIZE);
+	write_le16(buffer, header.format);
+	memcpy(buffer + PLAYBACK_FRAME_HEADER_SIZE, frame, video_size);
+	memcpy(buffer + PLAYBACK_FRAME_HEADER_SIZE + video_size, audio_data, audio_size);
+	// The recorded frame index is as good as a device frame counter
+	data_buf->has_device_frame_counter = true;
+	data_buf->device_frame_counter = (uint32_t)header.index;
+	const auto curr_time = std::chrono::high_resolution_clock::now();
+	const std::chrono::duration<double> diff = curr_time - clock_start;
+	clock_start = curr_time;
+	frame_device->video_data_type = (InputVideoDataType)(header.format & RECORDING_VIDEO_FORMAT_TYPE_MASK);
+	capture_data->data_buffers.WriteToBuffer(NULL, PLAYBACK_FRAME_HEADER_SIZE + video_size + audio_size, diff.count(), frame_device, 0, (header.format & RECORDING_VIDEO_FORMAT_3D) != 0);
+	if(capture_data->status.cooldown_curr_in)
+		capture_data->status.cooldown_curr_in = capture_data->status.cooldown_curr_in - 1;
+	capture_data->status.video_wait.unlock();
+	capture_data->status.audio_wait.unlock();
+}
+
+// Goes through the records in order, and sends out each frame with
+// the audio which came before it, at the recorded pace.
+// Once it reaches the end, it starts again from the seek position.
+void playback_acquisition_main_loop(CaptureData* capture_data) {
+	PlaybackRecording* recording = (PlaybackRecording*)capture_data->handle;
+	if(recording == NULL)
+		return;
+	CaptureDevice frame_device = capture_data->status.device;
+	size_t max_audio_size = (size_t)frame_device.max_samples_in * sizeof(uint16_t);
+	uint8_t* frame = new uint8_t[get_recording_video_raw_size(VIDEO_DATA_RGB)];
+	size_t max_delta_size = get_recording_max_compressed_size(get_recording_video_raw_size(VIDEO_DATA_RGB));
+	uint8_t* delta_data = new uint8_t[max_delta_size];
+	uint8_t* audio_data = new uint8_t[max_audio_size + 1];
+	size_t audio_size = 0;
+	bool has_frame = false;
+	bool restart_timing = true;
+	bool any_frame_output = false;
+	uint64_t base_time_us = 0;
+	size_t pos = recording->start_pos;
+	std::chrono::time_point<std::chrono::steady_clock> base_clock = std::chrono::steady_clock::now();
+	std::chrono::time_point<std::chrono::high_resolution_clock> clock_start = std::chrono::high_resolution_clock::now();
+
+	while(capture_data->status.connected && capture_data->status.running) {
+		RecordingRecordHeader header;
+		bool is_end = !read_recording_record_at(recording, pos, header);
+		if((!is_end) && (header.type == RECORDING_RECORD_INDEX))
+			is_end = true;
+		// A different device was connected, after this
+		if((!is_end) && (header.type == RECORDING_RECORD_DEVICE_INFO) && (pos > recording->device_info_pos))
+			is_end = true;
+		if(is_end) {
+			if(!any_frame_output) {
+				capture_error_print(true, capture_data, "Recording has no frames");
+				break;
+			}
+			pos = recording->start_pos;
+			has_frame = false;
+			restart_timing = true;
+			any_frame_output = false;
+			audio_size = 0;
+			continue;
+		}
+		const uint8_t* payload = recording->data + pos + RECORDING_RECORD_HEADER_SIZE;
+		pos += RECORDING_RECORD_HEADER_SIZE + header.payload_size;
+
+		if(header.type == RECORDING_RECORD_AUDIO) {
+			size_t to_copy = header.payload_size;
+			if(to_copy > (max_audio_size - audio_size))
+				to_copy = max_audio_size - audio_size;
+			memcpy(audio_data + audio_size, payload, to_copy);
+			audio_size += to_copy;
+			continue;
+		}
+		if(header.type != RECORDING_RECORD_VIDEO)
+			continue;
+		int video_data_type = header.format & RECORDING_VIDEO_FORMAT_TYPE_MASK;
+		if(video_data_type > VIDEO_DATA_BGR16)
+			continue;
+		size_t video_size = get_recording_video_raw_size((InputVideoDataType)video_data_type);
+		if(header.raw_size != video_size)
+			continue;
+		if(!decode_playback_frame(header, payload, frame, video_size, delta_data, max_delta_size, has_frame))
+			continue;
+
+		if(restart_timing || (header.time_us < base_time_us)) {
+			base_time_us = header.time_us;
+			base_clock = std::chrono::steady_clock::now();
+			restart_timing = false;
+		}
+		// No speed means as fast as possible
+		else if(playback_speed > 0.0)
+			playback_wait_until(capture_data, base_clock + std::chrono::microseconds((int64_t)((header.time_us - base_time_us) / playback_speed)));
+		playback_output_frame(capture_data, &frame_device, header, frame, video_size, audio_data, audio_size, clock_start);
+		any_frame_output = true;
+		audio_size = 0;
+	}
+
+	delete []frame;
+	delete []delta_data;
+	delete []audio_data;
+}
+
+void playback_acquisition_cleanup(CaptureData* capture_data) {
+	PlaybackRecording* recording = (PlaybackRecording*)capture_data->handle;
+	if(recording == NULL)
+		return;
+	unmap_recording(recording);
+	delete recording;
+	capture_data->handle = NULL;
+}
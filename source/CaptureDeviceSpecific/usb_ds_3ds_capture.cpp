@@ -148,6 +148,8 @@ static int insert_device(std::vector<CaptureDevice> &devices_list, const usb_dev
 	libusb_device_handle *handle = NULL;
 	if((usb_descriptor->idVendor != usb_device_desc->vid) || (usb_descriptor->idProduct != usb_device_desc->pid))
 		return LIBUSB_ERROR_NOT_FOUND;
+	if(usb_device_cache_lookup(usb_device, usb_device_desc, usb_device_desc->capture_interface, devices_list))
+		return LIBUSB_SUCCESS;
 	int result = libusb_open(usb_device, &handle);
 	if(result || (handle == NULL))
 		return result;
@@ -163,11 +165,15 @@ static int insert_device(std::vector<CaptureDevice> &devices_list, const usb_dev
 		libusb_close(handle);
 		return result;
 	}
+	size_t first_new_device = devices_list.size();
+	int old_serial_extra_id = curr_serial_extra_id;
 	std::string serial_str = get_serial(handle, usb_descriptor, curr_serial_extra_id);
 	if(usb_device_desc->is_3ds)
 		devices_list.emplace_back(serial_str, "3DS", CAPTURE_CONN_USB, (void*)usb_device_desc, true, capture_get_has_3d(handle, usb_device_desc), true, HEIGHT_3DS, TOP_WIDTH_3DS + BOT_WIDTH_3DS, O3DS_SAMPLES_IN, 90, 0, 0, TOP_WIDTH_3DS, 0, VIDEO_DATA_RGB);
 	else
 		devices_list.emplace_back(serial_str, "DS", CAPTURE_CONN_USB, (void*)usb_device_desc, false, false, false, WIDTH_DS, HEIGHT_DS + HEIGHT_DS, 0, 0, 0, 0, 0, HEIGHT_DS, VIDEO_DATA_RGB16);
+	if(curr_serial_extra_id == old_serial_extra_id)
+		usb_device_cache_store(usb_device, usb_device_desc, devices_list, first_new_device);
 	libusb_close(handle);
 	return result;
 }
@@ -229,7 +235,7 @@ static uint64_t get_capture_size(const usb_device* usb_device_desc, bool enabled
 static usb_capture_status capture_read_oldds_3ds(CaptureData* capture_data, size_t *read_amount) {
 	*read_amount = 0;
 	CaptureDataSingleBuffer* full_data_buf = capture_data->data_buffers.GetWriterBuffer(0);
-	CaptureReceived* data_buffer = &full_data_buf->capture_buf;
+	CaptureReceived* data_buffer = full_data_buf->capture_buf;
 	libusb_device_handle* handle = (libusb_device_handle*)capture_data->handle;
 	const usb_device* usb_device_desc = get_usb_device_desc(capture_data);
 	const bool enabled_3d = get_3d_enabled(&capture_data->status);
@@ -1,7 +1,15 @@
 #include "usb_generic.hpp"
 #include "utils.hpp"
+#include "ThreadScheduling.hpp"
+#include "capture_structs.hpp"
 #include <thread>
 #include <mutex>
+#include <atomic>
+
+#define USB_DEVICE_WATCH_POLL_PERIOD_MS 500
+#define USB_DEVICE_WATCH_SLEEP_STEP_MS 50
+// USB allows at most 7 tiers of hubs
+#define USB_MAX_PORT_NUMBERS 7
 
 static bool usb_initialized = false;
 static libusb_context* usb_ctx = NULL; // libusb session context
@@ -9,6 +17,27 @@ static int usb_thread_registered = 0;
 std::thread usb_thread;
 std::mutex usb_thread_mutex;
 
+static std::atomic<uint64_t> usb_device_change_id = 0;
+static bool usb_hotplug_registered = false;
+static libusb_hotplug_callback_handle usb_hotplug_handle;
+static volatile bool usb_device_watch_running = false;
+static bool usb_device_watch_thread_running = false;
+static std::thread usb_device_watch_thread;
+
+// What probing a device produced, the last time it was opened while listing
+struct UsbDeviceCacheEntry {
+	std::string bus_path;
+	const void* probe_id;
+	uint8_t address;
+	uint16_t vid;
+	uint16_t pid;
+	uint16_t bcd_device;
+	std::vector<CaptureDevice> devices;
+};
+
+static std::vector<UsbDeviceCacheEntry> usb_device_cache;
+static std::mutex usb_device_cache_mutex;
+
 void usb_init() {
 	if(usb_initialized)
 		return;
@@ -30,6 +59,7 @@ void usb_init() {
 }
 
 void usb_close() {
+	usb_device_cache_clear();
 	if(usb_initialized)
 		libusb_exit(usb_ctx);
 	usb_ctx = NULL;
@@ -72,8 +102,10 @@ static void libusb_usb_thread_function() {
 	struct timeval tv;
 	tv.tv_sec = 0;
 	tv.tv_usec = 300000;
+	register_current_thread_scheduling(THREAD_SCHEDULING_USB_EVENTS);
 	while(usb_thread_registered > 0)
 		libusb_handle_events_timeout_completed(get_usb_ctx(), &tv, NULL);
+	unregister_current_thread_scheduling();
 }
 
 void libusb_register_to_event_thread() {
@@ -96,3 +128,191 @@ void libusb_unregister_from_event_thread() {
 		usb_thread.join();
 	usb_thread_mutex.unlock();
 }
+
+static std::string usb_get_bus_path(libusb_device* usb_device) {
+	uint8_t port_numbers[USB_MAX_PORT_NUMBERS];
+	int num_ports = libusb_get_port_numbers(usb_device, port_numbers, USB_MAX_PORT_NUMBERS);
+	std::string bus_path = std::to_string(libusb_get_bus_number(usb_device));
+	for(int i = 0; i < num_ports; i++)
+		bus_path += "." + std::to_string(port_numbers[i]);
+	return bus_path;
+}
+
+static void usb_device_cache_remove(const std::string &bus_path) {
+	usb_device_cache_mutex.lock();
+	for(size_t i = 0; i < usb_device_cache.size(); i++) {
+		if(usb_device_cache[i].bus_path != bus_path)
+			continue;
+		usb_device_cache.erase(usb_device_cache.begin() + i);
+		i--;
+	}
+	usb_device_cache_mutex.unlock();
+}
+
+// Cheaper than a full probe. Makes sure the device still answers, and
+// that nothing else took it since it was probed.
+static bool usb_device_cache_check_device(libusb_device* usb_device, int claim_interface) {
+	libusb_device_handle* handle = NULL;
+	int result = libusb_open(usb_device, &handle);
+	if((result < 0) || (handle == NULL))
+		return false;
+	libusb_check_and_detach_kernel_driver(handle, claim_interface);
+	result = libusb_claim_interface(handle, claim_interface);
+	if(result == LIBUSB_SUCCESS)
+		libusb_release_interface(handle, claim_interface);
+	libusb_close(handle);
+	return result == LIBUSB_SUCCESS;
+}
+
+// A re-plugged or re-enumerated device (E.g. after a firmware upload)
+// gets a new address, so it does not match its old entry anymore.
+bool usb_device_cache_lookup(libusb_device* usb_device, const void* probe_id, int claim_interface, std::vector<CaptureDevice> &devices_list) {
+	libusb_device_descriptor usb_descriptor{};
+	if(libusb_get_device_descriptor(usb_device, &usb_descriptor) < 0)
+		return false;
+	std::string bus_path = usb_get_bus_path(usb_device);
+	uint8_t address = libusb_get_device_address(usb_device);
+	bool found = false;
+	std::vector<CaptureDevice> cached_devices;
+	usb_device_cache_mutex.lock();
+	for(size_t i = 0; i < usb_device_cache.size(); i++) {
+		UsbDeviceCacheEntry* entry = &usb_device_cache[i];
+		if((entry->bus_path != bus_path) || (entry->probe_id != probe_id))
+			continue;
+		if((entry->address != address) || (entry->vid != usb_descriptor.idVendor) || (entry->pid != usb_descriptor.idProduct) || (entry->bcd_device != usb_descriptor.bcdDevice))
+			break;
+		cached_devices = entry->devices;
+		found = true;
+		break;
+	}
+	usb_device_cache_mutex.unlock();
+	if(!found)
+		return false;
+	if(!usb_device_cache_check_device(usb_device, claim_interface)) {
+		usb_device_cache_remove(bus_path);
+		return false;
+	}
+	devices_list.insert(devices_list.end(), cached_devices.begin(), cached_devices.end());
+	return true;
+}
+
+// Only store successful probes. Failures (E.g. no access) must be retried.
+void usb_device_cache_store(libusb_device* usb_device, const void* probe_id, const std::vector<CaptureDevice> &devices_list, size_t first_new_device) {
+	if(first_new_device >= devices_list.size())
+		return;
+	libusb_device_descriptor usb_descriptor{};
+	if(libusb_get_device_descriptor(usb_device, &usb_descriptor) < 0)
+		return;
+	UsbDeviceCacheEntry new_entry;
+	new_entry.bus_path = usb_get_bus_path(usb_device);
+	new_entry.probe_id = probe_id;
+	new_entry.address = libusb_get_device_address(usb_device);
+	new_entry.vid = usb_descriptor.idVendor;
+	new_entry.pid = usb_descriptor.idProduct;
+	new_entry.bcd_device = usb_descriptor.bcdDevice;
+	new_entry.devices.insert(new_entry.devices.end(), devices_list.begin() + first_new_device, devices_list.end());
+	usb_device_cache_mutex.lock();
+	for(size_t i = 0; i < usb_device_cache.size(); i++) {
+		if((usb_device_cache[i].bus_path != new_entry.bus_path) || (usb_device_cache[i].probe_id != probe_id))
+			continue;
+		usb_device_cache.erase(usb_device_cache.begin() + i);
+		break;
+	}
+	usb_device_cache.push_back(new_entry);
+	usb_device_cache_mutex.unlock();
+}
+
+void usb_device_cache_clear() {
+	usb_device_cache_mutex.lock();
+	usb_device_cache.clear();
+	usb_device_cache_mutex.unlock();
+}
+
+// Called from the event thread
+static int LIBUSB_CALL usb_hotplug_callback(libusb_context* ctx, libusb_device* device, libusb_hotplug_event event, void* user_data) {
+	if(event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT)
+		usb_device_cache_remove(usb_get_bus_path(device));
+	usb_device_change_id++;
+	return 0;
+}
+
+// Cheap, no device gets opened. Does not depend on the order of the list.
+static bool usb_get_devices_signature(uint64_t &signature) {
+	libusb_device **usb_devices;
+	ssize_t num_devices = libusb_get_device_list(get_usb_ctx(), &usb_devices);
+	if(num_devices < 0)
+		return false;
+	signature = num_devices;
+	for(ssize_t i = 0; i < num_devices; i++) {
+		libusb_device_descriptor usb_descriptor{};
+		if(libusb_get_device_descriptor(usb_devices[i], &usb_descriptor) < 0)
+			continue;
+		uint64_t value = (((uint64_t)libusb_get_bus_number(usb_devices[i])) << 48) | (((uint64_t)libusb_get_port_number(usb_devices[i])) << 40) | (((uint64_t)libusb_get_device_address(usb_devices[i])) << 32) | (((uint64_t)usb_descriptor.idVendor) << 16) | usb_descriptor.idProduct;
+		value *= 0x9E3779B97F4A7C15ULL;
+		signature += value ^ (value >> 29);
+	}
+	libusb_free_device_list(usb_devices, 1);
+	return true;
+}
+
+// Only used when hotplug is not available
+static void usb_device_watch_function() {
+	register_current_thread_scheduling(THREAD_SCHEDULING_USB_EVENTS);
+	uint64_t last_signature = 0;
+	usb_get_devices_signature(last_signature);
+	while(usb_device_watch_running) {
+		for(int i = 0; (i < (USB_DEVICE_WATCH_POLL_PERIOD_MS / USB_DEVICE_WATCH_SLEEP_STEP_MS)) && usb_device_watch_running; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(USB_DEVICE_WATCH_SLEEP_STEP_MS));
+		uint64_t signature = 0;
+		if(usb_get_devices_signature(signature) && (signature != last_signature)) {
+			last_signature = signature;
+			usb_device_change_id++;
+		}
+	}
+	unregister_current_thread_scheduling();
+}
+
+void usb_device_watch_start() {
+	if((!usb_is_initialized()) || usb_device_watch_running)
+		return;
+	usb_hotplug_registered = false;
+	if(libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+		int result = libusb_hotplug_register_callback(get_usb_ctx(), (libusb_hotplug_event)(LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT), (libusb_hotplug_flag)0, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, usb_hotplug_callback, NULL, &usb_hotplug_handle);
+		usb_hotplug_registered = result == LIBUSB_SUCCESS;
+	}
+	if(usb_hotplug_registered) {
+		// The callback gets called by the shared event thread.
+		// Keep it alive, even while no device is connected.
+		libusb_register_to_event_thread();
+		usb_device_watch_running = true;
+		return;
+	}
+	// If the list cannot be read (E.g. Android), there is nothing to watch
+	uint64_t signature = 0;
+	if(!usb_get_devices_signature(signature))
+		return;
+	usb_device_watch_running = true;
+	usb_device_watch_thread_running = true;
+	usb_device_watch_thread = std::thread(usb_device_watch_function);
+}
+
+void usb_device_watch_stop() {
+	if(!usb_device_watch_running)
+		return;
+	usb_device_watch_running = false;
+	if(usb_hotplug_registered) {
+		libusb_hotplug_deregister_callback(get_usb_ctx(), usb_hotplug_handle);
+		libusb_unregister_from_event_thread();
+	}
+	if(usb_device_watch_thread_running)
+		usb_device_watch_thread.join();
+	usb_device_watch_thread_running = false;
+	usb_hotplug_registered = false;
+}
+
+bool usb_device_watch_get_change_id(uint64_t* change_id) {
+	if(!usb_device_watch_running)
+		return false;
+	*change_id = usb_device_change_id;
+	return true;
+}
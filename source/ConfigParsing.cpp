@@ -0,0 +1,353 @@
+#include "ConfigParsing.hpp"
+#include "WindowCommands.hpp"
+#include "ThreadScheduling.hpp"
+
+#include <cmath>
+
+static InputColorspaceMode input_colorspace_sanitization(int value) {
+	if((value < 0) || (value >= INPUT_COLORSPACE_END))
+		return FULL_COLORSPACE;
+	return static_cast<InputColorspaceMode>(value);
+}
+
+static FrameBlendingMode frame_blending_sanitization(int value) {
+	if((value < 0) || (value >= FRAME_BLENDING_END))
+		return NO_FRAME_BLENDING;
+	return static_cast<FrameBlendingMode>(value);
+}
+
+static float offset_sanitization(float value) {
+	if(value <= 0.0)
+		return 0.0;
+	if(value >= 1.0)
+		return 1.0;
+	return value;
+}
+
+bool load_screen_info(std::string key, std::string value, std::string base, ScreenInfo &info) {
+	if(key == (base + "blur")) {
+		info.is_blurred = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "crop")) {
+		info.crop_kind = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "crop_ds")) {
+		info.crop_kind_ds = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "allow_games_crops")) {
+		info.allow_games_crops = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "scale")) {
+		info.scaling = std::stod(value);
+		if(info.scaling < MIN_WINDOW_SCALING_VALUE)
+			info.scaling = MIN_WINDOW_SCALING_VALUE;
+		if(info.scaling > MAX_WINDOW_SCALING_VALUE)
+			info.scaling = MAX_WINDOW_SCALING_VALUE;
+		return true;
+	}
+	if(key == (base + "fullscreen")) {
+		info.is_fullscreen = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "bot_pos")) {
+		info.bottom_pos = static_cast<BottomRelativePosition>(std::stoi(value) % BottomRelativePosition::BOT_REL_POS_END);
+		return true;
+	}
+	if(key == (base + "sub_off")) {
+		info.subscreen_offset = offset_sanitization(std::stof(value));
+		return true;
+	}
+	if(key == (base + "sub_att_off")) {
+		info.subscreen_attached_offset = offset_sanitization(std::stof(value));
+		return true;
+	}
+	if(key == (base + "off_x")) {
+		info.total_offset_x = offset_sanitization(std::stof(value));
+		return true;
+	}
+	if(key == (base + "off_y")) {
+		info.total_offset_y = offset_sanitization(std::stof(value));
+		return true;
+	}
+	if(key == (base + "top_rot")) {
+		info.top_rotation = std::stoi(value);
+		info.top_rotation %= 360;
+		info.top_rotation += (info.top_rotation < 0) ? 360 : 0;
+		return true;
+	}
+	if(key == (base + "bot_rot")) {
+		info.bot_rotation = std::stoi(value);
+		info.bot_rotation %= 360;
+		info.bot_rotation += (info.bot_rotation < 0) ? 360 : 0;
+		return true;
+	}
+	if(key == (base + "vsync")) {
+		info.v_sync_enabled = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "async")) {
+		info.async = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "top_scaling")) {
+		info.top_scaling = std::stoi(value);
+		info.non_integer_top_scaling = (float)info.top_scaling;
+		return true;
+	}
+	if(key == (base + "bot_scaling")) {
+		info.bot_scaling = std::stoi(value);
+		info.non_integer_bot_scaling = (float)info.bot_scaling;
+		return true;
+	}
+	if(key == (base + "bfi")) {
+		info.bfi = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "bfi_divider")) {
+		info.bfi_divider = std::stoi(value);
+		if(info.bfi_divider < 2)
+			info.bfi_divider = 2;
+		if(info.bfi_divider > 10)
+			info.bfi_divider = 10;
+		if(info.bfi_amount > (info.bfi_divider - 1))
+			info.bfi_amount = info.bfi_divider - 1;
+		return true;
+	}
+	if(key == (base + "bfi_amount")) {
+		info.bfi_amount = std::stoi(value);
+		if(info.bfi_amount < 1)
+			info.bfi_amount = 1;
+		if(info.bfi_amount > (info.bfi_divider - 1))
+			info.bfi_amount = info.bfi_divider - 1;
+		return true;
+	}
+	if(key == (base + "menu_scaling_factor")) {
+		info.menu_scaling_factor = std::stod(value);
+		if(info.menu_scaling_factor < 0.3)
+			info.menu_scaling_factor = 0.3;
+		if(info.menu_scaling_factor > 10.0)
+			info.menu_scaling_factor = 10.0;
+		return true;
+	}
+	if(key == (base + "rounded_corners_fix")) {
+		info.rounded_corners_fix = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "force_same_scaling")) {
+		info.force_same_scaling = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "separator_pixel_size")) {
+		info.separator_pixel_size = std::stoi(value);
+		if(info.separator_pixel_size > MAX_SEP_SIZE)
+			info.separator_pixel_size = MAX_SEP_SIZE;
+		if(info.separator_pixel_size < 0)
+			info.separator_pixel_size = 0;
+		return true;
+	}
+	if(key == (base + "separator_windowed_multiplier")) {
+		info.separator_windowed_multiplier = std::stof(value);
+		if(info.separator_windowed_multiplier < SEP_WINDOW_SCALING_MIN_MULTIPLIER)
+			info.separator_windowed_multiplier = SEP_WINDOW_SCALING_MIN_MULTIPLIER;
+		if(info.separator_windowed_multiplier > MAX_WINDOW_SCALING_VALUE)
+			info.separator_windowed_multiplier = MAX_WINDOW_SCALING_VALUE;
+		info.separator_windowed_multiplier = (float)(std::round(info.separator_windowed_multiplier / WINDOW_SCALING_CHANGE) * WINDOW_SCALING_CHANGE);
+		return true;
+	}
+	if(key == (base + "separator_fullscreen_multiplier")) {
+		info.separator_fullscreen_multiplier = std::stof(value);
+		if(info.separator_fullscreen_multiplier < SEP_FULLSCREEN_SCALING_MIN_MULTIPLIER)
+			info.separator_fullscreen_multiplier = SEP_FULLSCREEN_SCALING_MIN_MULTIPLIER;
+		if(info.separator_fullscreen_multiplier > MAX_WINDOW_SCALING_VALUE)
+			info.separator_fullscreen_multiplier = MAX_WINDOW_SCALING_VALUE;
+		info.separator_fullscreen_multiplier = (float)(std::round(info.separator_fullscreen_multiplier / WINDOW_SCALING_CHANGE) * WINDOW_SCALING_CHANGE);
+		return true;
+	}
+	if(key == (base + "top_par")) {
+		info.top_par = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "bot_par")) {
+		info.bot_par = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "fullscreen_mode_width")) {
+		info.fullscreen_mode_width = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "fullscreen_mode_height")) {
+		info.fullscreen_mode_height = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "fullscreen_mode_bpp")) {
+		info.fullscreen_mode_bpp = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "non_integer_mode")) {
+		int read_value = std::stoi(value);
+		if((read_value < 0) || (read_value >= END_NONINT_SCALE_MODES))
+			read_value = 0;
+		info.non_integer_mode = static_cast<NonIntegerScalingModes>(read_value);
+		return true;
+	}
+	if(key == (base + "use_non_integer_scaling_top")) {
+		info.use_non_integer_scaling_top = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "use_non_integer_scaling_bottom")) {
+		info.use_non_integer_scaling_bottom = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "have_titlebar")) {
+		info.have_titlebar = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "top_color_correction")) {
+		info.top_color_correction = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "bot_color_correction")) {
+		info.bot_color_correction = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "in_colorspace_top")) {
+		info.in_colorspace_top = input_colorspace_sanitization(std::stoi(value));
+		return true;
+	}
+	if(key == (base + "in_colorspace_bot")) {
+		info.in_colorspace_bot = input_colorspace_sanitization(std::stoi(value));
+		return true;
+	}
+	if(key == (base + "frame_blending_top")) {
+		info.frame_blending_top = frame_blending_sanitization(std::stoi(value));
+		return true;
+	}
+	if(key == (base + "frame_blending_bot")) {
+		info.frame_blending_bot = frame_blending_sanitization(std::stoi(value));
+		return true;
+	}
+	if(key == (base + "window_enabled")) {
+		info.window_enabled = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "second_screen_pos")) {
+		info.second_screen_pos = static_cast<SecondScreen3DRelativePosition>(std::stoi(value) % SecondScreen3DRelativePosition::SECOND_SCREEN_3D_REL_POS_END);
+		return true;
+	}
+	if(key == (base + "squish_3d_top")) {
+		info.squish_3d_top = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "squish_3d_bot")) {
+		info.squish_3d_bot = std::stoi(value);
+		return true;
+	}
+	if(key == (base + "match_bottom_pos_and_second_screen_pos")) {
+		info.match_bottom_pos_and_second_screen_pos = std::stoi(value);
+		return true;
+	}
+	return false;
+}
+
+std::string save_screen_info(std::string base, const ScreenInfo &info) {
+	std::string out = "";
+	out += base + "blur=" + std::to_string(info.is_blurred) + "\n";
+	out += base + "crop=" + std::to_string(info.crop_kind) + "\n";
+	out += base + "crop_ds=" + std::to_string(info.crop_kind_ds) + "\n";
+	out += base + "allow_games_crops=" + std::to_string(info.allow_games_crops) + "\n";
+	out += base + "scale=" + std::to_string(info.scaling) + "\n";
+	out += base + "fullscreen=" + std::to_string(info.is_fullscreen) + "\n";
+	out += base + "bot_pos=" + std::to_string(info.bottom_pos) + "\n";
+	out += base + "sub_off=" + std::to_string(info.subscreen_offset) + "\n";
+	out += base + "sub_att_off=" + std::to_string(info.subscreen_attached_offset) + "\n";
+	out += base + "off_x=" + std::to_string(info.total_offset_x) + "\n";
+	out += base + "off_y=" + std::to_string(info.total_offset_y) + "\n";
+	out += base + "top_rot=" + std::to_string(info.top_rotation) + "\n";
+	out += base + "bot_rot=" + std::to_string(info.bot_rotation) + "\n";
+	out += base + "vsync=" + std::to_string(info.v_sync_enabled) + "\n";
+	out += base + "async=" + std::to_string(info.async) + "\n";
+	out += base + "top_scaling=" + std::to_string(info.top_scaling) + "\n";
+	out += base + "bot_scaling=" + std::to_string(info.bot_scaling) + "\n";
+	out += base + "bfi=" + std::to_string(info.bfi) + "\n";
+	out += base + "bfi_divider=" + std::to_string(info.bfi_divider) + "\n";
+	out += base + "bfi_amount=" + std::to_string(info.bfi_amount) + "\n";
+	out += base + "menu_scaling_factor=" + std::to_string(info.menu_scaling_factor) + "\n";
+	out += base + "rounded_corners_fix=" + std::to_string(info.rounded_corners_fix) + "\n";
+	out += base + "top_par=" + std::to_string(info.top_par) + "\n";
+	out += base + "bot_par=" + std::to_string(info.bot_par) + "\n";
+	out += base + "fullscreen_mode_width=" + std::to_string(info.fullscreen_mode_width) + "\n";
+	out += base + "fullscreen_mode_height=" + std::to_string(info.fullscreen_mode_height) + "\n";
+	out += base + "fullscreen_mode_bpp=" + std::to_string(info.fullscreen_mode_bpp) + "\n";
+	out += base + "non_integer_mode=" + std::to_string(info.non_integer_mode) + "\n";
+	out += base + "use_non_integer_scaling_top=" + std::to_string(info.use_non_integer_scaling_top) + "\n";
+	out += base + "use_non_integer_scaling_bottom=" + std::to_string(info.use_non_integer_scaling_bottom) + "\n";
+	out += base + "have_titlebar=" + std::to_string(info.have_titlebar) + "\n";
+	out += base + "top_color_correction=" + std::to_string(info.top_color_correction) + "\n";
+	out += base + "bot_color_correction=" + std::to_string(info.bot_color_correction) + "\n";
+	out += base + "in_colorspace_top=" + std::to_string(info.in_colorspace_top) + "\n";
+	out += base + "in_colorspace_bot=" + std::to_string(info.in_colorspace_bot) + "\n";
+	out += base + "frame_blending_top=" + std::to_string(info.frame_blending_top) + "\n";
+	out += base + "frame_blending_bot=" + std::to_string(info.frame_blending_bot) + "\n";
+	out += base + "window_enabled=" + std::to_string(info.window_enabled) + "\n";
+	out += base + "force_same_scaling=" + std::to_string(info.force_same_scaling) + "\n";
+	out += base + "separator_pixel_size=" + std::to_string(info.separator_pixel_size) + "\n";
+	out += base + "separator_windowed_multiplier=" + std::to_string(info.separator_windowed_multiplier) + "\n";
+	out += base + "separator_fullscreen_multiplier=" + std::to_string(info.separator_fullscreen_multiplier) + "\n";
+	out += base + "second_screen_pos=" + std::to_string(info.second_screen_pos) + "\n";
+	out += base + "squish_3d_top=" + std::to_string(info.squish_3d_top) + "\n";
+	out += base + "squish_3d_bot=" + std::to_string(info.squish_3d_bot) + "\n";
+	out += base + "match_bottom_pos_and_second_screen_pos=" + std::to_string(info.match_bottom_pos_and_second_screen_pos) + "\n";
+	return out;
+}
+
+bool load_shared_data_value(const std::string &key, const std::string &value, SharedData* shared_data) {
+	if(key == "extra_button_enter_short") {
+		shared_data->input_data.extra_button_shortcuts.enter_shortcut = get_window_command(static_cast<PossibleWindowCommands>(std::stoi(value)));
+		return true;
+	}
+	if(key == "extra_button_page_up_short") {
+		shared_data->input_data.extra_button_shortcuts.page_up_shortcut = get_window_command(static_cast<PossibleWindowCommands>(std::stoi(value)));
+		return true;
+	}
+	if(key == "fast_poll") {
+		shared_data->input_data.fast_poll = std::stoi(value);
+		return true;
+	}
+	if(key == "enable_keyboard_input") {
+		shared_data->input_data.enable_keyboard_input = std::stoi(value);
+		return true;
+	}
+	if(key == "enable_controller_input") {
+		shared_data->input_data.enable_controller_input = std::stoi(value);
+		return true;
+	}
+	if(key == "enable_mouse_input") {
+		shared_data->input_data.enable_mouse_input = std::stoi(value);
+		return true;
+	}
+	if(key == "enable_buttons_input") {
+		shared_data->input_data.enable_buttons_input = std::stoi(value);
+		return true;
+	}
+	if(key == "periodic_connection_try") {
+		shared_data->periodic_connection_try = std::stoi(value);
+		return true;
+	}
+	bool found = false;
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		std::string thread_name = get_thread_scheduling_cfg_name(static_cast<ThreadSchedulingType>(i));
+		if(key == (thread_name + "_thread_priority")) {
+			shared_data->thread_scheduling[i].priority_class = static_cast<ThreadPriorityClass>(std::stoi(value));
+			found = true;
+		}
+		if(key == (thread_name + "_thread_cpu")) {
+			shared_data->thread_scheduling[i].cpu = std::stoi(value);
+			found = true;
+		}
+	}
+	return found;
+}
@@ -0,0 +1,371 @@
+#include "ConfigSnapshot.hpp"
+#include "WindowCommands.hpp"
+#include "utils.hpp"
+
+#if (!defined(_MSC_VER)) || (_MSC_VER > 1916)
+#include <filesystem>
+#else
+#include <experimental/filesystem>
+#endif
+#include <fstream>
+#include <iterator>
+#include <cstring>
+#include <type_traits>
+
+#define FNV_64_OFFSET_BASIS 0xCBF29CE484222325
+#define FNV_64_PRIME 0x100000001B3
+
+#define CONFIG_SNAPSHOT_MAGIC "CC3DSSNP"
+#define CONFIG_SNAPSHOT_MAGIC_SIZE 8
+#define CONFIG_SNAPSHOT_MAX_SIZE 0x100000
+#define CONFIG_SNAPSHOT_MAX_STRING_SIZE 0x1000
+#define CONFIG_SNAPSHOT_TEMP_EXTENSION ".tmp"
+
+enum ConfigSnapshotKind { CONFIG_SNAPSHOT_KIND_LAYOUT = 1, CONFIG_SNAPSHOT_KIND_SHARED = 2 };
+
+// Saved as they are. The program's version and the size are checked on load.
+static_assert(std::is_trivially_copyable<ScreenInfo>::value, "ScreenInfo must be trivially copyable to be in a snapshot");
+
+struct SnapshotReader {
+	const uint8_t* data;
+	size_t size;
+	size_t pos;
+};
+
+static uint64_t get_data_hash(const uint8_t* data, size_t size) {
+	uint64_t hash = FNV_64_OFFSET_BASIS;
+	for(size_t i = 0; i < size; i++) {
+		hash ^= data[i];
+		hash *= FNV_64_PRIME;
+	}
+	return hash;
+}
+
+uint64_t get_config_content_hash(const std::string &content) {
+	return get_data_hash((const uint8_t*)content.data(), content.size());
+}
+
+bool get_config_source_state(const std::string &path, ConfigSourceState &state) {
+	std::error_code error;
+	#if (!defined(_MSC_VER)) || (_MSC_VER > 1916)
+	auto write_time = std::filesystem::last_write_time(path, error);
+	if(error)
+		return false;
+	auto file_size = std::filesystem::file_size(path, error);
+	#else
+	auto write_time = std::experimental::filesystem::last_write_time(path, error);
+	if(error)
+		return false;
+	auto file_size = std::experimental::filesystem::file_size(path, error);
+	#endif
+	if(error)
+		return false;
+	state.write_time = (int64_t)write_time.time_since_epoch().count();
+	state.file_size = (uint64_t)file_size;
+	state.content_hash = 0;
+	return true;
+}
+
+bool is_config_source_unchanged(const ConfigSourceState &snapshot_state, const ConfigSourceState &file_state) {
+	return (snapshot_state.write_time == file_state.write_time) && (snapshot_state.file_size == file_state.file_size);
+}
+
+static void write_snapshot_bytes(std::vector<uint8_t> &out, const void* data, size_t size) {
+	const uint8_t* data_u8 = (const uint8_t*)data;
+	out.insert(out.end(), data_u8, data_u8 + size);
+}
+
+static void write_snapshot_u8(std::vector<uint8_t> &out, uint8_t value) {
+	out.push_back(value);
+}
+
+static void write_snapshot_u32(std::vector<uint8_t> &out, uint32_t value) {
+	uint8_t data[sizeof(uint32_t)];
+	write_le32(data, value);
+	write_snapshot_bytes(out, data, sizeof(data));
+}
+
+static void write_snapshot_u64(std::vector<uint8_t> &out, uint64_t value) {
+	uint8_t data[sizeof(uint64_t)];
+	write_le64(data, value);
+	write_snapshot_bytes(out, data, sizeof(data));
+}
+
+static void write_snapshot_string(std::vector<uint8_t> &out, const std::string &value) {
+	write_snapshot_u32(out, (uint32_t)value.size());
+	write_snapshot_bytes(out, value.data(), value.size());
+}
+
+static bool read_snapshot_bytes(SnapshotReader &reader, void* out, size_t size) {
+	if((reader.size - reader.pos) < size)
+		return false;
+	memcpy(out, reader.data + reader.pos, size);
+	reader.pos += size;
+	return true;
+}
+
+static bool read_snapshot_u8(SnapshotReader &reader, uint8_t &value) {
+	return read_snapshot_bytes(reader, &value, sizeof(uint8_t));
+}
+
+static bool read_snapshot_bool(SnapshotReader &reader, bool &value) {
+	uint8_t read_value = 0;
+	if((!read_snapshot_u8(reader, read_value)) || (read_value > 1))
+		return false;
+	value = read_value == 1;
+	return true;
+}
+
+static bool read_snapshot_u32(SnapshotReader &reader, uint32_t &value) {
+	uint8_t data[sizeof(uint32_t)];
+	if(!read_snapshot_bytes(reader, data, sizeof(data)))
+		return false;
+	value = read_le32(data);
+	return true;
+}
+
+static bool read_snapshot_int(SnapshotReader &reader, int &value) {
+	uint32_t read_value = 0;
+	if(!read_snapshot_u32(reader, read_value))
+		return false;
+	value = (int)(int32_t)read_value;
+	return true;
+}
+
+static bool read_snapshot_u64(SnapshotReader &reader, uint64_t &value) {
+	uint8_t data[sizeof(uint64_t)];
+	if(!read_snapshot_bytes(reader, data, sizeof(data)))
+		return false;
+	value = read_le64(data);
+	return true;
+}
+
+static bool read_snapshot_string(SnapshotReader &reader, std::string &value) {
+	uint32_t size = 0;
+	if((!read_snapshot_u32(reader, size)) || (size > CONFIG_SNAPSHOT_MAX_STRING_SIZE) || ((reader.size - reader.pos) < size))
+		return false;
+	value.assign((const char*)(reader.data + reader.pos), size);
+	reader.pos += size;
+	return true;
+}
+
+static void write_snapshot_header(std::vector<uint8_t> &out, ConfigSnapshotKind kind, const ConfigSourceState &source_state) {
+	write_snapshot_bytes(out, CONFIG_SNAPSHOT_MAGIC, CONFIG_SNAPSHOT_MAGIC_SIZE);
+	write_snapshot_u32(out, CONFIG_SNAPSHOT_VERSION);
+	write_snapshot_u32(out, kind);
+	write_snapshot_string(out, get_version_string());
+	write_snapshot_u32(out, sizeof(ScreenInfo));
+	write_snapshot_u64(out, (uint64_t)source_state.write_time);
+	write_snapshot_u64(out, source_state.file_size);
+	write_snapshot_u64(out, source_state.content_hash);
+}
+
+static bool read_snapshot_header(SnapshotReader &reader, ConfigSnapshotKind kind, ConfigSourceState &source_state) {
+	uint8_t magic[CONFIG_SNAPSHOT_MAGIC_SIZE];
+	if((!read_snapshot_bytes(reader, magic, sizeof(magic))) || (memcmp(magic, CONFIG_SNAPSHOT_MAGIC, sizeof(magic)) != 0))
+		return false;
+	uint32_t version = 0;
+	uint32_t read_kind = 0;
+	if((!read_snapshot_u32(reader, version)) || (version != CONFIG_SNAPSHOT_VERSION))
+		return false;
+	if((!read_snapshot_u32(reader, read_kind)) || (read_kind != (uint32_t)kind))
+		return false;
+	std::string program_version;
+	if((!read_snapshot_string(reader, program_version)) || (program_version != get_version_string()))
+		return false;
+	uint32_t screen_info_size = 0;
+	if((!read_snapshot_u32(reader, screen_info_size)) || (screen_info_size != sizeof(ScreenInfo)))
+		return false;
+	uint64_t write_time = 0;
+	if(!read_snapshot_u64(reader, write_time))
+		return false;
+	source_state.write_time = (int64_t)write_time;
+	if(!read_snapshot_u64(reader, source_state.file_size))
+		return false;
+	return read_snapshot_u64(reader, source_state.content_hash);
+}
+
+static bool rename_snapshot_file(const std::string &from, const std::string &to) {
+	std::error_code error;
+	#if (!defined(_MSC_VER)) || (_MSC_VER > 1916)
+	std::filesystem::rename(from, to, error);
+	if(error)
+		std::filesystem::remove(from, error);
+	#else
+	std::experimental::filesystem::rename(from, to, error);
+	if(error)
+		std::experimental::filesystem::remove(from, error);
+	#endif
+	return !error;
+}
+
+// Written to a temporary file first, so a half written snapshot is never read
+static bool write_snapshot_file(const std::string &path, std::vector<uint8_t> &data) {
+	write_snapshot_u64(data, get_data_hash(data.data(), data.size()));
+	const std::string temp_path = path + CONFIG_SNAPSHOT_TEMP_EXTENSION;
+	std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+	if(!file.good())
+		return false;
+	file.write((const char*)data.data(), data.size());
+	file.close();
+	if(!file.good())
+		return false;
+	return rename_snapshot_file(temp_path, path);
+}
+
+static bool read_snapshot_file(const std::string &path, std::vector<uint8_t> &data) {
+	std::ifstream file(path, std::ios::binary);
+	if((!file) || (!file.is_open()) || (!file.good()))
+		return false;
+	data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	file.close();
+	if((data.size() < sizeof(uint64_t)) || (data.size() > CONFIG_SNAPSHOT_MAX_SIZE))
+		return false;
+	size_t data_size = data.size() - sizeof(uint64_t);
+	if(read_le64(data.data() + data_size) != get_data_hash(data.data(), data_size))
+		return false;
+	data.resize(data_size);
+	return true;
+}
+
+bool save_layout_config_snapshot(const std::string &path, const ConfigSourceState &source_state, const LayoutConfigSnapshot &snapshot) {
+	std::vector<uint8_t> data;
+	write_snapshot_header(data, CONFIG_SNAPSHOT_KIND_LAYOUT, source_state);
+	write_snapshot_u8(data, snapshot.mono_app_mode);
+	write_snapshot_bytes(data, &snapshot.top_info, sizeof(ScreenInfo));
+	write_snapshot_bytes(data, &snapshot.bottom_info, sizeof(ScreenInfo));
+	write_snapshot_bytes(data, &snapshot.joint_info, sizeof(ScreenInfo));
+	write_snapshot_u8(data, snapshot.interleaved_3d);
+	write_snapshot_u8(data, snapshot.do_ratio_cycling);
+	write_snapshot_u8(data, snapshot.last_connected_ds);
+	write_snapshot_u8(data, snapshot.requested_3d);
+	write_snapshot_u32(data, snapshot.is_capture_type);
+	write_snapshot_u32(data, snapshot.is_capture_speed);
+	write_snapshot_u32(data, (uint32_t)snapshot.is_battery_percentage);
+	write_snapshot_u8(data, snapshot.is_ac_adapter_connected);
+	write_snapshot_u32(data, (uint32_t)snapshot.partner_ctr_battery_percentage);
+	write_snapshot_u8(data, snapshot.partner_ctr_ac_adapter_connected);
+	write_snapshot_u8(data, snapshot.partner_ctr_ac_adapter_charging);
+	write_snapshot_u8(data, snapshot.request_low_bw_format);
+	write_snapshot_u8(data, snapshot.request_low_bw_format_old_2ds);
+	write_snapshot_u32(data, CC_POSSIBLE_DEVICES_END);
+	for(int i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		write_snapshot_u8(data, snapshot.devices_allowed_scan[i]);
+	write_snapshot_u32(data, (uint32_t)snapshot.audio_values.size());
+	for(size_t i = 0; i < snapshot.audio_values.size(); i++) {
+		write_snapshot_string(data, snapshot.audio_values[i].first);
+		write_snapshot_string(data, snapshot.audio_values[i].second);
+	}
+	return write_snapshot_file(path, data);
+}
+
+bool load_layout_config_snapshot(const std::string &path, ConfigSourceState &source_state, LayoutConfigSnapshot &snapshot) {
+	std::vector<uint8_t> data;
+	if(!read_snapshot_file(path, data))
+		return false;
+	SnapshotReader reader = {data.data(), data.size(), 0};
+	if(!read_snapshot_header(reader, CONFIG_SNAPSHOT_KIND_LAYOUT, source_state))
+		return false;
+	uint32_t capture_type = 0;
+	uint32_t capture_speed = 0;
+	uint32_t num_devices = 0;
+	uint32_t num_audio_values = 0;
+	bool success = read_snapshot_bool(reader, snapshot.mono_app_mode);
+	success = success && read_snapshot_bytes(reader, &snapshot.top_info, sizeof(ScreenInfo));
+	success = success && read_snapshot_bytes(reader, &snapshot.bottom_info, sizeof(ScreenInfo));
+	success = success && read_snapshot_bytes(reader, &snapshot.joint_info, sizeof(ScreenInfo));
+	success = success && read_snapshot_bool(reader, snapshot.interleaved_3d);
+	success = success && read_snapshot_bool(reader, snapshot.do_ratio_cycling);
+	success = success && read_snapshot_bool(reader, snapshot.last_connected_ds);
+	success = success && read_snapshot_bool(reader, snapshot.requested_3d);
+	success = success && read_snapshot_u32(reader, capture_type) && (capture_type < CAPTURE_SCREENS_ENUM_END);
+	success = success && read_snapshot_u32(reader, capture_speed) && (capture_speed < CAPTURE_SPEEDS_ENUM_END);
+	success = success && read_snapshot_int(reader, snapshot.is_battery_percentage);
+	success = success && read_snapshot_bool(reader, snapshot.is_ac_adapter_connected);
+	success = success && read_snapshot_int(reader, snapshot.partner_ctr_battery_percentage);
+	success = success && read_snapshot_bool(reader, snapshot.partner_ctr_ac_adapter_connected);
+	success = success && read_snapshot_bool(reader, snapshot.partner_ctr_ac_adapter_charging);
+	success = success && read_snapshot_bool(reader, snapshot.request_low_bw_format);
+	success = success && read_snapshot_bool(reader, snapshot.request_low_bw_format_old_2ds);
+	success = success && read_snapshot_u32(reader, num_devices) && (num_devices == CC_POSSIBLE_DEVICES_END);
+	for(int i = 0; success && (i < CC_POSSIBLE_DEVICES_END); i++)
+		success = read_snapshot_bool(reader, snapshot.devices_allowed_scan[i]);
+	success = success && read_snapshot_u32(reader, num_audio_values);
+	if(!success)
+		return false;
+	snapshot.is_capture_type = static_cast<CaptureScreensType>(capture_type);
+	snapshot.is_capture_speed = static_cast<CaptureSpeedsType>(capture_speed);
+	snapshot.audio_values.clear();
+	for(uint32_t i = 0; i < num_audio_values; i++) {
+		std::string key;
+		std::string value;
+		if((!read_snapshot_string(reader, key)) || (!read_snapshot_string(reader, value)))
+			return false;
+		snapshot.audio_values.emplace_back(key, value);
+	}
+	return reader.pos == reader.size;
+}
+
+static PossibleWindowCommands get_snapshot_window_command_id(const WindowCommand* command) {
+	if(command == NULL)
+		return WINDOW_COMMAND_NONE;
+	return command->cmd;
+}
+
+bool save_shared_config_snapshot(const std::string &path, const ConfigSourceState &source_state, const SharedData &shared_data) {
+	std::vector<uint8_t> data;
+	write_snapshot_header(data, CONFIG_SNAPSHOT_KIND_SHARED, source_state);
+	write_snapshot_u32(data, get_snapshot_window_command_id(shared_data.input_data.extra_button_shortcuts.enter_shortcut));
+	write_snapshot_u32(data, get_snapshot_window_command_id(shared_data.input_data.extra_button_shortcuts.page_up_shortcut));
+	write_snapshot_u8(data, shared_data.input_data.fast_poll);
+	write_snapshot_u8(data, shared_data.input_data.enable_controller_input);
+	write_snapshot_u8(data, shared_data.input_data.enable_keyboard_input);
+	write_snapshot_u8(data, shared_data.input_data.enable_mouse_input);
+	write_snapshot_u8(data, shared_data.input_data.enable_buttons_input);
+	write_snapshot_u8(data, shared_data.periodic_connection_try);
+	write_snapshot_u32(data, THREAD_SCHEDULING_TYPE_END);
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		write_snapshot_u32(data, shared_data.thread_scheduling[i].priority_class);
+		write_snapshot_u32(data, (uint32_t)shared_data.thread_scheduling[i].cpu);
+	}
+	return write_snapshot_file(path, data);
+}
+
+bool load_shared_config_snapshot(const std::string &path, ConfigSourceState &source_state, SharedData &shared_data) {
+	std::vector<uint8_t> data;
+	if(!read_snapshot_file(path, data))
+		return false;
+	SnapshotReader reader = {data.data(), data.size(), 0};
+	if(!read_snapshot_header(reader, CONFIG_SNAPSHOT_KIND_SHARED, source_state))
+		return false;
+	// Only changes shared_data if everything could be read
+	InputData input_data;
+	bool periodic_connection_try = false;
+	ThreadSchedulingSettings thread_scheduling[THREAD_SCHEDULING_TYPE_END];
+	uint32_t enter_shortcut = 0;
+	uint32_t page_up_shortcut = 0;
+	uint32_t num_thread_types = 0;
+	bool success = read_snapshot_u32(reader, enter_shortcut);
+	success = success && read_snapshot_u32(reader, page_up_shortcut);
+	success = success && read_snapshot_bool(reader, input_data.fast_poll);
+	success = success && read_snapshot_bool(reader, input_data.enable_controller_input);
+	success = success && read_snapshot_bool(reader, input_data.enable_keyboard_input);
+	success = success && read_snapshot_bool(reader, input_data.enable_mouse_input);
+	success = success && read_snapshot_bool(reader, input_data.enable_buttons_input);
+	success = success && read_snapshot_bool(reader, periodic_connection_try);
+	success = success && read_snapshot_u32(reader, num_thread_types) && (num_thread_types == THREAD_SCHEDULING_TYPE_END);
+	for(int i = 0; success && (i < THREAD_SCHEDULING_TYPE_END); i++) {
+		uint32_t priority_class = 0;
+		success = read_snapshot_u32(reader, priority_class) && read_snapshot_int(reader, thread_scheduling[i].cpu);
+		thread_scheduling[i].priority_class = static_cast<ThreadPriorityClass>(priority_class);
+	}
+	if((!success) || (reader.pos != reader.size))
+		return false;
+	input_data.extra_button_shortcuts.enter_shortcut = get_window_command(static_cast<PossibleWindowCommands>(enter_shortcut));
+	input_data.extra_button_shortcuts.page_up_shortcut = get_window_command(static_cast<PossibleWindowCommands>(page_up_shortcut));
+	shared_data.input_data = input_data;
+	shared_data.periodic_connection_try = periodic_connection_try;
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++)
+		shared_data.thread_scheduling[i] = thread_scheduling[i];
+	return true;
+}
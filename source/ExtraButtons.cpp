@@ -1,56 +1,93 @@
 #include "ExtraButtons.hpp"
 #include "utils.hpp"
 
+#ifdef RASPI
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
 #define NUM_PI_BUTTONS (sizeof(pi_buttons) / sizeof(pi_buttons[0]))
 
 static ExtraButton pi_page_up, pi_page_down, pi_enter, pi_power;
 static ExtraButton* pi_buttons[] = {&pi_page_up, &pi_page_down, &pi_enter, &pi_power};
+// Filled by the input thread, emptied by the main thread
+static ExtraButtonsEventsQueue extra_buttons_events;
+#ifdef RASPI
+// Lets the main thread wake up the input thread when closing
+static int extra_buttons_wake_fds[2] = {-1, -1};
+#endif
 
-void ExtraButton::initialize(int id, sf::Keyboard::Key corresponding_key, bool is_power, float first_re_press_time, float later_re_press_time, bool use_pud_up, std::string name) {
+void ExtraButton::initialize(int id, sf::Keyboard::Key corresponding_key, bool is_power, float first_re_press_time, float later_re_press_time, bool use_pud_up, bool use_events, std::string name) {
 	this->id = id;
 	this->is_power = is_power;
 	this->corresponding_key = corresponding_key;
 	this->started = false;
+	this->last_sent_pressed = false;
 	this->initialized = true;
 	this->is_time_valid = false;
 	this->last_press_time = std::chrono::high_resolution_clock::now();
 	this->first_re_press_time = first_re_press_time;
 	this->later_re_press_time = later_re_press_time;
 	this->name = name;
-	#ifdef RASPI
-	if(this->id >= 0) {
-		std::string gpio_str = "GPIO" + std::to_string(this->id);
-		this->gpioline_ptr = gpiod_line_find(gpio_str.c_str());
-	}
+	this->line_source = open_gpio_extra_button_line(id, use_pud_up, use_events);
+	if(this->line_source && this->line_source->has_events())
+		this->debouncer.reset(this->line_source->is_low());
 	else
-		this->gpioline_ptr = NULL;
-	if(this->gpioline_ptr) {
-		if(use_pud_up)
-			gpiod_line_request_input_flags(this->gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
-		else
-			gpiod_line_request_input_flags(this->gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN);
-	}
-	#endif
+		this->debouncer.reset(false);
 }
 
 void ExtraButton::end() {
 	if(!initialized)
 		return;
-	#ifdef RASPI
-	if(!this->gpioline_ptr)
-		return;
-	gpiod_line_close_chip(this->gpioline_ptr);
-	gpiod_line_release(this->gpioline_ptr);
-	this->gpioline_ptr = NULL;
-	#endif
+	if(this->line_source)
+		delete this->line_source;
+	this->line_source = NULL;
 }
 
 bool ExtraButton::is_pressed() {
-	#ifdef RASPI
-	if(this->gpioline_ptr)
-		return gpiod_line_get_value(this->gpioline_ptr) == 0;
-	#endif
-	return false;
+	if(!this->line_source)
+		return false;
+	if(this->line_source->has_events())
+		return this->debouncer.is_pressed();
+	return this->line_source->is_low();
+}
+
+int ExtraButton::get_event_fd() {
+	if(this->is_valid())
+		return this->line_source->get_event_fd();
+	return -1;
+}
+
+// How long the input thread can sleep without missing anything.
+// -1 means until the next edge.
+int ExtraButton::get_event_wait_timeout_ms() {
+	int timeout_ms = -1;
+	// Wake up when the next re-press is due
+	if(!this->is_valid())
+		return -1;
+	if(this->debouncer.is_pressed()) {
+		if(!this->is_time_valid)
+			return 0;
+		float press_frequency_limit = this->first_re_press_time;
+		if((!this->started) || this->after_first)
+			press_frequency_limit = this->later_re_press_time;
+		const std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - this->last_press_time;
+		timeout_ms = (int)((press_frequency_limit - diff.count()) * 1000) + 1;
+		if(timeout_ms < 0)
+			timeout_ms = 0;
+	}
+	// Wake up when the line needs to be read again after bouncing
+	int resync_timeout_ms = this->debouncer.get_resync_timeout_ms(this->line_source);
+	if((resync_timeout_ms >= 0) && ((timeout_ms < 0) || (resync_timeout_ms < timeout_ms)))
+		timeout_ms = resync_timeout_ms;
+	return timeout_ms;
+}
+
+void ExtraButton::process_events() {
+	if((!this->is_valid()) || (!this->line_source->has_events()))
+		return;
+	this->debouncer.process_events(this->line_source);
 }
 
 std::string ExtraButton::get_name() {
@@ -64,14 +101,10 @@ bool ExtraButton::is_button_x(sf::Keyboard::Key corresponding_key) {
 }
 
 bool ExtraButton::is_valid() {
-	#ifdef RASPI
-	return this->initialized && (this->id >= 0) && this->gpioline_ptr;
-	#else
-	return false;
-	#endif
+	return this->initialized && (this->id >= 0) && this->line_source;
 }
 
-void ExtraButton::poll(std::queue<SFEvent> &events_queue) {
+void ExtraButton::poll(ExtraButtonsEventsQueue &events_queue) {
 	if(!this->is_valid())
 		return;
 	bool pressed = false;
@@ -96,9 +129,14 @@ void ExtraButton::poll(std::queue<SFEvent> &events_queue) {
 		else
 			this->after_first = true;
 	}
-	else
+	else {
 		this->started = false;
-	events_queue.emplace(pressed, this->corresponding_key, false, false, false, false, this->is_power, true);
+		// Only send releases once, this runs way more often than the main loop
+		if(!this->last_sent_pressed)
+			return;
+	}
+	if(events_queue.push(SFEvent(pressed, this->corresponding_key, false, false, false, false, this->is_power, true)))
+		this->last_sent_pressed = pressed;
 }
 
 std::string get_extra_button_name(sf::Keyboard::Key corresponding_key) {
@@ -108,11 +146,21 @@ std::string get_extra_button_name(sf::Keyboard::Key corresponding_key) {
 	return "";
 }
 
-void init_extra_buttons_poll(int page_up_id, int page_down_id, int enter_id, int power_id, bool use_pud_up) {
-	pi_page_up.initialize(page_up_id, sf::Keyboard::Key::PageUp, false, 0.5f, 0.03f, use_pud_up, "Select");
-	pi_page_down.initialize(page_down_id, sf::Keyboard::Key::PageDown, false, 0.5f, 0.03f, use_pud_up, "Menu");
-	pi_enter.initialize(enter_id, sf::Keyboard::Key::Enter, false, 0.5f, 0.075f, use_pud_up, "Enter");
-	pi_power.initialize(power_id, sf::Keyboard::Key::Escape, true, 30.0f, 30.0f, use_pud_up, "Power");
+void init_extra_buttons_poll(int page_up_id, int page_down_id, int enter_id, int power_id, bool use_pud_up, bool use_events) {
+	#ifdef RASPI
+	if(pipe(extra_buttons_wake_fds) == 0) {
+		fcntl(extra_buttons_wake_fds[0], F_SETFL, O_NONBLOCK);
+		fcntl(extra_buttons_wake_fds[1], F_SETFL, O_NONBLOCK);
+	}
+	else {
+		extra_buttons_wake_fds[0] = -1;
+		extra_buttons_wake_fds[1] = -1;
+	}
+	#endif
+	pi_page_up.initialize(page_up_id, sf::Keyboard::Key::PageUp, false, 0.5f, 0.03f, use_pud_up, use_events, "Select");
+	pi_page_down.initialize(page_down_id, sf::Keyboard::Key::PageDown, false, 0.5f, 0.03f, use_pud_up, use_events, "Menu");
+	pi_enter.initialize(enter_id, sf::Keyboard::Key::Enter, false, 0.5f, 0.075f, use_pud_up, use_events, "Enter");
+	pi_power.initialize(power_id, sf::Keyboard::Key::Escape, true, 30.0f, 30.0f, use_pud_up, use_events, "Power");
 }
 
 bool are_extra_buttons_usable() {
@@ -122,9 +170,81 @@ bool are_extra_buttons_usable() {
 void end_extra_buttons_poll() {
 	for(size_t i = 0; i < NUM_PI_BUTTONS; i++)
 		pi_buttons[i]->end();
+	#ifdef RASPI
+	for(int i = 0; i < 2; i++) {
+		if(extra_buttons_wake_fds[i] >= 0)
+			close(extra_buttons_wake_fds[i]);
+		extra_buttons_wake_fds[i] = -1;
+	}
+	#endif
 }
 
-void extra_buttons_poll(std::queue<SFEvent> &events_queue) {
+void extra_buttons_thread_poll() {
 	for(size_t i = 0; i < NUM_PI_BUTTONS; i++)
-		pi_buttons[i]->poll(events_queue);
+		pi_buttons[i]->poll(extra_buttons_events);
+}
+
+// Sleeps until something may have changed, or until woken up.
+// Lines without events need to be polled every poll_period_ms.
+void extra_buttons_thread_wait(int poll_period_ms) {
+	#ifdef RASPI
+	struct pollfd fds[NUM_PI_BUTTONS + 1];
+	ExtraButton* fds_buttons[NUM_PI_BUTTONS];
+	int num_fds = 0;
+	int timeout_ms = -1;
+	for(size_t i = 0; i < NUM_PI_BUTTONS; i++) {
+		if(pi_buttons[i]->get_name() == "")
+			continue;
+		int fd = pi_buttons[i]->get_event_fd();
+		int button_timeout_ms = poll_period_ms;
+		if(fd >= 0) {
+			fds[num_fds].fd = fd;
+			fds[num_fds].events = POLLIN;
+			fds[num_fds].revents = 0;
+			fds_buttons[num_fds++] = pi_buttons[i];
+			button_timeout_ms = pi_buttons[i]->get_event_wait_timeout_ms();
+		}
+		if((button_timeout_ms >= 0) && ((timeout_ms < 0) || (button_timeout_ms < timeout_ms)))
+			timeout_ms = button_timeout_ms;
+	}
+	int num_button_fds = num_fds;
+	if(extra_buttons_wake_fds[0] >= 0) {
+		fds[num_fds].fd = extra_buttons_wake_fds[0];
+		fds[num_fds].events = POLLIN;
+		fds[num_fds].revents = 0;
+		num_fds++;
+	}
+	// Without a way to be woken up, do not sleep forever
+	else if((timeout_ms < 0) || (timeout_ms > EXTRA_BUTTONS_MAX_EVENT_WAIT_MS))
+		timeout_ms = EXTRA_BUTTONS_MAX_EVENT_WAIT_MS;
+	if(num_fds > 0) {
+		poll(fds, num_fds, timeout_ms);
+		for(int i = 0; i < num_button_fds; i++)
+			fds_buttons[i]->process_events();
+		if((num_fds > num_button_fds) && (fds[num_button_fds].revents & POLLIN)) {
+			uint8_t wake_data[16];
+			while(read(extra_buttons_wake_fds[0], wake_data, sizeof(wake_data)) > 0);
+		}
+		return;
+	}
+	#endif
+	sf::sleep(sf::milliseconds(poll_period_ms));
+}
+
+void extra_buttons_thread_wake() {
+	#ifdef RASPI
+	if(extra_buttons_wake_fds[1] >= 0) {
+		uint8_t wake_data = 0;
+		if(write(extra_buttons_wake_fds[1], &wake_data, sizeof(wake_data)) < 0)
+			return;
+	}
+	#endif
+}
+
+void extra_buttons_poll(std::queue<SFEvent> &events_queue) {
+	take_extra_button_events(extra_buttons_events, &events_queue);
+}
+
+void extra_buttons_flush() {
+	take_extra_button_events<SFEvent>(extra_buttons_events, NULL);
 }
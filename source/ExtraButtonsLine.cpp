@@ -0,0 +1,127 @@
+#include "ExtraButtonsLine.hpp"
+#include "libgpiod_compat.h"
+#include "utils.hpp"
+
+#include <chrono>
+#include <string>
+
+#ifdef RASPI
+class GpiodExtraButtonLineSource : public ExtraButtonLineSource {
+public:
+	GpiodExtraButtonLineSource(gpiod_line* gpioline_ptr, bool uses_events) {
+		this->gpioline_ptr = gpioline_ptr;
+		this->uses_events = uses_events;
+	}
+
+	~GpiodExtraButtonLineSource() {
+		gpiod_line_close_chip(this->gpioline_ptr);
+		gpiod_line_release(this->gpioline_ptr);
+	}
+
+	bool has_events() override {
+		return this->uses_events;
+	}
+
+	bool is_low() override {
+		return gpiod_line_get_value(this->gpioline_ptr) == 0;
+	}
+
+	int get_event_fd() override {
+		if(!this->uses_events)
+			return -1;
+		return gpiod_line_event_get_fd(this->gpioline_ptr);
+	}
+
+	bool read_edge(uint64_t &edge_ns, bool &is_falling) override {
+		if(!this->uses_events)
+			return false;
+		struct timespec no_wait = {0, 0};
+		struct gpiod_line_event event;
+		if(gpiod_line_event_wait(this->gpioline_ptr, &no_wait) != 1)
+			return false;
+		if(gpiod_line_event_read(this->gpioline_ptr, &event) != 0)
+			return false;
+		edge_ns = (((uint64_t)event.ts.tv_sec) * 1000000000) + event.ts.tv_nsec;
+		is_falling = event.event_type == GPIOD_LINE_EVENT_FALLING_EDGE;
+		return true;
+	}
+
+	// The kernel uses the monotonic clock for the edges, too
+	uint64_t get_time_ns() override {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	gpiod_line* gpioline_ptr;
+	bool uses_events;
+};
+#endif
+
+ExtraButtonLineSource* open_gpio_extra_button_line([[maybe_unused]] int id, [[maybe_unused]] bool use_pud_up, [[maybe_unused]] bool use_events) {
+	#ifdef RASPI
+	if(id < 0)
+		return NULL;
+	std::string gpio_str = "GPIO" + std::to_string(id);
+	gpiod_line* gpioline_ptr = gpiod_line_find(gpio_str.c_str());
+	if(!gpioline_ptr)
+		return NULL;
+	// Get told about the changes by the kernel, if possible.
+	// Otherwise, keep polling the line.
+	bool uses_events = false;
+	if(use_events) {
+		if(use_pud_up)
+			uses_events = gpiod_line_request_both_edges_events_flags(gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP) == 0;
+		else
+			uses_events = gpiod_line_request_both_edges_events_flags(gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN) == 0;
+	}
+	if(!uses_events) {
+		if(use_pud_up)
+			gpiod_line_request_input_flags(gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_UP);
+		else
+			gpiod_line_request_input_flags(gpioline_ptr, NAME, GPIOD_LINE_REQUEST_FLAG_BIAS_PULL_DOWN);
+	}
+	return new GpiodExtraButtonLineSource(gpioline_ptr, uses_events);
+	#else
+	return NULL;
+	#endif
+}
+
+void ExtraButtonDebouncer::reset(bool pressed) {
+	this->pressed = pressed;
+	this->has_last_edge = false;
+	this->needs_resync = false;
+	this->last_edge_ns = 0;
+	this->last_edge_local_ns = 0;
+}
+
+bool ExtraButtonDebouncer::is_pressed() {
+	return this->pressed;
+}
+
+void ExtraButtonDebouncer::process_events(ExtraButtonLineSource* line_source) {
+	uint64_t edge_ns = 0;
+	bool is_falling = false;
+	while(line_source->read_edge(edge_ns, is_falling)) {
+		if(this->has_last_edge && (edge_ns >= this->last_edge_ns) && ((edge_ns - this->last_edge_ns) < EXTRA_BUTTONS_DEBOUNCE_NS)) {
+			this->needs_resync = true;
+			continue;
+		}
+		this->has_last_edge = true;
+		this->last_edge_ns = edge_ns;
+		this->last_edge_local_ns = line_source->get_time_ns();
+		this->pressed = is_falling;
+	}
+	if(this->needs_resync && ((line_source->get_time_ns() - this->last_edge_local_ns) >= EXTRA_BUTTONS_DEBOUNCE_NS)) {
+		this->needs_resync = false;
+		this->pressed = line_source->is_low();
+	}
+}
+
+int ExtraButtonDebouncer::get_resync_timeout_ms(ExtraButtonLineSource* line_source) {
+	if(!this->needs_resync)
+		return -1;
+	uint64_t elapsed_ns = line_source->get_time_ns() - this->last_edge_local_ns;
+	if(elapsed_ns >= EXTRA_BUTTONS_DEBOUNCE_NS)
+		return 0;
+	return (int)((EXTRA_BUTTONS_DEBOUNCE_NS - elapsed_ns) / 1000000) + 1;
+}
@@ -0,0 +1,656 @@
+#include "FrameRecorder.hpp"
+
+#include <cstring>
+#include <algorithm>
+
+static inline void write_recording_varint(uint8_t* out, size_t &out_pos, uint64_t value) {
+	while(value >= 0x80) {
+		out[out_pos++] = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	out[out_pos++] = (uint8_t)value;
+}
+
+// Byte-wise difference from the previous frame. Runs of unchanged 8 bytes
+// words become just a length, everything else is stored as it is.
+// The screens rarely change completely between two frames, so this
+// is enough to make the data a lot smaller, and it is very cheap.
+size_t encode_recording_delta(const uint8_t* curr, const uint8_t* prev, size_t size, uint8_t* out) {
+	size_t pos = 0;
+	size_t out_pos = 0;
+	while(pos < size) {
+		size_t start = pos;
+		while(((pos + 8) <= size) && (memcmp(curr + pos, prev + pos, 8) == 0))
+			pos += 8;
+		if(pos > start) {
+			write_recording_varint(out, out_pos, ((pos - start) << 1) | 1);
+			continue;
+		}
+		while(((pos + 8) <= size) && (memcmp(curr + pos, prev + pos, 8) != 0))
+			pos += 8;
+		if((pos + 8) > size)
+			pos = size;
+		write_recording_varint(out, out_pos, (pos - start) << 1);
+		for(size_t i = start; i < pos; i++)
+			out[out_pos++] = curr[i] - prev[i];
+	}
+	return out_pos;
+}
+
+static inline bool read_recording_varint(const uint8_t* in, size_t in_size, size_t &in_pos, uint64_t &value) {
+	value = 0;
+	for(int shift = 0; shift < 64; shift += 7) {
+		if(in_pos >= in_size)
+			return false;
+		uint8_t data = in[in_pos++];
+		value |= ((uint64_t)(data & 0x7F)) << shift;
+		if(!(data & 0x80))
+			return true;
+	}
+	return false;
+}
+
+// Applies the output of encode_recording_delta to the previous frame.
+// Anything which would end up out of bounds means the data is broken.
+bool decode_recording_delta(const uint8_t* in, size_t in_size, uint8_t* frame, size_t size) {
+	size_t in_pos = 0;
+	size_t pos = 0;
+	while(in_pos < in_size) {
+		uint64_t token = 0;
+		if(!read_recording_varint(in, in_size, in_pos, token))
+			return false;
+		uint64_t length = token >> 1;
+		if(length > (size - pos))
+			return false;
+		if(!(token & 1)) {
+			if(length > (in_size - in_pos))
+				return false;
+			for(size_t i = 0; i < length; i++)
+				frame[pos + i] += in[in_pos + i];
+			in_pos += length;
+		}
+		pos += length;
+	}
+	return pos == size;
+}
+
+// Plain Huffman code lengths. Two sorted queues are enough, since the new
+// nodes are created with increasing frequencies.
+static void compute_recording_entropy_lengths(const uint64_t* freqs, uint8_t* lengths) {
+	const int max_nodes = (RECORDING_ENTROPY_NUM_SYMBOLS * 2) - 1;
+	uint64_t node_freqs[max_nodes];
+	int parents[max_nodes];
+	int leaves[RECORDING_ENTROPY_NUM_SYMBOLS];
+	int num_leaves = 0;
+	memset(lengths, 0, RECORDING_ENTROPY_NUM_SYMBOLS);
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++) {
+		if(freqs[i] == 0)
+			continue;
+		node_freqs[num_leaves] = freqs[i];
+		leaves[num_leaves++] = i;
+	}
+	if(num_leaves == 0)
+		return;
+	if(num_leaves == 1) {
+		lengths[leaves[0]] = 1;
+		return;
+	}
+	int order[RECORDING_ENTROPY_NUM_SYMBOLS];
+	for(int i = 0; i < num_leaves; i++)
+		order[i] = i;
+	std::sort(order, order + num_leaves, [&node_freqs](int a, int b) { return node_freqs[a] < node_freqs[b]; });
+	int num_nodes = num_leaves;
+	int leaf_pos = 0;
+	int internal_pos = num_leaves;
+	while(((num_leaves - leaf_pos) + (num_nodes - internal_pos)) > 1) {
+		int children[2];
+		for(int j = 0; j < 2; j++) {
+			if((leaf_pos < num_leaves) && ((internal_pos >= num_nodes) || (node_freqs[order[leaf_pos]] <= node_freqs[internal_pos])))
+				children[j] = order[leaf_pos++];
+			else
+				children[j] = internal_pos++;
+		}
+		node_freqs[num_nodes] = node_freqs[children[0]] + node_freqs[children[1]];
+		parents[children[0]] = num_nodes;
+		parents[children[1]] = num_nodes;
+		num_nodes++;
+	}
+	// The root is the last node. Parents always come after their children.
+	int depths[max_nodes];
+	depths[num_nodes - 1] = 0;
+	for(int i = num_nodes - 2; i >= 0; i--)
+		depths[i] = depths[parents[i]] + 1;
+	for(int i = 0; i < num_leaves; i++)
+		lengths[leaves[i]] = (uint8_t)depths[i];
+}
+
+// Flattening the frequencies until the codes are short enough
+// is not optimal, but it is simple and it rarely needs to happen.
+static void build_recording_entropy_lengths(const uint64_t* freqs, uint8_t* lengths) {
+	uint64_t curr_freqs[RECORDING_ENTROPY_NUM_SYMBOLS];
+	memcpy(curr_freqs, freqs, sizeof(curr_freqs));
+	while(true) {
+		compute_recording_entropy_lengths(curr_freqs, lengths);
+		uint8_t max_length = 0;
+		for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++)
+			max_length = std::max(max_length, lengths[i]);
+		if(max_length <= RECORDING_ENTROPY_MAX_CODE_LENGTH)
+			return;
+		for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++)
+			if(curr_freqs[i] > 0)
+				curr_freqs[i] = (curr_freqs[i] >> 1) | 1;
+	}
+}
+
+// Canonical codes, bit reversed, since the bits are read from the lowest one.
+// Returns false if the lengths do not make a valid prefix code.
+static bool build_recording_entropy_codes(const uint8_t* lengths, uint16_t* codes) {
+	int length_counts[RECORDING_ENTROPY_MAX_CODE_LENGTH + 1] = {};
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++)
+		length_counts[lengths[i]]++;
+	length_counts[0] = 0;
+	int available_codes = 1;
+	uint16_t next_code[RECORDING_ENTROPY_MAX_CODE_LENGTH + 1] = {};
+	uint16_t code = 0;
+	for(int i = 1; i <= RECORDING_ENTROPY_MAX_CODE_LENGTH; i++) {
+		available_codes = (available_codes * 2) - length_counts[i];
+		if(available_codes < 0)
+			return false;
+		code = (code + length_counts[i - 1]) << 1;
+		next_code[i] = code;
+	}
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++) {
+		if(lengths[i] == 0)
+			continue;
+		uint16_t curr_code = next_code[lengths[i]]++;
+		uint16_t reversed_code = 0;
+		for(int j = 0; j < lengths[i]; j++)
+			reversed_code |= ((curr_code >> j) & 1) << (lengths[i] - 1 - j);
+		codes[i] = reversed_code;
+	}
+	return true;
+}
+
+// Returns 0 when the coded data would not be any smaller.
+// out must have space for RECORDING_ENTROPY_HEADER_SIZE + size bytes.
+size_t encode_recording_entropy(const uint8_t* in, size_t size, uint8_t* out) {
+	if((size == 0) || (size > 0xFFFFFFFF))
+		return 0;
+	uint64_t freqs[RECORDING_ENTROPY_NUM_SYMBOLS] = {};
+	for(size_t i = 0; i < size; i++)
+		freqs[in[i]]++;
+	uint8_t lengths[RECORDING_ENTROPY_NUM_SYMBOLS];
+	uint16_t codes[RECORDING_ENTROPY_NUM_SYMBOLS];
+	build_recording_entropy_lengths(freqs, lengths);
+	if(!build_recording_entropy_codes(lengths, codes))
+		return 0;
+	uint64_t total_bits = 0;
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++)
+		total_bits += freqs[i] * lengths[i];
+	size_t out_size = RECORDING_ENTROPY_HEADER_SIZE + (size_t)((total_bits + 7) / 8);
+	if(out_size >= size)
+		return 0;
+	for(int i = 0; i < (RECORDING_ENTROPY_NUM_SYMBOLS / 2); i++)
+		out[i] = lengths[i * 2] | (lengths[(i * 2) + 1] << 4);
+	write_le32(out + (RECORDING_ENTROPY_NUM_SYMBOLS / 2), (uint32_t)size);
+	size_t out_pos = RECORDING_ENTROPY_HEADER_SIZE;
+	uint64_t bit_buffer = 0;
+	int num_bits = 0;
+	for(size_t i = 0; i < size; i++) {
+		bit_buffer |= ((uint64_t)codes[in[i]]) << num_bits;
+		num_bits += lengths[in[i]];
+		if(num_bits >= 32) {
+			write_le32(out + out_pos, (uint32_t)bit_buffer);
+			out_pos += 4;
+			bit_buffer >>= 32;
+			num_bits -= 32;
+		}
+	}
+	while(num_bits > 0) {
+		out[out_pos++] = bit_buffer & 0xFF;
+		bit_buffer >>= 8;
+		num_bits -= 8;
+	}
+	return out_pos;
+}
+
+// Anything which does not decode to exactly the stored size is broken
+bool decode_recording_entropy(const uint8_t* in, size_t in_size, uint8_t* out, size_t out_max_size, size_t &out_size) {
+	out_size = 0;
+	if(in_size < RECORDING_ENTROPY_HEADER_SIZE)
+		return false;
+	uint8_t lengths[RECORDING_ENTROPY_NUM_SYMBOLS];
+	uint16_t codes[RECORDING_ENTROPY_NUM_SYMBOLS];
+	for(int i = 0; i < (RECORDING_ENTROPY_NUM_SYMBOLS / 2); i++) {
+		lengths[i * 2] = in[i] & 0xF;
+		lengths[(i * 2) + 1] = in[i] >> 4;
+	}
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++)
+		if(lengths[i] > RECORDING_ENTROPY_MAX_CODE_LENGTH)
+			return false;
+	size_t decoded_size = read_le32(in + (RECORDING_ENTROPY_NUM_SYMBOLS / 2));
+	if(decoded_size > out_max_size)
+		return false;
+	if(!build_recording_entropy_codes(lengths, codes))
+		return false;
+	// Each entry is the symbol plus its length, or 0 for no code
+	const int table_size = 1 << RECORDING_ENTROPY_MAX_CODE_LENGTH;
+	uint16_t table[table_size];
+	memset(table, 0, sizeof(table));
+	for(int i = 0; i < RECORDING_ENTROPY_NUM_SYMBOLS; i++) {
+		if(lengths[i] == 0)
+			continue;
+		for(int j = codes[i]; j < table_size; j += 1 << lengths[i])
+			table[j] = i | (lengths[i] << 8);
+	}
+	size_t in_pos = RECORDING_ENTROPY_HEADER_SIZE;
+	uint64_t bit_buffer = 0;
+	int num_bits = 0;
+	for(size_t i = 0; i < decoded_size; i++) {
+		while((num_bits <= 56) && (in_pos < in_size)) {
+			bit_buffer |= ((uint64_t)in[in_pos++]) << num_bits;
+			num_bits += 8;
+		}
+		uint16_t entry = table[bit_buffer & (table_size - 1)];
+		int length = entry >> 8;
+		if((length == 0) || (length > num_bits))
+			return false;
+		out[i] = entry & 0xFF;
+		bit_buffer >>= length;
+		num_bits -= length;
+	}
+	out_size = decoded_size;
+	return true;
+}
+
+void write_recording_record_header(uint8_t* data, const RecordingRecordHeader &header) {
+	write_le32(data, header.type);
+	write_le16(data + 4, header.flags);
+	write_le16(data + 6, header.format);
+	write_le32(data + 8, header.payload_size);
+	write_le32(data + 12, header.raw_size);
+	write_le64(data + 16, header.time_us);
+	write_le64(data + 24, header.index);
+}
+
+bool read_recording_record_header(const uint8_t* data, RecordingRecordHeader &header) {
+	uint32_t type = read_le32(data);
+	if(type > RECORDING_RECORD_INDEX)
+		return false;
+	header.type = (RecordingRecordType)type;
+	header.flags = read_le16(data + 4);
+	header.format = read_le16(data + 6);
+	header.payload_size = read_le32(data + 8);
+	header.raw_size = read_le32(data + 12);
+	header.time_us = read_le64(data + 16);
+	header.index = read_le64(data + 24);
+	return true;
+}
+
+void write_recording_device_info(uint8_t* data, const CaptureDevice &device) {
+	memset(data, 0, RECORDING_DEVICE_INFO_SIZE);
+	data[0] = device.is_3ds;
+	data[1] = device.has_3d;
+	data[2] = device.has_audio;
+	data[3] = device.video_data_type;
+	write_le32(data + 4, device.sample_rate);
+	const int values[] = {device.width, device.height, device.width_3d, device.height_3d, device.base_rotation, device.top_screen_x, device.top_screen_y, device.second_top_screen_x, device.second_top_screen_y, device.bot_screen_x, device.bot_screen_y};
+	for(size_t i = 0; i < (sizeof(values) / sizeof(values[0])); i++)
+		write_le32(data + 8, (uint32_t)values[i], i);
+	data[52] = device.is_second_top_screen_right;
+	data[53] = device.continuous_3d_screens;
+	data[54] = device.is_horizontally_flipped;
+	data[55] = device.is_vertically_flipped;
+	write_le64(data + 56, device.max_samples_in);
+	std::string name = device.long_name;
+	if(name.size() >= RECORDING_DEVICE_INFO_NAME_SIZE)
+		name = name.substr(0, RECORDING_DEVICE_INFO_NAME_SIZE - 1);
+	write_string(data + RECORDING_DEVICE_INFO_SIZE - RECORDING_DEVICE_INFO_NAME_SIZE, name);
+}
+
+void read_recording_device_info(const uint8_t* data, CaptureDevice &device) {
+	device.is_3ds = data[0];
+	device.has_3d = data[1];
+	device.has_audio = data[2];
+	device.video_data_type = (InputVideoDataType)data[3];
+	device.sample_rate = (AudioSampleRate)read_le32(data + 4);
+	int* values[] = {&device.width, &device.height, &device.width_3d, &device.height_3d, &device.base_rotation, &device.top_screen_x, &device.top_screen_y, &device.second_top_screen_x, &device.second_top_screen_y, &device.bot_screen_x, &device.bot_screen_y};
+	for(size_t i = 0; i < (sizeof(values) / sizeof(values[0])); i++)
+		*values[i] = (int)read_le32(data + 8, i);
+	device.is_second_top_screen_right = data[52];
+	device.continuous_3d_screens = data[53];
+	device.is_horizontally_flipped = data[54];
+	device.is_vertically_flipped = data[55];
+	device.max_samples_in = read_le64(data + 56);
+	device.long_name = read_string((uint8_t*)data + RECORDING_DEVICE_INFO_SIZE - RECORDING_DEVICE_INFO_NAME_SIZE, RECORDING_DEVICE_INFO_NAME_SIZE - 1);
+	device.name = device.long_name;
+}
+
+size_t get_recording_video_raw_size(InputVideoDataType video_data_type) {
+	if((video_data_type == VIDEO_DATA_RGB16) || (video_data_type == VIDEO_DATA_BGR16))
+		return sizeof(VideoOutputDataRGB16);
+	return sizeof(VideoOutputDataRGB);
+}
+
+uint16_t get_recording_video_format(InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d) {
+	uint16_t format = video_data_type;
+	if(is_3d)
+		format |= RECORDING_VIDEO_FORMAT_3D;
+	if(is_3d && interleaved_3d)
+		format |= RECORDING_VIDEO_FORMAT_INTERLEAVED_3D;
+	return format;
+}
+
+size_t get_recording_max_compressed_size(size_t raw_size) {
+	return raw_size + (raw_size / 8) + 64;
+}
+
+void write_recording_index(uint8_t* data, const std::vector<RecordingIndexEntry> &index) {
+	for(size_t i = 0; i < index.size(); i++) {
+		write_le64(data, index[i].time_us, i * 2);
+		write_le64(data, index[i].offset, (i * 2) + 1);
+	}
+}
+
+void read_recording_index(const uint8_t* data, size_t size, std::vector<RecordingIndexEntry> &index) {
+	size_t num_entries = size / RECORDING_INDEX_ENTRY_SIZE;
+	index.resize(num_entries);
+	for(size_t i = 0; i < num_entries; i++) {
+		index[i].time_us = read_le64(data, i * 2);
+		index[i].offset = read_le64(data, (i * 2) + 1);
+	}
+}
+
+FrameRecorder::FrameRecorder() {
+}
+
+FrameRecorder::~FrameRecorder() {
+	this->stop();
+}
+
+bool FrameRecorder::start(std::string path, bool compress) {
+	if(this->running)
+		return false;
+	this->out_file = fopen(path.c_str(), "wb");
+	if(this->out_file == NULL)
+		return false;
+	// The data is already collected in big blocks
+	setvbuf(this->out_file, NULL, _IONBF, 0);
+	this->compress = compress;
+	size_t max_raw_size = get_recording_video_raw_size(VIDEO_DATA_RGB);
+	this->video_buffers_memory = new VideoOutputData[RECORDING_NUM_VIDEO_SLOTS];
+	this->audio_buffers_memory = new std::int16_t[RECORDING_NUM_AUDIO_SLOTS * MAX_SAMPLES_IN];
+	this->prev_frame = new uint8_t[max_raw_size];
+	this->delta_buffer = new uint8_t[get_recording_max_compressed_size(max_raw_size)];
+	this->compressed_buffer = new uint8_t[RECORDING_ENTROPY_HEADER_SIZE + get_recording_max_compressed_size(max_raw_size)];
+	this->write_block = new uint8_t[RECORDING_WRITE_BLOCK_SIZE];
+	this->write_block_pos = 0;
+	this->file_pos = 0;
+	this->keyframes_index.clear();
+	this->write_failed = false;
+	this->video_index = 0;
+	this->audio_index = 0;
+	this->frames_since_keyframe = 0;
+	this->last_video_format = 0;
+	this->has_device_info = false;
+	this->num_dropped = 0;
+	VideoSlot video_slot;
+	AudioSlot audio_slot;
+	VideoOutputData* video_buffer;
+	std::int16_t* audio_buffer;
+	while(this->video_queue.pop(video_slot));
+	while(this->audio_queue.pop(audio_slot));
+	while(this->free_video_buffers.pop(video_buffer));
+	while(this->free_audio_buffers.pop(audio_buffer));
+	for(int i = 0; i < RECORDING_NUM_VIDEO_SLOTS; i++)
+		this->free_video_buffers.push(&this->video_buffers_memory[i]);
+	for(int i = 0; i < RECORDING_NUM_AUDIO_SLOTS; i++)
+		this->free_audio_buffers.push(&this->audio_buffers_memory[i * MAX_SAMPLES_IN]);
+
+	uint8_t file_header[RECORDING_FILE_HEADER_SIZE];
+	memcpy(file_header, RECORDING_FILE_MAGIC, RECORDING_FILE_MAGIC_SIZE);
+	write_le32(file_header + RECORDING_FILE_MAGIC_SIZE, RECORDING_FILE_VERSION);
+	write_le32(file_header + RECORDING_FILE_MAGIC_SIZE + 4, RECORDING_FILE_HEADER_SIZE);
+	this->append_data(file_header, RECORDING_FILE_HEADER_SIZE);
+
+	this->start_time = std::chrono::steady_clock::now();
+	this->running = true;
+	this->io_thread_handle = std::thread(&FrameRecorder::io_thread, this);
+	return true;
+}
+
+// Must not be called while the push functions may still be running
+void FrameRecorder::stop() {
+	if(!this->running)
+		return;
+	this->running = false;
+	this->work_condition.notify_one();
+	this->io_thread_handle.join();
+	fclose(this->out_file);
+	this->out_file = NULL;
+	if(this->write_failed)
+		ActualConsoleOutTextError("Recording: Could not write all the data to disk");
+	if(this->num_dropped > 0)
+		ActualConsoleOutText("Recording: " + std::to_string(this->num_dropped) + " frames were dropped");
+	this->free_memory();
+}
+
+bool FrameRecorder::is_recording() {
+	return this->running;
+}
+
+uint64_t FrameRecorder::get_num_dropped() {
+	return this->num_dropped;
+}
+
+uint64_t FrameRecorder::get_time_us() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start_time).count();
+}
+
+void FrameRecorder::push_device_info(CaptureDevice* device) {
+	if(!this->running)
+		return;
+	this->access_mutex.lock();
+	this->device_info = *device;
+	this->has_device_info = true;
+	this->access_mutex.unlock();
+	this->work_condition.notify_one();
+}
+
+// Only copies the data. Everything else happens in the I/O thread.
+void FrameRecorder::push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d) {
+	if(!this->running)
+		return;
+	VideoOutputData* buffer = NULL;
+	if(!this->free_video_buffers.pop(buffer)) {
+		this->num_dropped++;
+		return;
+	}
+	memcpy(buffer, data, get_recording_video_raw_size(video_data_type));
+	VideoSlot slot = {buffer, video_data_type, is_3d, interleaved_3d, this->get_time_us()};
+	this->video_queue.push(slot);
+	this->work_condition.notify_one();
+}
+
+void FrameRecorder::push_audio(std::int16_t* samples, uint64_t n_samples, AudioSampleRate sample_rate) {
+	if((!this->running) || (n_samples == 0))
+		return;
+	if(n_samples > MAX_SAMPLES_IN)
+		n_samples = MAX_SAMPLES_IN;
+	std::int16_t* buffer = NULL;
+	if(!this->free_audio_buffers.pop(buffer)) {
+		this->num_dropped++;
+		return;
+	}
+	memcpy(buffer, samples, (size_t)n_samples * sizeof(std::int16_t));
+	AudioSlot slot = {buffer, n_samples, sample_rate, this->get_time_us()};
+	this->audio_queue.push(slot);
+	this->work_condition.notify_one();
+}
+
+void FrameRecorder::io_thread() {
+	while(true) {
+		bool was_running = this->running;
+		if(this->write_pending())
+			continue;
+		if(!was_running)
+			break;
+		this->access_mutex.lock();
+		this->work_condition.wait_for(this->access_mutex, std::chrono::milliseconds(10));
+		this->access_mutex.unlock();
+	}
+	this->write_index();
+	this->flush_write_block(true);
+}
+
+// Writes the oldest pending element, if any
+bool FrameRecorder::write_pending() {
+	this->access_mutex.lock();
+	bool write_device_info = this->has_device_info;
+	CaptureDevice device;
+	if(write_device_info)
+		device = this->device_info;
+	this->has_device_info = false;
+	this->access_mutex.unlock();
+	if(write_device_info) {
+		uint8_t payload[RECORDING_DEVICE_INFO_SIZE];
+		write_recording_device_info(payload, device);
+		RecordingRecordHeader header = {RECORDING_RECORD_DEVICE_INFO, 0, 0, RECORDING_DEVICE_INFO_SIZE, RECORDING_DEVICE_INFO_SIZE, this->get_time_us(), 0};
+		this->write_record(header, payload);
+		// Start over from a whole frame
+		this->frames_since_keyframe = 0;
+		return true;
+	}
+
+	VideoSlot video_slot;
+	AudioSlot audio_slot;
+	bool has_video = this->video_queue.peek(video_slot);
+	bool has_audio = this->audio_queue.peek(audio_slot);
+	if(has_video && ((!has_audio) || (video_slot.time_us <= audio_slot.time_us))) {
+		this->video_queue.pop(video_slot);
+		this->write_video(video_slot);
+		this->free_video_buffers.push(video_slot.data);
+		return true;
+	}
+	if(has_audio) {
+		this->audio_queue.pop(audio_slot);
+		this->write_audio(audio_slot);
+		this->free_audio_buffers.push(audio_slot.samples);
+		return true;
+	}
+	return false;
+}
+
+void FrameRecorder::write_video(VideoSlot &slot) {
+	size_t raw_size = get_recording_video_raw_size(slot.video_data_type);
+	uint16_t format = get_recording_video_format(slot.video_data_type, slot.is_3d, slot.interleaved_3d);
+	RecordingRecordHeader header = {RECORDING_RECORD_VIDEO, RECORDING_FLAG_KEYFRAME, format, (uint32_t)raw_size, (uint32_t)raw_size, slot.time_us, this->video_index};
+	if(format != this->last_video_format)
+		this->frames_since_keyframe = 0;
+	this->last_video_format = format;
+	bool is_keyframe = this->frames_since_keyframe == 0;
+	if(++this->frames_since_keyframe >= RECORDING_KEYFRAME_INTERVAL)
+		this->frames_since_keyframe = 0;
+	// Without compression every frame is whole, but the index
+	// does not need to be any more precise than this.
+	if(is_keyframe)
+		this->keyframes_index.push_back({slot.time_us, this->get_write_pos()});
+	if(!this->compress) {
+		this->write_record(header, (uint8_t*)slot.data);
+		this->video_index++;
+		return;
+	}
+	if(is_keyframe)
+		memset(this->prev_frame, 0, raw_size);
+	header.flags = RECORDING_FLAG_COMPRESSED;
+	if(is_keyframe)
+		header.flags |= RECORDING_FLAG_KEYFRAME;
+	size_t delta_size = encode_recording_delta((uint8_t*)slot.data, this->prev_frame, raw_size, this->delta_buffer);
+	size_t entropy_size = encode_recording_entropy(this->delta_buffer, delta_size, this->compressed_buffer);
+	if(entropy_size > 0) {
+		header.flags |= RECORDING_FLAG_ENTROPY_CODED;
+		header.payload_size = (uint32_t)entropy_size;
+		this->write_record(header, this->compressed_buffer);
+	}
+	else {
+		header.payload_size = (uint32_t)delta_size;
+		this->write_record(header, this->delta_buffer);
+	}
+	memcpy(this->prev_frame, slot.data, raw_size);
+	this->video_index++;
+}
+
+void FrameRecorder::write_audio(AudioSlot &slot) {
+	size_t raw_size = (size_t)slot.n_samples * sizeof(std::int16_t);
+	if(is_big_endian())
+		for(uint64_t i = 0; i < slot.n_samples; i++)
+			slot.samples[i] = (std::int16_t)to_le((uint16_t)slot.samples[i]);
+	RecordingRecordHeader header = {RECORDING_RECORD_AUDIO, RECORDING_FLAG_KEYFRAME, (uint16_t)slot.sample_rate, (uint32_t)raw_size, (uint32_t)raw_size, slot.time_us, this->audio_index++};
+	this->write_record(header, (uint8_t*)slot.samples);
+}
+
+void FrameRecorder::write_index() {
+	uint64_t index_pos = this->get_write_pos();
+	size_t payload_size = this->keyframes_index.size() * RECORDING_INDEX_ENTRY_SIZE;
+	uint8_t* payload = new uint8_t[payload_size + 1];
+	write_recording_index(payload, this->keyframes_index);
+	RecordingRecordHeader header = {RECORDING_RECORD_INDEX, 0, 0, (uint32_t)payload_size, (uint32_t)payload_size, this->get_time_us(), this->keyframes_index.size()};
+	this->write_record(header, payload);
+	delete []payload;
+	uint8_t trailer[RECORDING_FILE_TRAILER_SIZE];
+	memcpy(trailer, RECORDING_FILE_TRAILER_MAGIC, RECORDING_FILE_MAGIC_SIZE);
+	write_le64(trailer + RECORDING_FILE_MAGIC_SIZE, index_pos);
+	this->append_data(trailer, RECORDING_FILE_TRAILER_SIZE);
+}
+
+uint64_t FrameRecorder::get_write_pos() {
+	return this->file_pos + this->write_block_pos;
+}
+
+void FrameRecorder::write_record(RecordingRecordHeader &header, const uint8_t* payload) {
+	uint8_t header_data[RECORDING_RECORD_HEADER_SIZE];
+	write_recording_record_header(header_data, header);
+	this->append_data(header_data, RECORDING_RECORD_HEADER_SIZE);
+	this->append_data(payload, header.payload_size);
+}
+
+void FrameRecorder::append_data(const uint8_t* data, size_t size) {
+	while(size > 0) {
+		size_t to_copy = RECORDING_WRITE_BLOCK_SIZE - this->write_block_pos;
+		if(to_copy > size)
+			to_copy = size;
+		memcpy(this->write_block + this->write_block_pos, data, to_copy);
+		this->write_block_pos += to_copy;
+		data += to_copy;
+		size -= to_copy;
+		if(this->write_block_pos == RECORDING_WRITE_BLOCK_SIZE)
+			this->flush_write_block(false);
+	}
+}
+
+// Only whole blocks are written, until the very end
+void FrameRecorder::flush_write_block(bool is_final) {
+	if((this->write_block_pos < RECORDING_WRITE_BLOCK_SIZE) && (!is_final))
+		return;
+	if((this->write_block_pos > 0) && (!this->write_failed)) {
+		if(fwrite(this->write_block, 1, this->write_block_pos, this->out_file) != this->write_block_pos)
+			this->write_failed = true;
+	}
+	this->file_pos += this->write_block_pos;
+	this->write_block_pos = 0;
+}
+
+void FrameRecorder::free_memory() {
+	delete []this->video_buffers_memory;
+	delete []this->audio_buffers_memory;
+	delete []this->prev_frame;
+	delete []this->delta_buffer;
+	delete []this->compressed_buffer;
+	delete []this->write_block;
+	this->video_buffers_memory = NULL;
+	this->audio_buffers_memory = NULL;
+	this->prev_frame = NULL;
+	this->delta_buffer = NULL;
+	this->compressed_buffer = NULL;
+	this->write_block = NULL;
+}
@@ -0,0 +1,141 @@
+#include "FrameSharedMemory.hpp"
+#include "FrameRecorder.hpp"
+
+#include <cstring>
+#include <atomic>
+#ifdef _WIN32
+#include <windows.h>
+#elif !defined(ANDROID_COMPILATION)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static inline void store_shared_u64(uint8_t* data, uint64_t value) {
+	std::atomic_ref<uint64_t>(*(uint64_t*)data).store(value, std::memory_order_release);
+}
+
+FrameSharedMemory::FrameSharedMemory() {
+}
+
+FrameSharedMemory::~FrameSharedMemory() {
+	this->stop();
+}
+
+bool FrameSharedMemory::map_memory() {
+	#if defined(_WIN32)
+	std::string full_name = "Local\\" + this->name;
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)(((uint64_t)this->memory_size) >> 32), (DWORD)(this->memory_size & 0xFFFFFFFF), full_name.c_str());
+	if(mapping == NULL)
+		return false;
+	this->memory = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, this->memory_size);
+	if(this->memory == NULL) {
+		CloseHandle(mapping);
+		return false;
+	}
+	this->mapping_handle = (void*)mapping;
+	return true;
+	#elif defined(ANDROID_COMPILATION)
+	return false;
+	#else
+	std::string full_name = "/" + this->name;
+	int fd = shm_open(full_name.c_str(), O_CREAT | O_RDWR, 0600);
+	if(fd < 0)
+		return false;
+	if(ftruncate(fd, this->memory_size) != 0) {
+		close(fd);
+		shm_unlink(full_name.c_str());
+		return false;
+	}
+	void* data = mmap(NULL, this->memory_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) {
+		shm_unlink(full_name.c_str());
+		return false;
+	}
+	this->memory = (uint8_t*)data;
+	return true;
+	#endif
+}
+
+void FrameSharedMemory::unmap_memory() {
+	if(this->memory == NULL)
+		return;
+	#if defined(_WIN32)
+	UnmapViewOfFile(this->memory);
+	CloseHandle((HANDLE)this->mapping_handle);
+	this->mapping_handle = NULL;
+	#elif !defined(ANDROID_COMPILATION)
+	munmap(this->memory, this->memory_size);
+	// Whoever still has it mapped can keep reading it
+	shm_unlink(("/" + this->name).c_str());
+	#endif
+	this->memory = NULL;
+}
+
+bool FrameSharedMemory::start(std::string name) {
+	if(this->active)
+		return false;
+	this->name = name;
+	this->slot_size = SHARED_MEMORY_SLOT_HEADER_SIZE + sizeof(VideoOutputData);
+	this->slot_size = ((this->slot_size + SHARED_MEMORY_SLOT_ALIGNMENT - 1) / SHARED_MEMORY_SLOT_ALIGNMENT) * SHARED_MEMORY_SLOT_ALIGNMENT;
+	this->memory_size = SHARED_MEMORY_HEADER_SIZE + (this->slot_size * SHARED_MEMORY_NUM_SLOTS);
+	if(!this->map_memory())
+		return false;
+	// Whatever a previous run left in there is not valid anymore
+	memset(this->memory, 0, this->memory_size);
+	memcpy(this->memory, SHARED_MEMORY_MAGIC, SHARED_MEMORY_MAGIC_SIZE);
+	*(uint32_t*)(this->memory + SHARED_MEMORY_VERSION_POS) = SHARED_MEMORY_VERSION;
+	*(uint32_t*)(this->memory + SHARED_MEMORY_HEADER_SIZE_POS) = SHARED_MEMORY_HEADER_SIZE;
+	*(uint32_t*)(this->memory + SHARED_MEMORY_NUM_SLOTS_POS) = SHARED_MEMORY_NUM_SLOTS;
+	*(uint32_t*)(this->memory + SHARED_MEMORY_SLOT_SIZE_POS) = (uint32_t)this->slot_size;
+	*(uint32_t*)(this->memory + SHARED_MEMORY_SLOT_HEADER_SIZE_POS) = SHARED_MEMORY_SLOT_HEADER_SIZE;
+	this->sequence = 0;
+	this->device_info_sequence = 0;
+	this->start_time = std::chrono::steady_clock::now();
+	this->active = true;
+	return true;
+}
+
+void FrameSharedMemory::stop() {
+	if(!this->active)
+		return;
+	this->active = false;
+	this->unmap_memory();
+}
+
+bool FrameSharedMemory::is_active() {
+	return this->active;
+}
+
+uint8_t* FrameSharedMemory::get_slot(uint64_t sequence) {
+	return this->memory + SHARED_MEMORY_HEADER_SIZE + ((sequence % SHARED_MEMORY_NUM_SLOTS) * this->slot_size);
+}
+
+void FrameSharedMemory::push_device_info(CaptureDevice* device) {
+	if(!this->active)
+		return;
+	store_shared_u64(this->memory + SHARED_MEMORY_DEVICE_INFO_SEQUENCE_POS, ++this->device_info_sequence);
+	std::atomic_thread_fence(std::memory_order_release);
+	write_recording_device_info(this->memory + SHARED_MEMORY_DEVICE_INFO_POS, *device);
+	store_shared_u64(this->memory + SHARED_MEMORY_DEVICE_INFO_SEQUENCE_POS, ++this->device_info_sequence);
+}
+
+// Same thread as the conversions. The frame is copied only once,
+// and the readers can take it straight from the shared memory.
+void FrameSharedMemory::push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d) {
+	if(!this->active)
+		return;
+	size_t data_size = get_recording_video_raw_size(video_data_type);
+	uint64_t curr_sequence = ++this->sequence;
+	uint8_t* slot = this->get_slot(curr_sequence);
+	store_shared_u64(slot + SHARED_MEMORY_SLOT_SEQUENCE_POS, 0);
+	std::atomic_thread_fence(std::memory_order_release);
+	*(uint32_t*)(slot + SHARED_MEMORY_SLOT_FORMAT_POS) = get_recording_video_format(video_data_type, is_3d, interleaved_3d);
+	*(uint32_t*)(slot + SHARED_MEMORY_SLOT_DATA_SIZE_POS) = (uint32_t)data_size;
+	*(uint64_t*)(slot + SHARED_MEMORY_SLOT_TIME_POS) = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start_time).count();
+	memcpy(slot + SHARED_MEMORY_SLOT_HEADER_SIZE, data, data_size);
+	store_shared_u64(slot + SHARED_MEMORY_SLOT_SEQUENCE_POS, curr_sequence);
+	store_shared_u64(this->memory + SHARED_MEMORY_LAST_SEQUENCE_POS, curr_sequence);
+}
@@ -0,0 +1,443 @@
+// Needs to come before anything which may include windows.h
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#endif
+
+#include "FrameStreamServer.hpp"
+
+#include <cstring>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef _WIN32
+#define INVALID_STREAM_SOCKET ((StreamSocket)INVALID_SOCKET)
+#define poll_sockets WSAPoll
+typedef WSAPOLLFD stream_pollfd;
+#else
+#define INVALID_STREAM_SOCKET (-1)
+#define poll_sockets poll
+typedef struct pollfd stream_pollfd;
+#endif
+
+#if defined(MSG_NOSIGNAL)
+#define STREAM_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define STREAM_SEND_FLAGS 0
+#endif
+
+static void close_socket(StreamSocket socket) {
+	#ifdef _WIN32
+	closesocket((SOCKET)socket);
+	#else
+	close(socket);
+	#endif
+}
+
+static bool set_non_blocking(StreamSocket socket) {
+	#ifdef _WIN32
+	u_long mode = 1;
+	return ioctlsocket((SOCKET)socket, FIONBIO, &mode) == 0;
+	#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	if(flags < 0)
+		return false;
+	return fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+	#endif
+}
+
+static bool last_error_would_block() {
+	#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+	#else
+	return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+	#endif
+}
+
+static bool is_port_number(std::string address) {
+	if((address.size() == 0) || (address.size() > 5))
+		return false;
+	for(size_t i = 0; i < address.size(); i++)
+		if((address[i] < '0') || (address[i] > '9'))
+			return false;
+	return true;
+}
+
+static StreamSocket open_listen_socket(std::string address) {
+	StreamSocket listen_socket = INVALID_STREAM_SOCKET;
+	if(is_port_number(address)) {
+		int port = std::stoi(address);
+		if((port <= 0) || (port > 0xFFFF))
+			return INVALID_STREAM_SOCKET;
+		listen_socket = (StreamSocket)socket(AF_INET, SOCK_STREAM, 0);
+		if(listen_socket == INVALID_STREAM_SOCKET)
+			return INVALID_STREAM_SOCKET;
+		int reuse = 1;
+		setsockopt(listen_socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)port);
+		// Only reachable from this machine
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if(bind(listen_socket, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+			close_socket(listen_socket);
+			return INVALID_STREAM_SOCKET;
+		}
+	}
+	else {
+		#ifdef _WIN32
+		return INVALID_STREAM_SOCKET;
+		#else
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		if(address.size() >= sizeof(addr.sun_path))
+			return INVALID_STREAM_SOCKET;
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+		listen_socket = socket(AF_UNIX, SOCK_STREAM, 0);
+		if(listen_socket == INVALID_STREAM_SOCKET)
+			return INVALID_STREAM_SOCKET;
+		// Left behind by a previous run which did not close properly.
+		// Never remove something which is not a socket, though.
+		struct stat path_stat;
+		if(lstat(address.c_str(), &path_stat) == 0) {
+			if(!S_ISSOCK(path_stat.st_mode)) {
+				ActualConsoleOutTextError("Stream server: " + address + " already exists and is not a socket");
+				close_socket(listen_socket);
+				return INVALID_STREAM_SOCKET;
+			}
+			unlink(address.c_str());
+		}
+		if(bind(listen_socket, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+			close_socket(listen_socket);
+			return INVALID_STREAM_SOCKET;
+		}
+		#endif
+	}
+	if((listen(listen_socket, STREAM_SERVER_LISTEN_BACKLOG) != 0) || (!set_non_blocking(listen_socket))) {
+		close_socket(listen_socket);
+		return INVALID_STREAM_SOCKET;
+	}
+	return listen_socket;
+}
+
+FrameStreamServer::FrameStreamServer() {
+	this->listen_socket = INVALID_STREAM_SOCKET;
+}
+
+FrameStreamServer::~FrameStreamServer() {
+	this->stop();
+}
+
+bool FrameStreamServer::start(std::string address) {
+	if(this->running)
+		return false;
+	#ifdef _WIN32
+	WSADATA wsa_data;
+	if(WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+		return false;
+	#endif
+	this->listen_socket = open_listen_socket(address);
+	if(this->listen_socket == INVALID_STREAM_SOCKET) {
+		#ifdef _WIN32
+		WSACleanup();
+		#endif
+		return false;
+	}
+	if(!is_port_number(address))
+		this->unix_path = address;
+
+	this->file_header_packet = std::make_shared<Packet>();
+	this->file_header_packet->data.resize(RECORDING_FILE_HEADER_SIZE);
+	this->file_header_packet->is_video = false;
+	this->file_header_packet->can_drop = false;
+	uint8_t* file_header = this->file_header_packet->data.data();
+	memcpy(file_header, RECORDING_FILE_MAGIC, RECORDING_FILE_MAGIC_SIZE);
+	write_le32(file_header + RECORDING_FILE_MAGIC_SIZE, RECORDING_FILE_VERSION);
+	write_le32(file_header + RECORDING_FILE_MAGIC_SIZE + 4, RECORDING_FILE_HEADER_SIZE);
+	this->device_info_packet = NULL;
+	this->video_index = 0;
+	this->audio_index = 0;
+	this->num_dropped = 0;
+
+	this->start_time = std::chrono::steady_clock::now();
+	this->running = true;
+	this->io_thread_handle = std::thread(&FrameStreamServer::io_thread, this);
+	return true;
+}
+
+void FrameStreamServer::stop() {
+	if(!this->running)
+		return;
+	this->running = false;
+	this->io_thread_handle.join();
+	this->access_mutex.lock();
+	for(size_t i = 0; i < this->clients.size(); i++) {
+		close_socket(this->clients[i]->socket);
+		delete this->clients[i];
+	}
+	this->clients.clear();
+	this->num_clients = 0;
+	this->device_info_packet = NULL;
+	this->video_packet_pool.clear();
+	this->access_mutex.unlock();
+	close_socket(this->listen_socket);
+	this->listen_socket = INVALID_STREAM_SOCKET;
+	#ifdef _WIN32
+	WSACleanup();
+	#else
+	if(this->unix_path != "")
+		unlink(this->unix_path.c_str());
+	#endif
+	this->unix_path = "";
+}
+
+bool FrameStreamServer::is_running() {
+	return this->running;
+}
+
+bool FrameStreamServer::has_clients() {
+	return this->running && (this->num_clients > 0);
+}
+
+uint64_t FrameStreamServer::get_time_us() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - this->start_time).count();
+}
+
+// The frames are big. Their buffers are reused once no client holds them
+// anymore. The clients release them with access_mutex locked.
+std::shared_ptr<FrameStreamServer::Packet> FrameStreamServer::get_video_packet() {
+	std::shared_ptr<Packet> packet = NULL;
+	this->access_mutex.lock();
+	for(size_t i = 0; i < this->video_packet_pool.size(); i++) {
+		if(this->video_packet_pool[i].use_count() == 1) {
+			packet = this->video_packet_pool[i];
+			break;
+		}
+	}
+	if(packet == NULL) {
+		packet = std::make_shared<Packet>();
+		// Too many slow clients. This one is not kept.
+		if(this->video_packet_pool.size() < STREAM_SERVER_VIDEO_POOL_SIZE)
+			this->video_packet_pool.push_back(packet);
+	}
+	this->access_mutex.unlock();
+	return packet;
+}
+
+std::shared_ptr<FrameStreamServer::Packet> FrameStreamServer::create_packet(RecordingRecordType type, uint16_t flags, uint16_t format, uint32_t payload_size, uint64_t index, bool is_video) {
+	std::shared_ptr<Packet> packet = is_video ? this->get_video_packet() : std::make_shared<Packet>();
+	packet->data.resize(RECORDING_RECORD_HEADER_SIZE + payload_size);
+	packet->is_video = is_video;
+	// Without these, the rest of the stream can't be interpreted
+	packet->can_drop = type != RECORDING_RECORD_DEVICE_INFO;
+	RecordingRecordHeader header = {type, flags, format, payload_size, payload_size, this->get_time_us(), index};
+	write_recording_record_header(packet->data.data(), header);
+	return packet;
+}
+
+void FrameStreamServer::push_device_info(CaptureDevice* device) {
+	if(!this->running)
+		return;
+	std::shared_ptr<Packet> packet = this->create_packet(RECORDING_RECORD_DEVICE_INFO, 0, 0, RECORDING_DEVICE_INFO_SIZE, 0, false);
+	write_recording_device_info(packet->data.data() + RECORDING_RECORD_HEADER_SIZE, *device);
+	this->access_mutex.lock();
+	// Clients which connect later get this one first
+	this->device_info_packet = packet;
+	this->access_mutex.unlock();
+	this->send_to_clients(packet);
+}
+
+// The frame is copied once, then shared by all the clients
+void FrameStreamServer::push_video(VideoOutputData* data, InputVideoDataType video_data_type, bool is_3d, bool interleaved_3d) {
+	if((!this->running) || (this->num_clients == 0))
+		return;
+	size_t raw_size = get_recording_video_raw_size(video_data_type);
+	std::shared_ptr<Packet> packet = this->create_packet(RECORDING_RECORD_VIDEO, RECORDING_FLAG_KEYFRAME, get_recording_video_format(video_data_type, is_3d, interleaved_3d), (uint32_t)raw_size, this->video_index++, true);
+	memcpy(packet->data.data() + RECORDING_RECORD_HEADER_SIZE, data, raw_size);
+	this->send_to_clients(packet);
+}
+
+void FrameStreamServer::push_audio(std::int16_t* samples, uint64_t n_samples, AudioSampleRate sample_rate) {
+	if((!this->running) || (n_samples == 0) || (this->num_clients == 0))
+		return;
+	size_t raw_size = (size_t)n_samples * sizeof(std::int16_t);
+	std::shared_ptr<Packet> packet = this->create_packet(RECORDING_RECORD_AUDIO, RECORDING_FLAG_KEYFRAME, (uint16_t)sample_rate, (uint32_t)raw_size, this->audio_index++, false);
+	uint8_t* payload = packet->data.data() + RECORDING_RECORD_HEADER_SIZE;
+	for(uint64_t i = 0; i < n_samples; i++)
+		write_le16(payload, (uint16_t)samples[i], i);
+	this->send_to_clients(packet);
+}
+
+void FrameStreamServer::send_to_clients(std::shared_ptr<Packet> &packet) {
+	this->access_mutex.lock();
+	for(size_t i = 0; i < this->clients.size(); i++) {
+		if(this->clients[i]->closed)
+			continue;
+		this->enqueue(this->clients[i], packet);
+		// Sockets are non-blocking, so this only sends what fits right now.
+		// The I/O thread takes care of the rest.
+		this->flush_client(this->clients[i]);
+	}
+	this->access_mutex.unlock();
+}
+
+// Called with access_mutex locked.
+// The front packet may be partially sent already. It can't be dropped.
+// The file header and the device info are never dropped either.
+void FrameStreamServer::enqueue(Client* client, std::shared_ptr<Packet> &packet) {
+	size_t first_droppable = (client->front_sent > 0) ? 1 : 0;
+	if(packet->is_video) {
+		int num_video = 0;
+		for(size_t i = first_droppable; i < client->queue.size(); i++)
+			if(client->queue[i]->is_video)
+				num_video++;
+		for(size_t i = first_droppable; (i < client->queue.size()) && (num_video >= STREAM_SERVER_MAX_QUEUED_VIDEO);) {
+			if(client->queue[i]->is_video) {
+				client->queue.erase(client->queue.begin() + i);
+				num_video--;
+				this->num_dropped++;
+			}
+			else
+				i++;
+		}
+	}
+	size_t drop_pos = first_droppable;
+	while((client->queue.size() >= STREAM_SERVER_MAX_QUEUED_PACKETS) && (drop_pos < client->queue.size())) {
+		if(client->queue[drop_pos]->can_drop) {
+			client->queue.erase(client->queue.begin() + drop_pos);
+			this->num_dropped++;
+		}
+		else
+			drop_pos++;
+	}
+	client->queue.push_back(packet);
+}
+
+// Called with access_mutex locked
+void FrameStreamServer::flush_client(Client* client) {
+	while((!client->closed) && (client->queue.size() > 0)) {
+		Packet* packet = client->queue.front().get();
+		size_t remaining = packet->data.size() - client->front_sent;
+		auto result = send(client->socket, (const char*)(packet->data.data() + client->front_sent), (int)remaining, STREAM_SEND_FLAGS);
+		if(result < 0) {
+			if(!last_error_would_block())
+				client->closed = true;
+			return;
+		}
+		client->front_sent += result;
+		if(client->front_sent < packet->data.size())
+			return;
+		client->queue.pop_front();
+		client->front_sent = 0;
+	}
+}
+
+void FrameStreamServer::accept_clients() {
+	while(true) {
+		StreamSocket new_socket = (StreamSocket)accept(this->listen_socket, NULL, NULL);
+		if(new_socket == INVALID_STREAM_SOCKET)
+			return;
+		this->access_mutex.lock();
+		if((this->clients.size() >= STREAM_SERVER_MAX_CLIENTS) || (!set_non_blocking(new_socket))) {
+			this->access_mutex.unlock();
+			close_socket(new_socket);
+			continue;
+		}
+		#ifdef SO_NOSIGPIPE
+		int no_sigpipe = 1;
+		setsockopt(new_socket, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&no_sigpipe, sizeof(no_sigpipe));
+		#endif
+		// Fails for Unix sockets, which is fine
+		int no_delay = 1;
+		setsockopt(new_socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay, sizeof(no_delay));
+		Client* client = new Client;
+		client->socket = new_socket;
+		client->front_sent = 0;
+		client->closed = false;
+		client->queue.push_back(this->file_header_packet);
+		if(this->device_info_packet != NULL)
+			client->queue.push_back(this->device_info_packet);
+		this->clients.push_back(client);
+		this->num_clients = this->clients.size();
+		this->flush_client(client);
+		this->access_mutex.unlock();
+	}
+}
+
+void FrameStreamServer::remove_closed_clients() {
+	this->access_mutex.lock();
+	for(size_t i = 0; i < this->clients.size();) {
+		if(this->clients[i]->closed) {
+			close_socket(this->clients[i]->socket);
+			delete this->clients[i];
+			this->clients.erase(this->clients.begin() + i);
+		}
+		else
+			i++;
+	}
+	this->num_clients = this->clients.size();
+	this->access_mutex.unlock();
+}
+
+void FrameStreamServer::io_thread() {
+	std::vector<stream_pollfd> poll_fds;
+	std::vector<Client*> polled_clients;
+	uint8_t discard_buffer[256];
+	while(this->running) {
+		poll_fds.clear();
+		polled_clients.clear();
+		stream_pollfd listen_fd;
+		memset(&listen_fd, 0, sizeof(listen_fd));
+		listen_fd.fd = this->listen_socket;
+		listen_fd.events = POLLIN;
+		poll_fds.push_back(listen_fd);
+		this->access_mutex.lock();
+		for(size_t i = 0; i < this->clients.size(); i++) {
+			stream_pollfd client_fd;
+			memset(&client_fd, 0, sizeof(client_fd));
+			client_fd.fd = this->clients[i]->socket;
+			client_fd.events = POLLIN;
+			if(this->clients[i]->queue.size() > 0)
+				client_fd.events |= POLLOUT;
+			poll_fds.push_back(client_fd);
+			polled_clients.push_back(this->clients[i]);
+		}
+		this->access_mutex.unlock();
+
+		// Only this thread removes clients, so the pointers stay valid
+		int result = poll_sockets(poll_fds.data(), (unsigned long)poll_fds.size(), STREAM_SERVER_POLL_TIMEOUT_MS);
+		if(result > 0) {
+			if(poll_fds[0].revents & POLLIN)
+				this->accept_clients();
+			this->access_mutex.lock();
+			for(size_t i = 0; i < polled_clients.size(); i++) {
+				short revents = poll_fds[i + 1].revents;
+				Client* client = polled_clients[i];
+				if(revents & POLLIN) {
+					// Clients are not supposed to send anything. Only look for them closing.
+					auto read_size = recv(client->socket, (char*)discard_buffer, sizeof(discard_buffer), 0);
+					if((read_size == 0) || ((read_size < 0) && (!last_error_would_block())))
+						client->closed = true;
+				}
+				if(revents & (POLLERR | POLLHUP | POLLNVAL))
+					client->closed = true;
+				if(revents & POLLOUT)
+					this->flush_client(client);
+			}
+			this->access_mutex.unlock();
+		}
+		this->remove_closed_clients();
+	}
+}
@@ -0,0 +1,70 @@
+#include "IdleState.hpp"
+
+SteadyIdleClock::SteadyIdleClock() {
+	this->start_time = std::chrono::steady_clock::now();
+}
+
+double SteadyIdleClock::now() {
+	const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - this->start_time;
+	return diff.count();
+}
+
+IdleState::IdleState(IdleClock* clock) {
+	this->owns_clock = clock == NULL;
+	if(this->owns_clock)
+		clock = new SteadyIdleClock();
+	this->clock = clock;
+	this->last_activity_time = this->clock->now();
+	this->last_draw_time = this->last_activity_time;
+}
+
+IdleState::~IdleState() {
+	if(this->owns_clock)
+		delete this->clock;
+}
+
+void IdleState::activity() {
+	this->last_activity_time = this->clock->now();
+}
+
+bool IdleState::is_idle() {
+	return (this->clock->now() - this->last_activity_time) > IDLE_ENTER_TIME;
+}
+
+bool IdleState::should_draw() {
+	double curr_time = this->clock->now();
+	if(this->is_idle() && ((curr_time - this->last_draw_time) < IDLE_REDRAW_PERIOD))
+		return false;
+	this->last_draw_time = curr_time;
+	return true;
+}
+
+IdleBackoff::IdleBackoff(double min_wait, double max_wait) {
+	this->min_wait = min_wait;
+	this->max_wait = max_wait;
+	this->curr_wait = min_wait;
+}
+
+double IdleBackoff::get_wait(bool is_idle) {
+	if(!is_idle) {
+		this->curr_wait = this->min_wait;
+		return this->min_wait;
+	}
+	double wait = this->curr_wait;
+	this->curr_wait *= 2;
+	if(this->curr_wait > this->max_wait)
+		this->curr_wait = this->max_wait;
+	return wait;
+}
+
+double idle_main_loop_step(IdleState &idle_state, IdleBackoff &backoff, bool is_busy, volatile bool &published_idle) {
+	if(is_busy)
+		idle_state.activity();
+	bool is_idle = idle_state.is_idle();
+	published_idle = is_idle;
+	return backoff.get_wait(is_idle);
+}
+
+double idle_capture_loop_step(IdleBackoff &backoff, volatile bool &published_idle) {
+	return backoff.get_wait(published_idle);
+}
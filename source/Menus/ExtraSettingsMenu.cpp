@@ -1,5 +1,6 @@
 #include "ExtraSettingsMenu.hpp"
 #include "USBConflictResolutionMenu.hpp"
+#include "ThreadScheduling.hpp"
 
 #define NUM_TOTAL_MENU_OPTIONS (sizeof(pollable_options)/sizeof(pollable_options[0]))
 
@@ -14,6 +15,10 @@ struct ExtraSettingsMenuOptionInfo {
 	const bool active_bottom_screen;
 	const bool active_regular;
 	const bool active_mono_app;
+	const bool is_inc;
+	const std::string dec_str;
+	const std::string inc_str;
+	const ExtraSettingsMenuOutAction inc_out_action;
 	const ExtraSettingsMenuOutAction out_action;
 };
 
@@ -22,6 +27,7 @@ static const ExtraSettingsMenuOptionInfo warning_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = true, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_NO_ACTION};
 
 static const ExtraSettingsMenuOptionInfo reset_to_default_option = {
@@ -29,6 +35,7 @@ static const ExtraSettingsMenuOptionInfo reset_to_default_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = true, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_RESET_SETTINGS};
 
 static const ExtraSettingsMenuOptionInfo windowed_option = {
@@ -36,6 +43,7 @@ static const ExtraSettingsMenuOptionInfo windowed_option = {
 .active_fullscreen = true, .active_windowed_screen = false,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = false, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_FULLSCREEN};
 
 static const ExtraSettingsMenuOptionInfo fullscreen_option = {
@@ -43,6 +51,7 @@ static const ExtraSettingsMenuOptionInfo fullscreen_option = {
 .active_fullscreen = false, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = false, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_FULLSCREEN};
 
 static const ExtraSettingsMenuOptionInfo join_screens_option = {
@@ -50,6 +59,7 @@ static const ExtraSettingsMenuOptionInfo join_screens_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = false, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = false, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_SPLIT};
 
 static const ExtraSettingsMenuOptionInfo split_screens_option = {
@@ -57,6 +67,7 @@ static const ExtraSettingsMenuOptionInfo split_screens_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = false, .active_bottom_screen = false,
 .active_regular = false, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_SPLIT};
 
 static const ExtraSettingsMenuOptionInfo quit_option = {
@@ -64,6 +75,7 @@ static const ExtraSettingsMenuOptionInfo quit_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = false, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_QUIT_APPLICATION};
 
 static const ExtraSettingsMenuOptionInfo usb_conflict_resolution_menu_option = {
@@ -71,6 +83,7 @@ static const ExtraSettingsMenuOptionInfo usb_conflict_resolution_menu_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = true, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_USB_CONFLICT_RESOLUTION};
 
 static const ExtraSettingsMenuOptionInfo periodic_connection_try_menu_option = {
@@ -78,8 +91,73 @@ static const ExtraSettingsMenuOptionInfo periodic_connection_try_menu_option = {
 .active_fullscreen = true, .active_windowed_screen = true,
 .active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
 .active_regular = true, .active_mono_app = true,
+.is_inc = false, .dec_str = "", .inc_str = "", .inc_out_action = EXTRA_SETTINGS_MENU_NO_ACTION,
 .out_action = EXTRA_SETTINGS_MENU_CHANGE_PERIODIC_CONNECTION_TRY};
 
+static const ExtraSettingsMenuOptionInfo capture_thread_priority_option = {
+.base_name = "Capture Priority",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_INC,
+.out_action = EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_DEC};
+
+static const ExtraSettingsMenuOptionInfo capture_thread_cpu_option = {
+.base_name = "Capture CPU",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_CAPTURE_CPU_INC,
+.out_action = EXTRA_SETTINGS_MENU_CAPTURE_CPU_DEC};
+
+static const ExtraSettingsMenuOptionInfo audio_thread_priority_option = {
+.base_name = "Audio Priority",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_AUDIO_PRIORITY_INC,
+.out_action = EXTRA_SETTINGS_MENU_AUDIO_PRIORITY_DEC};
+
+static const ExtraSettingsMenuOptionInfo audio_thread_cpu_option = {
+.base_name = "Audio CPU",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_AUDIO_CPU_INC,
+.out_action = EXTRA_SETTINGS_MENU_AUDIO_CPU_DEC};
+
+static const ExtraSettingsMenuOptionInfo display_thread_priority_option = {
+.base_name = "Display Priority",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_DISPLAY_PRIORITY_INC,
+.out_action = EXTRA_SETTINGS_MENU_DISPLAY_PRIORITY_DEC};
+
+static const ExtraSettingsMenuOptionInfo display_thread_cpu_option = {
+.base_name = "Display CPU",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_DISPLAY_CPU_INC,
+.out_action = EXTRA_SETTINGS_MENU_DISPLAY_CPU_DEC};
+
+static const ExtraSettingsMenuOptionInfo usb_events_thread_priority_option = {
+.base_name = "USB Events Priority",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_USB_EVENTS_PRIORITY_INC,
+.out_action = EXTRA_SETTINGS_MENU_USB_EVENTS_PRIORITY_DEC};
+
+static const ExtraSettingsMenuOptionInfo usb_events_thread_cpu_option = {
+.base_name = "USB Events CPU",  .false_name = "", .is_selectable = true,
+.active_fullscreen = true, .active_windowed_screen = true,
+.active_joint_screen = true, .active_top_screen = true, .active_bottom_screen = true,
+.active_regular = true, .active_mono_app = true,
+.is_inc = true, .dec_str = "<", .inc_str = ">", .inc_out_action = EXTRA_SETTINGS_MENU_USB_EVENTS_CPU_INC,
+.out_action = EXTRA_SETTINGS_MENU_USB_EVENTS_CPU_DEC};
+
 static const ExtraSettingsMenuOptionInfo* pollable_options[] = {
 &warning_option,
 &periodic_connection_try_menu_option,
@@ -89,6 +167,14 @@ static const ExtraSettingsMenuOptionInfo* pollable_options[] = {
 &join_screens_option,
 &split_screens_option,
 &usb_conflict_resolution_menu_option,
+&capture_thread_priority_option,
+&capture_thread_cpu_option,
+&audio_thread_priority_option,
+&audio_thread_cpu_option,
+&display_thread_priority_option,
+&display_thread_cpu_option,
+&usb_events_thread_priority_option,
+&usb_events_thread_cpu_option,
 &quit_option,
 };
 
@@ -166,6 +252,8 @@ void ExtraSettingsMenu::reset_output_option() {
 void ExtraSettingsMenu::set_output_option(int index, int action) {
 	if(index == BACK_X_OUTPUT_OPTION)
 		this->selected_index = EXTRA_SETTINGS_MENU_BACK;
+	else if((action == INC_ACTION) && this->is_option_inc_dec(index))
+		this->selected_index = pollable_options[this->options_indexes[index]]->inc_out_action;
 	else
 		this->selected_index = pollable_options[this->options_indexes[index]]->out_action;
 }
@@ -174,17 +262,53 @@ bool ExtraSettingsMenu::is_option_selectable(int index, int action) {
 	return pollable_options[this->options_indexes[index]]->is_selectable;
 }
 
+bool ExtraSettingsMenu::is_option_inc_dec(int index) {
+	return pollable_options[this->options_indexes[index]]->is_inc;
+}
+
 size_t ExtraSettingsMenu::get_num_options() {
 	return this->num_enabled_options;
 }
 
 std::string ExtraSettingsMenu::get_string_option(int index, int action) {
+	if((action == INC_ACTION) && this->is_option_inc_dec(index))
+		return pollable_options[this->options_indexes[index]]->inc_str;
+	if((action == DEC_ACTION) && this->is_option_inc_dec(index))
+		return pollable_options[this->options_indexes[index]]->dec_str;
 	if(action == FALSE_ACTION)
 		return pollable_options[this->options_indexes[index]]->false_name;
 	return pollable_options[this->options_indexes[index]]->base_name;
 }
 
-void ExtraSettingsMenu::prepare(float menu_scaling_factor, int view_size_x, int view_size_y, bool periodic_connection_try) {
+bool ExtraSettingsMenu::get_thread_scheduling_change(ExtraSettingsMenuOutAction action, ThreadSchedulingType &type, bool &is_cpu, bool &is_inc) {
+	if((action < EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_DEC) || (action > EXTRA_SETTINGS_MENU_USB_EVENTS_CPU_INC))
+		return false;
+	// Each thread has its priority dec/inc, then its cpu dec/inc
+	int offset = action - EXTRA_SETTINGS_MENU_CAPTURE_PRIORITY_DEC;
+	type = static_cast<ThreadSchedulingType>(offset / 4);
+	is_cpu = ((offset / 2) % 2) == 1;
+	is_inc = (offset % 2) == 1;
+	return true;
+}
+
+static std::string get_thread_priority_text(const ThreadSchedulingSettings* thread_scheduling, ThreadSchedulingType type) {
+	ThreadPriorityClass applied_priority_class = get_applied_thread_priority_class(type);
+	std::string text = get_thread_priority_class_name(thread_scheduling[type].priority_class);
+	if(applied_priority_class != thread_scheduling[type].priority_class)
+		text += " (got " + get_thread_priority_class_name(applied_priority_class) + ")";
+	return text;
+}
+
+static std::string get_thread_cpu_text(const ThreadSchedulingSettings* thread_scheduling, ThreadSchedulingType type) {
+	std::string text = "Any";
+	if(thread_scheduling[type].cpu >= 0)
+		text = std::to_string(thread_scheduling[type].cpu);
+	if(!is_thread_affinity_applied(type))
+		text += " (failed)";
+	return text;
+}
+
+void ExtraSettingsMenu::prepare(float menu_scaling_factor, int view_size_x, int view_size_y, bool periodic_connection_try, const ThreadSchedulingSettings* thread_scheduling) {
 	int num_pages = this->get_num_pages();
 	if(this->future_data.page >= num_pages)
 		this->future_data.page = num_pages - 1;
@@ -200,6 +324,15 @@ void ExtraSettingsMenu::prepare(float menu_scaling_factor, int view_size_x, int
 				this->labels[index]->setText(this->setTextOptionBool(real_index, periodic_connection_try));
 				break;
 			default:
+				ThreadSchedulingType type;
+				bool is_cpu;
+				bool is_inc;
+				if(!get_thread_scheduling_change(pollable_options[option_index]->out_action, type, is_cpu, is_inc))
+					break;
+				if(is_cpu)
+					this->labels[index]->setText(this->setTextOptionString(real_index, get_thread_cpu_text(thread_scheduling, type)));
+				else
+					this->labels[index]->setText(this->setTextOptionString(real_index, get_thread_priority_text(thread_scheduling, type)));
 				break;
 		}
 	}
@@ -9,6 +9,13 @@ enum StatusMenuID {
 	STATUS_MENU_FPS_IN,
 	STATUS_MENU_FPS_POLL,
 	STATUS_MENU_FPS_DRAW,
+	STATUS_MENU_TIMES_IN,
+	STATUS_MENU_TIMES_POLL,
+	STATUS_MENU_TIMES_DRAW,
+	STATUS_MENU_MAX_DROPS_IN,
+	STATUS_MENU_MAX_DROPS_POLL,
+	STATUS_MENU_MAX_DROPS_DRAW,
+	STATUS_MENU_BFI_MISSES,
 	STATUS_MENU_CONNECTION,
 	STATUS_MENU_USB_CONNECTION,
 };
@@ -39,6 +46,34 @@ static const StatusMenuOptionInfo status_fps_draw_option = {
 .base_name = "Output FPS:", .is_inc = true,
 .id = STATUS_MENU_FPS_DRAW};
 
+static const StatusMenuOptionInfo status_times_in_option = {
+.base_name = "Input ms 50/95/99%:", .is_inc = true,
+.id = STATUS_MENU_TIMES_IN};
+
+static const StatusMenuOptionInfo status_times_poll_option = {
+.base_name = "Poll ms 50/95/99%:", .is_inc = true,
+.id = STATUS_MENU_TIMES_POLL};
+
+static const StatusMenuOptionInfo status_times_draw_option = {
+.base_name = "Output ms 50/95/99%:", .is_inc = true,
+.id = STATUS_MENU_TIMES_DRAW};
+
+static const StatusMenuOptionInfo status_max_drops_in_option = {
+.base_name = "Input Max ms/Drops:", .is_inc = true,
+.id = STATUS_MENU_MAX_DROPS_IN};
+
+static const StatusMenuOptionInfo status_max_drops_poll_option = {
+.base_name = "Poll Max ms/Drops:", .is_inc = true,
+.id = STATUS_MENU_MAX_DROPS_POLL};
+
+static const StatusMenuOptionInfo status_max_drops_draw_option = {
+.base_name = "Output Max ms/Drops:", .is_inc = true,
+.id = STATUS_MENU_MAX_DROPS_DRAW};
+
+static const StatusMenuOptionInfo status_bfi_misses_option = {
+.base_name = "BFI Shown Max ms/Late:", .is_inc = true,
+.id = STATUS_MENU_BFI_MISSES};
+
 static const StatusMenuOptionInfo status_curr_device_option = {
 .base_name = "", .is_inc = false,
 .id = STATUS_MENU_CONNECTION};
@@ -55,6 +90,13 @@ static const StatusMenuOptionInfo* pollable_options[] = {
 &status_fps_in_option,
 //&status_fps_poll_option,
 &status_fps_draw_option,
+&status_times_in_option,
+//&status_times_poll_option,
+&status_times_draw_option,
+&status_max_drops_in_option,
+//&status_max_drops_poll_option,
+&status_max_drops_draw_option,
+&status_bfi_misses_option,
 };
 
 StatusMenu::StatusMenu(TextRectanglePool* text_rectangle_pool) : OptionSelectionMenu(){
@@ -131,7 +173,23 @@ static std::string get_usb_speed_text(int usb_speed) {
 	return "Connection: USB " + std::to_string(usb_speed);
 }
 
-void StatusMenu::prepare(float menu_scaling_factor, int view_size_x, int view_size_y, double in_fps, double poll_fps, double draw_fps, CaptureStatus* capture_status) {
+static std::string get_ms_str(double time, float multiplier) {
+	return get_float_str_decimals((float)(time * 1000.0) / multiplier, 1);
+}
+
+static std::string get_times_text(const FrameTimeStats &stats, float multiplier) {
+	return get_ms_str(stats.p50_time, multiplier) + "/" + get_ms_str(stats.p95_time, multiplier) + "/" + get_ms_str(stats.p99_time, multiplier);
+}
+
+static std::string get_max_drops_text(const FrameTimeStats &stats, float multiplier) {
+	return get_ms_str(stats.max_time, multiplier) + "/" + std::to_string(stats.dropped_frames);
+}
+
+static std::string get_misses_text(const PresentationMissStats &stats) {
+	return get_ms_str(stats.max_miss, 1.0f) + "/" + std::to_string(stats.num_late);
+}
+
+void StatusMenu::prepare(float menu_scaling_factor, int view_size_x, int view_size_y, const FrameTimeStats &in_stats, const FrameTimeStats &poll_stats, const FrameTimeStats &draw_stats, const PresentationMissStats &bfi_stats, CaptureStatus* capture_status) {
 	if(!this->do_update) {
 		auto curr_time = std::chrono::high_resolution_clock::now();
 		const std::chrono::duration<double> diff = curr_time - this->last_update_time;
@@ -161,13 +219,34 @@ void StatusMenu::prepare(float menu_scaling_factor, int view_size_x, int view_si
 					this->labels[index]->setText(get_usb_speed_text(get_usb_speed_of_device(capture_status)));
 					break;
 				case STATUS_MENU_FPS_IN:
-					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)in_fps * get_framerate_multiplier(capture_status), 2));
+					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)in_stats.fps * get_framerate_multiplier(capture_status), 2));
 					break;
 				case STATUS_MENU_FPS_POLL:
-					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)poll_fps, 2));
+					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)poll_stats.fps, 2));
 					break;
 				case STATUS_MENU_FPS_DRAW:
-					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)draw_fps * get_framerate_multiplier(capture_status), 2));
+					this->labels[index + INC_ACTION]->setText(get_float_str_decimals((float)draw_stats.fps * get_framerate_multiplier(capture_status), 2));
+					break;
+				case STATUS_MENU_TIMES_IN:
+					this->labels[index + INC_ACTION]->setText(get_times_text(in_stats, get_framerate_multiplier(capture_status)));
+					break;
+				case STATUS_MENU_TIMES_POLL:
+					this->labels[index + INC_ACTION]->setText(get_times_text(poll_stats, 1.0f));
+					break;
+				case STATUS_MENU_TIMES_DRAW:
+					this->labels[index + INC_ACTION]->setText(get_times_text(draw_stats, get_framerate_multiplier(capture_status)));
+					break;
+				case STATUS_MENU_MAX_DROPS_IN:
+					this->labels[index + INC_ACTION]->setText(get_max_drops_text(in_stats, get_framerate_multiplier(capture_status)));
+					break;
+				case STATUS_MENU_MAX_DROPS_POLL:
+					this->labels[index + INC_ACTION]->setText(get_max_drops_text(poll_stats, 1.0f));
+					break;
+				case STATUS_MENU_MAX_DROPS_DRAW:
+					this->labels[index + INC_ACTION]->setText(get_max_drops_text(draw_stats, get_framerate_multiplier(capture_status)));
+					break;
+				case STATUS_MENU_BFI_MISSES:
+					this->labels[index + INC_ACTION]->setText(get_misses_text(bfi_stats));
 					break;
 				default:
 					break;
@@ -0,0 +1,80 @@
+#include "PresentationScheduler.hpp"
+
+#include <thread>
+
+SteadyPresentationClock::SteadyPresentationClock() {
+	this->start_time = std::chrono::steady_clock::now();
+}
+
+double SteadyPresentationClock::now() {
+	const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - this->start_time;
+	return diff.count();
+}
+
+void SteadyPresentationClock::sleep(double seconds) {
+	std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+}
+
+PresentationScheduler::PresentationScheduler(PresentationClock* clock) {
+	this->owns_clock = clock == NULL;
+	if(this->owns_clock)
+		clock = new SteadyPresentationClock();
+	this->clock = clock;
+}
+
+PresentationScheduler::~PresentationScheduler() {
+	if(this->owns_clock)
+		delete this->clock;
+}
+
+void PresentationScheduler::start_frame(double slot_time) {
+	this->base_time = this->clock->now();
+	this->slot_time = slot_time;
+	this->curr_deadline = this->base_time;
+}
+
+double PresentationScheduler::wait_until(double offset) {
+	double deadline = this->base_time + offset;
+	this->curr_deadline = deadline;
+	double remaining = deadline - this->clock->now();
+	if(remaining > PRESENTATION_SPIN_TIME)
+		this->clock->sleep(remaining - PRESENTATION_SPIN_TIME);
+	double curr_time = this->clock->now();
+	while(curr_time < deadline)
+		curr_time = this->clock->now();
+	return curr_time - deadline;
+}
+
+double PresentationScheduler::presented() {
+	double miss = this->clock->now() - this->curr_deadline;
+	if(miss < 0.0)
+		miss = 0.0;
+	this->log_miss(miss);
+	return miss;
+}
+
+void PresentationScheduler::log_miss(double miss) {
+	this->miss_log[this->miss_log_pos] = miss;
+	this->miss_log_pos = (this->miss_log_pos + 1) % PRESENTATION_MISS_LOG_SIZE;
+	if(this->miss_log_size < PRESENTATION_MISS_LOG_SIZE)
+		this->miss_log_size++;
+
+	PresentationMissStats new_stats = {};
+	double miss_sum = 0.0;
+	for(size_t i = 0; i < this->miss_log_size; i++) {
+		miss_sum += this->miss_log[i];
+		if(this->miss_log[i] > new_stats.max_miss)
+			new_stats.max_miss = this->miss_log[i];
+		if(this->miss_log[i] > this->slot_time)
+			new_stats.num_late++;
+	}
+	new_stats.avg_miss = miss_sum / this->miss_log_size;
+	new_stats.num_deadlines = (uint32_t)this->miss_log_size;
+	new_stats.last_miss = miss;
+	// Read by the menus, from other threads
+	this->stats.write(new_stats);
+}
+
+PresentationMissStats PresentationScheduler::get_stats() {
+	return this->stats.read();
+}
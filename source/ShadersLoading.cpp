@@ -0,0 +1,79 @@
+#include "ShadersLoading.hpp"
+
+void prepare_shaders(std::vector<shader_and_data> &shaders) {
+	shader_strings_init();
+	for(int i = 0; i < TOTAL_NUM_SHADERS; i++)
+		shaders.emplace_back(static_cast<shader_list_enum>(i));
+}
+
+void compile_shaders(std::vector<shader_and_data> &shaders) {
+	for(size_t i = 0; i < shaders.size(); i++) {
+		shader_and_data* current_shader = &shaders[i];
+		if(current_shader->shader.loadFromMemory(get_shader_string(current_shader->shader_enum), sf::Shader::Type::Fragment)) {
+			current_shader->is_valid = true;
+			auto* const defaultStreamBuffer = sf::err().rdbuf();
+			sf::err().rdbuf(nullptr);
+			sf::Glsl::Vec2 old_pos = {0.0, 0.0};
+			current_shader->shader.setUniform("old_frame_offset", old_pos);
+			sf::err().rdbuf(defaultStreamBuffer);
+		}
+	}
+}
+
+void ShadersLoading::start(std::vector<shader_and_data>* shaders) {
+	this->shaders = shaders;
+	this->num_warmed_up = 0;
+	this->stop_warm_up = false;
+	this->start_time = std::chrono::steady_clock::now();
+	this->compiled_time = this->start_time;
+	this->done_time = this->start_time;
+	this->loading = true;
+	this->loading_thread = std::thread(&ShadersLoading::loading_thread_function, this);
+}
+
+void ShadersLoading::loading_thread_function() {
+	sf::Context context;
+	compile_shaders(*this->shaders);
+	this->compiled_time = std::chrono::steady_clock::now();
+	sf::RenderTexture warm_up_tex;
+	if(warm_up_tex.resize({1, 1})) {
+		sf::RectangleShape warm_up_rect({1, 1});
+		for(size_t i = 0; (i < this->shaders->size()) && (!this->stop_warm_up); i++) {
+			if(!(*this->shaders)[i].is_valid)
+				continue;
+			warm_up_tex.draw(warm_up_rect, &(*this->shaders)[i].shader);
+			warm_up_tex.display();
+			// Reading the pixel back makes sure the draw is actually done
+			(void)warm_up_tex.getTexture().copyToImage();
+			this->num_warmed_up++;
+		}
+	}
+	this->done_time = std::chrono::steady_clock::now();
+}
+
+void ShadersLoading::wait() {
+	if(!this->loading)
+		return;
+	std::scoped_lock lock(this->loading_mutex);
+	if(!this->loading_thread.joinable())
+		return;
+	this->stop_warm_up = true;
+	this->loading_thread.join();
+	this->loading = false;
+}
+
+double ShadersLoading::get_compile_time() {
+	return std::chrono::duration<double>(this->compiled_time - this->start_time).count();
+}
+
+double ShadersLoading::get_warm_up_time() {
+	return std::chrono::duration<double>(this->done_time - this->compiled_time).count();
+}
+
+int ShadersLoading::get_num_warmed_up() {
+	return this->num_warmed_up;
+}
+
+std::chrono::time_point<std::chrono::steady_clock> ShadersLoading::get_done_time() {
+	return this->done_time;
+}
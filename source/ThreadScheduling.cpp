@@ -0,0 +1,289 @@
+#include "ThreadScheduling.hpp"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#endif
+
+#define THREAD_SCHEDULING_MIN_NICE (-20)
+
+struct RegisteredThread {
+	ThreadSchedulingType type;
+	std::thread::id id;
+	#if defined(_WIN32)
+	HANDLE handle;
+	#elif defined(__linux__)
+	pid_t tid;
+	#else
+	pthread_t handle;
+	#endif
+};
+
+static std::mutex scheduling_mutex;
+static std::vector<RegisteredThread> registered_threads;
+static ThreadSchedulingSettings curr_settings[THREAD_SCHEDULING_TYPE_END];
+static ThreadPriorityClass applied_priority_classes[THREAD_SCHEDULING_TYPE_END];
+static bool applied_affinities[THREAD_SCHEDULING_TYPE_END];
+static bool thread_scheduling_initialized = false;
+
+#if defined(_WIN32)
+static DWORD_PTR default_affinity_mask = 0;
+#elif defined(__linux__)
+static cpu_set_t default_affinity_set;
+static bool default_affinity_set_valid = false;
+static int default_nice = 0;
+#else
+static int default_sched_priority = 0;
+#endif
+
+static bool set_thread_priority_class(RegisteredThread &thread, ThreadPriorityClass priority_class) {
+	#if defined(_WIN32)
+	int priority = THREAD_PRIORITY_NORMAL;
+	if(priority_class == THREAD_PRIORITY_CLASS_HIGH)
+		priority = THREAD_PRIORITY_HIGHEST;
+	else if(priority_class == THREAD_PRIORITY_CLASS_REALTIME)
+		priority = THREAD_PRIORITY_TIME_CRITICAL;
+	return SetThreadPriority(thread.handle, priority) != 0;
+	#elif defined(__linux__)
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	if(priority_class == THREAD_PRIORITY_CLASS_REALTIME) {
+		param.sched_priority = sched_get_priority_min(SCHED_RR);
+		return sched_setscheduler(thread.tid, SCHED_RR, &param) == 0;
+	}
+	// Leaving SCHED_RR is always allowed
+	if(sched_setscheduler(thread.tid, SCHED_OTHER, &param) != 0)
+		return false;
+	int nice_value = default_nice;
+	if(priority_class == THREAD_PRIORITY_CLASS_HIGH) {
+		nice_value += THREAD_SCHEDULING_HIGH_NICE_DELTA;
+		if(nice_value < THREAD_SCHEDULING_MIN_NICE)
+			nice_value = THREAD_SCHEDULING_MIN_NICE;
+	}
+	// On Linux, the nice value is per thread
+	return setpriority(PRIO_PROCESS, thread.tid, nice_value) == 0;
+	#else
+	struct sched_param param;
+	memset(&param, 0, sizeof(param));
+	int policy = SCHED_OTHER;
+	param.sched_priority = default_sched_priority;
+	if(priority_class == THREAD_PRIORITY_CLASS_REALTIME) {
+		policy = SCHED_RR;
+		param.sched_priority = sched_get_priority_min(SCHED_RR);
+	}
+	else if(priority_class == THREAD_PRIORITY_CLASS_HIGH)
+		param.sched_priority = sched_get_priority_max(SCHED_OTHER);
+	return pthread_setschedparam(thread.handle, policy, &param) == 0;
+	#endif
+}
+
+static bool set_thread_affinity(RegisteredThread &thread, int cpu) {
+	#if defined(_WIN32)
+	DWORD_PTR mask = default_affinity_mask;
+	if(cpu >= 0) {
+		if(cpu >= (int)(sizeof(DWORD_PTR) * 8))
+			return false;
+		mask = ((DWORD_PTR)1) << cpu;
+	}
+	if(mask == 0)
+		return false;
+	return SetThreadAffinityMask(thread.handle, mask) != 0;
+	#elif defined(__linux__)
+	cpu_set_t set;
+	if(cpu < 0) {
+		if(!default_affinity_set_valid)
+			return false;
+		set = default_affinity_set;
+	}
+	else {
+		if(cpu >= CPU_SETSIZE)
+			return false;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+	}
+	return sched_setaffinity(thread.tid, sizeof(set), &set) == 0;
+	#else
+	// No way to pin a thread to a core here
+	return cpu < 0;
+	#endif
+}
+
+static void apply_thread_scheduling(RegisteredThread &thread) {
+	ThreadSchedulingSettings* settings = &curr_settings[thread.type];
+	ThreadPriorityClass priority_class = settings->priority_class;
+	// Go down one class at a time until one is permitted
+	while((priority_class != THREAD_PRIORITY_CLASS_DEFAULT) && (!set_thread_priority_class(thread, priority_class)))
+		priority_class = (ThreadPriorityClass)(priority_class - 1);
+	if(priority_class == THREAD_PRIORITY_CLASS_DEFAULT)
+		set_thread_priority_class(thread, priority_class);
+	if(priority_class < applied_priority_classes[thread.type])
+		applied_priority_classes[thread.type] = priority_class;
+	if(!set_thread_affinity(thread, settings->cpu))
+		applied_affinities[thread.type] = false;
+}
+
+void init_thread_scheduling() {
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	if(thread_scheduling_initialized)
+		return;
+	#if defined(_WIN32)
+	DWORD_PTR system_mask = 0;
+	if(!GetProcessAffinityMask(GetCurrentProcess(), &default_affinity_mask, &system_mask))
+		default_affinity_mask = 0;
+	#elif defined(__linux__)
+	CPU_ZERO(&default_affinity_set);
+	default_affinity_set_valid = sched_getaffinity(0, sizeof(default_affinity_set), &default_affinity_set) == 0;
+	errno = 0;
+	default_nice = getpriority(PRIO_PROCESS, 0);
+	if(errno != 0)
+		default_nice = 0;
+	#else
+	struct sched_param param;
+	int policy = SCHED_OTHER;
+	if(pthread_getschedparam(pthread_self(), &policy, &param) == 0)
+		default_sched_priority = param.sched_priority;
+	#endif
+	reset_thread_scheduling_settings(curr_settings);
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		applied_priority_classes[i] = THREAD_PRIORITY_CLASS_DEFAULT;
+		applied_affinities[i] = true;
+	}
+	thread_scheduling_initialized = true;
+}
+
+void register_current_thread_scheduling(ThreadSchedulingType type) {
+	RegisteredThread thread;
+	thread.type = type;
+	thread.id = std::this_thread::get_id();
+	#if defined(_WIN32)
+	if(!DuplicateHandle(GetCurrentProcess(), GetCurrentThread(), GetCurrentProcess(), &thread.handle, 0, FALSE, DUPLICATE_SAME_ACCESS))
+		return;
+	#elif defined(__linux__)
+	thread.tid = (pid_t)syscall(SYS_gettid);
+	#else
+	thread.handle = pthread_self();
+	#endif
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	if(thread_scheduling_initialized)
+		apply_thread_scheduling(thread);
+	registered_threads.push_back(thread);
+}
+
+void unregister_current_thread_scheduling() {
+	std::thread::id id = std::this_thread::get_id();
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	for(size_t i = 0; i < registered_threads.size(); i++) {
+		if(registered_threads[i].id != id)
+			continue;
+		#ifdef _WIN32
+		CloseHandle(registered_threads[i].handle);
+		#endif
+		registered_threads.erase(registered_threads.begin() + i);
+		return;
+	}
+}
+
+void set_thread_scheduling_settings(const ThreadSchedulingSettings* settings) {
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	if(!thread_scheduling_initialized)
+		return;
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++)
+		curr_settings[i] = settings[i];
+	sanitize_thread_scheduling_settings(curr_settings);
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		applied_priority_classes[i] = curr_settings[i].priority_class;
+		applied_affinities[i] = true;
+	}
+	for(size_t i = 0; i < registered_threads.size(); i++)
+		apply_thread_scheduling(registered_threads[i]);
+}
+
+void reset_thread_scheduling_settings(ThreadSchedulingSettings* settings) {
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		settings[i].priority_class = THREAD_PRIORITY_CLASS_DEFAULT;
+		settings[i].cpu = THREAD_SCHEDULING_ANY_CPU;
+	}
+}
+
+void sanitize_thread_scheduling_settings(ThreadSchedulingSettings* settings) {
+	int num_cpus = get_num_thread_scheduling_cpus();
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		if((settings[i].priority_class < THREAD_PRIORITY_CLASS_DEFAULT) || (settings[i].priority_class >= THREAD_PRIORITY_CLASS_END))
+			settings[i].priority_class = THREAD_PRIORITY_CLASS_DEFAULT;
+		if((settings[i].cpu < 0) || (settings[i].cpu >= num_cpus))
+			settings[i].cpu = THREAD_SCHEDULING_ANY_CPU;
+	}
+}
+
+int get_num_thread_scheduling_cpus() {
+	int num_cpus = (int)std::thread::hardware_concurrency();
+	if(num_cpus <= 0)
+		num_cpus = 1;
+	return num_cpus;
+}
+
+ThreadPriorityClass get_applied_thread_priority_class(ThreadSchedulingType type) {
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	return applied_priority_classes[type];
+}
+
+bool is_thread_affinity_applied(ThreadSchedulingType type) {
+	std::lock_guard<std::mutex> lock(scheduling_mutex);
+	return applied_affinities[type];
+}
+
+std::string get_thread_scheduling_type_name(ThreadSchedulingType type) {
+	switch(type) {
+		case THREAD_SCHEDULING_CAPTURE:
+			return "Capture";
+		case THREAD_SCHEDULING_AUDIO:
+			return "Audio";
+		case THREAD_SCHEDULING_DISPLAY:
+			return "Display";
+		case THREAD_SCHEDULING_USB_EVENTS:
+			return "USB Events";
+		default:
+			return "";
+	}
+}
+
+std::string get_thread_scheduling_cfg_name(ThreadSchedulingType type) {
+	switch(type) {
+		case THREAD_SCHEDULING_CAPTURE:
+			return "capture";
+		case THREAD_SCHEDULING_AUDIO:
+			return "audio";
+		case THREAD_SCHEDULING_DISPLAY:
+			return "display";
+		case THREAD_SCHEDULING_USB_EVENTS:
+			return "usb_events";
+		default:
+			return "";
+	}
+}
+
+std::string get_thread_priority_class_name(ThreadPriorityClass priority_class) {
+	switch(priority_class) {
+		case THREAD_PRIORITY_CLASS_DEFAULT:
+			return "Default";
+		case THREAD_PRIORITY_CLASS_HIGH:
+			return "High";
+		case THREAD_PRIORITY_CLASS_REALTIME:
+			return "Realtime";
+		default:
+			return "";
+	}
+}
@@ -7,6 +7,7 @@
 #include "font_ttf.h"
 #include "font_mono_ttf.h"
 #include "shaders_list.hpp"
+#include "ShadersLoading.hpp"
 #include "devicecapture.hpp"
 #include <conversions.hpp>
 
@@ -24,15 +25,17 @@
 static bool loaded_shaders = false;
 static int n_shader_refs = 0;
 
-struct shader_and_data {
-	shader_and_data(shader_list_enum value) : shader(sf::Shader()), is_valid(false), shader_enum(value) {}
+static std::vector<shader_and_data> usable_shaders;
+static ShadersLoading shaders_loading;
 
-	sf::Shader shader;
-	bool is_valid;
-	shader_list_enum shader_enum;
-};
+static void start_shaders_loading() {
+	prepare_shaders(usable_shaders);
+	shaders_loading.start(&usable_shaders);
+}
 
-static std::vector<shader_and_data> usable_shaders;
+static void wait_for_shaders_loading() {
+	shaders_loading.wait();
+}
 
 static bool is_size_valid(sf::Vector2f size) {
 	return (size.x > 0.0) && (size.y > 0.0);
@@ -60,9 +63,9 @@ WindowScreen::WindowScreen(ScreenType stype, CaptureStatus* capture_status, Disp
 	this->notification = new TextRectangle(font_load_success, &this->text_font, font_mono_load_success, &this->text_font_mono);
 	this->text_rectangle_pool = new TextRectanglePool(font_load_success, &this->text_font, font_mono_load_success, &this->text_font_mono);
 	this->init_menus();
-	FPSArrayInit(&this->in_fps);
-	FPSArrayInit(&this->draw_fps);
-	FPSArrayInit(&this->poll_fps);
+	FrameTimeHistogramInit(&this->in_fps);
+	FrameTimeHistogramInit(&this->draw_fps);
+	FrameTimeHistogramInit(&this->poll_fps);
 	this->last_update_texture_data_type = VIDEO_DATA_RGB;
 	this->texture_software_based_conv = NO_SOFTWARE_CONV;
 	this->num_frames_to_blend = NUM_FRAMES_BLENDED;
@@ -139,27 +142,24 @@ WindowScreen::WindowScreen(ScreenType stype, CaptureStatus* capture_status, Disp
 	this->last_enabled_3d = false;
 	this->last_interleaved_3d = false;
 	this->capture_status = capture_status;
+	this->loaded_capture_status = get_capture_status_snapshot(this->capture_status);
 	if(this->display_data->mono_app_mode && this->m_stype == ScreenType::JOINT)
 		this->m_info.is_fullscreen = true;
 	if(sf::Shader::isAvailable() && (!loaded_shaders)) {
-		shader_strings_init();
-		for(int i = 0; i < TOTAL_NUM_SHADERS; i++) {
-			usable_shaders.emplace_back(static_cast<shader_list_enum>(i));
-			shader_and_data* current_shader = &usable_shaders[usable_shaders.size()-1];
-			if(current_shader->shader.loadFromMemory(get_shader_string(current_shader->shader_enum), sf::Shader::Type::Fragment)) {
-				current_shader->is_valid = true;
-				auto* const defaultStreamBuffer = sf::err().rdbuf();
-				sf::err().rdbuf(nullptr);
-				sf::Glsl::Vec2 old_pos = {0.0, 0.0};
-				current_shader->shader.setUniform("old_frame_offset", old_pos);
-				sf::err().rdbuf(defaultStreamBuffer);
-			}
-		}
+		start_shaders_loading();
 		loaded_shaders = true;
 	}
 	n_shader_refs += 1;
 	this->was_last_frame_null = true;
+	for(int i = 0; i < NUM_DIRTY_REGIONS; i++)
+		this->dirty_regions[i].generation = 0;
+	this->reset_dirty_regions();
+	this->processed_top.is_valid = false;
+	this->processed_bot.is_valid = false;
+	this->processed_top_right.is_valid = false;
 	this->main_thread_owns_window = true;
+	this->was_open_last_poll = true;
+	this->polled_events = false;
 	this->is_window_windowed = false;
 	this->saved_windowed_pos = sf::Vector2i(0, 0);
 	this->was_windowed_pos_saved = false;
@@ -172,10 +172,11 @@ WindowScreen::~WindowScreen() {
 	delete this->notification;
 	this->destroy_menus();
 	delete this->text_rectangle_pool;
-	FPSArrayDestroy(&this->in_fps);
-	FPSArrayDestroy(&this->draw_fps);
-	FPSArrayDestroy(&this->poll_fps);
+	FrameTimeHistogramDestroy(&this->in_fps);
+	FrameTimeHistogramDestroy(&this->draw_fps);
+	FrameTimeHistogramDestroy(&this->poll_fps);
 	if(sf::Shader::isAvailable() && (n_shader_refs == 1)) {
+		wait_for_shaders_loading();
 		while(!usable_shaders.empty())
 			usable_shaders.pop_back();
 		loaded_shaders = false;
@@ -203,6 +204,9 @@ void WindowScreen::build() {
 	this->m_out_rect_bot.out_rect.setTexture(&this->m_out_rect_bot.out_tex.getTexture());
 
 	this->m_view.setRotation(sf::degrees(0));
+	this->processed_top.is_valid = false;
+	this->processed_bot.is_valid = false;
+	this->processed_top_right.is_valid = false;
 
 	this->reload();
 }
@@ -284,8 +288,9 @@ void WindowScreen::after_thread_join() {
 	}
 }
 
-void WindowScreen::draw(double frame_time, VideoOutputData* out_buf, InputVideoDataType video_data_type, bool update_rendered_buffer) {
-	FPSArrayInsertElement(&this->in_fps, frame_time);
+void WindowScreen::draw(double frame_time, double raw_frame_time, VideoOutputData* out_buf, InputVideoDataType video_data_type, bool update_rendered_buffer) {
+	// The recovered clock would hide the jitter of the real input
+	FrameTimeHistogramInsertElement(&this->in_fps, raw_frame_time);
 	if(!this->done_display)
 		return;
 
@@ -298,7 +303,8 @@ void WindowScreen::draw(double frame_time, VideoOutputData* out_buf, InputVideoD
 	}
 	if(!should_be_open)
 		this->m_info.is_fullscreen = false;
-	bool curr_enabled_3d = get_3d_enabled(this->capture_status);
+	this->loaded_capture_status = get_capture_status_snapshot(this->capture_status);
+	bool curr_enabled_3d = this->loaded_capture_status.enabled_3d;
 	if(this->last_enabled_3d != curr_enabled_3d) {
 		this->prepare_size_ratios(false, false);
 		this->future_operations.call_crop = true;
@@ -320,7 +326,7 @@ void WindowScreen::draw(double frame_time, VideoOutputData* out_buf, InputVideoD
 		this->curr_frame_texture_pos = (this->curr_frame_texture_pos + 1) % this->num_frames_to_blend;
 		auto curr_time = std::chrono::high_resolution_clock::now();
 		const std::chrono::duration<double> diff = curr_time - this->last_draw_time;
-		FPSArrayInsertElement(&this->draw_fps, diff.count());
+		FrameTimeHistogramInsertElement(&this->draw_fps, diff.count());
 		this->last_draw_time = curr_time;
 		WindowScreen::reset_operations(future_operations);
 		if(update_rendered_buffer) {
@@ -367,9 +373,9 @@ void WindowScreen::draw(double frame_time, VideoOutputData* out_buf, InputVideoD
 }
 
 void WindowScreen::update_connection() {
-	if((this->last_connected_status == this->capture_status->connected) && (this->last_title_check_id == this->capture_status->title_check_id))
+	if((this->last_connected_status == this->loaded_capture_status.connected) && (this->last_title_check_id == this->capture_status->title_check_id))
 		return;	
-	this->last_connected_status = this->capture_status->connected;
+	this->last_connected_status = this->loaded_capture_status.connected;
 	this->last_title_check_id = this->capture_status->title_check_id;
 	if(this->m_win.isOpen()) {
 		this->m_win.setTitle(this->title_factory());
@@ -499,7 +505,7 @@ bool WindowScreen::window_needs_work() {
 	int win_height = this->m_win.getSize().y;
 	if((win_width != width) || (win_height != height))
 		return true;
-	if(this->last_connected_status != this->capture_status->connected)
+	if(this->last_connected_status != this->loaded_capture_status.connected)
 		return true;
 	return false;
 }
@@ -572,7 +578,7 @@ void WindowScreen::window_factory(bool is_main_thread) {
 
 std::string WindowScreen::_title_factory() {
 	std::string title = this->win_title;
-	if(this->capture_status->connected)
+	if(this->loaded_capture_status.connected)
 		title += " - " + get_name_of_device(this->capture_status, false, true);
 	return title;
  }
@@ -674,8 +680,8 @@ bool WindowScreen::single_update_texture(unsigned int m_texture, InputVideoDataT
 	return false;
 }
 
-void WindowScreen::execute_single_update_texture(bool &manually_converted, bool do_full, bool is_top, bool is_second) {
-	InputVideoDataType video_data_type = this->curr_video_data_type;
+WindowScreen::TextureUpdateRegion WindowScreen::get_texture_update_region(bool do_full, bool is_top, bool is_second) {
+	TextureUpdateRegion region;
 	size_t top_width = TOP_WIDTH_3DS;
 	size_t top_height = HEIGHT_3DS;
 	size_t single_top_width = TOP_WIDTH_3DS;
@@ -690,7 +696,7 @@ void WindowScreen::execute_single_update_texture(bool &manually_converted, bool
 		bot_width = WIDTH_DS;
 		bot_height = HEIGHT_DS;
 	}
-	if(get_3d_enabled(this->capture_status)) {
+	if(this->loaded_capture_status.enabled_3d) {
 		if(this->capture_status->device.continuous_3d_screens)
 			top_width *= 2;
 		else
@@ -702,55 +708,61 @@ void WindowScreen::execute_single_update_texture(bool &manually_converted, bool
 		std::swap(single_top_width, single_top_height);
 		std::swap(bot_width, bot_height);
 	}
-	size_t full_width = std::max(top_width, bot_width);
-	size_t full_height = top_height + bot_height;
-	size_t width = full_width;
-	size_t height = full_height;
-	size_t pos_x_data = 0;
-	size_t pos_y_data = 0;
+	region.full_width = std::max(top_width, bot_width);
+	region.full_height = top_height + bot_height;
+	region.width = region.full_width;
+	region.height = region.full_height;
+	region.pos_x_data = 0;
+	region.pos_y_data = 0;
 	if(this->m_stype == ScreenType::TOP) {
-		full_height = top_height;
-		height = full_height;
-		pos_x_data = this->get_pos_x_screen_inside_data(true);
-		pos_y_data = this->get_pos_y_screen_inside_data(true);
+		region.full_height = top_height;
+		region.height = region.full_height;
+		region.pos_x_data = this->get_pos_x_screen_inside_data(true);
+		region.pos_y_data = this->get_pos_y_screen_inside_data(true);
 	}
 	if(this->m_stype == ScreenType::BOTTOM) {
-		full_height = bot_height;
-		height = full_height;
-		pos_x_data = this->get_pos_x_screen_inside_data(false);
-		pos_y_data = this->get_pos_y_screen_inside_data(false);
+		region.full_height = bot_height;
+		region.height = region.full_height;
+		region.pos_x_data = this->get_pos_x_screen_inside_data(false);
+		region.pos_y_data = this->get_pos_y_screen_inside_data(false);
 	}
-	size_t pos_x_conv = pos_x_data;
-	size_t pos_y_conv = pos_y_data;
+	region.pos_x_conv = region.pos_x_data;
+	region.pos_y_conv = region.pos_y_data;
 
-	sf::Texture* target_texture = &this->full_in_tex;
+	region.target_texture = &this->full_in_tex;
 	if(!do_full) {
 		if(is_top) {
-			height = single_top_height;
-			pos_x_data = this->get_pos_x_screen_inside_data(true, is_second);
-			pos_y_data = this->get_pos_y_screen_inside_data(true, is_second);
+			region.height = single_top_height;
+			region.pos_x_data = this->get_pos_x_screen_inside_data(true, is_second);
+			region.pos_y_data = this->get_pos_y_screen_inside_data(true, is_second);
 			sf::Texture* top_l_texture = &this->top_l_in_tex;
 			sf::Texture* top_r_texture = &this->top_r_in_tex;
-			if(get_3d_enabled(this->capture_status) && (!this->display_data->interleaved_3d)) {
+			if(this->loaded_capture_status.enabled_3d && (!this->display_data->interleaved_3d)) {
 				if(!this->capture_status->device.is_second_top_screen_right)
 					std::swap(top_l_texture, top_r_texture);
 			}
-			target_texture = top_l_texture;
+			region.target_texture = top_l_texture;
 			if(is_second)
-				target_texture = top_r_texture;
+				region.target_texture = top_r_texture;
 		}
 		else {
-			height = bot_height;
-			pos_x_data = this->get_pos_x_screen_inside_data(false);
-			pos_y_data = this->get_pos_y_screen_inside_data(false);
-			target_texture = &this->bot_in_tex;
+			region.height = bot_height;
+			region.pos_x_data = this->get_pos_x_screen_inside_data(false);
+			region.pos_y_data = this->get_pos_y_screen_inside_data(false);
+			region.target_texture = &this->bot_in_tex;
 		}
 	}
 
 	if(is_vertically_rotated(this->capture_status->device.base_rotation))
-		std::swap(pos_x_data, pos_y_data);
+		std::swap(region.pos_x_data, region.pos_y_data);
+	return region;
+}
 
-	unsigned int m_texture = target_texture->getNativeHandle();
+void WindowScreen::execute_single_update_texture(bool &manually_converted, bool do_full, bool is_top, bool is_second) {
+	InputVideoDataType video_data_type = this->curr_video_data_type;
+	TextureUpdateRegion region = this->get_texture_update_region(do_full, is_top, is_second);
+
+	unsigned int m_texture = region.target_texture->getNativeHandle();
 	bool retry = true;
 	while(retry) {
 		bool software_based_conv = manually_converted || ((this->texture_software_based_conv != NO_SOFTWARE_CONV) && (video_data_type == this->last_update_texture_data_type));
@@ -758,9 +770,9 @@ void WindowScreen::execute_single_update_texture(bool &manually_converted, bool
 		if(software_based_conv) {
 			if(!manually_converted) {
 				if(this->texture_software_based_conv == TO_RGB_SOFTWARE_CONV)
-					manualConvertOutputToRGB(this->saved_buf, this->saved_buf, pos_x_conv, pos_y_conv, full_width, full_height, video_data_type);
+					manualConvertOutputToRGB(this->saved_buf, this->saved_buf, region.pos_x_conv, region.pos_y_conv, region.full_width, region.full_height, video_data_type);
 				if(this->texture_software_based_conv == TO_RGBA_SOFTWARE_CONV)
-					manualConvertOutputToRGBA(this->saved_buf, this->saved_buf, pos_x_conv, pos_y_conv, full_width, full_height, video_data_type);
+					manualConvertOutputToRGBA(this->saved_buf, this->saved_buf, region.pos_x_conv, region.pos_y_conv, region.full_width, region.full_height, video_data_type);
 			}
 			manually_converted = true;
 		}
@@ -769,30 +781,109 @@ void WindowScreen::execute_single_update_texture(bool &manually_converted, bool
 			this->last_update_texture_data_type = video_data_type;
 		}
 
-		retry = this->single_update_texture(m_texture, video_data_type, pos_x_data, pos_y_data, width, height, manually_converted);
+		retry = this->single_update_texture(m_texture, video_data_type, region.pos_x_data, region.pos_y_data, region.width, region.height, manually_converted);
 	}
 }
 
+void WindowScreen::reset_dirty_regions() {
+	for(int i = 0; i < NUM_DIRTY_REGIONS; i++) {
+		this->dirty_regions[i].is_valid = false;
+		this->dirty_regions[i].is_dirty = true;
+		this->dirty_regions[i].num_same_frames = 0;
+		this->dirty_regions[i].generation += 1;
+	}
+}
+
+bool WindowScreen::check_dirty_region(DirtyScreenRegion region, bool is_top, bool is_second) {
+	// Hash the screen before any software conversion touches saved_buf.
+	// A texture holds num_frames_to_blend frames, so a screen is only skipped
+	// once the same data has been uploaded to all of them.
+	DirtyRegionData* dirty_data = &this->dirty_regions[region];
+	TextureUpdateRegion update_region = this->get_texture_update_region(false, is_top, is_second);
+	uint64_t hash = hashOutputRegion(this->saved_buf, update_region.pos_y_data, update_region.width, update_region.height, this->curr_video_data_type);
+	bool is_same = dirty_data->is_valid && (dirty_data->hash == hash) && (dirty_data->video_data_type == this->curr_video_data_type);
+	is_same = is_same && (dirty_data->pos_y_data == update_region.pos_y_data) && (dirty_data->width == update_region.width) && (dirty_data->height == update_region.height);
+	if(is_same)
+		dirty_data->num_same_frames += 1;
+	else
+		dirty_data->num_same_frames = 0;
+	if(dirty_data->num_same_frames > this->num_frames_to_blend)
+		dirty_data->num_same_frames = this->num_frames_to_blend;
+	dirty_data->is_valid = true;
+	dirty_data->hash = hash;
+	dirty_data->video_data_type = this->curr_video_data_type;
+	dirty_data->pos_y_data = update_region.pos_y_data;
+	dirty_data->width = update_region.width;
+	dirty_data->height = update_region.height;
+	dirty_data->is_dirty = dirty_data->num_same_frames < this->num_frames_to_blend;
+	if(dirty_data->is_dirty)
+		dirty_data->generation += 1;
+	return dirty_data->is_dirty;
+}
+
+bool WindowScreen::is_dirty_region_static(DirtyScreenRegion region) {
+	return this->dirty_regions[region].is_valid && (!this->dirty_regions[region].is_dirty);
+}
+
+// Both top regions are considered together, since which texture
+// ends up on the left and on the right depends on the device.
+bool WindowScreen::is_screen_static(bool is_top) {
+	if(!is_top)
+		return this->is_dirty_region_static(BOTTOM_DIRTY_REGION);
+	if(!this->is_dirty_region_static(TOP_DIRTY_REGION))
+		return false;
+	if(this->loaded_capture_status.enabled_3d)
+		return this->is_dirty_region_static(TOP_SECOND_DIRTY_REGION);
+	return true;
+}
+
+uint64_t WindowScreen::get_screen_generation(bool is_top) {
+	if(!is_top)
+		return this->dirty_regions[BOTTOM_DIRTY_REGION].generation;
+	return (((uint64_t)this->dirty_regions[TOP_SECOND_DIRTY_REGION].generation) << 32) | this->dirty_regions[TOP_DIRTY_REGION].generation;
+}
+
 void WindowScreen::update_texture() {
 	bool manually_converted = false;
-	if(this->shared_texture_available)
-		this->execute_single_update_texture(manually_converted, true);
+	bool has_top = (this->m_stype == ScreenType::TOP) || (this->m_stype == ScreenType::JOINT);
+	bool has_bot = (this->m_stype == ScreenType::BOTTOM) || (this->m_stype == ScreenType::JOINT);
+	bool has_top_second = has_top && this->loaded_capture_status.enabled_3d;
+	bool top_dirty = false;
+	bool top_second_dirty = false;
+	bool bot_dirty = false;
+	if(has_top)
+		top_dirty = this->check_dirty_region(TOP_DIRTY_REGION, true, false);
+	if(has_top_second)
+		top_second_dirty = this->check_dirty_region(TOP_SECOND_DIRTY_REGION, true, true);
+	else
+		this->dirty_regions[TOP_SECOND_DIRTY_REGION].is_valid = false;
+	if(has_bot)
+		bot_dirty = this->check_dirty_region(BOTTOM_DIRTY_REGION, false, false);
+
+	if(this->shared_texture_available) {
+		if(top_dirty || top_second_dirty || bot_dirty)
+			this->execute_single_update_texture(manually_converted, true);
+	}
 	else {
-		if((this->m_stype == ScreenType::TOP) || (this->m_stype == ScreenType::JOINT)) {
+		if(top_dirty)
 			this->execute_single_update_texture(manually_converted, false, true);
-			if(get_3d_enabled(this->capture_status))
-				this->execute_single_update_texture(manually_converted, false, true, true);
-		}
-		if((this->m_stype == ScreenType::BOTTOM) || (this->m_stype == ScreenType::JOINT))
+		if(top_second_dirty)
+			this->execute_single_update_texture(manually_converted, false, true, true);
+		if(bot_dirty)
 			this->execute_single_update_texture(manually_converted, false, false);
 	}
 }
 
 void WindowScreen::pre_texture_conversion_processing() {
-	if(this->loaded_menu == CONNECT_MENU_TYPE)
+	// Frames which are not uploaded break the per-frame texture rotation
+	if(this->loaded_menu == CONNECT_MENU_TYPE) {
+		this->reset_dirty_regions();
 		return;
-	if(!this->capture_status->connected)
+	}
+	if(!this->loaded_capture_status.connected) {
+		this->reset_dirty_regions();
 		return;
+	}
 	this->draw_lock->lock();
 	//Place preprocessing window-specific effects here
 	this->update_texture();
@@ -911,6 +1002,7 @@ int WindowScreen::_choose_shader(PossibleShaderTypes shader_type, bool is_top) {
 }
 
 int WindowScreen::choose_shader(PossibleShaderTypes shader_type, bool is_top) {
+	wait_for_shaders_loading();
 	int chosen_shader = _choose_shader(shader_type, is_top);
 	if((chosen_shader >= 0) && (chosen_shader < ((int)usable_shaders.size())) && usable_shaders[chosen_shader].is_valid)
 		return (int)chosen_shader;
@@ -954,12 +1046,38 @@ bool WindowScreen::apply_shaders_to_input(sf::RectangleShape &rect_data, sf::Ren
 	return true;
 }
 
-void WindowScreen::post_texture_conversion_processing(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, const sf::RectangleShape &in_rect, bool actually_draw, bool is_top, bool is_debug) {
+void WindowScreen::post_texture_conversion_processing(sf::RectangleShape &rect_data, sf::RenderTexture* &to_process_tex_data, sf::RenderTexture* &backup_tex_data, const sf::RectangleShape &in_rect, bool actually_draw, bool is_top, bool is_debug, ProcessedScreenData &processed_data) {
 	if((is_top && this->m_stype == ScreenType::BOTTOM) || ((!is_top) && this->m_stype == ScreenType::TOP))
 		return;
 	if(this->loaded_menu == CONNECT_MENU_TYPE)
 		return;
 
+	ProcessedScreenData new_processed_data;
+	new_processed_data.is_valid = (!is_debug) && this->loaded_capture_status.connected && this->is_screen_static(is_top);
+	new_processed_data.generation = this->get_screen_generation(is_top);
+	new_processed_data.in_texture_rect = in_rect.getTextureRect();
+	new_processed_data.out_texture_rect = rect_data.getTextureRect();
+	new_processed_data.in_size = in_rect.getSize();
+	new_processed_data.in_position = in_rect.getPosition();
+	new_processed_data.in_rotation = in_rect.getRotation();
+	new_processed_data.in_scale = {1, 1};
+	if(capture_status->device.is_horizontally_flipped)
+		new_processed_data.in_scale.x = -1;
+	if(capture_status->device.is_vertically_flipped)
+		new_processed_data.in_scale.y = -1;
+	new_processed_data.actually_draw = actually_draw;
+	new_processed_data.is_blurred = this->loaded_info.is_blurred;
+	new_processed_data.base_shader = this->was_last_frame_null ? -1 : this->_choose_base_input_shader(is_top);
+	new_processed_data.color_correction = is_top ? this->loaded_info.top_color_correction : this->loaded_info.bot_color_correction;
+	// The screen did not change, and neither did how it's processed.
+	// Reuse the result of the last shader passes.
+	if(new_processed_data.is_valid && processed_data.is_valid && (processed_data.generation == new_processed_data.generation) && (processed_data.in_texture_rect == new_processed_data.in_texture_rect) && (processed_data.out_texture_rect == new_processed_data.out_texture_rect) && (processed_data.in_size == new_processed_data.in_size) && (processed_data.in_position == new_processed_data.in_position) && (processed_data.in_rotation == new_processed_data.in_rotation) && (processed_data.in_scale == new_processed_data.in_scale) && (processed_data.actually_draw == new_processed_data.actually_draw) && (processed_data.is_blurred == new_processed_data.is_blurred) && (processed_data.base_shader == new_processed_data.base_shader) && (processed_data.color_correction == new_processed_data.color_correction)) {
+		to_process_tex_data = processed_data.result_tex;
+		backup_tex_data = processed_data.result_backup_tex;
+		rect_data.setTexture(&to_process_tex_data->getTexture());
+		return;
+	}
+
 	rect_data.setTexture(&to_process_tex_data->getTexture());
 	if(is_debug) {
 		if(is_top)
@@ -975,12 +1093,12 @@ void WindowScreen::post_texture_conversion_processing(sf::RectangleShape &rect_d
 		final_in_rect.setTextureRect(text_coords_rect);
 		float x_scale = 1;
 		float y_scale = 1;
-		if(capture_status->connected && capture_status->device.is_horizontally_flipped)
+		if(this->loaded_capture_status.connected && this->capture_status->device.is_horizontally_flipped)
 			x_scale = -1;
-		if(capture_status->connected && capture_status->device.is_vertically_flipped)
+		if(this->loaded_capture_status.connected && this->capture_status->device.is_vertically_flipped)
 			y_scale = -1;
 		final_in_rect.setScale({x_scale, y_scale});
-		if(this->capture_status->connected && actually_draw) {
+		if(this->loaded_capture_status.connected && actually_draw) {
 			bool use_default_shader = !(this->apply_shaders_to_input(rect_data, to_process_tex_data, backup_tex_data, final_in_rect, is_top));
 			if(use_default_shader)
 				to_process_tex_data->draw(final_in_rect);
@@ -988,6 +1106,9 @@ void WindowScreen::post_texture_conversion_processing(sf::RectangleShape &rect_d
 		}
 	}
 	to_process_tex_data->display();
+	new_processed_data.result_tex = to_process_tex_data;
+	new_processed_data.result_backup_tex = backup_tex_data;
+	processed_data = new_processed_data;
 }
 
 void WindowScreen::draw_rect_to_window(const sf::RectangleShape &out_rect, bool is_top) {
@@ -1013,7 +1134,7 @@ void WindowScreen::window_bg_processing() {
 }
 
 sf::Vector2u WindowScreen::get_3d_size_multiplier(ScreenInfo* info) {
-	if((!get_3d_enabled(this->capture_status)) || (this->display_data->interleaved_3d))
+	if((!this->loaded_capture_status.enabled_3d) || (this->display_data->interleaved_3d))
 		return {1, 1};
 	SecondScreen3DRelativePosition second_screen_pos = get_second_screen_pos(info, this->m_stype);
 	if((second_screen_pos == UNDER_FIRST) || (second_screen_pos == ABOVE_FIRST))
@@ -1022,13 +1143,13 @@ sf::Vector2u WindowScreen::get_3d_size_multiplier(ScreenInfo* info) {
 }
 
 sf::Vector2u WindowScreen::get_desk_mode_3d_multiplied(ScreenInfo* info) {
-	if((!get_3d_enabled(this->capture_status)) || (this->display_data->interleaved_3d) || (this->m_stype == ScreenType::BOTTOM) || (info->top_scaling == 0))
+	if((!this->loaded_capture_status.enabled_3d) || (this->display_data->interleaved_3d) || (this->m_stype == ScreenType::BOTTOM) || (info->top_scaling == 0))
 		return curr_desk_mode.size;
 	return curr_desk_mode.size.componentWiseDiv(get_3d_size_multiplier(info));
 }
 
 sf::Vector2f WindowScreen::get_3d_offset_out_rect(ScreenInfo* info, bool is_second_screen) {
-	if((!get_3d_enabled(this->capture_status)) || (this->display_data->interleaved_3d))
+	if((!this->loaded_capture_status.enabled_3d) || (this->display_data->interleaved_3d))
 		return {0, 0};
 	float x_contribution = (float)this->m_width_no_manip;
 	float y_contribution = (float)this->m_height_no_manip;
@@ -1065,16 +1186,16 @@ void WindowScreen::display_data_to_window(bool actually_draw, bool is_debug) {
 	sf::RectangleShape in_rect_bot = this->m_in_rect_bot;
 	this->m_out_rect_top.to_process_tex = &this->m_out_rect_top.out_tex;
 	this->m_out_rect_top.to_backup_tex = &this->m_out_rect_top.backup_tex;
-	this->post_texture_conversion_processing(out_rect_top, this->m_out_rect_top.to_process_tex, this->m_out_rect_top.to_backup_tex, in_rect_top, actually_draw, true, is_debug);
+	this->post_texture_conversion_processing(out_rect_top, this->m_out_rect_top.to_process_tex, this->m_out_rect_top.to_backup_tex, in_rect_top, actually_draw, true, is_debug, this->processed_top);
 	this->m_out_rect_bot.to_process_tex = &this->m_out_rect_bot.out_tex;
 	this->m_out_rect_bot.to_backup_tex = &this->m_out_rect_bot.backup_tex;
-	this->post_texture_conversion_processing(out_rect_bot, this->m_out_rect_bot.to_process_tex, this->m_out_rect_bot.to_backup_tex, in_rect_bot, actually_draw, false, is_debug);
-	bool has_to_do_top_right_screen = get_3d_enabled(this->capture_status) && (this->m_stype != ScreenType::BOTTOM) && is_size_valid(out_rect_top.getSize());
+	this->post_texture_conversion_processing(out_rect_bot, this->m_out_rect_bot.to_process_tex, this->m_out_rect_bot.to_backup_tex, in_rect_bot, actually_draw, false, is_debug, this->processed_bot);
+	bool has_to_do_top_right_screen = this->loaded_capture_status.enabled_3d && (this->m_stype != ScreenType::BOTTOM) && is_size_valid(out_rect_top.getSize());
 	if(has_to_do_top_right_screen) {
 		out_rect_top_right.setTextureRect(out_rect_top.getTextureRect());
 		this->m_out_rect_top_right.to_process_tex = &this->m_out_rect_top_right.out_tex;
 		this->m_out_rect_top_right.to_backup_tex = &this->m_out_rect_top_right.backup_tex;
-		this->post_texture_conversion_processing(out_rect_top_right, this->m_out_rect_top_right.to_process_tex, this->m_out_rect_top_right.to_backup_tex, in_rect_top_right, actually_draw, true, is_debug);
+		this->post_texture_conversion_processing(out_rect_top_right, this->m_out_rect_top_right.to_process_tex, this->m_out_rect_top_right.to_backup_tex, in_rect_top_right, actually_draw, true, is_debug, this->processed_top_right);
 	}
 
 	if(is_debug)
@@ -1142,12 +1263,14 @@ void WindowScreen::window_render_call() {
 				this->loaded_info.bfi_amount = 1;
 			if(this->loaded_info.bfi_amount > (this->loaded_info.bfi_divider - 1))
 				this->loaded_info.bfi_amount = this->loaded_info.bfi_divider - 1;
-			for(int i = 0; i < (this->loaded_info.bfi_divider - this->loaded_info.bfi_amount - 1); i++) {
-				sf::sleep(sf::seconds((float)(frame_time / (this->loaded_info.bfi_divider * 1.1))));
-			}
+			// Each sub-frame gets drawn a bit early, so it's ready for the next refresh
+			double sub_frame_time = this->frame_time / (this->loaded_info.bfi_divider * 1.1);
+			int first_black_sub_frame = this->loaded_info.bfi_divider - this->loaded_info.bfi_amount;
+			this->bfi_scheduler.start_frame(sub_frame_time);
 			for(int i = 0; i < this->loaded_info.bfi_amount; i++) {
-				sf::sleep(sf::seconds((float)(frame_time / (this->loaded_info.bfi_divider * 1.1))));
+				this->bfi_scheduler.wait_until(sub_frame_time * (first_black_sub_frame + i));
 				this->display_data_to_window(false);
+				this->bfi_scheduler.presented();
 			}
 		}
 	}
@@ -1526,7 +1649,7 @@ bool WindowScreen::prepare_screens_same_scaling_factor(ResizingScreenData* top_s
 }
 
 bool WindowScreen::get_divide_3d_par(bool is_top, ScreenInfo* info) {
-	if(!get_3d_enabled(this->capture_status))
+	if(!this->loaded_capture_status.enabled_3d)
 		return false;
 	if(!is_top)
 		return info->squish_3d_bot;
@@ -1675,7 +1798,7 @@ void WindowScreen::resize_window_and_out_rects(bool do_work) {
 	this->set_position_screens(new_top_screen_size, new_bot_screen_size, offset_x, offset_y, max_x, max_y, separator_size_x, separator_size_y, do_work);
 	this->m_width_no_manip = this->m_width;
 	this->m_height_no_manip = this->m_height;
-	if(get_3d_enabled(this->capture_status) && (!this->display_data->interleaved_3d) && (this->m_stype != ScreenType::BOTTOM) && is_size_valid(this->m_out_rect_top.out_rect.getSize())) {
+	if(this->loaded_capture_status.enabled_3d && (!this->display_data->interleaved_3d) && (this->m_stype != ScreenType::BOTTOM) && is_size_valid(this->m_out_rect_top.out_rect.getSize())) {
 		sf::Vector2f offset_first_screen = get_3d_offset_out_rect(&this->loaded_info, false);
 		this->m_out_rect_top.out_rect.setPosition(this->m_out_rect_top.out_rect.getPosition() + offset_first_screen);
 		this->m_out_rect_bot.out_rect.setPosition(this->m_out_rect_bot.out_rect.getPosition() + offset_first_screen);
@@ -1799,7 +1922,7 @@ sf::Vector2f WindowScreen::getShownScreenSize(bool is_top, ScreenInfo* info) {
 		*crop_kind = 0;
 	int width = (*crops)[*crop_kind]->top_width;
 	int height = (*crops)[*crop_kind]->top_height;
-	if(get_3d_enabled(this->capture_status) && this->display_data->interleaved_3d)
+	if(this->loaded_capture_status.enabled_3d && this->display_data->interleaved_3d)
 		width *= 2;
 	if(!is_top) {
 		width = (*crops)[*crop_kind]->bot_width;
@@ -1856,7 +1979,7 @@ void WindowScreen::crop() {
 	sf::Vector2f bot_screen_size = getShownScreenSize(false, &this->loaded_info);
 
 	this->resize_in_rect(this->m_in_rect_bot, this->get_pos_x_screen_inside_in_tex(false) + (*crops)[*crop_value]->bot_x, this->get_pos_y_screen_inside_in_tex(false) + (*crops)[*crop_value]->bot_y, (int)bot_screen_size.x, (int)bot_screen_size.y);
-	if(get_3d_enabled(this->capture_status) && (!this->display_data->interleaved_3d)) {
+	if(this->loaded_capture_status.enabled_3d && (!this->display_data->interleaved_3d)) {
 		int left_top_screen_x = this->get_pos_x_screen_inside_in_tex(true, false);
 		int left_top_screen_y = this->get_pos_y_screen_inside_in_tex(true, false);
 		int right_top_screen_x = this->get_pos_x_screen_inside_in_tex(true, true);
@@ -1869,7 +1992,7 @@ void WindowScreen::crop() {
 		this->resize_in_rect(this->m_in_rect_top_right, right_top_screen_x + (*crops)[*crop_value]->top_x, right_top_screen_y + (*crops)[*crop_value]->top_y, (int)top_screen_size.x, (int)top_screen_size.y);
 	}
 	else {
-		bool is_3d_interleaved = get_3d_enabled(this->capture_status) && this->display_data->interleaved_3d;
+		bool is_3d_interleaved = this->loaded_capture_status.enabled_3d && this->display_data->interleaved_3d;
 		float x_multiplier = 1.0f;
 		if(is_3d_interleaved)
 			x_multiplier = 2.0f;
@@ -3,8 +3,16 @@
 #include "frontend.hpp"
 #include "SFML/Audio/PlaybackDevice.hpp"
 #include "devicecapture.hpp"
+#include "ThreadScheduling.hpp"
+#include "ExtraButtonsLine.hpp"
 
-#define FPS_WINDOW_SIZE 64
+#define FRAME_TIME_SUB_BUCKETS 32
+#define FRAME_TIME_MAX_US (1 << 24)
+// Up to FRAME_TIME_MAX_US
+#define FRAME_TIME_NUM_BUCKETS ((FRAME_TIME_SUB_BUCKETS * 18) + (2 * FRAME_TIME_SUB_BUCKETS))
+#define FRAME_TIME_HALF_WINDOW_SIZE 256
+#define FRAME_TIME_REFERENCE_UPDATE_PERIOD 32
+#define FRAME_TIME_DROP_THRESHOLD 1.5
 
 static const int is_battery_levels[] = {1, 5, 12, 25, 50, 100};
 static const int partner_ctr_battery_levels[] = {0, 1, 10, 30, 60, 100};
@@ -63,37 +71,107 @@ static bool is_shortcut_valid() {
 	return ((get_extra_button_name(sf::Keyboard::Key::Enter) != "") || (get_extra_button_name(sf::Keyboard::Key::PageUp) != ""));
 }
 
-void FPSArrayInit(FPSArray *array) {
-	array->data = new double[FPS_WINDOW_SIZE];
-	array->index = 0;
+// Log-linear buckets, in microseconds. Each power of two is split into
+// FRAME_TIME_SUB_BUCKETS, so the error is ~3% regardless of the value.
+static size_t frame_time_to_bucket(double frame_time) {
+	uint64_t value = (uint64_t)(frame_time * 1000000.0);
+	if(value >= FRAME_TIME_MAX_US)
+		value = FRAME_TIME_MAX_US - 1;
+	if(value < (2 * FRAME_TIME_SUB_BUCKETS))
+		return (size_t)value;
+	int shift = 0;
+	while((value >> shift) >= (2 * FRAME_TIME_SUB_BUCKETS))
+		shift++;
+	return (size_t)((FRAME_TIME_SUB_BUCKETS * shift) + (value >> shift));
+}
+
+static double bucket_to_frame_time(size_t bucket) {
+	if(bucket < (2 * FRAME_TIME_SUB_BUCKETS))
+		return bucket / 1000000.0;
+	int shift = (int)(bucket / FRAME_TIME_SUB_BUCKETS) - 1;
+	uint64_t base = bucket - (FRAME_TIME_SUB_BUCKETS * shift);
+	// Middle of the bucket
+	return ((base << shift) + ((1ULL << shift) / 2)) / 1000000.0;
+}
+
+static void FrameTimeHistogramResetHalf(FrameTimeHistogram *histogram, int half) {
+	for(size_t i = 0; i < FRAME_TIME_NUM_BUCKETS; i++)
+		histogram->buckets[half][i] = 0;
+	histogram->num_samples[half] = 0;
+	histogram->num_empty_samples[half] = 0;
+	histogram->rate_sum[half] = 0.0;
+	histogram->max_time[half] = 0.0;
+	histogram->dropped_frames[half] = 0;
+}
+
+void FrameTimeHistogramInit(FrameTimeHistogram *histogram) {
+	for(int i = 0; i < 2; i++) {
+		histogram->buckets[i] = new uint32_t[FRAME_TIME_NUM_BUCKETS];
+		FrameTimeHistogramResetHalf(histogram, i);
+	}
+	histogram->curr_half = 0;
+	histogram->reference_time = 0.0;
 }
 
-void FPSArrayDestroy(FPSArray *array) {
-	delete []array->data;
+void FrameTimeHistogramDestroy(FrameTimeHistogram *histogram) {
+	for(int i = 0; i < 2; i++)
+		delete []histogram->buckets[i];
 }
 
-void FPSArrayInsertElement(FPSArray *array, double frame_time) {
-	if(array->index < 0)
-		array->index = 0;
-	double rate = 0.0;
-	if(frame_time != 0.0)
-		rate = 1.0 / frame_time;
-	array->data[array->index % FPS_WINDOW_SIZE] = rate;
-	array->index++;
-	if(array->index == (2 * FPS_WINDOW_SIZE))
-		array->index = FPS_WINDOW_SIZE;
+static double FrameTimeHistogramGetPercentile(FrameTimeHistogram *histogram, double percentile) {
+	uint32_t total = 0;
+	for(int i = 0; i < 2; i++)
+		total += histogram->num_samples[i] - histogram->num_empty_samples[i];
+	if(total == 0)
+		return 0.0;
+	uint32_t target = (uint32_t)ceil(total * percentile);
+	if(target == 0)
+		target = 1;
+	uint32_t found = 0;
+	for(size_t i = 0; i < FRAME_TIME_NUM_BUCKETS; i++) {
+		found += histogram->buckets[0][i] + histogram->buckets[1][i];
+		if(found >= target)
+			return bucket_to_frame_time(i);
+	}
+	return bucket_to_frame_time(FRAME_TIME_NUM_BUCKETS - 1);
 }
 
-static double FPSArrayGetAverage(FPSArray *array) {
-	int available_fps = FPS_WINDOW_SIZE;
-	if(array->index < available_fps)
-		available_fps = array->index;
-	if(available_fps == 0)
-		return 0.0;
-	double fps_sum = 0;
-	for(int i = 0; i < available_fps; i++)
-		fps_sum += array->data[i];
-	return fps_sum / available_fps;
+void FrameTimeHistogramInsertElement(FrameTimeHistogram *histogram, double frame_time) {
+	int half = histogram->curr_half;
+	if(histogram->num_samples[half] >= FRAME_TIME_HALF_WINDOW_SIZE) {
+		half = (half + 1) % 2;
+		histogram->curr_half = half;
+		FrameTimeHistogramResetHalf(histogram, half);
+	}
+	histogram->num_samples[half]++;
+	// No frame, same as a rate of 0
+	if(frame_time <= 0.0) {
+		histogram->num_empty_samples[half]++;
+		return;
+	}
+	histogram->rate_sum[half] += 1.0 / frame_time;
+	histogram->buckets[half][frame_time_to_bucket(frame_time)]++;
+	if(frame_time > histogram->max_time[half])
+		histogram->max_time[half] = frame_time;
+	// Anything taking way longer than usual means some frames were lost
+	if((histogram->reference_time > 0.0) && (frame_time > (histogram->reference_time * FRAME_TIME_DROP_THRESHOLD)))
+		histogram->dropped_frames[half] += (uint32_t)((frame_time / histogram->reference_time) + 0.5) - 1;
+	if((histogram->num_samples[half] % FRAME_TIME_REFERENCE_UPDATE_PERIOD) == 0)
+		histogram->reference_time = FrameTimeHistogramGetPercentile(histogram, 0.5);
+}
+
+FrameTimeStats FrameTimeHistogramGetStats(FrameTimeHistogram *histogram) {
+	FrameTimeStats stats;
+	uint32_t total = histogram->num_samples[0] + histogram->num_samples[1];
+	stats.fps = 0.0;
+	if(total > 0)
+		stats.fps = (histogram->rate_sum[0] + histogram->rate_sum[1]) / total;
+	stats.p50_time = FrameTimeHistogramGetPercentile(histogram, 0.5);
+	stats.p95_time = FrameTimeHistogramGetPercentile(histogram, 0.95);
+	stats.p99_time = FrameTimeHistogramGetPercentile(histogram, 0.99);
+	stats.max_time = std::max(histogram->max_time[0], histogram->max_time[1]);
+	stats.dropped_frames = histogram->dropped_frames[0] + histogram->dropped_frames[1];
+	return stats;
 }
 
 void WindowScreen::init_menus() {
@@ -212,6 +290,29 @@ void WindowScreen::fast_poll_change() {
 	this->print_notification_on_off("Slow Input checks", this->shared_data->input_data.fast_poll);
 }
 
+void WindowScreen::thread_scheduling_change(ThreadSchedulingType type, bool is_cpu, bool positive) {
+	ThreadSchedulingSettings* settings = &this->shared_data->thread_scheduling[type];
+	if(is_cpu) {
+		// Goes through Any, then each CPU
+		int num_values = get_num_thread_scheduling_cpus() + 1;
+		int new_value = settings->cpu + 1;
+		if(positive)
+			new_value += 1;
+		else
+			new_value += num_values - 1;
+		settings->cpu = (new_value % num_values) - 1;
+	}
+	else {
+		int new_value = (int)settings->priority_class;
+		if(positive)
+			new_value += 1;
+		else
+			new_value += THREAD_PRIORITY_CLASS_END - 1;
+		settings->priority_class = static_cast<ThreadPriorityClass>(new_value % THREAD_PRIORITY_CLASS_END);
+	}
+	set_thread_scheduling_settings(this->shared_data->thread_scheduling);
+}
+
 void WindowScreen::is_nitro_capture_type_change(bool positive) {
 	int new_value = (int)(this->capture_status->device_specific_status.is_status.capture_type);
 	if(positive)
@@ -368,7 +469,7 @@ void WindowScreen::request_3d_change() {
 
 void WindowScreen::interleaved_3d_change() {
 	this->display_data->interleaved_3d = !this->display_data->interleaved_3d;
-	bool updated = get_3d_enabled(this->capture_status);
+	bool updated = this->loaded_capture_status.enabled_3d;
 	if(updated) {
 		this->prepare_size_ratios(false, false);
 		this->future_operations.call_crop = true;
@@ -380,7 +481,7 @@ void WindowScreen::squish_3d_change(bool is_top) {
 		this->m_info.squish_3d_top = !this->m_info.squish_3d_top;
 	else
 		this->m_info.squish_3d_bot = !this->m_info.squish_3d_bot;
-	bool updated = get_3d_enabled(this->capture_status);
+	bool updated = this->loaded_capture_status.enabled_3d;
 	if(updated) {
 		this->prepare_size_ratios(false, false);
 		this->future_operations.call_screen_settings_update = true;
@@ -510,7 +611,7 @@ void WindowScreen::second_screen_3d_pos_change(int new_second_screen_3d_pos) {
 	SecondScreen3DRelativePosition prev_pos = get_second_screen_pos(&this->m_info, this->m_stype);
 	this->m_info.second_screen_pos = cast_new_pos;
 	SecondScreen3DRelativePosition curr_pos = get_second_screen_pos(&this->m_info, this->m_stype);
-	bool updated = get_3d_enabled(this->capture_status) && (prev_pos != curr_pos);
+	bool updated = this->loaded_capture_status.enabled_3d && (prev_pos != curr_pos);
 
 	if(updated) {
 		this->prepare_size_ratios(false, false);
@@ -522,7 +623,7 @@ void WindowScreen::second_screen_3d_match_bottom_pos_change() {
 	SecondScreen3DRelativePosition prev_pos = get_second_screen_pos(&this->m_info, this->m_stype);
 	this->m_info.match_bottom_pos_and_second_screen_pos = !this->m_info.match_bottom_pos_and_second_screen_pos;
 	SecondScreen3DRelativePosition curr_pos = get_second_screen_pos(&this->m_info, this->m_stype);
-	bool updated = get_3d_enabled(this->capture_status) && (prev_pos != curr_pos);
+	bool updated = this->loaded_capture_status.enabled_3d && (prev_pos != curr_pos);
 	if(updated) {
 		this->prepare_size_ratios(false, false);
 		this->future_operations.call_screen_settings_update = true;
@@ -972,7 +1073,7 @@ void WindowScreen::setup_main_menu(bool reset_data, bool skip_setup_check) {
 		return;
 	if(this->curr_menu != MAIN_MENU_TYPE) {
 		this->switch_to_menu(MAIN_MENU_TYPE, this->main_menu, reset_data);
-		this->main_menu->insert_data(this->m_stype, this->m_info.is_fullscreen, this->display_data->mono_app_mode, &this->capture_status->device, this->capture_status->connected);
+		this->main_menu->insert_data(this->m_stype, this->m_info.is_fullscreen, this->display_data->mono_app_mode, &this->capture_status->device, this->loaded_capture_status.connected);
 	}
 }
 
@@ -1557,8 +1658,14 @@ bool WindowScreen::main_poll(SFEvent &event_data) {
 }
 
 void WindowScreen::poll(bool do_everything) {
+	this->polled_events = false;
 	if(this->close_capture())
 		return;
+	// Closed windows only need one last poll, to reset their state
+	bool is_window_open = this->m_win.isOpen();
+	if((!is_window_open) && (!this->was_open_last_poll) && this->events_queue.empty())
+		return;
+	this->was_open_last_poll = is_window_open;
 	if((this->m_info.is_fullscreen || this->display_data->mono_app_mode || this->display_data->force_disable_mouse) && this->m_info.show_mouse) {
 		auto curr_time = std::chrono::high_resolution_clock::now();
 		const std::chrono::duration<double> diff = curr_time - this->last_mouse_action_time;
@@ -1566,6 +1673,7 @@ void WindowScreen::poll(bool do_everything) {
 			this->m_info.show_mouse = false;
 	}
 	this->poll_window(do_everything);
+	this->polled_events = !this->events_queue.empty();
 	bool done = false;
 	while(!events_queue.empty()) {
 		if(done)
@@ -2100,6 +2208,11 @@ void WindowScreen::poll(bool do_everything) {
 						this->shared_data->periodic_connection_try = !this->shared_data->periodic_connection_try;
 						break;
 					default:
+						ThreadSchedulingType type;
+						bool is_cpu;
+						bool is_inc;
+						if(ExtraSettingsMenu::get_thread_scheduling_change(this->extra_menu->selected_index, type, is_cpu, is_inc))
+							this->thread_scheduling_change(type, is_cpu, is_inc);
 						break;
 				}
 				this->loaded_menu_ptr->reset_output_option();
@@ -2560,6 +2673,11 @@ void WindowScreen::poll(bool do_everything) {
 				break;
 		}
 	}
+	// What is left is processed at the next poll, in the new menu
+	if(done)
+		drop_unprocessed_extra_button_events(this->events_queue, [](const SFEvent &event_data) {
+			return ((event_data.type == EVENT_KEY_PRESSED) || (event_data.type == EVENT_KEY_RELEASED)) && event_data.is_extra;
+		});
 }
 
 int WindowScreen::check_connection_menu_result() {
@@ -2672,12 +2790,16 @@ void WindowScreen::reset_held_times(bool force) {
 		check_held_reset(false, this->touch_action);
 }
 
+bool WindowScreen::has_polled_events() {
+	return this->polled_events;
+}
+
 void WindowScreen::poll_window(bool do_everything) {
 	if(this->m_win.isOpen()) {
 		if(do_everything) {
 			auto curr_time = std::chrono::high_resolution_clock::now();
 			const std::chrono::duration<double> diff = curr_time - this->last_poll_time;
-			FPSArrayInsertElement(&poll_fps, diff.count());
+			FrameTimeHistogramInsertElement(&poll_fps, diff.count());
 			this->last_poll_time = curr_time;
 			while(const std::optional event = this->m_win.pollEvent()) {
 				if(event->is<sf::Event::Closed>())
@@ -2792,7 +2914,7 @@ void WindowScreen::prepare_menu_draws(int view_size_x, int view_size_y) {
 			this->connection_menu->prepare(menu_scaling_factor, view_size_x, view_size_y);
 			break;
 		case MAIN_MENU_TYPE:
-			this->main_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, this->capture_status->connected);
+			this->main_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, this->loaded_capture_status.connected);
 			break;
 		case VIDEO_MENU_TYPE:
 			this->video_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, &this->loaded_info, this->m_stype);
@@ -2831,7 +2953,7 @@ void WindowScreen::prepare_menu_draws(int view_size_x, int view_size_y) {
 			this->fileconfig_menu->prepare(menu_scaling_factor, view_size_x, view_size_y);
 			break;
 		case EXTRA_MENU_TYPE:
-			this->extra_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, this->shared_data->periodic_connection_try);
+			this->extra_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, this->shared_data->periodic_connection_try, this->shared_data->thread_scheduling);
 			break;
 		case SHORTCUTS_MENU_TYPE:
 			this->shortcut_menu->prepare(menu_scaling_factor, view_size_x, view_size_y);
@@ -2840,7 +2962,7 @@ void WindowScreen::prepare_menu_draws(int view_size_x, int view_size_y) {
 			this->action_selection_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, (*this->possible_buttons_ptrs[this->chosen_button])->cmd);
 			break;
 		case STATUS_MENU_TYPE:
-			this->status_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, FPSArrayGetAverage(&in_fps), FPSArrayGetAverage(&poll_fps), FPSArrayGetAverage(&draw_fps), this->capture_status);
+			this->status_menu->prepare(menu_scaling_factor, view_size_x, view_size_y, FrameTimeHistogramGetStats(&in_fps), FrameTimeHistogramGetStats(&poll_fps), FrameTimeHistogramGetStats(&draw_fps), this->bfi_scheduler.get_stats(), this->capture_status);
 			break;
 		case LICENSES_MENU_TYPE:
 			this->license_menu->prepare(menu_scaling_factor, view_size_x, view_size_y);
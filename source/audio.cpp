@@ -5,7 +5,6 @@
 #include "frontend.hpp"
 
 #include <chrono>
-#include <queue>
 #include <cstring>
 
 // Number of consecutive failures to restart the audio when switching output.
@@ -23,7 +22,7 @@ static int greatest_diff = 0;
 Audio::Audio(AudioData *audio_data) {
 	this->audio_data = audio_data;
 	// Consume old events
-	this->buffer = new std::int16_t[MAX_SAMPLES_IN * (MAX_MAX_AUDIO_LATENCY + 1)];
+	this->buffer = new std::int16_t[AUDIO_RING_SIZE];
 	this->change_sample_rate(SAMPLE_RATE_DS);
 	this->audio_data->check_audio_restart_request();
 	start_audio();
@@ -98,6 +97,29 @@ bool Audio::hasTooMuchTimeElapsed() {
 	return (diff.count() > 1.0);
 }
 
+// Only the thread doing the conversions should call these two
+std::int16_t* Audio::get_free_chunk() {
+	uint64_t start_pos = this->write_pos;
+	uint64_t ring_pos = start_pos % AUDIO_RING_SIZE;
+	if((AUDIO_RING_SIZE - ring_pos) < MAX_SAMPLES_IN)
+		start_pos += AUDIO_RING_SIZE - ring_pos;
+	if((start_pos + MAX_SAMPLES_IN - this->release_pos.load(std::memory_order_acquire)) > AUDIO_RING_SIZE)
+		return NULL;
+	this->write_pos = start_pos;
+	return this->buffer + (start_pos % AUDIO_RING_SIZE);
+}
+
+void Audio::push_chunk(uint64_t n_samples, double time) {
+	AudioChunk chunk = {this->write_pos, n_samples, time};
+	if(!this->chunks.push(chunk))
+		return;
+	this->write_pos += n_samples;
+	samples_wait.unlock();
+}
+
+size_t Audio::get_num_queued_chunks() {
+	return this->chunks.size();
+}
 
 bool Audio::hasTooMuchTimeElapsedInside() {
 	auto curr_time = std::chrono::high_resolution_clock::now();
@@ -119,7 +141,7 @@ bool Audio::onGetData(sf::SoundStream::Chunk &data) {
 	inside_clock_time_start = std::chrono::high_resolution_clock::now();
 
 	inside_onGetData = true;
-	size_t loaded_samples = samples.size();
+	size_t loaded_samples = this->chunks.size();
 	while(loaded_samples == 0) {
 		switch(this->audio_data->get_audio_mode_output()) {
 			case AUDIO_MODE_STABLE:
@@ -131,7 +153,7 @@ bool Audio::onGetData(sf::SoundStream::Chunk &data) {
 					inside_onGetData = false;
 					return false;
 				}
-				loaded_samples = samples.size();
+				loaded_samples = this->chunks.size();
 				if((loaded_samples == 0) && this->hasTooMuchTimeElapsedInside()) {
 					// This is needed by MacOS...
 					// But it also causes some trailing noise when
@@ -144,44 +166,31 @@ bool Audio::onGetData(sf::SoundStream::Chunk &data) {
 				break;
 		}
 	}
-	data.samples = (const std::int16_t*)buffer;
 
+	AudioChunk chunk;
 	while(loaded_samples > this->audio_data->get_max_audio_latency()) {
-		samples.pop();
-		loaded_samples = samples.size();
+		this->chunks.pop(chunk);
+		loaded_samples = this->chunks.size();
 	}
 
-	data.sampleCount = 0;
-
-	for(size_t i = 0; i < loaded_samples; i++) {
-		const std::int16_t *data_samples = samples.front().bytes;
-		size_t count = (size_t)samples.front().size;
-		memcpy(buffer + data.sampleCount, data_samples, count * sizeof(std::int16_t));
-		// Unused, but could be useful info
-		//double real_sample_rate = (1.0 / samples.front().time) * count / 2;
-		data.sampleCount += count;
-		samples.pop();
+	this->chunks.pop(chunk);
+	// Whatever was handed out in the previous call is not needed anymore
+	this->release_pos.store(chunk.start_pos, std::memory_order_release);
+	data.samples = (const std::int16_t*)(buffer + (chunk.start_pos % AUDIO_RING_SIZE));
+	data.sampleCount = (size_t)chunk.size;
+	// Unused, but could be useful info
+	//double real_sample_rate = (1.0 / chunk.time) * chunk.size / 2;
+	uint64_t end_pos = chunk.start_pos + chunk.size;
+	while(this->chunks.peek(chunk) && (chunk.start_pos == end_pos)) {
+		this->chunks.pop(chunk);
+		data.sampleCount += (size_t)chunk.size;
+		end_pos += chunk.size;
 	}
 
-	if(this->audio_data->get_audio_output_type() == AUDIO_OUTPUT_MONO)
-		for(size_t i = 0; i < data.sampleCount; i++) {
-			int sum = ((int)buffer[i * 2]) + buffer[(i * 2) + 1];
-			// >> is apparently implementation-dependent. Do it like this...
-			int sign_mult = 1;
-			if(sum < 0)
-				sign_mult = -1;
-			int abs_sum = sum * sign_mult;
-			if(abs_sum >= 32768)
-				abs_sum += 1;
-			int avg = sign_mult * (abs_sum / 2);
-			buffer[i * 2] = avg;
-			buffer[(i * 2) + 1] = avg;
-		}
-
 	#ifdef AUDIO_PANNING_TEST
 	int max_diff = 0;
-	for(size_t i = 0; i < data.sampleCount; i++) {
-		int diff = abs(buffer[i * 2] - buffer[(i * 2) + 1]);
+	for(size_t i = 0; i < (data.sampleCount / 2); i++) {
+		int diff = abs(data.samples[i * 2] - data.samples[(i * 2) + 1]);
 		if(diff > max_diff)
 			max_diff = diff;
 	}
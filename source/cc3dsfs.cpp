@@ -13,6 +13,7 @@
 #include <mutex>
 #include <chrono>
 #include <queue>
+#include <iterator>
 
 #include "utils.hpp"
 #include "devicecapture.hpp"
@@ -20,9 +21,13 @@
 #include "frontend.hpp"
 #include "audio.hpp"
 #include "conversions.hpp"
-
-// Threshold to keep the audio latency limited in "amount of frames".
-#define NUM_CONCURRENT_AUDIO_BUFFERS ((MAX_MAX_AUDIO_LATENCY * 2) + 1)
+#include "FrameRecorder.hpp"
+#include "FrameSharedMemory.hpp"
+#include "FrameStreamServer.hpp"
+#include "ThreadScheduling.hpp"
+#include "ConfigSnapshot.hpp"
+#include "IdleState.hpp"
+#include "recording_playback_acquisition.hpp"
 
 #define LOW_POLL_DIVISOR 6
 #define NO_DATA_CONSECUTIVE_THRESHOLD 4
@@ -31,6 +36,14 @@
 #define ANDROID_FIRST_CONNECTION_TIMEOUT 0.5
 
 #define PERIOD_CONNECTION_TRY_TIMEOUT 0.5
+// Used when the list of devices is tracked, in case something is missed
+#define PERIOD_CONNECTION_TRY_UNCHANGED_TIMEOUT 3.0
+
+// Tried less and less often while nothing gets connected
+#define PERIOD_CONNECTION_TRY_MAX_BACKOFF 8
+
+// Only for the lines which cannot report their edges
+#define INPUT_THREAD_POLL_PERIOD_MS 10
 
 struct override_all_data {
 	override_win_data override_top_bot_data;
@@ -62,7 +75,19 @@ static void SuccessConnectionOutTextGenerator(OutTextData &out_text_data, Captur
 }
 
 static bool load_shared(const std::string path, const std::string name, SharedData* shared_data, OutTextData &out_text_data, bool do_print) {
-	std::ifstream file(path + name);
+	const std::string full_path = path + name;
+	const std::string snapshot_path = full_path + CONFIG_SNAPSHOT_EXTENSION;
+	ConfigSourceState file_state;
+	ConfigSourceState snapshot_state;
+	SharedData snapshot_data = *shared_data;
+	bool has_file_state = get_config_source_state(full_path, file_state);
+	bool has_snapshot = has_file_state && load_shared_config_snapshot(snapshot_path, snapshot_state, snapshot_data);
+	if(has_snapshot && is_config_source_unchanged(snapshot_state, file_state)) {
+		*shared_data = snapshot_data;
+		return true;
+	}
+
+	std::ifstream file(full_path);
 	std::string line;
 
 	if((!file) || (!file.is_open()) || (!file.good())) {
@@ -71,58 +96,29 @@ static bool load_shared(const std::string path, const std::string name, SharedDa
 		return false;
 	}
 
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	file_state.content_hash = get_config_content_hash(content);
+	// Touched, but not actually changed
+	if(has_snapshot && (snapshot_state.content_hash == file_state.content_hash)) {
+		*shared_data = snapshot_data;
+		save_shared_config_snapshot(snapshot_path, file_state, *shared_data);
+		return true;
+	}
+
+	std::istringstream file_data(content);
 	bool result = true;
 
 	try {
-		while(std::getline(file, line)) {
+		while(std::getline(file_data, line)) {
 			std::istringstream kvp(line);
 			std::string key;
 
 			if(std::getline(kvp, key, '=')) {
 				std::string value;
 
-				if(std::getline(kvp, value)) {
-
-					if(key == "extra_button_enter_short") {
-						shared_data->input_data.extra_button_shortcuts.enter_shortcut = get_window_command(static_cast<PossibleWindowCommands>(std::stoi(value)));
-						continue;
-					}
-
-					if(key == "extra_button_page_up_short") {
-						shared_data->input_data.extra_button_shortcuts.page_up_shortcut = get_window_command(static_cast<PossibleWindowCommands>(std::stoi(value)));
-						continue;
-					}
-
-					if(key == "fast_poll") {
-						shared_data->input_data.fast_poll = std::stoi(value);
-						continue;
-					}
-
-					if(key == "enable_keyboard_input") {
-						shared_data->input_data.enable_keyboard_input = std::stoi(value);
-						continue;
-					}
-
-					if(key == "enable_controller_input") {
-						shared_data->input_data.enable_controller_input = std::stoi(value);
-						continue;
-					}
-
-					if(key == "enable_mouse_input") {
-						shared_data->input_data.enable_mouse_input = std::stoi(value);
-						continue;
-					}
-
-					if(key == "enable_buttons_input") {
-						shared_data->input_data.enable_buttons_input = std::stoi(value);
-						continue;
-					}
-
-					if(key == "periodic_connection_try") {
-						shared_data->periodic_connection_try = std::stoi(value);
-						continue;
-					}
-				}
+				if(std::getline(kvp, value))
+					load_shared_data_value(key, value, shared_data);
 			}
 		}
 	}
@@ -132,12 +128,71 @@ static bool load_shared(const std::string path, const std::string name, SharedDa
 		result = false;
 	}
 
-	file.close();
+	if(result && has_file_state)
+		save_shared_config_snapshot(snapshot_path, file_state, *shared_data);
 	return result;
 }
 
+static void take_layout_snapshot(LayoutConfigSnapshot &snapshot, const ScreenInfo &top_info, const ScreenInfo &bottom_info, const ScreenInfo &joint_info, const DisplayData &display_data, CaptureStatus* capture_status) {
+	snapshot.mono_app_mode = display_data.mono_app_mode;
+	snapshot.top_info = top_info;
+	snapshot.bottom_info = bottom_info;
+	snapshot.joint_info = joint_info;
+	snapshot.interleaved_3d = display_data.interleaved_3d;
+	snapshot.do_ratio_cycling = display_data.do_ratio_cycling;
+	snapshot.last_connected_ds = display_data.last_connected_ds;
+	snapshot.requested_3d = capture_status->requested_3d;
+	snapshot.is_capture_type = capture_status->device_specific_status.is_status.capture_type;
+	snapshot.is_capture_speed = capture_status->device_specific_status.is_status.capture_speed;
+	snapshot.is_battery_percentage = capture_status->device_specific_status.is_status.battery_percentage;
+	snapshot.is_ac_adapter_connected = capture_status->device_specific_status.is_status.ac_adapter_connected;
+	snapshot.partner_ctr_battery_percentage = capture_status->device_specific_status.partner_ctr_status.battery_percentage;
+	snapshot.partner_ctr_ac_adapter_connected = capture_status->device_specific_status.partner_ctr_status.ac_adapter_connected;
+	snapshot.partner_ctr_ac_adapter_charging = capture_status->device_specific_status.partner_ctr_status.ac_adapter_charging;
+	snapshot.request_low_bw_format = capture_status->device_specific_status.optimize_status.request_low_bw_format;
+	snapshot.request_low_bw_format_old_2ds = capture_status->device_specific_status.optimize_status.request_low_bw_format_old_2ds;
+	for(int i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		snapshot.devices_allowed_scan[i] = capture_status->devices_allowed_scan[i];
+}
+
+static void apply_layout_snapshot(const LayoutConfigSnapshot &snapshot, ScreenInfo &top_info, ScreenInfo &bottom_info, ScreenInfo &joint_info, DisplayData &display_data, AudioData *audio_data, CaptureStatus* capture_status) {
+	top_info = snapshot.top_info;
+	bottom_info = snapshot.bottom_info;
+	joint_info = snapshot.joint_info;
+	display_data.interleaved_3d = snapshot.interleaved_3d;
+	display_data.do_ratio_cycling = snapshot.do_ratio_cycling;
+	display_data.last_connected_ds = snapshot.last_connected_ds;
+	set_3d_enabled(capture_status, snapshot.requested_3d);
+	capture_status->device_specific_status.is_status.capture_type = snapshot.is_capture_type;
+	capture_status->device_specific_status.is_status.capture_speed = snapshot.is_capture_speed;
+	capture_status->device_specific_status.is_status.battery_percentage = snapshot.is_battery_percentage;
+	capture_status->device_specific_status.is_status.ac_adapter_connected = snapshot.is_ac_adapter_connected;
+	capture_status->device_specific_status.partner_ctr_status.battery_percentage = snapshot.partner_ctr_battery_percentage;
+	capture_status->device_specific_status.partner_ctr_status.ac_adapter_connected = snapshot.partner_ctr_ac_adapter_connected;
+	capture_status->device_specific_status.partner_ctr_status.ac_adapter_charging = snapshot.partner_ctr_ac_adapter_charging;
+	capture_status->device_specific_status.optimize_status.request_low_bw_format = snapshot.request_low_bw_format;
+	capture_status->device_specific_status.optimize_status.request_low_bw_format_old_2ds = snapshot.request_low_bw_format_old_2ds;
+	for(int i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		capture_status->devices_allowed_scan[i] = snapshot.devices_allowed_scan[i];
+	for(size_t i = 0; i < snapshot.audio_values.size(); i++)
+		audio_data->load_audio_data(snapshot.audio_values[i].first, snapshot.audio_values[i].second);
+}
+
 static bool load(const std::string path, const std::string name, ScreenInfo &top_info, ScreenInfo &bottom_info, ScreenInfo &joint_info, DisplayData &display_data, AudioData *audio_data, OutTextData &out_text_data, CaptureStatus* capture_status) {
-	std::ifstream file(path + name);
+	const std::string full_path = path + name;
+	const std::string snapshot_path = full_path + CONFIG_SNAPSHOT_EXTENSION;
+	ConfigSourceState file_state;
+	ConfigSourceState snapshot_state;
+	LayoutConfigSnapshot snapshot;
+	bool has_file_state = get_config_source_state(full_path, file_state);
+	// The defaults the file is parsed on top of depend on mono_app_mode
+	bool has_snapshot = has_file_state && load_layout_config_snapshot(snapshot_path, snapshot_state, snapshot) && (snapshot.mono_app_mode == display_data.mono_app_mode);
+	if(has_snapshot && is_config_source_unchanged(snapshot_state, file_state)) {
+		apply_layout_snapshot(snapshot, top_info, bottom_info, joint_info, display_data, audio_data, capture_status);
+		return true;
+	}
+
+	std::ifstream file(full_path);
 	std::string line;
 	bool loaded_3d_request = false;
 
@@ -146,10 +201,22 @@ static bool load(const std::string path, const std::string name, ScreenInfo &top
 		return false;
 	}
 
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
+	file_state.content_hash = get_config_content_hash(content);
+	// Touched, but not actually changed
+	if(has_snapshot && (snapshot_state.content_hash == file_state.content_hash)) {
+		save_layout_config_snapshot(snapshot_path, file_state, snapshot);
+		apply_layout_snapshot(snapshot, top_info, bottom_info, joint_info, display_data, audio_data, capture_status);
+		return true;
+	}
+
+	std::istringstream file_data(content);
+	std::vector<std::pair<std::string, std::string>> audio_values;
 	bool result = true;
 
 	try {
-		while(std::getline(file, line)) {
+		while(std::getline(file_data, line)) {
 			std::istringstream kvp(line);
 			std::string key;
 
@@ -273,8 +340,10 @@ static bool load(const std::string path, const std::string name, ScreenInfo &top
 				continue;
 			}
 
-			if(audio_data->load_audio_data(key, value))
+			if(audio_data->load_audio_data(key, value)) {
+				audio_values.emplace_back(key, value);
 				continue;
+			}
 		}
 		if(!loaded_3d_request)
 			set_3d_enabled(capture_status, false);
@@ -284,7 +353,11 @@ static bool load(const std::string path, const std::string name, ScreenInfo &top
 		result = false;
 	}
 
-	file.close();
+	if(result && has_file_state) {
+		take_layout_snapshot(snapshot, top_info, bottom_info, joint_info, display_data, capture_status);
+		snapshot.audio_values = audio_values;
+		save_layout_config_snapshot(snapshot_path, file_state, snapshot);
+	}
 	return result;
 }
 
@@ -320,6 +393,7 @@ static void load_layout_file(int load_index, FrontendData *frontend_data, AudioD
 	if(load_index == SIMPLE_RESET_DATA_INDEX) {
 		set_3d_enabled(capture_status, false);
 		reset_shared_data(&frontend_data->shared_data);
+		set_thread_scheduling_settings(frontend_data->shared_data.thread_scheduling);
 		UpdateOutText(out_text_data, "Reset detected. Defaults re-loaded", "Reset detected\nDefaults re-loaded", TEXT_KIND_WARNING);
 		return;
 	}
@@ -346,6 +420,8 @@ static void load_layout_file(int load_index, FrontendData *frontend_data, AudioD
 		reset_shared_data(&frontend_data->shared_data);
 	if(!is_input_data_valid(&frontend_data->shared_data.input_data, are_extra_buttons_usable()))
 		reset_input_data(&frontend_data->shared_data.input_data);
+	sanitize_thread_scheduling_settings(frontend_data->shared_data.thread_scheduling);
+	set_thread_scheduling_settings(frontend_data->shared_data.thread_scheduling);
 }
 
 static bool save_shared(const std::string path, const std::string name, SharedData* shared_data, OutTextData &out_text_data, bool do_print) {
@@ -364,6 +440,11 @@ static bool save_shared(const std::string path, const std::string name, SharedDa
 	file << "enable_mouse_input=" << shared_data->input_data.enable_mouse_input << std::endl;
 	file << "enable_buttons_input=" << shared_data->input_data.enable_buttons_input << std::endl;
 	file << "periodic_connection_try=" << shared_data->periodic_connection_try << std::endl;
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		std::string thread_name = get_thread_scheduling_cfg_name(static_cast<ThreadSchedulingType>(i));
+		file << thread_name << "_thread_priority=" << shared_data->thread_scheduling[i].priority_class << std::endl;
+		file << thread_name << "_thread_cpu=" << shared_data->thread_scheduling[i].cpu << std::endl;
+	}
 
 	file.close();
 	return true;
@@ -499,10 +580,9 @@ static bool handleAudioDeviceChanges(Audio &audio, AudioData *audio_data, std::o
 	return success;
 }
 
-static void soundCall(AudioData *audio_data, CaptureData* capture_data, volatile bool* can_do_output) {
-	std::int16_t (*out_buf)[MAX_SAMPLES_IN] = new std::int16_t[NUM_CONCURRENT_AUDIO_BUFFERS][MAX_SAMPLES_IN];
+static void soundCall(AudioData *audio_data, CaptureData* capture_data, FrameRecorder* recorder, FrameStreamServer* stream_server, volatile bool* can_do_output) {
+	register_current_thread_scheduling(THREAD_SCHEDULING_AUDIO);
 	Audio audio(audio_data);
-	int audio_buf_counter = 0;
 	uint16_t last_buffer_index = -1;
 	const bool endianness = is_big_endian();
 	volatile size_t loaded_samples;
@@ -514,7 +594,8 @@ static void soundCall(AudioData *audio_data, CaptureData* capture_data, volatile
 	sf::PlaybackDevice::setNotificationCallback([&requestAudioResearch, &resetting](sf::PlaybackDevice::Notification notification){audioDeviceNotificationCallback(requestAudioResearch, resetting, notification);});
 
 	while(capture_data->status.running) {
-		if(capture_data->status.connected && capture_data->status.device.has_audio && (*can_do_output)) {
+		CaptureStatusSnapshot status_snapshot = get_capture_status_snapshot(&capture_data->status);
+		if(status_snapshot.connected && capture_data->status.device.has_audio && (*can_do_output)) {
 			if(audio.get_current_sample_rate() != capture_data->status.device.sample_rate) {
 				audio.stop_audio();
 				audio.stop();
@@ -523,28 +604,35 @@ static void soundCall(AudioData *audio_data, CaptureData* capture_data, volatile
 
 			bool timed_out = !capture_data->status.audio_wait.timed_lock();
 
-			if(!capture_data->status.cooldown_curr_in) {
+			if(!status_snapshot.cooldown_curr_in) {
 				CaptureDataSingleBuffer* data_buffer = capture_data->data_buffers.GetReaderBuffer(CAPTURE_READER_AUDIO);
 				if(data_buffer != NULL) {
-					loaded_samples = audio.samples.size();
-					if((data_buffer->read >= get_video_in_size(capture_data, data_buffer->is_3d, data_buffer->should_be_3d, data_buffer->buffer_video_data_type)) && (loaded_samples < MAX_MAX_AUDIO_LATENCY) && capture_data->status.connected) {
+					loaded_samples = audio.get_num_queued_chunks();
+					std::int16_t* out_buf = NULL;
+					if((loaded_samples < MAX_MAX_AUDIO_LATENCY) && (data_buffer->read >= get_video_in_size(capture_data, data_buffer->is_3d, data_buffer->should_be_3d, data_buffer->buffer_video_data_type)) && capture_data->status.connected)
+						out_buf = audio.get_free_chunk();
+					if(out_buf != NULL) {
 						uint64_t n_samples = get_audio_n_samples(capture_data, data_buffer);
 						double out_time = data_buffer->time_in_buf;
-						bool conversion_success = convertAudioToOutput(out_buf[audio_buf_counter], n_samples, last_buffer_index, endianness, data_buffer, &capture_data->status);
+						bool is_mono = audio_data->get_audio_output_type() == AUDIO_OUTPUT_MONO;
+						// Recordings and streams keep the stereo. Only the output is mixed.
+						bool mix_after_push = is_mono && (recorder->is_recording() || stream_server->has_clients());
+						bool conversion_success = convertAudioToOutput(out_buf, n_samples, last_buffer_index, endianness, is_mono && (!mix_after_push), data_buffer, &capture_data->status);
 						if(!conversion_success)
 							audio_data->signal_conversion_error();
 						if(n_samples > 0) {
-							audio.samples.emplace(out_buf[audio_buf_counter], n_samples, out_time);
-							if(++audio_buf_counter >= NUM_CONCURRENT_AUDIO_BUFFERS)
-								audio_buf_counter = 0;
-							audio.samples_wait.unlock();
+							recorder->push_audio(out_buf, n_samples, capture_data->status.device.sample_rate);
+							stream_server->push_audio(out_buf, n_samples, capture_data->status.device.sample_rate);
+							if(mix_after_push)
+								mixAudioOutputToMono(out_buf, n_samples);
+							audio.push_chunk(n_samples, out_time);
 						}
 					}
 					capture_data->data_buffers.ReleaseReaderBuffer(CAPTURE_READER_AUDIO);
 				}
 			}
 
-			loaded_samples = audio.samples.size();
+			loaded_samples = audio.get_num_queued_chunks();
 			if(audio.getStatus() != sf::SoundStream::Status::Playing) {
 				audio.stop_audio();
 				if(loaded_samples > 0) {
@@ -588,7 +676,7 @@ static void soundCall(AudioData *audio_data, CaptureData* capture_data, volatile
 	sf::PlaybackDevice::setNotificationCallback([](sf::PlaybackDevice::Notification notification){});
 	audio.stop_audio();
 	audio.stop();
-	delete []out_buf;
+	unregister_current_thread_scheduling();
 }
 
 static void poll_all_windows(FrontendData *frontend_data, bool do_everything, bool &polled) {
@@ -596,10 +684,20 @@ static void poll_all_windows(FrontendData *frontend_data, bool do_everything, bo
 		frontend_data->top_screen->poll(do_everything);
 		frontend_data->bot_screen->poll(do_everything);
 		frontend_data->joint_screen->poll(do_everything);
+		// Only the focused window takes them. Don't keep the rest around.
+		extra_buttons_flush();
 		polled = true;
 	}
 }
 
+// Runs separately, so the buttons are not tied to the capture's frame rate
+static void inputCall(CaptureData* capture_data) {
+	while(capture_data->status.running) {
+		extra_buttons_thread_poll();
+		extra_buttons_thread_wait(INPUT_THREAD_POLL_PERIOD_MS);
+	}
+}
+
 static void check_close_application(WindowScreen *screen, CaptureData* capture_data, int &ret_val) {
 	if(screen->close_capture() && capture_data->status.running) {
 		capture_data->status.running = false;
@@ -646,6 +744,7 @@ static void check_for_first_connection(bool &did_first_connection, std::chrono::
 	#endif
 
 	capture_data->status.connected = connect(true, capture_data, frontend_data, force_cc_disables, override_data.auto_connect_to_first);
+	publish_capture_status_snapshot(&capture_data->status);
 	if((override_data.quit_on_first_connection_failure || override_data.auto_close) && (!capture_data->status.connected)) {
 		capture_data->status.running = false;
 		ret_val = -3;
@@ -655,18 +754,41 @@ static void check_for_first_connection(bool &did_first_connection, std::chrono::
 	last_connection_time = std::chrono::high_resolution_clock::now();
 }
 
-static bool should_do_periodic_connection_try(SharedData* shared_data, bool connected, std::chrono::time_point<std::chrono::high_resolution_clock> &last_connection_time) {
-	if(connected || (!shared_data->periodic_connection_try))
+static bool should_do_periodic_connection_try(SharedData* shared_data, CaptureStatus* capture_status, std::chrono::time_point<std::chrono::high_resolution_clock> &last_connection_time, uint64_t &last_device_list_change_id, int &connection_try_backoff) {
+	if(capture_status->connected || (!shared_data->periodic_connection_try)) {
+		connection_try_backoff = 1;
+		return false;
+	}
+	// Trying now would only fail, and waste the device list change
+	if(!capture_status->close_success)
 		return false;
 
 	auto curr_time = std::chrono::high_resolution_clock::now();
 	const std::chrono::duration<double> diff = curr_time - last_connection_time;
-	return diff.count() >= PERIOD_CONNECTION_TRY_TIMEOUT;
+	if(diff.count() < PERIOD_CONNECTION_TRY_TIMEOUT)
+		return false;
+	// Listing the devices is slow. Avoid it, unless something changed.
+	uint64_t device_list_change_id = 0;
+	bool is_device_list_tracked = get_device_list_change_id(&device_list_change_id);
+	if(is_device_list_tracked && (device_list_change_id != last_device_list_change_id)) {
+		last_device_list_change_id = device_list_change_id;
+		connection_try_backoff = 1;
+		return true;
+	}
+	double timeout = PERIOD_CONNECTION_TRY_TIMEOUT;
+	if(is_device_list_tracked)
+		timeout = PERIOD_CONNECTION_TRY_UNCHANGED_TIMEOUT;
+	if(diff.count() < (timeout * connection_try_backoff))
+		return false;
+	if(connection_try_backoff < PERIOD_CONNECTION_TRY_MAX_BACKOFF)
+		connection_try_backoff *= 2;
+	return true;
 }
 
-static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data, override_all_data &override_data, volatile bool* can_do_output) {
+static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data, FrameRecorder* recorder, FrameSharedMemory* shared_memory, FrameStreamServer* stream_server, override_all_data &override_data, volatile bool* can_do_output) {
 	VideoOutputData *out_buf;
 	double last_frame_time = 0.0;
+	double last_raw_frame_time = 0.0;
 	FrontendData frontend_data;
 	ConsumerMutex draw_lock;
 	reset_display_data(&frontend_data.display_data);
@@ -681,6 +803,10 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_valid_frame_time = start_time;
 	OutTextData out_text_data;
 	std::chrono::time_point<std::chrono::high_resolution_clock> last_connection_time = std::chrono::high_resolution_clock::now();
+	uint64_t last_device_list_change_id = 0;
+	int connection_try_backoff = 1;
+	IdleState idle_state;
+	IdleBackoff idle_backoff(IDLE_MIN_WAIT, IDLE_MAIN_LOOP_MAX_WAIT);
 	int ret_val = 0;
 	int poll_timeout = 0;
 	const bool endianness = is_big_endian();
@@ -729,6 +855,7 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 		check_for_first_connection(did_first_connection, start_time, capture_data, &frontend_data, force_cc_disables, override_data, out_text_data, ret_val, last_connection_time);
 		if(!capture_data->status.running)
 			break;
+		publish_capture_status_snapshot(&capture_data->status);
 
 		bool polled = false;
 		bool poll_everything = true;
@@ -745,10 +872,18 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 		bool is_connected = capture_data->status.connected;
 		if(is_connected != last_connected) {
 			update_connected_specific_settings(&frontend_data, capture_data->status.device);
+			if(is_connected) {
+				capture_data->status.connection_wait.unlock();
+				recorder->push_device_info(&capture_data->status.device);
+				shared_memory->push_device_info(&capture_data->status.device);
+				stream_server->push_device_info(&capture_data->status.device);
+			}
 			no_data_consecutive = 0;
 			last_valid_frame_time = std::chrono::high_resolution_clock::now();
 		}
 		last_connected = is_connected;
+		// The capture thread backs off from the same moment
+		double idle_wait = idle_main_loop_step(idle_state, idle_backoff, is_connected || frontend_data.reload, capture_data->status.idle);
 		if(is_connected) {
 			if(no_data_consecutive > NO_DATA_CONSECUTIVE_THRESHOLD)
 				no_data_consecutive = NO_DATA_CONSECUTIVE_THRESHOLD;
@@ -760,6 +895,7 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 			CaptureDataSingleBuffer* data_buffer = capture_data->data_buffers.GetReaderBuffer(CAPTURE_READER_VIDEO);
 			if(data_buffer != NULL) {
 				last_frame_time = data_buffer->time_in_buf;
+				last_raw_frame_time = data_buffer->raw_time_in_buf;
 				if(data_buffer->read >= get_video_in_size(capture_data, data_buffer->is_3d, data_buffer->should_be_3d, data_buffer->buffer_video_data_type)) {
 					if(capture_data->status.cooldown_curr_in || (!capture_data->status.connected))
 						blank_out = true;
@@ -768,6 +904,12 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 						bool conversion_success = convertVideoToOutput(out_buf, endianness, data_buffer, &capture_data->status, frontend_data.display_data.interleaved_3d);
 						if(!conversion_success)
 							UpdateOutText(out_text_data, "", "Video conversion failed...", TEXT_KIND_NORMAL);
+						else {
+							bool enabled_3d = get_capture_status_snapshot(&capture_data->status).enabled_3d;
+							recorder->push_video(out_buf, video_data_type, enabled_3d, frontend_data.display_data.interleaved_3d);
+							shared_memory->push_video(out_buf, video_data_type, enabled_3d, frontend_data.display_data.interleaved_3d);
+							stream_server->push_video(out_buf, video_data_type, enabled_3d, frontend_data.display_data.interleaved_3d);
+						}
 					}
 					last_valid_frame_time = std::chrono::high_resolution_clock::now();
 					no_data_consecutive = 0;
@@ -789,12 +931,13 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 			last_connection_time = std::chrono::high_resolution_clock::now();
 		}
 		else {
-			default_sleep();
+			default_sleep((float)(idle_wait * 1000.0));
 			blank_out = true;
 		}
 
 		if(blank_out) {
 			last_frame_time = 0.0;
+			last_raw_frame_time = 0.0;
 			chosen_buf = NULL;
 		}
 
@@ -803,11 +946,13 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 
 		*can_do_output = should_do_output(&frontend_data);
 
-		if(*can_do_output)
-			update_output(&frontend_data, last_frame_time, chosen_buf, video_data_type, update_rendered_buffer);
+		if(*can_do_output && idle_state.should_draw())
+			update_output(&frontend_data, last_frame_time, last_raw_frame_time, chosen_buf, video_data_type, update_rendered_buffer);
 
 		if(!frontend_data.shared_data.input_data.fast_poll)
 			poll_all_windows(&frontend_data, poll_everything, polled);
+		if(top_screen->has_polled_events() || bot_screen->has_polled_events() || joint_screen->has_polled_events())
+			idle_state.activity();
 
 		int load_index = 0;
 		int save_index = 0;
@@ -824,9 +969,13 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 		}
 
 		bool asked_for_connect = top_screen->open_capture() || bot_screen->open_capture() || joint_screen->open_capture();
-		if(asked_for_connect || should_do_periodic_connection_try(&frontend_data.shared_data, capture_data->status.connected, last_connection_time)) {
+		if(did_first_connection && should_do_periodic_connection_try(&frontend_data.shared_data, &capture_data->status, last_connection_time, last_device_list_change_id, connection_try_backoff))
+			start_background_device_listing(capture_data, force_cc_disables);
+		bool periodic_try_ready = is_background_device_listing_done() && (!capture_data->status.connected) && capture_data->status.close_success;
+		if(asked_for_connect || periodic_try_ready) {
 			if(did_first_connection) {
 				capture_data->status.connected = connect(asked_for_connect, capture_data, &frontend_data, force_cc_disables);
+				publish_capture_status_snapshot(&capture_data->status);
 				if(capture_data->status.connected || asked_for_connect)
 					SuccessConnectionOutTextGenerator(out_text_data, capture_data);
 				last_connection_time = std::chrono::high_resolution_clock::now();
@@ -868,6 +1017,7 @@ static int mainVideoOutputCall(AudioData* audio_data, CaptureData* capture_data,
 		bot_screen->process_own_out_text_data();
 		joint_screen->process_own_out_text_data();
 		if((!out_text_data.consumed) && (!frontend_data.reload)) {
+			idle_state.activity();
 			ConsumeOutText(out_text_data, false);
 			top_screen->print_notification(out_text_data.small_text, out_text_data.kind);
 			bot_screen->print_notification(out_text_data.small_text, out_text_data.kind);
@@ -980,14 +1130,25 @@ static bool parse_string_arg(int &index, int argc, char **argv, std::string &tar
 int main(int argc, char **argv) {
 	init_threads();
 	init_start_time();
+	init_thread_scheduling();
 	int page_up_id = -1;
 	int page_down_id = -1;
 	int enter_id = -1;
 	int power_id = -1;
 	bool use_pud_up = true;
+	bool use_gpio_events = true;
 	volatile bool can_do_output = true;
 	bool mono_app_default_value = false;
 	std::string touch_file_path = "";
+	int num_capture_buffers = NUM_CONCURRENT_DATA_BUFFERS;
+	int num_usb_transfers = AUTO_TRANSFERS_IN_FLIGHT;
+	std::string record_path = "";
+	bool record_uncompressed = false;
+	std::string playback_path = "";
+	double playback_speed = 1.0;
+	double playback_start = 0.0;
+	std::string shared_memory_name = "";
+	std::string stream_server_address = "";
 	#ifdef ANDROID_COMPILATION
 		mono_app_default_value = true;
 	#endif
@@ -1050,6 +1211,24 @@ int main(int argc, char **argv) {
 			continue;
 		if(parse_string_arg(i, argc, argv, touch_file_path, "--touch_file"))
 			continue;
+		if(parse_int_arg(i, argc, argv, num_capture_buffers, "--capture_buffers"))
+			continue;
+		if(parse_int_arg(i, argc, argv, num_usb_transfers, "--usb_transfers"))
+			continue;
+		if(parse_string_arg(i, argc, argv, record_path, "--record"))
+			continue;
+		if(parse_existence_arg(i, argv, record_uncompressed, true, "--record_raw"))
+			continue;
+		if(parse_string_arg(i, argc, argv, playback_path, "--playback"))
+			continue;
+		if(parse_double_arg(i, argc, argv, playback_speed, "--playback_speed"))
+			continue;
+		if(parse_double_arg(i, argc, argv, playback_start, "--playback_start"))
+			continue;
+		if(parse_string_arg(i, argc, argv, shared_memory_name, "--shm_output"))
+			continue;
+		if(parse_string_arg(i, argc, argv, stream_server_address, "--stream_server"))
+			continue;
 		#ifdef RASPI
 		if(parse_int_arg(i, argc, argv, page_up_id, "--pi_select"))
 			continue;
@@ -1061,6 +1240,8 @@ int main(int argc, char **argv) {
 			continue;
 		if(parse_existence_arg(i, argv, use_pud_up, false, "--pi_pud_down"))
 			continue;
+		if(parse_existence_arg(i, argv, use_gpio_events, false, "--pi_poll"))
+			continue;
 		#endif
 		std::string mono_app_action_str = "Enables";
 		std::string default_mono_app_strn = "Disabled";
@@ -1106,31 +1287,79 @@ int main(int argc, char **argv) {
 		ActualConsoleOutText("  --no_auto_save    Disables automatic save when closing the software.");
 		ActualConsoleOutText("  --list_joysticks  Prints a list of all the detected joysticks.");
 		ActualConsoleOutText("  --touch_file      Path of a file that the program should create when exiting.");
+		ActualConsoleOutText("  --capture_buffers Number of buffers used for the captured data. " + std::to_string(NUM_CONCURRENT_DATA_BUFFERS) + " - " + std::to_string(MAX_CONCURRENT_DATA_BUFFERS));
+		ActualConsoleOutText("                    More buffers use more memory. " + std::to_string(NUM_CONCURRENT_DATA_BUFFERS) + " by default.");
+		ActualConsoleOutText("  --usb_transfers   Number of USB transfers kept running at the same time.");
+		ActualConsoleOutText("                    More are more robust, less have lower latency.");
+		ActualConsoleOutText("                    " + std::to_string(MIN_TRANSFERS_IN_FLIGHT) + " - " + std::to_string(NUM_CONCURRENT_DATA_BUFFER_WRITERS) + ", or 0 for automatic. 0 by default.");
+		ActualConsoleOutText("                    Overrides the per-device value, in device_specific_configs.");
+		ActualConsoleOutText("                    Not used by the Optimize and Partner CTR devices.");
+		ActualConsoleOutText("  --record          Path of a file to record the video and audio to.");
+		ActualConsoleOutText("                    Frames are compressed losslessly.");
+		ActualConsoleOutText("  --record_raw      Disables the compression of the recorded frames.");
+		ActualConsoleOutText("  --playback        Path of a recording to show as if it was a device.");
+		ActualConsoleOutText("  --playback_speed  Speed multiplier for the playback. 1.0 by default.");
+		ActualConsoleOutText("                    0 plays the frames as fast as possible.");
+		ActualConsoleOutText("  --playback_start  Seconds into the recording to start the playback from.");
+		ActualConsoleOutText("                    Playback goes back there when the recording ends.");
+		ActualConsoleOutText("  --shm_output      Name of a shared memory area to output the frames to.");
+		ActualConsoleOutText("                    Lets other programs read them directly.");
+		ActualConsoleOutText("                    Use " + std::string(SHARED_MEMORY_DEFAULT_NAME) + " if unsure.");
+		ActualConsoleOutText("  --stream_server   Streams the frames and the audio to local clients.");
+		ActualConsoleOutText("                    Takes a TCP port on localhost, or the path of a");
+		ActualConsoleOutText("                    Unix socket (not on Windows).");
 		#ifdef RASPI
 		ActualConsoleOutText("  --pi_select ID    Specifies ID for the select GPIO button.");
 		ActualConsoleOutText("  --pi_menu ID      Specifies ID for the menu GPIO button.");
 		ActualConsoleOutText("  --pi_enter ID     Specifies ID for the enter GPIO button.");
 		ActualConsoleOutText("  --pi_power ID     Specifies ID for the poweroff GPIO button.");
 		ActualConsoleOutText("  --pi_pud_down     Sets the pull-up GPIO mode to down. Default is up.");
+		ActualConsoleOutText("  --pi_poll         Polls the GPIO buttons, instead of waiting for");
+		ActualConsoleOutText("                    their events.");
 		#endif
 		return 0;
 	}
 	create_out_folder();
-	init_extra_buttons_poll(page_up_id, page_down_id, enter_id, power_id, use_pud_up);
+	init_extra_buttons_poll(page_up_id, page_down_id, enter_id, power_id, use_pud_up, use_gpio_events);
 	AudioData audio_data;
 	audio_data.reset();
 	CaptureData* capture_data = new CaptureData;
+	capture_data->data_buffers.SetNumBuffers(num_capture_buffers);
+	capture_data->status.transfers_in_flight.set_requested(num_usb_transfers);
+	set_playback_recording(playback_path, playback_speed, playback_start);
 	capture_init();
+	FrameRecorder recorder;
+	if((record_path != "") && (!recorder.start(record_path, !record_uncompressed)))
+		ActualConsoleOutTextError("Could not start recording to " + record_path);
+	FrameSharedMemory shared_memory;
+	if((shared_memory_name != "") && (!shared_memory.start(shared_memory_name)))
+		ActualConsoleOutTextError("Could not create the shared memory output " + shared_memory_name);
+	FrameStreamServer stream_server;
+	if((stream_server_address != "") && (!stream_server.start(stream_server_address)))
+		ActualConsoleOutTextError("Could not start the stream server on " + stream_server_address);
 
 	std::thread capture_thread(captureCall, capture_data);
 	std::thread audio_thread;
 	if(!override_data.no_audio)
-		audio_thread = std::thread(soundCall, &audio_data, capture_data, &can_do_output);
-
-	int ret_val = mainVideoOutputCall(&audio_data, capture_data, override_data, &can_do_output);
+		audio_thread = std::thread(soundCall, &audio_data, capture_data, &recorder, &stream_server, &can_do_output);
+	std::thread input_thread;
+	bool has_input_thread = are_extra_buttons_usable();
+	if(has_input_thread)
+		input_thread = std::thread(inputCall, capture_data);
+
+	int ret_val = mainVideoOutputCall(&audio_data, capture_data, &recorder, &shared_memory, &stream_server, override_data, &can_do_output);
+	// Do not wait for the idle capture thread to wake up by itself
+	capture_data->status.connection_wait.unlock();
+	if(has_input_thread) {
+		extra_buttons_thread_wake();
+		input_thread.join();
+	}
 	if(!override_data.no_audio)
 		audio_thread.join();
 	capture_thread.join();
+	recorder.stop();
+	shared_memory.stop();
+	stream_server.stop();
 	delete capture_data;
 	end_extra_buttons_poll();
 	capture_close();
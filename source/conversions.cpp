@@ -6,6 +6,10 @@
 #include "usb_is_device_acquisition.hpp"
 #include "cypress_optimize_3ds_acquisition.hpp"
 #include "cypress_partner_ctr_acquisition.hpp"
+#include "recording_playback_acquisition.hpp"
+#include "FrameRecorder.hpp"
+#include "conversions_audio_optimize.hpp"
+#include "conversions_video_is_twl.hpp"
 
 #include <cstring>
 
@@ -19,8 +23,6 @@
 #define INTERLEAVED_RGB888_DATA_SIZE sizeof(uint16_t)
 #define INTERLEAVED_RGB888_TOTAL_SIZE (INTERLEAVED_RGB888_PIXEL_SIZE * INTERLEAVED_RGB888_PIXEL_NUM / INTERLEAVED_RGB888_DATA_SIZE)
 
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3D(CaptureReceived* buffer, bool is_rgb888, uint16_t column);
-
 struct interleaved_rgb565_pixels {
 	uint16_t pixels[INTERLEAVED_RGB565_TOTAL_SIZE][2];
 };
@@ -38,32 +40,6 @@ struct ALIGNED(INTERLEAVED_RGB888_PIXEL_NUM) deinterleaved_rgb888_u16_pixels {
 	uint16_t pixels[INTERLEAVED_RGB888_TOTAL_SIZE];
 };
 
-struct twl_16bit_pixels {
-	uint16_t first_r : 5;
-	uint16_t first_g : 6;
-	uint16_t first_b : 5;
-	uint16_t second_r : 5;
-	uint16_t second_g : 6;
-	uint16_t second_b : 5;
-	uint16_t third_r : 5;
-	uint16_t third_g : 6;
-	uint16_t third_b : 5;
-	uint16_t fourth_r : 5;
-	uint16_t fourth_g : 6;
-	uint16_t fourth_b : 5;
-};
-
-struct twl_2bit_pixels {
-	uint8_t first_r : 1;
-	uint8_t first_b : 1;
-	uint8_t second_r : 1;
-	uint8_t second_b : 1;
-	uint8_t third_r : 1;
-	uint8_t third_b : 1;
-	uint8_t fourth_r : 1;
-	uint8_t fourth_b : 1;
-};
-
 // Optimized de-interleave methods...
 
 static inline uint16_t _reverse_endianness(uint16_t data) {
@@ -396,14 +372,6 @@ static inline void usb_oldDSconvertVideoToOutputHalfLineDirectOptBE(USBOldDSCapt
 	usb_rgb565convertInterleaveVideoToOutputDirectOptBE(out_ptr_top, out_ptr_bottom, in_ptr, halfline_iters, input_halfline, output_halfline);
 }
 
-static inline bool usb_OptimizeHasExtraHeaderSoundData(USB3DSOptimizeHeaderSoundData* header_sound_data) {
-	// The macos compiler requires this... :/
-	uint16_t base_data = read_le16((uint8_t*)&header_sound_data->header_info.column_info);
-	USB3DSOptimizeColumnInfo column_info;
-	column_info.has_extra_header_data_2d_only = (base_data >> 15) & 1;
-	return column_info.has_extra_header_data_2d_only;
-}
-
 static inline uint16_t usb_OptimizeGetDataBufferNumber(USB3DSOptimizeHeaderSoundData* header_sound_data) {
 	// The macos compiler requires this... :/
 	uint16_t base_data = read_le16((uint8_t*)&header_sound_data->header_info.column_info);
@@ -963,34 +931,7 @@ static void usb_is_device_convertVideoToOutput(CaptureReceived *p_in, VideoOutpu
 		memcpy((uint8_t*)&p_out->bgr_video_output_data.screen_data[out_start_pos], p_in->is_nitro_capture_received.video_in.screen_data, (size_t)(num_pixels * sizeof(VideoPixelBGR)));
 		return;
 	}
-	ISTWLCaptureVideoInputData* data = &p_in->is_twl_capture_received.video_capture_in.video_in;
-	twl_16bit_pixels* data_16_bit = (twl_16bit_pixels*)data->screen_data;
-	twl_2bit_pixels* data_2_bit = (twl_2bit_pixels*)data->bit_6_rb_screen_data;
-	const int num_pixels_struct = sizeof(twl_16bit_pixels) / sizeof(uint16_t);
-	const int num_screens = 2;
-	for(int i = 0; i < HEIGHT_DS; i++) {
-		for(int j = 0; j < num_screens; j++) {
-			size_t out_pos = ((num_screens - 1 - j) * (WIDTH_DS * HEIGHT_DS)) + (i * WIDTH_DS);
-			for(int u = 0; u < (WIDTH_DS / num_pixels_struct); u++) {
-				uint8_t pixels[num_pixels_struct][3];
-				size_t index = (((i * num_screens * WIDTH_DS) + (j * WIDTH_DS)) / num_pixels_struct) + u;
-				pixels[0][0] = (data_16_bit[index].first_r << 1) | (data_2_bit[index].first_r);
-				pixels[0][1] = data_16_bit[index].first_g;
-				pixels[0][2] = (data_16_bit[index].first_b << 1) | (data_2_bit[index].first_b);
-				pixels[1][0] = (data_16_bit[index].second_r << 1) | (data_2_bit[index].second_r);
-				pixels[1][1] = data_16_bit[index].second_g;
-				pixels[1][2] = (data_16_bit[index].second_b << 1) | (data_2_bit[index].second_b);
-				pixels[2][0] = (data_16_bit[index].third_r << 1) | (data_2_bit[index].third_r);
-				pixels[2][1] = data_16_bit[index].third_g;
-				pixels[2][2] = (data_16_bit[index].third_b << 1) | (data_2_bit[index].third_b);
-				pixels[3][0] = (data_16_bit[index].fourth_r << 1) | (data_2_bit[index].fourth_r);
-				pixels[3][1] = data_16_bit[index].fourth_g;
-				pixels[3][2] = (data_16_bit[index].fourth_b << 1) | (data_2_bit[index].fourth_b);
-				for(int k = 0; k < num_pixels_struct; k++)
-					to_8_bit_6((uint8_t*)&p_out->rgb_video_output_data.screen_data[out_pos + (u * num_pixels_struct) + k], pixels[k]);
-			}
-		}
-	}
+	convertISTWLVideoToOutput(&p_in->is_twl_capture_received.video_capture_in.video_in, &p_out->rgb_video_output_data);
 }
 
 static PartnerCTRCaptureCommand read_partner_ctr_base_command(uint8_t* data) {
@@ -1102,7 +1043,7 @@ static bool is_valid_frame_partner_ctr(uint8_t* data, bool enabled_3d, uint8_t**
 	return has_top && has_top_second && has_bottom;
 }
 
-static void convert_partner_ctr_screen_x(uint8_t* screen_ptr, VideoOutputData *p_out) {
+static void convert_partner_ctr_screen_x(uint8_t* screen_ptr, uint8_t* data_end, VideoOutputData *p_out) {
 	if(screen_ptr == NULL)
 		return;
 
@@ -1110,6 +1051,13 @@ static void convert_partner_ctr_screen_x(uint8_t* screen_ptr, VideoOutputData *p
 	VideoPixelRGB* out_screen_data = &p_out->rgb_video_output_data.screen_data[0];
 	screen_ptr += get_partner_ctr_size_command_header(read_command);
 
+	// The payload sizes come from the device. Never read past the frame
+	size_t screen_size = TOP_WIDTH_3DS * HEIGHT_3DS * sizeof(VideoPixelRGB);
+	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN)
+		screen_size = BOT_WIDTH_3DS * HEIGHT_3DS * sizeof(VideoPixelRGB);
+	if((screen_ptr > data_end) || (((size_t)(data_end - screen_ptr)) < screen_size))
+		return;
+
 	if(read_command.command == PARTNER_CTR_CAPTURE_COMMAND_BOT_SCREEN) {
 		for(size_t i = 0; i < HEIGHT_3DS; i++)
 			memcpy(&out_screen_data[i * TOP_WIDTH_3DS], screen_ptr + (i * BOT_WIDTH_3DS * sizeof(VideoPixelRGB)), BOT_WIDTH_3DS * sizeof(VideoPixelRGB));
@@ -1139,8 +1087,9 @@ static void usb_partner_ctr_interleave_3d(VideoOutputData *p_out) {
 	}
 }
 
-static void usb_partner_ctr_convertVideoToOutput(CaptureReceived *p_in, VideoOutputData *p_out, bool enabled_3d, bool interleaved_3d, bool requested_3d) {
+static void usb_partner_ctr_convertVideoToOutput(CaptureReceived *p_in, size_t read_size, VideoOutputData *p_out, bool enabled_3d, bool interleaved_3d, bool requested_3d) {
 	uint8_t* data = (uint8_t*)p_in;
+	uint8_t* data_end = data + read_size;
 	uint8_t* first_screen = NULL;
 	uint8_t* second_screen = NULL;
 	uint8_t* third_screen = NULL;
@@ -1148,9 +1097,9 @@ static void usb_partner_ctr_convertVideoToOutput(CaptureReceived *p_in, VideoOut
 	if(!is_valid_frame_partner_ctr(data, enabled_3d, &first_screen, &second_screen, &third_screen))
 		return;
 
-	convert_partner_ctr_screen_x(first_screen, p_out);
-	convert_partner_ctr_screen_x(second_screen, p_out);
-	convert_partner_ctr_screen_x(third_screen, p_out);
+	convert_partner_ctr_screen_x(first_screen, data_end, p_out);
+	convert_partner_ctr_screen_x(second_screen, data_end, p_out);
+	convert_partner_ctr_screen_x(third_screen, data_end, p_out);
 
 	if(requested_3d && (!enabled_3d))
 		memcpy(&p_out->rgb_video_output_data.screen_data[2 * TOP_WIDTH_3DS * HEIGHT_3DS], &p_out->rgb_video_output_data.screen_data[TOP_WIDTH_3DS * HEIGHT_3DS], TOP_WIDTH_3DS * HEIGHT_3DS * sizeof(VideoPixelRGB));
@@ -1159,8 +1108,22 @@ static void usb_partner_ctr_convertVideoToOutput(CaptureReceived *p_in, VideoOut
 		usb_partner_ctr_interleave_3d(p_out);
 }
 
+// Recordings already hold the converted frames.
+// They can only be shown the same way they were recorded.
+static bool playback_convertVideoToOutput(CaptureReceived *p_in, VideoOutputData *p_out, InputVideoDataType video_data_type, bool requested_3d, bool interleaved_3d) {
+	uint16_t format = playback_get_frame_format(p_in);
+	bool is_data_3d = (format & RECORDING_VIDEO_FORMAT_3D) != 0;
+	bool is_data_interleaved_3d = (format & RECORDING_VIDEO_FORMAT_INTERLEAVED_3D) != 0;
+	if(is_data_3d != requested_3d)
+		return false;
+	if(is_data_3d && (is_data_interleaved_3d != interleaved_3d))
+		return false;
+	memcpy(p_out, ((uint8_t*)p_in) + PLAYBACK_FRAME_HEADER_SIZE, get_recording_video_raw_size(video_data_type));
+	return true;
+}
+
 bool convertVideoToOutput(VideoOutputData *p_out, const bool is_big_endian, CaptureDataSingleBuffer* data_buffer, CaptureStatus* status, bool interleaved_3d) {
-	CaptureReceived* p_in = (CaptureReceived*)(((uint8_t*)&data_buffer->capture_buf) + data_buffer->unused_offset);
+	CaptureReceived* p_in = (CaptureReceived*)(((uint8_t*)data_buffer->capture_buf) + data_buffer->unused_offset);
 	bool converted = false;
 	CaptureDevice* chosen_device = &status->device;
 	bool is_data_3d = data_buffer->is_3d;
@@ -1211,164 +1174,48 @@ bool convertVideoToOutput(VideoOutputData *p_out, const bool is_big_endian, Capt
 	#endif
 	#ifdef USE_PARTNER_CTR
 	if(status->device.cc_type == CAPTURE_CONN_PARTNER_CTR) {
-		usb_partner_ctr_convertVideoToOutput(p_in, p_out, is_data_3d, interleaved_3d, is_3d_requested);
+		usb_partner_ctr_convertVideoToOutput(p_in, data_buffer->read, p_out, is_data_3d, interleaved_3d, is_3d_requested);
 		converted = true;
 	}
 	#endif
+	if(status->device.cc_type == CAPTURE_CONN_PLAYBACK)
+		converted = playback_convertVideoToOutput(p_in, p_out, video_data_type, is_3d_requested, interleaved_3d);
 	return converted;
 }
 
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
-	if(!is_rgb888)
-		return &buffer->cypress_optimize_received_565.columns_data[column].header_sound;
-	return &buffer->cypress_optimize_received_888.columns_data[column].header_sound;
-}
-
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DSExtraHeader(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
-	if(!is_rgb888)
-		return &buffer->cypress_optimize_received_565_extra_header.columns_data[column].header_sound;
-	return &buffer->cypress_optimize_received_888_extra_header.columns_data[column].header_sound;
-}
-
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3D(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
-	if(!is_rgb888) {
-		int target_column = column / 2;
-		if((column % 2) == 0)
-			return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].top_r_screen_column.header_sound;
-		return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].bot_top_l_screens_column.header_sound;
+// Endianness, L/R inversion and mono mixing, all in the same pass
+static void copyAudioSamplesLEOrigin(std::int16_t *p_out, uint8_t* src, size_t num_samples, const bool is_big_endian, bool invert_lr, bool is_mono) {
+	if((!invert_lr) && (!is_mono)) {
+		memcpy_data_u16le_origin((uint16_t*)p_out, src, num_samples, is_big_endian);
+		return;
+	}
+	for(size_t i = 0; i < (num_samples / 2); i++) {
+		std::int16_t sample_l = (std::int16_t)((src[(i * 4) + 1] << 8) | src[i * 4]);
+		std::int16_t sample_r = (std::int16_t)((src[(i * 4) + 3] << 8) | src[(i * 4) + 2]);
+		if(invert_lr) {
+			std::int16_t tmp_sample = sample_l;
+			sample_l = sample_r;
+			sample_r = tmp_sample;
+		}
+		if(is_mono) {
+			sample_l = mix_audio_samples_mono(sample_l, sample_r);
+			sample_r = sample_l;
+		}
+		p_out[i * 2] = sample_l;
+		p_out[(i * 2) + 1] = sample_r;
 	}
-	return &buffer->cypress_optimize_received_888_3d.columns_data[column / 2][column % 2].header_sound;
-}
-
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3DForced2D(CaptureReceived* buffer, uint16_t column) {
-	return &buffer->cypress_optimize_received_888_3d_2d.columns_data[column].header_sound;
-}
-
-static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3DExtraHeader(CaptureReceived* buffer, bool is_rgb888) {
-	if(!is_rgb888)
-		return &buffer->cypress_optimize_received_565_3d.bottom_only_column.header_sound;
-	return &buffer->cypress_optimize_received_888_3d.bottom_only_column.header_sound;
-}
-
-static inline uint16_t read_sample_indexLE(USB3DSOptimizeSingleSoundData* sample) {
-	return sample->sample_index % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
-}
-
-static inline uint16_t read_sample_indexBE(USB3DSOptimizeSingleSoundData* sample) {
-	return _reverse_endianness(sample->sample_index) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
 }
 
-static inline void copyAudioFromSoundDataOptimize3DSLE(std::int16_t *p_out, USB3DSOptimizeSingleSoundData* sample, uint64_t& num_inserted, int& last_inserted_index) {
-	uint16_t read_index = read_sample_indexLE(sample) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
-	if(read_index == last_inserted_index)
-		return;
-	p_out[num_inserted * 2] = sample->sample_l;
-	p_out[(num_inserted * 2) + 1] = sample->sample_r;
-	num_inserted += 1;
-	last_inserted_index = read_index;
+// For when the stereo samples are needed too, before they are mixed
+void mixAudioOutputToMono(std::int16_t *p_out, uint64_t n_samples) {
+	for(uint64_t i = 0; i < (n_samples / 2); i++) {
+		std::int16_t sample = mix_audio_samples_mono(p_out[i * 2], p_out[(i * 2) + 1]);
+		p_out[i * 2] = sample;
+		p_out[(i * 2) + 1] = sample;
+	}
 }
 
-static inline void copyAudioFromSoundDataOptimize3DSBE(std::int16_t *p_out, USB3DSOptimizeSingleSoundData* sample, uint64_t& num_inserted, int& last_inserted_index) {
-	uint16_t read_index = read_sample_indexBE(sample) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
-	if(read_index == last_inserted_index)
-		return;
-	p_out[num_inserted * 2] = _reverse_endianness(sample->sample_l);
-	p_out[(num_inserted * 2) + 1] = _reverse_endianness(sample->sample_r);
-	num_inserted += 1;
-	last_inserted_index = read_index;
-}
-
-static void copyAudioOptimize3DSLE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888, bool force_check_extra_header) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS(buffer, is_rgb888, i);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	USB3DSOptimizeHeaderSoundData* initial_column_data = getAudioHeaderPtrOptimize3DS(buffer, is_rgb888, 0);
-	if(force_check_extra_header || usb_OptimizeHasExtraHeaderSoundData(initial_column_data)) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DSExtraHeader(buffer, is_rgb888, TOP_WIDTH_3DS);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void copyAudioOptimize3DS3DLE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < TOP_WIDTH_3DS * 2; i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3D(buffer, is_rgb888, i);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3DExtraHeader(buffer, is_rgb888);
-	copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-	copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void copyAudioOptimize3DS3DForced2DLE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3DForced2D(buffer, i);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSLE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void copyAudioOptimize3DSBE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888, bool force_check_extra_header) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < TOP_WIDTH_3DS; i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS(buffer, is_rgb888, i);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	USB3DSOptimizeHeaderSoundData* initial_column_data = getAudioHeaderPtrOptimize3DS(buffer, is_rgb888, 0);
-	if(force_check_extra_header || usb_OptimizeHasExtraHeaderSoundData(initial_column_data)) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DSExtraHeader(buffer, is_rgb888, TOP_WIDTH_3DS);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void copyAudioOptimize3DS3DBE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < TOP_WIDTH_3DS * 2; i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3D(buffer, is_rgb888, i);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3DExtraHeader(buffer, is_rgb888);
-	copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-	copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void copyAudioOptimize3DS3DForced2DBE(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer) {
-	uint64_t num_inserted = 0;
-	int last_inserted_index = last_buffer_index;
-	for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++) {
-		USB3DSOptimizeHeaderSoundData* curr_column_data = getAudioHeaderPtrOptimize3DS3DForced2D(buffer, i);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[0], num_inserted, last_inserted_index);
-		copyAudioFromSoundDataOptimize3DSBE(p_out, &curr_column_data->samples[1], num_inserted, last_inserted_index);
-	}
-	last_buffer_index = last_inserted_index;
-	n_samples = num_inserted * 2;
-}
-
-static void usb_partner_ctr_copyBufferToAudio(uint8_t* buffer_ptr, std::int16_t *p_out, uint64_t &n_samples, const bool is_big_endian) {
+static void usb_partner_ctr_copyBufferToAudio(uint8_t* buffer_ptr, std::int16_t *p_out, uint64_t &n_samples, const bool is_big_endian, bool is_mono) {
 	uint8_t* audio_buffer_ptr = NULL;
 	PartnerCTRCaptureCommand read_command = read_partner_ctr_base_command(buffer_ptr);
 
@@ -1377,7 +1224,7 @@ static void usb_partner_ctr_copyBufferToAudio(uint8_t* buffer_ptr, std::int16_t
 			return;
 		audio_buffer_ptr = buffer_ptr + get_partner_ctr_size_command_header(read_command);
 
-		memcpy_data_u16le_origin((uint16_t*)p_out + n_samples, audio_buffer_ptr, (size_t)read_command.payload_size / 2, is_big_endian);
+		copyAudioSamplesLEOrigin(p_out + n_samples, audio_buffer_ptr, (size_t)read_command.payload_size / 2, is_big_endian, false, is_mono);
 
 		n_samples += read_command.payload_size / 2;
 
@@ -1386,14 +1233,14 @@ static void usb_partner_ctr_copyBufferToAudio(uint8_t* buffer_ptr, std::int16_t
 	}
 }
 
-static void usb_partner_ctr_copyBufferAfterCommandToAudio(uint8_t* buffer_ptr, std::int16_t *p_out, uint64_t &n_samples, const bool is_big_endian) {
+static void usb_partner_ctr_copyBufferAfterCommandToAudio(uint8_t* buffer_ptr, std::int16_t *p_out, uint64_t &n_samples, const bool is_big_endian, bool is_mono) {
 	if(buffer_ptr == NULL)
 		return;
 
-	usb_partner_ctr_copyBufferToAudio(get_ptr_next_command_partner_ctr(buffer_ptr), p_out, n_samples, is_big_endian);
+	usb_partner_ctr_copyBufferToAudio(get_ptr_next_command_partner_ctr(buffer_ptr), p_out, n_samples, is_big_endian, is_mono);
 }
 
-static void usb_partner_ctr_convertAudioToOutput(CaptureReceived *p_in, std::int16_t *p_out, uint64_t &n_samples, bool enabled_3d, const bool is_big_endian) {
+static void usb_partner_ctr_convertAudioToOutput(CaptureReceived *p_in, std::int16_t *p_out, uint64_t &n_samples, bool enabled_3d, const bool is_big_endian, bool is_mono) {
 	uint8_t* data = (uint8_t*)p_in;
 	uint8_t* first_screen = NULL;
 	uint8_t* second_screen = NULL;
@@ -1403,13 +1250,13 @@ static void usb_partner_ctr_convertAudioToOutput(CaptureReceived *p_in, std::int
 	if(!is_valid_frame_partner_ctr(data, enabled_3d, &first_screen, &second_screen, &third_screen))
 		return;
 
-	usb_partner_ctr_copyBufferToAudio(data, p_out, n_samples, is_big_endian);
-	usb_partner_ctr_copyBufferAfterCommandToAudio(first_screen, p_out, n_samples, is_big_endian);
-	usb_partner_ctr_copyBufferAfterCommandToAudio(second_screen, p_out, n_samples, is_big_endian);
-	usb_partner_ctr_copyBufferAfterCommandToAudio(third_screen, p_out, n_samples, is_big_endian);
+	usb_partner_ctr_copyBufferToAudio(data, p_out, n_samples, is_big_endian, is_mono);
+	usb_partner_ctr_copyBufferAfterCommandToAudio(first_screen, p_out, n_samples, is_big_endian, is_mono);
+	usb_partner_ctr_copyBufferAfterCommandToAudio(second_screen, p_out, n_samples, is_big_endian, is_mono);
+	usb_partner_ctr_copyBufferAfterCommandToAudio(third_screen, p_out, n_samples, is_big_endian, is_mono);
 }
 
-bool convertAudioToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, const bool is_big_endian, CaptureDataSingleBuffer* data_buffer, CaptureStatus* status) {
+bool convertAudioToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, const bool is_big_endian, bool is_mono, CaptureDataSingleBuffer* data_buffer, CaptureStatus* status) {
 	if(!status->device.has_audio) {
 		n_samples = 0;
 		return true;
@@ -1417,7 +1264,7 @@ bool convertAudioToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &la
 	bool is_data_3d = data_buffer->is_3d;
 	bool should_be_3d = data_buffer->should_be_3d;
 	InputVideoDataType video_data_type = data_buffer->buffer_video_data_type;
-	CaptureReceived* p_in = (CaptureReceived*)(((uint8_t*)&data_buffer->capture_buf) + data_buffer->unused_offset);
+	CaptureReceived* p_in = (CaptureReceived*)(((uint8_t*)data_buffer->capture_buf) + data_buffer->unused_offset);
 	uint8_t* base_ptr = NULL;
 	#ifdef USE_FTD3
 	if(status->device.cc_type == CAPTURE_CONN_FTD3) {
@@ -1441,20 +1288,17 @@ bool convertAudioToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &la
 	#endif
 	#ifdef USE_IS_DEVICES_USB
 	if(status->device.cc_type == CAPTURE_CONN_IS_NITRO) {
-		base_ptr = (uint8_t*)p_in->is_twl_capture_received.audio_capture_in;
-		uint16_t* base_ptr16 = (uint16_t*)base_ptr;
-		size_t size_real = (size_t)(n_samples * 2);
-		size_t size_packet_converted = sizeof(ISTWLCaptureSoundData);
-		size_t num_packets = size_real / size_packet_converted;
-		for(size_t i = 0; i < num_packets; i++)
-			memcpy(base_ptr + (i * size_packet_converted), ((uint8_t*)&p_in->is_twl_capture_received.audio_capture_in[i].sound_data.data), size_packet_converted);
-		// Inverted L and R...
-		for(uint64_t i = 0; i < n_samples; i++) {
-			uint16_t r_sample = base_ptr16[(i * 2)];
-			base_ptr16[(i * 2)] = base_ptr16[(i * 2) + 1];
-			base_ptr16[(i * 2) + 1] = r_sample;
+		// Skip the time of each packet. Also, inverted L and R...
+		size_t num_samples_left = (size_t)n_samples;
+		for(size_t i = 0; (num_samples_left > 0) && (i < TWL_CAPTURE_MAX_SAMPLES_CHUNK_NUM); i++) {
+			size_t num_samples_packet = TWL_CAPTURE_SAMPLES_IN;
+			if(num_samples_packet > num_samples_left)
+				num_samples_packet = num_samples_left;
+			copyAudioSamplesLEOrigin(p_out + (i * TWL_CAPTURE_SAMPLES_IN), (uint8_t*)p_in->is_twl_capture_received.audio_capture_in[i].sound_data.data, num_samples_packet, is_big_endian, true, is_mono);
+			num_samples_left -= num_samples_packet;
 		}
-			
+		n_samples -= num_samples_left;
+		return true;
 	}
 	#endif
 	#ifdef USE_CYPRESS_OPTIMIZE
@@ -1467,38 +1311,22 @@ bool convertAudioToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &la
 			n_samples = 0;
 			return true;
 		}
-		if(is_big_endian) {
-			if(is_data_3d)
-				copyAudioOptimize3DS3DBE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf, is_rgb888);
-			else {
-				if(should_be_3d && is_rgb888)
-					copyAudioOptimize3DS3DForced2DBE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf);
-				else
-					copyAudioOptimize3DSBE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf, is_rgb888, is_device_optimize_old_fw(&status->device));
-			}
-		}
-		else {
-			if(is_data_3d)
-				copyAudioOptimize3DS3DLE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf, is_rgb888);
-			else {
-				if(should_be_3d && is_rgb888)
-					copyAudioOptimize3DS3DForced2DLE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf);
-				else
-					copyAudioOptimize3DSLE(p_out, n_samples, last_buffer_index, &data_buffer->capture_buf, is_rgb888, is_device_optimize_old_fw(&status->device));
-			}
-		}
+		bool is_forced_2d = (!is_data_3d) && should_be_3d && is_rgb888;
+		copyAudioOptimize3DSToOutput(p_out, n_samples, last_buffer_index, data_buffer->capture_buf, is_rgb888, is_data_3d, is_forced_2d, is_device_optimize_old_fw(&status->device), is_mono);
 		return true;
 	}
 	#endif
 	#ifdef USE_PARTNER_CTR
 	if(status->device.cc_type == CAPTURE_CONN_PARTNER_CTR) {
-		usb_partner_ctr_convertAudioToOutput(p_in, p_out, n_samples, is_data_3d, is_big_endian);
+		usb_partner_ctr_convertAudioToOutput(p_in, p_out, n_samples, is_data_3d, is_big_endian, is_mono);
 		return true;
 	}
 	#endif
+	if(status->device.cc_type == CAPTURE_CONN_PLAYBACK)
+		base_ptr = ((uint8_t*)p_in) + PLAYBACK_FRAME_HEADER_SIZE + get_recording_video_raw_size(video_data_type);
 	if(base_ptr == NULL)
 		return false;
-	memcpy_data_u16le_origin((uint16_t*)p_out, base_ptr, (size_t)n_samples, is_big_endian);
+	copyAudioSamplesLEOrigin(p_out, base_ptr, (size_t)n_samples, is_big_endian, false, is_mono);
 	return true;
 }
 
@@ -1642,3 +1470,51 @@ void manualConvertOutputToRGBA(VideoOutputData* src, VideoOutputData* dst, size_
 			break;
 	}
 }
+
+static size_t get_output_pixel_size(InputVideoDataType video_data_type) {
+	switch(video_data_type) {
+		case VIDEO_DATA_RGB16:
+			return sizeof(VideoPixelRGB16);
+		case VIDEO_DATA_BGR16:
+			return sizeof(VideoPixelBGR16);
+		case VIDEO_DATA_BGR:
+			return sizeof(VideoPixelBGR);
+		default:
+			return sizeof(VideoPixelRGB);
+	}
+}
+
+static inline uint64_t hash_mix_u64(uint64_t hash, uint64_t value) {
+	hash = (hash ^ value) * 0x9E3779B97F4A7C15ULL;
+	return hash ^ (hash >> 29);
+}
+
+// Not cryptographic, it only needs to be fast and to notice when a screen changes.
+// Uses the same layout as the texture upload, so pos_x_data is not needed.
+uint64_t hashOutputRegion(VideoOutputData* src, size_t pos_y_data, size_t width, size_t height, InputVideoDataType video_data_type) {
+	const size_t pixel_size = get_output_pixel_size(video_data_type);
+	size_t start = pos_y_data * width * pixel_size;
+	size_t size = width * height * pixel_size;
+	if(start >= sizeof(VideoOutputData))
+		return 0;
+	if(size > (sizeof(VideoOutputData) - start))
+		size = sizeof(VideoOutputData) - start;
+	const uint8_t* data = ((const uint8_t*)src) + start;
+	const int num_lanes = 4;
+	uint64_t lanes[num_lanes] = {size, video_data_type, ~size, 0x2545F4914F6CDD1DULL};
+	size_t pos = 0;
+	// Multiple lanes, so the multiplications can run in parallel
+	for(; (pos + (num_lanes * sizeof(uint64_t))) <= size; pos += num_lanes * sizeof(uint64_t)) {
+		for(int i = 0; i < num_lanes; i++) {
+			uint64_t value;
+			memcpy(&value, data + pos + (i * sizeof(uint64_t)), sizeof(uint64_t));
+			lanes[i] = hash_mix_u64(lanes[i], value);
+		}
+	}
+	for(; pos < size; pos++)
+		lanes[0] = hash_mix_u64(lanes[0], data[pos]);
+	uint64_t hash = lanes[0];
+	for(int i = 1; i < num_lanes; i++)
+		hash = hash_mix_u64(hash, lanes[i]);
+	return hash;
+}
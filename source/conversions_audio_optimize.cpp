@@ -0,0 +1,102 @@
+#include "conversions_audio_optimize.hpp"
+
+#include <cstddef>
+
+static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565.columns_data[column].header_sound;
+	return &buffer->cypress_optimize_received_888.columns_data[column].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DSExtraHeader(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565_extra_header.columns_data[column].header_sound;
+	return &buffer->cypress_optimize_received_888_extra_header.columns_data[column].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3DForced2D(CaptureReceived* buffer, uint16_t column) {
+	return &buffer->cypress_optimize_received_888_3d_2d.columns_data[column].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* getAudioHeaderPtrOptimize3DS3DExtraHeader(CaptureReceived* buffer, bool is_rgb888) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565_3d.bottom_only_column.header_sound;
+	return &buffer->cypress_optimize_received_888_3d.bottom_only_column.header_sound;
+}
+
+// The sound headers of a frame are all at fixed distances from each other,
+// so they can be gathered without working out each column's position.
+// 3D RGB565 alternates between two different distances.
+// Every sample is written, but only new ones move the output forward.
+// The data is Little Endian, and the reads are done byte by byte,
+// so this is the same for both endiannesses.
+// This is plain scalar code. There are only 2 samples per column,
+// each ~1 KiB apart, so SIMD gathers would not buy anything here.
+// Mono mixing is done here too, to avoid a second pass.
+static void extractAudioOptimize3DS(std::int16_t *p_out, uint64_t &num_inserted, int &last_inserted_index, USB3DSOptimizeHeaderSoundData* first_header, size_t num_headers, size_t distance_even, size_t distance_odd, bool is_mono) {
+	const size_t index_offset = offsetof(USB3DSOptimizeSingleSoundData, sample_index);
+	const size_t l_offset = offsetof(USB3DSOptimizeSingleSoundData, sample_l);
+	const size_t r_offset = offsetof(USB3DSOptimizeSingleSoundData, sample_r);
+	uint8_t* header_ptr = (uint8_t*)first_header;
+	uint64_t curr_inserted = num_inserted;
+	int curr_last_index = last_inserted_index;
+	for(size_t i = 0; i < num_headers; i++) {
+		uint8_t* sample_ptr = (uint8_t*)((USB3DSOptimizeHeaderSoundData*)header_ptr)->samples;
+		for(size_t j = 0; j < 2; j++) {
+			int read_index = (sample_ptr[index_offset] | (sample_ptr[index_offset + 1] << 8)) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
+			std::int16_t sample_l = (std::int16_t)(sample_ptr[l_offset] | (sample_ptr[l_offset + 1] << 8));
+			std::int16_t sample_r = (std::int16_t)(sample_ptr[r_offset] | (sample_ptr[r_offset + 1] << 8));
+			if(is_mono) {
+				sample_l = mix_audio_samples_mono(sample_l, sample_r);
+				sample_r = sample_l;
+			}
+			p_out[curr_inserted * 2] = sample_l;
+			p_out[(curr_inserted * 2) + 1] = sample_r;
+			curr_inserted += (read_index != curr_last_index) ? 1 : 0;
+			curr_last_index = read_index;
+			sample_ptr += sizeof(USB3DSOptimizeSingleSoundData);
+		}
+		header_ptr += (i % 2) ? distance_odd : distance_even;
+	}
+	num_inserted = curr_inserted;
+	last_inserted_index = curr_last_index;
+}
+
+static void copyAudioOptimize3DS(std::int16_t *p_out, uint64_t &num_inserted, int &last_inserted_index, CaptureReceived* buffer, bool is_rgb888, bool force_check_extra_header, bool is_mono) {
+	size_t distance = sizeof(USB8883DSOptimizeInputColumnData);
+	if(!is_rgb888)
+		distance = sizeof(USB5653DSOptimizeInputColumnData);
+	USB3DSOptimizeHeaderSoundData* initial_column_data = getAudioHeaderPtrOptimize3DS(buffer, is_rgb888, 0);
+	extractAudioOptimize3DS(p_out, num_inserted, last_inserted_index, initial_column_data, TOP_WIDTH_3DS, distance, distance, is_mono);
+	if(force_check_extra_header || usb_OptimizeHasExtraHeaderSoundData(initial_column_data))
+		extractAudioOptimize3DS(p_out, num_inserted, last_inserted_index, getAudioHeaderPtrOptimize3DSExtraHeader(buffer, is_rgb888, TOP_WIDTH_3DS), 1, distance, distance, is_mono);
+}
+
+static void copyAudioOptimize3DS3D(std::int16_t *p_out, uint64_t &num_inserted, int &last_inserted_index, CaptureReceived* buffer, bool is_rgb888, bool is_mono) {
+	size_t distance_even = sizeof(USB8883DSOptimizeInputColumnData3D);
+	size_t distance_odd = sizeof(USB8883DSOptimizeInputColumnData3D);
+	if(!is_rgb888) {
+		distance_even = offsetof(USB5653DSOptimizeInputColumnData3D, bot_top_l_screens_column);
+		distance_odd = sizeof(USB5653DSOptimizeInputColumnData3D) - distance_even;
+	}
+	extractAudioOptimize3DS(p_out, num_inserted, last_inserted_index, getAudioHeaderPtrOptimize3DS3D(buffer, is_rgb888, 0), TOP_WIDTH_3DS * 2, distance_even, distance_odd, is_mono);
+	extractAudioOptimize3DS(p_out, num_inserted, last_inserted_index, getAudioHeaderPtrOptimize3DS3DExtraHeader(buffer, is_rgb888), 1, distance_even, distance_odd, is_mono);
+}
+
+static void copyAudioOptimize3DS3DForced2D(std::int16_t *p_out, uint64_t &num_inserted, int &last_inserted_index, CaptureReceived* buffer, bool is_mono) {
+	size_t distance = sizeof(USB8883DSOptimizeInputColumnData3D);
+	extractAudioOptimize3DS(p_out, num_inserted, last_inserted_index, getAudioHeaderPtrOptimize3DS3DForced2D(buffer, 0), TOP_WIDTH_3DS + 1, distance, distance, is_mono);
+}
+
+void copyAudioOptimize3DSToOutput(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888, bool is_data_3d, bool is_forced_2d, bool force_check_extra_header, bool is_mono) {
+	uint64_t num_inserted = 0;
+	int last_inserted_index = last_buffer_index;
+	if(is_data_3d)
+		copyAudioOptimize3DS3D(p_out, num_inserted, last_inserted_index, buffer, is_rgb888, is_mono);
+	else if(is_forced_2d)
+		copyAudioOptimize3DS3DForced2D(p_out, num_inserted, last_inserted_index, buffer, is_mono);
+	else
+		copyAudioOptimize3DS(p_out, num_inserted, last_inserted_index, buffer, is_rgb888, force_check_extra_header, is_mono);
+	last_buffer_index = last_inserted_index;
+	n_samples = num_inserted * 2;
+}
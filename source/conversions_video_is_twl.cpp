@@ -0,0 +1,69 @@
+#include "conversions_video_is_twl.hpp"
+
+#include <cstddef>
+
+struct twl_16bit_pixels {
+	uint16_t first_r : 5;
+	uint16_t first_g : 6;
+	uint16_t first_b : 5;
+	uint16_t second_r : 5;
+	uint16_t second_g : 6;
+	uint16_t second_b : 5;
+	uint16_t third_r : 5;
+	uint16_t third_g : 6;
+	uint16_t third_b : 5;
+	uint16_t fourth_r : 5;
+	uint16_t fourth_g : 6;
+	uint16_t fourth_b : 5;
+};
+
+struct twl_2bit_pixels {
+	uint8_t first_r : 1;
+	uint8_t first_b : 1;
+	uint8_t second_r : 1;
+	uint8_t second_b : 1;
+	uint8_t third_r : 1;
+	uint8_t third_b : 1;
+	uint8_t fourth_r : 1;
+	uint8_t fourth_b : 1;
+};
+
+inline static uint8_t to_8_bit_6(uint8_t data) {
+	return (data << 2) | (data >> 4);
+}
+
+inline static void to_8_bit_6(uint8_t* out, uint8_t* in) {
+	out[0] = to_8_bit_6(in[0]);
+	out[1] = to_8_bit_6(in[1]);
+	out[2] = to_8_bit_6(in[2]);
+}
+
+void convertISTWLVideoToOutput(ISTWLCaptureVideoInputData* data, VideoOutputDataRGB* p_out) {
+	twl_16bit_pixels* data_16_bit = (twl_16bit_pixels*)data->screen_data;
+	twl_2bit_pixels* data_2_bit = (twl_2bit_pixels*)data->bit_6_rb_screen_data;
+	const int num_pixels_struct = sizeof(twl_16bit_pixels) / sizeof(uint16_t);
+	const int num_screens = 2;
+	for(int i = 0; i < HEIGHT_DS; i++) {
+		for(int j = 0; j < num_screens; j++) {
+			size_t out_pos = ((num_screens - 1 - j) * (WIDTH_DS * HEIGHT_DS)) + (i * WIDTH_DS);
+			for(int u = 0; u < (WIDTH_DS / num_pixels_struct); u++) {
+				uint8_t pixels[num_pixels_struct][3];
+				size_t index = (((i * num_screens * WIDTH_DS) + (j * WIDTH_DS)) / num_pixels_struct) + u;
+				pixels[0][0] = (data_16_bit[index].first_r << 1) | (data_2_bit[index].first_r);
+				pixels[0][1] = data_16_bit[index].first_g;
+				pixels[0][2] = (data_16_bit[index].first_b << 1) | (data_2_bit[index].first_b);
+				pixels[1][0] = (data_16_bit[index].second_r << 1) | (data_2_bit[index].second_r);
+				pixels[1][1] = data_16_bit[index].second_g;
+				pixels[1][2] = (data_16_bit[index].second_b << 1) | (data_2_bit[index].second_b);
+				pixels[2][0] = (data_16_bit[index].third_r << 1) | (data_2_bit[index].third_r);
+				pixels[2][1] = data_16_bit[index].third_g;
+				pixels[2][2] = (data_16_bit[index].third_b << 1) | (data_2_bit[index].third_b);
+				pixels[3][0] = (data_16_bit[index].fourth_r << 1) | (data_2_bit[index].fourth_r);
+				pixels[3][1] = data_16_bit[index].fourth_g;
+				pixels[3][2] = (data_16_bit[index].fourth_b << 1) | (data_2_bit[index].fourth_b);
+				for(int k = 0; k < num_pixels_struct; k++)
+					to_8_bit_6((uint8_t*)&p_out->screen_data[out_pos + (u * num_pixels_struct) + k], pixels[k]);
+			}
+		}
+	}
+}
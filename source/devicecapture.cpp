@@ -6,14 +6,27 @@
 #include "cypress_partner_ctr_acquisition.hpp"
 #include "cypress_nisetro_acquisition.hpp"
 #include "cypress_optimize_3ds_acquisition.hpp"
+#include "recording_playback_acquisition.hpp"
+#ifdef USE_LIBUSB
+#include "usb_generic.hpp"
+#endif
+#include "ThreadScheduling.hpp"
+#include "IdleState.hpp"
 
 #include <vector>
 #include <thread>
 #include <chrono>
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <memory>
+#include <algorithm>
+#include <atomic>
 
 #define CONNECTION_NO_DEVICE_SELECTED (-1)
 #define NO_SERIAL_KEY_STR "No Serial Key"
+#define DEVICE_LISTING_DEADLINE_MS 5000
 
 static bool poll_connection_window_screen(WindowScreen *screen, int &chosen_index) {
 	screen->poll();
@@ -110,50 +123,359 @@ void capture_warning_print(CaptureData* capture_data, std::string warning_string
 	capture_warning_print(capture_data, warning_string, warning_string);
 }
 
-bool connect(bool print_failed, CaptureData* capture_data, FrontendData* frontend_data, bool* force_cc_disables, bool auto_connect_to_first) {
-	capture_data->status.new_error_text = false;
-	if (capture_data->status.connected) {
-		capture_data->status.close_success = false;
-		return false;
+// Backends sharing code (and static state) are listed sequentially,
+// in the same group. Different groups are listed in parallel.
+enum DeviceListingGroup { LISTING_GROUP_PLAYBACK, LISTING_GROUP_CYPRESS, LISTING_GROUP_FTD3, LISTING_GROUP_FTD2, LISTING_GROUP_USB_DS_3DS, LISTING_GROUP_IS_DEVICE, LISTING_GROUP_END };
+static const std::string listing_group_names[LISTING_GROUP_END] = {"Playback", "Cypress", "FTD3", "FTD2", "USB DS/3DS", "IS Devices"};
+// Used to merge the results in a deterministic order
+enum DeviceListingBackend { LISTING_BACKEND_PLAYBACK, LISTING_BACKEND_CYOP, LISTING_BACKEND_CYNI, LISTING_BACKEND_FTD3, LISTING_BACKEND_FTD2, LISTING_BACKEND_USB_DS_3DS, LISTING_BACKEND_IS_DEVICE, LISTING_BACKEND_CYPART, LISTING_BACKEND_END };
+
+struct DeviceListingData {
+	std::vector<CaptureDevice> devices_list[LISTING_BACKEND_END];
+	std::vector<no_access_recap_data> no_access_list[LISTING_BACKEND_END];
+	bool devices_allowed_scan[CC_POSSIBLE_DEVICES_END];
+	bool done[LISTING_GROUP_END];
+};
+
+static std::mutex listing_mutex;
+static std::condition_variable_any listing_condition;
+static bool listing_group_running[LISTING_GROUP_END] = {};
+static int listing_num_running = 0;
+
+static DeviceListingGroup listing_backend_to_group(int backend) {
+	switch(backend) {
+		case LISTING_BACKEND_PLAYBACK:
+			return LISTING_GROUP_PLAYBACK;
+		case LISTING_BACKEND_FTD3:
+			return LISTING_GROUP_FTD3;
+		case LISTING_BACKEND_FTD2:
+			return LISTING_GROUP_FTD2;
+		case LISTING_BACKEND_USB_DS_3DS:
+			return LISTING_GROUP_USB_DS_3DS;
+		case LISTING_BACKEND_IS_DEVICE:
+			return LISTING_GROUP_IS_DEVICE;
+		default:
+			return LISTING_GROUP_CYPRESS;
 	}
+}
 
-	if(!capture_data->status.close_success) {
-		capture_error_print(print_failed, capture_data, "Previous device still closing...");
-		return false;
+static void list_devices_group(DeviceListingGroup group, std::shared_ptr<DeviceListingData> data) {
+	switch(group) {
+		case LISTING_GROUP_PLAYBACK:
+			list_devices_playback(data->devices_list[LISTING_BACKEND_PLAYBACK], data->no_access_list[LISTING_BACKEND_PLAYBACK]);
+			break;
+		case LISTING_GROUP_CYPRESS:
+			#ifdef USE_CYPRESS_OPTIMIZE
+			list_devices_cyop_device(data->devices_list[LISTING_BACKEND_CYOP], data->no_access_list[LISTING_BACKEND_CYOP], data->devices_allowed_scan);
+			#endif
+			#ifdef USE_CYNI_USB
+			list_devices_cyni_device(data->devices_list[LISTING_BACKEND_CYNI], data->no_access_list[LISTING_BACKEND_CYNI], data->devices_allowed_scan);
+			#endif
+			#ifdef USE_PARTNER_CTR
+			list_devices_cypart_device(data->devices_list[LISTING_BACKEND_CYPART], data->no_access_list[LISTING_BACKEND_CYPART], data->devices_allowed_scan);
+			#endif
+			break;
+		case LISTING_GROUP_FTD3:
+			#ifdef USE_FTD3
+			list_devices_ftd3(data->devices_list[LISTING_BACKEND_FTD3], data->no_access_list[LISTING_BACKEND_FTD3], data->devices_allowed_scan);
+			#endif
+			break;
+		case LISTING_GROUP_FTD2:
+			#ifdef USE_FTD2
+			list_devices_ftd2_shared(data->devices_list[LISTING_BACKEND_FTD2], data->no_access_list[LISTING_BACKEND_FTD2], data->devices_allowed_scan);
+			#endif
+			break;
+		case LISTING_GROUP_USB_DS_3DS:
+			#ifdef USE_DS_3DS_USB
+			list_devices_usb_ds_3ds(data->devices_list[LISTING_BACKEND_USB_DS_3DS], data->no_access_list[LISTING_BACKEND_USB_DS_3DS], data->devices_allowed_scan);
+			#endif
+			break;
+		case LISTING_GROUP_IS_DEVICE:
+			#ifdef USE_IS_DEVICES_USB
+			list_devices_is_device(data->devices_list[LISTING_BACKEND_IS_DEVICE], data->no_access_list[LISTING_BACKEND_IS_DEVICE], data->devices_allowed_scan);
+			#endif
+			break;
+		default:
+			break;
 	}
+	listing_mutex.lock();
+	data->done[group] = true;
+	listing_group_running[group] = false;
+	listing_num_running -= 1;
+	listing_condition.notify_all();
+	listing_mutex.unlock();
+}
 
-	capture_data->status.cooldown_curr_in = FIX_PARTIAL_FIRST_FRAME_NUM;
-	// Device Listing
+static void list_devices_all(std::vector<CaptureDevice> &devices_list, std::vector<no_access_recap_data> &no_access_list, std::vector<std::string> &timed_out_list, bool* devices_allowed_scan) {
+	std::shared_ptr<DeviceListingData> data = std::make_shared<DeviceListingData>();
+	for(size_t i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		data->devices_allowed_scan[i] = devices_allowed_scan[i];
+	bool started[LISTING_GROUP_END];
+	listing_mutex.lock();
+	for(int i = 0; i < LISTING_GROUP_END; i++) {
+		data->done[i] = false;
+		started[i] = false;
+		// A group which missed the previous deadline is still busy.
+		// Skip it, instead of having it run twice at the same time.
+		if(listing_group_running[i])
+			continue;
+		listing_group_running[i] = true;
+		listing_num_running += 1;
+		started[i] = true;
+		std::thread(list_devices_group, (DeviceListingGroup)i, data).detach();
+	}
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(DEVICE_LISTING_DEADLINE_MS);
+	bool all_done = false;
+	while(!all_done) {
+		all_done = true;
+		for(int i = 0; i < LISTING_GROUP_END; i++)
+			if(started[i] && (!data->done[i]))
+				all_done = false;
+		if(all_done)
+			break;
+		if(listing_condition.wait_until(listing_mutex, deadline) == std::cv_status::timeout)
+			break;
+	}
+	// Whatever did not finish in time is ignored, this round.
+	// Still, let the user know why a device may be missing.
+	for(int i = 0; i < LISTING_GROUP_END; i++)
+		if(!data->done[i])
+			timed_out_list.push_back(listing_group_names[i]);
+	for(int i = 0; i < LISTING_BACKEND_END; i++) {
+		if(!data->done[listing_backend_to_group(i)])
+			continue;
+		devices_list.insert(devices_list.end(), data->devices_list[i].begin(), data->devices_list[i].end());
+		no_access_list.insert(no_access_list.end(), data->no_access_list[i].begin(), data->no_access_list[i].end());
+	}
+	listing_mutex.unlock();
+}
+
+// Listing threads may still be running after a missed deadline.
+// They need to be done before the USB backends get closed.
+static void wait_list_devices_all() {
+	listing_mutex.lock();
+	while(listing_num_running > 0)
+		listing_condition.wait(listing_mutex);
+	listing_mutex.unlock();
+}
+
+// Periodic connection tries list the devices on their own thread,
+// so the main loop does not stall. connect() then uses the result.
+struct BackgroundListingData {
 	std::vector<CaptureDevice> devices_list;
 	std::vector<no_access_recap_data> no_access_list;
+	std::vector<std::string> timed_out_list;
 	bool devices_allowed_scan[CC_POSSIBLE_DEVICES_END];
+	bool is_change_id_tracked;
+	uint64_t change_id;
+};
+
+static BackgroundListingData background_listing;
+static std::thread background_listing_thread;
+static bool background_listing_started = false;
+static std::atomic<bool> background_listing_done = false;
+
+static void get_devices_allowed_scan(CaptureData* capture_data, bool* force_cc_disables, bool* devices_allowed_scan) {
 	for(size_t i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
 		devices_allowed_scan[i] = capture_data->status.devices_allowed_scan[i] & (!force_cc_disables[i]);
+}
 
-	#ifdef USE_CYPRESS_OPTIMIZE
-	list_devices_cyop_device(devices_list, no_access_list, devices_allowed_scan);
-	#endif
+static void background_listing_function() {
+	list_devices_all(background_listing.devices_list, background_listing.no_access_list, background_listing.timed_out_list, background_listing.devices_allowed_scan);
+	background_listing_done = true;
+}
+
+static void wait_background_device_listing() {
+	if(!background_listing_started)
+		return;
+	background_listing_thread.join();
+	background_listing_started = false;
+}
+
+void start_background_device_listing(CaptureData* capture_data, bool* force_cc_disables) {
+	if(background_listing_started && (!background_listing_done))
+		return;
+	wait_background_device_listing();
+	background_listing.devices_list.clear();
+	background_listing.no_access_list.clear();
+	background_listing.timed_out_list.clear();
+	get_devices_allowed_scan(capture_data, force_cc_disables, background_listing.devices_allowed_scan);
+	// Taken before listing, so changes happening while listing are not missed
+	background_listing.is_change_id_tracked = get_device_list_change_id(&background_listing.change_id);
+	background_listing_done = false;
+	background_listing_started = true;
+	background_listing_thread = std::thread(background_listing_function);
+}
+
+bool is_background_device_listing_done() {
+	return background_listing_started && background_listing_done;
+}
+
+// Waits for a listing which is still running.
+// Its result is only used if nothing changed since it started.
+static bool take_background_device_listing(std::vector<CaptureDevice> &devices_list, std::vector<no_access_recap_data> &no_access_list, std::vector<std::string> &timed_out_list, bool* devices_allowed_scan) {
+	if(!background_listing_started)
+		return false;
+	wait_background_device_listing();
+	for(size_t i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		if(background_listing.devices_allowed_scan[i] != devices_allowed_scan[i])
+			return false;
+	uint64_t change_id = 0;
+	bool is_change_id_tracked = get_device_list_change_id(&change_id);
+	if(is_change_id_tracked != background_listing.is_change_id_tracked)
+		return false;
+	if(is_change_id_tracked && (change_id != background_listing.change_id))
+		return false;
+	devices_list = std::move(background_listing.devices_list);
+	no_access_list = std::move(background_listing.no_access_list);
+	timed_out_list = std::move(background_listing.timed_out_list);
+	return true;
+}
+
+// Only what the connected device can actually receive is needed.
+// The slots are much smaller than the whole union, for most devices.
+static size_t get_capture_buffer_slot_size(CaptureDevice* device) {
+	switch(device->cc_type) {
+		case CAPTURE_CONN_FTD3:
+			return std::max(sizeof(FTD3_3DSCaptureReceived), sizeof(FTD3_3DSCaptureReceived_3D));
+		case CAPTURE_CONN_USB:
+			return std::max(std::max(sizeof(USB3DSCaptureReceived), sizeof(USB3DSCaptureReceived_3D)), sizeof(USBOldDSCaptureReceived));
+		case CAPTURE_CONN_FTD2:
+			#ifdef USE_FTD2
+			return std::max(sizeof(FTD2OldDSCaptureReceived) + ftd2_get_max_unused_offset(), sizeof(FTD2OldDSCaptureReceivedNormalPlusRaw));
+			#else
+			return std::max(sizeof(FTD2OldDSCaptureReceived), sizeof(FTD2OldDSCaptureReceivedNormalPlusRaw));
+			#endif
+		case CAPTURE_CONN_IS_NITRO:
+			return std::max(sizeof(ISNitroCaptureReceived), sizeof(ISTWLCaptureReceived));
+		case CAPTURE_CONN_CYPRESS_NISETRO:
+			// Frames not starting at the vsync are dropped and re-read,
+			// never passed with an unused_offset.
+			return sizeof(CypressNisetroDSCaptureReceived);
+		case CAPTURE_CONN_CYPRESS_OPTIMIZE:
+			if(!device->has_3d)
+				return std::max({sizeof(USB5653DSOptimizeCaptureReceived), sizeof(USB5653DSOptimizeOldFirmwareCaptureReceived), sizeof(USB5653DSOptimizeCaptureReceivedExtraHeader), sizeof(USB8883DSOptimizeCaptureReceived), sizeof(USB8883DSOptimizeOldFirmwareCaptureReceived), sizeof(USB8883DSOptimizeCaptureReceivedExtraHeader)});
+			return sizeof(CaptureReceived);
+		case CAPTURE_CONN_PLAYBACK:
+			return playback_get_capture_buffer_slot_size();
+		default:
+			return sizeof(CaptureReceived);
+	}
+}
+
+static std::string get_transfers_profile_file_path(CaptureDevice* device) {
+	std::string name = device->long_name + "_" + device->serial_number;
+	for(size_t i = 0; i < name.size(); i++)
+		if(!(isalnum((unsigned char)name[i]) || (name[i] == '-') || (name[i] == '.')))
+			name[i] = '_';
+	return get_base_path_device_specific_configs() + "usb_transfers_" + name + ".txt";
+}
+
+// usb_transfers can be set by hand, for a single device. 0 is automatic.
+static void load_transfers_profile(CaptureStatus* capture_status) {
+	int device_requested = AUTO_TRANSFERS_IN_FLIGHT;
+	int auto_start = AUTO_TRANSFERS_IN_FLIGHT;
+	std::ifstream file(get_transfers_profile_file_path(&capture_status->device));
+	std::string line;
+	if(file && file.is_open() && file.good()) {
+		try {
+			while(std::getline(file, line)) {
+				std::istringstream kvp(line);
+				std::string key;
+				std::string value;
+				if((!std::getline(kvp, key, '=')) || (!std::getline(kvp, value)))
+					continue;
+				if(key == "usb_transfers")
+					device_requested = std::stoi(value);
+				if(key == "usb_transfers_auto_start")
+					auto_start = std::stoi(value);
+			}
+		}
+		catch(...) {
+		}
+	}
+	capture_status->transfers_in_flight.set_device_profile(device_requested, auto_start);
+}
+
+static void save_transfers_profile(CaptureStatus* capture_status) {
+	int device_requested = AUTO_TRANSFERS_IN_FLIGHT;
+	int auto_start = AUTO_TRANSFERS_IN_FLIGHT;
+	if(!capture_status->transfers_in_flight.get_device_profile(device_requested, auto_start))
+		return;
+	std::ofstream file(get_transfers_profile_file_path(&capture_status->device));
+	if(!file.good())
+		return;
+	file << "usb_transfers=" << std::to_string(device_requested) << "\n";
+	file << "usb_transfers_auto_start=" << std::to_string(auto_start) << "\n";
+	file.close();
+}
+
+static void capture_cleanup_device(CaptureData* capture_data) {
 	#ifdef USE_CYNI_USB
-	list_devices_cyni_device(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_CYPRESS_NISETRO)
+		usb_cyni_device_acquisition_cleanup(capture_data);
+	#endif
+	#ifdef USE_CYPRESS_OPTIMIZE
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_CYPRESS_OPTIMIZE)
+		usb_cyop_device_acquisition_cleanup(capture_data);
 	#endif
 	#ifdef USE_FTD3
-	list_devices_ftd3(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_FTD3)
+		ftd3_capture_cleanup(capture_data);
 	#endif
 	#ifdef USE_FTD2
-	list_devices_ftd2_shared(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_FTD2)
+		ftd2_capture_cleanup_shared(capture_data);
 	#endif
 	#ifdef USE_DS_3DS_USB
-	list_devices_usb_ds_3ds(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_USB)
+		usb_capture_cleanup(capture_data);
 	#endif
 	#ifdef USE_IS_DEVICES_USB
-	list_devices_is_device(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_IS_NITRO)
+		usb_is_device_acquisition_cleanup(capture_data);
 	#endif
 	#ifdef USE_PARTNER_CTR
-	list_devices_cypart_device(devices_list, no_access_list, devices_allowed_scan);
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_PARTNER_CTR)
+		usb_cypart_device_acquisition_cleanup(capture_data);
 	#endif
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_PLAYBACK)
+		playback_acquisition_cleanup(capture_data);
+}
+
+bool connect(bool print_failed, CaptureData* capture_data, FrontendData* frontend_data, bool* force_cc_disables, bool auto_connect_to_first) {
+	capture_data->status.new_error_text = false;
+	if (capture_data->status.connected) {
+		capture_data->status.close_success = false;
+		return false;
+	}
+
+	if(!capture_data->status.close_success) {
+		capture_error_print(print_failed, capture_data, "Previous device still closing...");
+		return false;
+	}
+
+	capture_data->status.cooldown_curr_in = FIX_PARTIAL_FIRST_FRAME_NUM;
+	// Device Listing
+	std::vector<CaptureDevice> devices_list;
+	std::vector<no_access_recap_data> no_access_list;
+	std::vector<std::string> timed_out_list;
+	bool devices_allowed_scan[CC_POSSIBLE_DEVICES_END];
+	get_devices_allowed_scan(capture_data, force_cc_disables, devices_allowed_scan);
+
+	if(!take_background_device_listing(devices_list, no_access_list, timed_out_list, devices_allowed_scan))
+		list_devices_all(devices_list, no_access_list, timed_out_list, devices_allowed_scan);
+
+	std::string timed_out_part = "";
+	for(size_t i = 0; i < timed_out_list.size(); i++)
+		timed_out_part += " - " + timed_out_list[i];
+	if((timed_out_list.size() > 0) && print_failed)
+		ActualConsoleOutTextError("Device listing timed out" + timed_out_part);
 
 	if(devices_list.size() <= 0) {
-		if(no_access_list.size() <= 0)
+		if((no_access_list.size() <= 0) && (timed_out_list.size() > 0))
+			capture_error_print(print_failed, capture_data, "No device was found\nListing timed out", "No device was found - Listing timed out" + timed_out_part);
+		else if(no_access_list.size() <= 0)
 			capture_error_print(print_failed, capture_data, "No device was found");
 		else {
 			std::string full_error_part = "";
@@ -167,9 +489,13 @@ bool connect(bool print_failed, CaptureData* capture_data, FrontendData* fronten
 			#ifdef _WIN32
 			std::string base_error_string = "No device was found\nPossible driver issue";
 			std::string long_error_string = "No device was found - Possible driver issue" + full_error_part;
+			if(timed_out_list.size() > 0)
+				long_error_string += " - Listing timed out" + timed_out_part;
 			#else
 			std::string base_error_string = "No device was found\nPossible permission error";
 			std::string long_error_string = "No device was found - Possible permission error" + full_error_part;
+			if(timed_out_list.size() > 0)
+				long_error_string += " - Listing timed out" + timed_out_part;
 			#endif
 			capture_error_print(print_failed, capture_data, base_error_string, long_error_string);
 		}
@@ -182,6 +508,12 @@ bool connect(bool print_failed, CaptureData* capture_data, FrontendData* fronten
 		return false;
 	}
 
+	// Done before connecting, so a failure here does not need to close the device
+	if(!capture_data->data_buffers.AllocateBuffers(get_capture_buffer_slot_size(&devices_list[chosen_device]))) {
+		capture_error_print(print_failed, capture_data, "Capture buffers allocation failed");
+		return false;
+	}
+
 	// Actual connection
 	#ifdef USE_CYNI_USB
 	if((devices_list[chosen_device].cc_type == CAPTURE_CONN_CYPRESS_NISETRO) && (!cyni_device_connect_usb(print_failed, capture_data, &devices_list[chosen_device], frontend_data)))
@@ -211,8 +543,22 @@ bool connect(bool print_failed, CaptureData* capture_data, FrontendData* fronten
 	if((devices_list[chosen_device].cc_type == CAPTURE_CONN_PARTNER_CTR) && (!cypart_device_connect_usb(print_failed, capture_data, &devices_list[chosen_device])))
 		return false;
 	#endif
+	if((devices_list[chosen_device].cc_type == CAPTURE_CONN_PLAYBACK) && (!playback_connect(print_failed, capture_data, &devices_list[chosen_device])))
+		return false;
+	// Loading a firmware may have changed the device
+	if(get_capture_buffer_slot_size(&devices_list[chosen_device]) > capture_data->data_buffers.GetSlotSize()) {
+		if(!capture_data->data_buffers.AllocateBuffers(get_capture_buffer_slot_size(&devices_list[chosen_device]))) {
+			CaptureDevice old_device = capture_data->status.device;
+			capture_data->status.device = devices_list[chosen_device];
+			capture_cleanup_device(capture_data);
+			capture_data->status.device = old_device;
+			capture_error_print(print_failed, capture_data, "Capture buffers allocation failed");
+			return false;
+		}
+	}
 	update_connected_3ds_ds(frontend_data, capture_data->status.device, devices_list[chosen_device]);
 	capture_data->status.device = devices_list[chosen_device];
+	load_transfers_profile(&capture_data->status);
 
 	// Avoid having old open locks
 	capture_data->status.video_wait.try_lock();
@@ -222,11 +568,14 @@ bool connect(bool print_failed, CaptureData* capture_data, FrontendData* fronten
 }
 
 void captureCall(CaptureData* capture_data) {
+	register_current_thread_scheduling(THREAD_SCHEDULING_CAPTURE);
 	capture_data->status.cooldown_curr_in = FIX_PARTIAL_FIRST_FRAME_NUM;
+	IdleBackoff idle_backoff(IDLE_MIN_WAIT, IDLE_CAPTURE_MAX_WAIT);
 
 	while(capture_data->status.running) {
 		if (!capture_data->status.connected) {
-			default_sleep();
+			// Nothing to do until a device connects. Once idle, wake up less and less often.
+			capture_data->status.connection_wait.timed_lock(idle_capture_loop_step(idle_backoff, capture_data->status.idle));
 			continue;
 		}
 
@@ -259,6 +608,8 @@ void captureCall(CaptureData* capture_data) {
 		if(capture_data->status.device.cc_type == CAPTURE_CONN_PARTNER_CTR)
 			cypart_device_acquisition_main_loop(capture_data);
 		#endif
+		if(capture_data->status.device.cc_type == CAPTURE_CONN_PLAYBACK)
+			playback_acquisition_main_loop(capture_data);
 
 		capture_data->status.close_success = false;
 		capture_data->status.connected = false;
@@ -268,41 +619,15 @@ void captureCall(CaptureData* capture_data) {
 		capture_data->status.video_wait.unlock();
 		capture_data->status.audio_wait.unlock();
 
-		// Capture cleanup
-		#ifdef USE_CYNI_USB
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_CYPRESS_NISETRO)
-			usb_cyni_device_acquisition_cleanup(capture_data);
-		#endif
-		#ifdef USE_CYPRESS_OPTIMIZE
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_CYPRESS_OPTIMIZE)
-			usb_cyop_device_acquisition_cleanup(capture_data);
-		#endif
-		#ifdef USE_FTD3
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_FTD3)
-			ftd3_capture_cleanup(capture_data);
-		#endif
-		#ifdef USE_FTD2
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_FTD2)
-			ftd2_capture_cleanup_shared(capture_data);
-		#endif
-		#ifdef USE_DS_3DS_USB
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_USB)
-			usb_capture_cleanup(capture_data);
-		#endif
-		#ifdef USE_IS_DEVICES_USB
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_IS_NITRO)
-			usb_is_device_acquisition_cleanup(capture_data);
-		#endif
-		#ifdef USE_PARTNER_CTR
-		if(capture_data->status.device.cc_type == CAPTURE_CONN_PARTNER_CTR)
-			usb_cypart_device_acquisition_cleanup(capture_data);
-		#endif
+		capture_cleanup_device(capture_data);
+		save_transfers_profile(&capture_data->status);
 
 		capture_data->status.close_success = false;
 		capture_data->status.connected = false;
 
 		capture_data->status.close_success = true;
 	}
+	unregister_current_thread_scheduling();
 }
 
 uint64_t get_audio_n_samples(CaptureData* capture_data, CaptureDataSingleBuffer* data_buffer) {
@@ -350,6 +675,8 @@ uint64_t get_video_in_size(CaptureData* capture_data, bool is_3d, bool should_be
 	if(capture_data->status.device.cc_type == CAPTURE_CONN_PARTNER_CTR)
 		return cypart_device_get_video_in_size(capture_data, is_3d);
 	#endif
+	if(capture_data->status.device.cc_type == CAPTURE_CONN_PLAYBACK)
+		return playback_get_video_in_size(capture_data, video_data_type);
 	return 0;
 }
 
@@ -456,6 +783,8 @@ bool get_device_3d_implemented(CaptureStatus* capture_status) {
 			return true;
 		case CAPTURE_CONN_PARTNER_CTR:
 			return true;
+		case CAPTURE_CONN_PLAYBACK:
+			return true;
 		default:
 			return false;
 	}
@@ -548,9 +877,17 @@ void capture_init() {
 	#ifdef USE_CYPRESS_OPTIMIZE
 	usb_cyop_device_init();
 	#endif
+	#ifdef USE_LIBUSB
+	usb_device_watch_start();
+	#endif
 }
 
 void capture_close() {
+	wait_background_device_listing();
+	wait_list_devices_all();
+	#ifdef USE_LIBUSB
+	usb_device_watch_stop();
+	#endif
 	#ifdef USE_DS_3DS_USB
 	usb_ds_3ds_close();
 	#endif
@@ -570,3 +907,25 @@ void capture_close() {
 	usb_cyop_device_close();
 	#endif
 }
+
+// Returns false if changes in the connected devices cannot be tracked
+bool get_device_list_change_id(uint64_t* change_id) {
+	#ifdef USE_LIBUSB
+	return usb_device_watch_get_change_id(change_id);
+	#else
+	return false;
+	#endif
+}
+
+// Only the main loop should publish
+void publish_capture_status_snapshot(CaptureStatus* capture_status) {
+	CaptureStatusSnapshot snapshot;
+	snapshot.connected = capture_status->connected;
+	snapshot.cooldown_curr_in = capture_status->cooldown_curr_in;
+	snapshot.enabled_3d = get_3d_enabled(capture_status);
+	capture_status->snapshot.write(snapshot);
+}
+
+CaptureStatusSnapshot get_capture_status_snapshot(CaptureStatus* capture_status) {
+	return capture_status->snapshot.read();
+}
@@ -73,6 +73,8 @@ struct gpiod_line* gpiod_line_find(const char *line_name)
 		if(offset != -1) {
 			struct gpiod_line* output = new gpiod_line;
 			output->chip = chip;
+			output->request = NULL;
+			output->event_buffer = NULL;
 			output->offset = offset;
 			delete []chip_paths;
 			return output;
@@ -86,7 +88,7 @@ struct gpiod_line* gpiod_line_find(const char *line_name)
 	return NULL;
 }
 
-static void return_from_gpiod_line_request_input_flags(struct gpiod_request_config* req_cfg, struct gpiod_line_config* line_cfg, struct gpiod_line_settings* settings) {
+static int return_from_gpiod_line_request_input(struct gpiod_line* in, struct gpiod_request_config* req_cfg, struct gpiod_line_config* line_cfg, struct gpiod_line_settings* settings) {
 	if(req_cfg)
 		gpiod_request_config_free(req_cfg);
 
@@ -95,52 +97,107 @@ static void return_from_gpiod_line_request_input_flags(struct gpiod_request_conf
 
 	if(settings)
 		gpiod_line_settings_free(settings);
+
+	if(in->request == NULL)
+		return -1;
+	return 0;
 }
 
-void gpiod_line_request_input_flags(struct gpiod_line* in, const char* consumer, gpiod_line_bias bias) {
+static int gpiod_line_request_input(struct gpiod_line* in, const char* consumer, gpiod_line_bias bias, gpiod_line_edge edge) {
 	if(in == NULL)
-		return;
+		return -1;
 	if(in->chip == NULL)
-		return;
+		return -1;
 
 	struct gpiod_request_config* req_cfg = NULL;
 	struct gpiod_line_config* line_cfg = NULL;
 
 	struct gpiod_line_settings* settings = gpiod_line_settings_new();
 	if(settings == NULL)
-		return return_from_gpiod_line_request_input_flags(req_cfg, line_cfg, settings);
+		return return_from_gpiod_line_request_input(in, req_cfg, line_cfg, settings);
 
 	gpiod_line_settings_set_direction(settings, GPIOD_LINE_DIRECTION_INPUT);
 	gpiod_line_settings_set_bias(settings, bias);
+	gpiod_line_settings_set_edge_detection(settings, edge);
 
 	line_cfg = gpiod_line_config_new();
 	if(line_cfg == NULL)
-		return return_from_gpiod_line_request_input_flags(req_cfg, line_cfg, settings);
+		return return_from_gpiod_line_request_input(in, req_cfg, line_cfg, settings);
 
 	if(gpiod_line_config_add_line_settings(line_cfg, (const unsigned int*)&in->offset, 1, settings) != 0)
-		return return_from_gpiod_line_request_input_flags(req_cfg, line_cfg, settings);
+		return return_from_gpiod_line_request_input(in, req_cfg, line_cfg, settings);
 
 	if(consumer != NULL) {
 		req_cfg = gpiod_request_config_new();
 		if(req_cfg == NULL)
-			return return_from_gpiod_line_request_input_flags(req_cfg, line_cfg, settings);
+			return return_from_gpiod_line_request_input(in, req_cfg, line_cfg, settings);
 
 		gpiod_request_config_set_consumer(req_cfg, consumer);
 	}
 
 	in->request = gpiod_chip_request_lines(in->chip, req_cfg, line_cfg);
 
-	return return_from_gpiod_line_request_input_flags(req_cfg, line_cfg, settings);
+	return return_from_gpiod_line_request_input(in, req_cfg, line_cfg, settings);
+}
+
+int gpiod_line_request_input_flags(struct gpiod_line* in, const char* consumer, gpiod_line_bias bias) {
+	return gpiod_line_request_input(in, consumer, bias, GPIOD_LINE_EDGE_NONE);
+}
+
+int gpiod_line_request_both_edges_events_flags(struct gpiod_line* in, const char* consumer, gpiod_line_bias bias) {
+	if(gpiod_line_request_input(in, consumer, bias, GPIOD_LINE_EDGE_BOTH) != 0)
+		return -1;
+	// The old API reads one event at a time
+	in->event_buffer = gpiod_edge_event_buffer_new(1);
+	if(in->event_buffer == NULL) {
+		gpiod_line_request_release(in->request);
+		in->request = NULL;
+		return -1;
+	}
+	return 0;
 }
 
 int gpiod_line_get_value(struct gpiod_line* in) {
 	return gpiod_line_request_get_value(in->request, in->offset);
 }
 
+int gpiod_line_event_wait(struct gpiod_line* in, const struct timespec *timeout) {
+	if((in == NULL) || (in->request == NULL) || (in->event_buffer == NULL))
+		return -1;
+	int64_t timeout_ns = -1;
+	if(timeout != NULL)
+		timeout_ns = (((int64_t)timeout->tv_sec) * 1000000000) + timeout->tv_nsec;
+	return gpiod_line_request_wait_edge_events(in->request, timeout_ns);
+}
+
+int gpiod_line_event_read(struct gpiod_line* in, struct gpiod_line_event *event) {
+	if((in == NULL) || (in->request == NULL) || (in->event_buffer == NULL))
+		return -1;
+	if(gpiod_line_request_read_edge_events(in->request, in->event_buffer, 1) != 1)
+		return -1;
+	struct gpiod_edge_event* edge_event = gpiod_edge_event_buffer_get_event(in->event_buffer, 0);
+	if(edge_event == NULL)
+		return -1;
+	uint64_t timestamp_ns = gpiod_edge_event_get_timestamp_ns(edge_event);
+	event->ts.tv_sec = timestamp_ns / 1000000000;
+	event->ts.tv_nsec = timestamp_ns % 1000000000;
+	event->event_type = gpiod_edge_event_get_event_type(edge_event);
+	return 0;
+}
+
+int gpiod_line_event_get_fd(struct gpiod_line* in) {
+	if((in == NULL) || (in->request == NULL) || (in->event_buffer == NULL))
+		return -1;
+	return gpiod_line_request_get_fd(in->request);
+}
+
 void gpiod_line_close_chip(struct gpiod_line* in)
 {
 	if(in == NULL)
 		return;
+	if(in->event_buffer != NULL)
+		gpiod_edge_event_buffer_free(in->event_buffer);
+	in->event_buffer = NULL;
 	if(in->request != NULL)
 		gpiod_line_request_release(in->request);
 	in->request = NULL;
@@ -487,7 +487,11 @@ void ConsumerMutex::lock() {
 }
 
 bool ConsumerMutex::timed_lock() {
-	std::chrono::duration<double>max_timed_wait = std::chrono::duration<double>(this->get_time_s());
+	return this->timed_lock(this->get_time_s());
+}
+
+bool ConsumerMutex::timed_lock(double max_wait_s) {
+	std::chrono::duration<double>max_timed_wait = std::chrono::duration<double>(max_wait_s);
 	access_mutex.lock();
 	bool success = false;
 	while (!success) {
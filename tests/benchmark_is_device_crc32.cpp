@@ -0,0 +1,56 @@
+#include "usb_is_device_crc32.hpp"
+#include "ccitt32_crc32_table.h"
+#include "utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+
+// Times the sliced CRC32 of the IS devices against the byte-wise one.
+// Not run by ctest. Usage: benchmark_is_device_crc32 [num_mib]
+
+static uint32_t get_crc32_data_comm_reference(const uint8_t* data, size_t size) {
+	uint32_t value = 0xFFFFFFFF;
+	for(size_t i = 0; i < size; i++) {
+		uint8_t inner_value = (value >> 24) ^ data[i];
+		value <<= 8;
+		value ^= read_le32(ccitt32_crc32_table, inner_value);
+	}
+	return ~value;
+}
+
+template<typename T> static double time_crc32(T crc32_function, const std::vector<uint8_t> &buffer, size_t packet_size, size_t total_size, uint32_t &result) {
+	auto start_time = std::chrono::steady_clock::now();
+	uint32_t value = 0;
+	for(size_t done = 0; done < total_size; done += packet_size)
+		value ^= crc32_function(buffer.data() + (done % (buffer.size() - packet_size)), packet_size);
+	const std::chrono::duration<double> diff = std::chrono::steady_clock::now() - start_time;
+	result = value;
+	return diff.count();
+}
+
+int main(int argc, char **argv) {
+	size_t num_mib = 256;
+	if(argc > 1)
+		num_mib = std::stoul(argv[1]);
+	const size_t total_size = num_mib << 20;
+	std::mt19937 rng(0xBE4C);
+	std::vector<uint8_t> buffer((1 << 20) + 0x10000);
+	for(size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = rng() & 0xFF;
+
+	// The command packets, and bigger transfers
+	const size_t packet_sizes[] = {0x10, 0xB4, 0x1000, 0x10000};
+	for(size_t i = 0; i < (sizeof(packet_sizes) / sizeof(packet_sizes[0])); i++) {
+		uint32_t reference_result = 0;
+		uint32_t sliced_result = 0;
+		double reference_time = time_crc32(get_crc32_data_comm_reference, buffer, packet_sizes[i], total_size, reference_result);
+		double sliced_time = time_crc32(get_crc32_data_comm, buffer, packet_sizes[i], total_size, sliced_result);
+		std::cout << "Packets of " << packet_sizes[i] << " bytes: byte-wise " << (num_mib / reference_time) << " MiB/s, sliced " << (num_mib / sliced_time) << " MiB/s, " << (reference_time / sliced_time) << "x";
+		if(reference_result != sliced_result)
+			std::cout << " - MISMATCH";
+		std::cout << std::endl;
+	}
+	return 0;
+}
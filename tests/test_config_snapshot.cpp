@@ -0,0 +1,336 @@
+#include "ConfigSnapshot.hpp"
+#include "ConfigParsing.hpp"
+#include "WindowCommands.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+// Parses randomly generated config files, then makes sure what comes back
+// from their snapshots is exactly what a fresh parse results in.
+// Broken snapshots must be refused.
+
+#define NUM_LAYOUT_FILES 300
+#define NUM_SHARED_FILES 300
+
+static int random_int(std::mt19937 &rng, int min, int max) {
+	return min + (int)(rng() % (uint32_t)(max - min + 1));
+}
+
+// Some of the values are out of range, so the sanitization is part of the parse
+static void random_screen_info(ScreenInfo &info, std::mt19937 &rng) {
+	info.is_blurred = rng() & 1;
+	info.crop_kind = random_int(rng, -2, 40);
+	info.crop_kind_ds = random_int(rng, -2, 40);
+	info.allow_games_crops = rng() & 1;
+	info.scaling = random_int(rng, -10, 600) / 10.0;
+	info.is_fullscreen = rng() & 1;
+	info.bottom_pos = static_cast<BottomRelativePosition>(random_int(rng, 0, 8));
+	info.second_screen_pos = static_cast<SecondScreen3DRelativePosition>(random_int(rng, 0, 8));
+	info.match_bottom_pos_and_second_screen_pos = rng() & 1;
+	info.subscreen_offset = random_int(rng, -100, 200) / 100.0f;
+	info.subscreen_attached_offset = random_int(rng, -100, 200) / 100.0f;
+	info.total_offset_x = random_int(rng, -100, 200) / 100.0f;
+	info.total_offset_y = random_int(rng, -100, 200) / 100.0f;
+	info.top_rotation = random_int(rng, -360, 720);
+	info.bot_rotation = random_int(rng, -360, 720);
+	info.v_sync_enabled = rng() & 1;
+	info.async = rng() & 1;
+	info.top_scaling = random_int(rng, -5, 50);
+	info.bot_scaling = random_int(rng, -5, 50);
+	info.bfi = rng() & 1;
+	info.bfi_divider = random_int(rng, -2, 20);
+	info.bfi_amount = random_int(rng, -2, 20);
+	info.menu_scaling_factor = random_int(rng, -10, 100) / 10.0;
+	info.rounded_corners_fix = rng() & 1;
+	info.top_par = random_int(rng, -2, 30);
+	info.bot_par = random_int(rng, -2, 30);
+	info.fullscreen_mode_width = random_int(rng, -1, 4000);
+	info.fullscreen_mode_height = random_int(rng, -1, 3000);
+	info.fullscreen_mode_bpp = random_int(rng, -1, 64);
+	info.non_integer_mode = static_cast<NonIntegerScalingModes>(random_int(rng, 0, 6));
+	info.use_non_integer_scaling_top = rng() & 1;
+	info.use_non_integer_scaling_bottom = rng() & 1;
+	info.have_titlebar = rng() & 1;
+	info.top_color_correction = random_int(rng, -2, 20);
+	info.bot_color_correction = random_int(rng, -2, 20);
+	info.in_colorspace_top = static_cast<InputColorspaceMode>(random_int(rng, 0, 8));
+	info.in_colorspace_bot = static_cast<InputColorspaceMode>(random_int(rng, 0, 8));
+	info.frame_blending_top = static_cast<FrameBlendingMode>(random_int(rng, 0, 8));
+	info.frame_blending_bot = static_cast<FrameBlendingMode>(random_int(rng, 0, 8));
+	info.window_enabled = rng() & 1;
+	info.force_same_scaling = rng() & 1;
+	info.separator_pixel_size = random_int(rng, -5, 100);
+	info.separator_windowed_multiplier = random_int(rng, -10, 100) / 10.0f;
+	info.separator_fullscreen_multiplier = random_int(rng, -10, 100) / 10.0f;
+	info.squish_3d_top = rng() & 1;
+	info.squish_3d_bot = rng() & 1;
+}
+
+// Lines get shuffled, dropped and mixed with unknown ones, like in hand edited files
+static std::string mix_lines(const std::string &content, std::mt19937 &rng) {
+	std::istringstream data(content);
+	std::vector<std::string> lines;
+	std::string line;
+	while(std::getline(data, line)) {
+		if((rng() % 8) == 0)
+			continue;
+		lines.push_back(line);
+		if((rng() % 16) == 0)
+			lines.push_back("unknown_key_" + std::to_string(rng() % 100) + "=" + std::to_string(rng() % 100));
+		if((rng() % 32) == 0)
+			lines.push_back("no_value_line");
+	}
+	std::shuffle(lines.begin(), lines.end(), rng);
+	std::string out = "";
+	for(size_t i = 0; i < lines.size(); i++)
+		out += lines[i] + "\n";
+	return out;
+}
+
+static void parse_layout(const std::string &content, LayoutConfigSnapshot &snapshot) {
+	std::istringstream data(content);
+	std::string line;
+	while(std::getline(data, line)) {
+		std::istringstream kvp(line);
+		std::string key;
+		std::string value;
+		if((!std::getline(kvp, key, '=')) || (!std::getline(kvp, value)))
+			continue;
+		if(load_screen_info(key, value, "bot_", snapshot.bottom_info))
+			continue;
+		if(load_screen_info(key, value, "joint_", snapshot.joint_info))
+			continue;
+		load_screen_info(key, value, "top_", snapshot.top_info);
+	}
+}
+
+static void random_layout_snapshot_values(LayoutConfigSnapshot &snapshot, std::mt19937 &rng) {
+	snapshot.mono_app_mode = rng() & 1;
+	snapshot.interleaved_3d = rng() & 1;
+	snapshot.do_ratio_cycling = rng() & 1;
+	snapshot.last_connected_ds = rng() & 1;
+	snapshot.requested_3d = rng() & 1;
+	snapshot.is_capture_type = static_cast<CaptureScreensType>(rng() % CAPTURE_SCREENS_ENUM_END);
+	snapshot.is_capture_speed = static_cast<CaptureSpeedsType>(rng() % CAPTURE_SPEEDS_ENUM_END);
+	snapshot.is_battery_percentage = random_int(rng, 5, 100);
+	snapshot.is_ac_adapter_connected = rng() & 1;
+	snapshot.partner_ctr_battery_percentage = random_int(rng, 1, 100);
+	snapshot.partner_ctr_ac_adapter_connected = rng() & 1;
+	snapshot.partner_ctr_ac_adapter_charging = rng() & 1;
+	snapshot.request_low_bw_format = rng() & 1;
+	snapshot.request_low_bw_format_old_2ds = rng() & 1;
+	for(int i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		snapshot.devices_allowed_scan[i] = rng() & 1;
+	snapshot.audio_values.clear();
+	int num_audio_values = random_int(rng, 0, 4);
+	for(int i = 0; i < num_audio_values; i++)
+		snapshot.audio_values.emplace_back("audio_key_" + std::to_string(i), std::to_string(rng() % 200));
+}
+
+static bool are_layout_snapshots_equal(const LayoutConfigSnapshot &a, const LayoutConfigSnapshot &b) {
+	if((memcmp(&a.top_info, &b.top_info, sizeof(ScreenInfo)) != 0) || (memcmp(&a.bottom_info, &b.bottom_info, sizeof(ScreenInfo)) != 0) || (memcmp(&a.joint_info, &b.joint_info, sizeof(ScreenInfo)) != 0))
+		return false;
+	for(int i = 0; i < CC_POSSIBLE_DEVICES_END; i++)
+		if(a.devices_allowed_scan[i] != b.devices_allowed_scan[i])
+			return false;
+	return (a.mono_app_mode == b.mono_app_mode) && (a.interleaved_3d == b.interleaved_3d) &&
+		(a.do_ratio_cycling == b.do_ratio_cycling) && (a.last_connected_ds == b.last_connected_ds) &&
+		(a.requested_3d == b.requested_3d) && (a.is_capture_type == b.is_capture_type) &&
+		(a.is_capture_speed == b.is_capture_speed) && (a.is_battery_percentage == b.is_battery_percentage) &&
+		(a.is_ac_adapter_connected == b.is_ac_adapter_connected) && (a.partner_ctr_battery_percentage == b.partner_ctr_battery_percentage) &&
+		(a.partner_ctr_ac_adapter_connected == b.partner_ctr_ac_adapter_connected) && (a.partner_ctr_ac_adapter_charging == b.partner_ctr_ac_adapter_charging) &&
+		(a.request_low_bw_format == b.request_low_bw_format) && (a.request_low_bw_format_old_2ds == b.request_low_bw_format_old_2ds) &&
+		(a.audio_values == b.audio_values);
+}
+
+static void reset_test_shared_data(SharedData &shared_data) {
+	shared_data.input_data.fast_poll = false;
+	shared_data.input_data.enable_controller_input = true;
+	shared_data.input_data.enable_keyboard_input = true;
+	shared_data.input_data.enable_mouse_input = true;
+	shared_data.input_data.enable_buttons_input = true;
+	shared_data.input_data.extra_button_shortcuts.enter_shortcut = get_window_command(WINDOW_COMMAND_NONE);
+	shared_data.input_data.extra_button_shortcuts.page_up_shortcut = get_window_command(WINDOW_COMMAND_NONE);
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++) {
+		shared_data.thread_scheduling[i].priority_class = THREAD_PRIORITY_CLASS_DEFAULT;
+		shared_data.thread_scheduling[i].cpu = -1;
+	}
+	shared_data.periodic_connection_try = false;
+}
+
+static std::string random_shared_content(std::mt19937 &rng) {
+	const std::string thread_names[] = {"capture", "audio", "display", "usb_events"};
+	std::string out = "";
+	out += "extra_button_enter_short=" + std::to_string(rng() % (WINDOW_COMMAND_SAVE_PROFILE_4 + 1)) + "\n";
+	out += "extra_button_page_up_short=" + std::to_string(rng() % (WINDOW_COMMAND_SAVE_PROFILE_4 + 1)) + "\n";
+	out += "fast_poll=" + std::to_string(rng() & 1) + "\n";
+	out += "enable_keyboard_input=" + std::to_string(rng() & 1) + "\n";
+	out += "enable_controller_input=" + std::to_string(rng() & 1) + "\n";
+	out += "enable_mouse_input=" + std::to_string(rng() & 1) + "\n";
+	out += "enable_buttons_input=" + std::to_string(rng() & 1) + "\n";
+	out += "periodic_connection_try=" + std::to_string(rng() & 1) + "\n";
+	for(size_t i = 0; i < (sizeof(thread_names) / sizeof(thread_names[0])); i++) {
+		out += thread_names[i] + "_thread_priority=" + std::to_string(rng() % THREAD_PRIORITY_CLASS_END) + "\n";
+		out += thread_names[i] + "_thread_cpu=" + std::to_string(random_int(rng, -1, 15)) + "\n";
+	}
+	return mix_lines(out, rng);
+}
+
+static void parse_shared(const std::string &content, SharedData &shared_data) {
+	std::istringstream data(content);
+	std::string line;
+	while(std::getline(data, line)) {
+		std::istringstream kvp(line);
+		std::string key;
+		std::string value;
+		if(std::getline(kvp, key, '=') && std::getline(kvp, value))
+			load_shared_data_value(key, value, &shared_data);
+	}
+}
+
+static bool are_shared_data_equal(const SharedData &a, const SharedData &b) {
+	for(int i = 0; i < THREAD_SCHEDULING_TYPE_END; i++)
+		if((a.thread_scheduling[i].priority_class != b.thread_scheduling[i].priority_class) || (a.thread_scheduling[i].cpu != b.thread_scheduling[i].cpu))
+			return false;
+	return (a.input_data.fast_poll == b.input_data.fast_poll) && (a.input_data.enable_controller_input == b.input_data.enable_controller_input) &&
+		(a.input_data.enable_keyboard_input == b.input_data.enable_keyboard_input) && (a.input_data.enable_mouse_input == b.input_data.enable_mouse_input) &&
+		(a.input_data.enable_buttons_input == b.input_data.enable_buttons_input) &&
+		(a.input_data.extra_button_shortcuts.enter_shortcut == b.input_data.extra_button_shortcuts.enter_shortcut) &&
+		(a.input_data.extra_button_shortcuts.page_up_shortcut == b.input_data.extra_button_shortcuts.page_up_shortcut) &&
+		(a.periodic_connection_try == b.periodic_connection_try);
+}
+
+static std::vector<uint8_t> read_file(const std::string &path) {
+	std::ifstream file(path, std::ios::binary);
+	return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string &path, const void* data, size_t size) {
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	file.write((const char*)data, size);
+}
+
+int main() {
+	std::mt19937 rng(0x5A7C);
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / ("cc3dsfs_test_config_snapshot_" + std::to_string(std::random_device()()));
+	std::filesystem::create_directories(dir);
+	const std::string cfg_path = (dir / "layout.cfg").string();
+	const std::string snapshot_path = cfg_path + CONFIG_SNAPSHOT_EXTENSION;
+	const std::string shared_snapshot_path = (dir / "shared.cfg").string() + CONFIG_SNAPSHOT_EXTENSION;
+
+	for(int i = 0; i < NUM_LAYOUT_FILES; i++) {
+		ScreenInfo source_infos[3];
+		const std::string bases[] = {"top_", "bot_", "joint_"};
+		std::string content = "";
+		for(int j = 0; j < 3; j++) {
+			random_screen_info(source_infos[j], rng);
+			content += save_screen_info(bases[j], source_infos[j]);
+		}
+		content = mix_lines(content, rng);
+		write_file(cfg_path, content.data(), content.size());
+
+		// Zeroed, so the padding is the same wherever it ends up
+		LayoutConfigSnapshot parsed;
+		memset(&parsed.top_info, 0, sizeof(ScreenInfo));
+		memset(&parsed.bottom_info, 0, sizeof(ScreenInfo));
+		memset(&parsed.joint_info, 0, sizeof(ScreenInfo));
+		try {
+			parse_layout(content, parsed);
+		}
+		catch(...) {
+			check(false, "layout file " + std::to_string(i) + " parses");
+			continue;
+		}
+		random_layout_snapshot_values(parsed, rng);
+
+		ConfigSourceState state;
+		check(get_config_source_state(cfg_path, state), "source state of layout file " + std::to_string(i));
+		state.content_hash = get_config_content_hash(content);
+		check(save_layout_config_snapshot(snapshot_path, state, parsed), "layout snapshot " + std::to_string(i) + " saved");
+
+		LayoutConfigSnapshot loaded;
+		ConfigSourceState loaded_state;
+		check(load_layout_config_snapshot(snapshot_path, loaded_state, loaded), "layout snapshot " + std::to_string(i) + " loaded");
+		check(are_layout_snapshots_equal(parsed, loaded), "layout snapshot " + std::to_string(i) + " matches the fresh parse");
+		check(save_screen_info("top_", loaded.top_info) == save_screen_info("top_", parsed.top_info), "layout snapshot " + std::to_string(i) + " saves back the same");
+		check((loaded_state.write_time == state.write_time) && (loaded_state.file_size == state.file_size) && (loaded_state.content_hash == state.content_hash), "layout snapshot " + std::to_string(i) + " source state");
+		check(is_config_source_unchanged(loaded_state, state), "layout file " + std::to_string(i) + " is unchanged");
+	}
+
+	for(int i = 0; i < NUM_SHARED_FILES; i++) {
+		std::string content = random_shared_content(rng);
+		SharedData parsed;
+		reset_test_shared_data(parsed);
+		try {
+			parse_shared(content, parsed);
+		}
+		catch(...) {
+			check(false, "shared file " + std::to_string(i) + " parses");
+			continue;
+		}
+		ConfigSourceState state = {(int64_t)rng(), content.size(), get_config_content_hash(content)};
+		check(save_shared_config_snapshot(shared_snapshot_path, state, parsed), "shared snapshot " + std::to_string(i) + " saved");
+		SharedData loaded;
+		reset_test_shared_data(loaded);
+		ConfigSourceState loaded_state;
+		check(load_shared_config_snapshot(shared_snapshot_path, loaded_state, loaded), "shared snapshot " + std::to_string(i) + " loaded");
+		check(are_shared_data_equal(parsed, loaded), "shared snapshot " + std::to_string(i) + " matches the fresh parse");
+	}
+
+	// The hash only depends on the contents
+	check(get_config_content_hash("top_blur=1\n") == get_config_content_hash(std::string("top_blur=1\n")), "hash is stable");
+	check(get_config_content_hash("top_blur=1\n") != get_config_content_hash("top_blur=0\n"), "hash changes with the contents");
+
+	// A file with a different size is not the same file
+	ConfigSourceState old_state;
+	get_config_source_state(cfg_path, old_state);
+	std::string longer_content = "top_blur=1\ntop_blur=1\ntop_blur=1\n" + std::string(read_file(cfg_path).size(), '\n');
+	write_file(cfg_path, longer_content.data(), longer_content.size());
+	ConfigSourceState new_state;
+	check(get_config_source_state(cfg_path, new_state), "source state after a rewrite");
+	check(!is_config_source_unchanged(old_state, new_state), "rewritten file is detected");
+
+	// Broken snapshots
+	std::vector<uint8_t> good_snapshot = read_file(snapshot_path);
+	LayoutConfigSnapshot dummy;
+	ConfigSourceState dummy_state;
+	int num_accepted_corruptions = 0;
+	for(int i = 0; i < 500; i++) {
+		std::vector<uint8_t> broken = good_snapshot;
+		size_t pos = rng() % broken.size();
+		broken[pos] ^= (uint8_t)(1 + (rng() % 255));
+		write_file(snapshot_path, broken.data(), broken.size());
+		if(load_layout_config_snapshot(snapshot_path, dummy_state, dummy))
+			num_accepted_corruptions++;
+	}
+	check(num_accepted_corruptions == 0, "corrupted snapshots are refused");
+	int num_accepted_truncations = 0;
+	for(size_t i = 0; i < good_snapshot.size(); i++) {
+		write_file(snapshot_path, good_snapshot.data(), i);
+		if(load_layout_config_snapshot(snapshot_path, dummy_state, dummy))
+			num_accepted_truncations++;
+	}
+	check(num_accepted_truncations == 0, "truncated snapshots are refused");
+	write_file(snapshot_path, good_snapshot.data(), good_snapshot.size());
+	check(load_layout_config_snapshot(snapshot_path, dummy_state, dummy), "restored snapshot loads");
+	SharedData dummy_shared;
+	reset_test_shared_data(dummy_shared);
+	SharedData untouched_shared = dummy_shared;
+	check(!load_shared_config_snapshot(snapshot_path, dummy_state, dummy_shared), "layout snapshot is not a shared one");
+	check(are_shared_data_equal(dummy_shared, untouched_shared), "refused shared snapshot changes nothing");
+	check(!load_layout_config_snapshot(shared_snapshot_path, dummy_state, dummy), "shared snapshot is not a layout one");
+	check(!load_layout_config_snapshot((dir / "missing.cfg.snap").string(), dummy_state, dummy), "missing snapshot fails");
+
+	std::error_code error;
+	std::filesystem::remove_all(dir, error);
+
+	return get_test_result();
+}
@@ -0,0 +1,215 @@
+#include "ExtraButtonsLine.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <deque>
+
+// Feeds fake edge sequences to the debouncing of the extra buttons.
+// Checks the bouncing is ignored, and that the line is read again
+// once it settles, even if it settled on the other state.
+// Also checks the queued events nobody processed are not replayed.
+
+#define MS_TO_NS(x) (((uint64_t)(x)) * 1000000)
+
+struct FakeEdge {
+	uint64_t edge_ns;
+	bool is_falling;
+};
+
+class FakeExtraButtonLineSource : public ExtraButtonLineSource {
+public:
+	bool has_events() override {
+		return true;
+	}
+
+	bool is_low() override {
+		this->num_level_reads++;
+		return this->low;
+	}
+
+	int get_event_fd() override {
+		return -1;
+	}
+
+	bool read_edge(uint64_t &edge_ns, bool &is_falling) override {
+		if(this->edges.empty())
+			return false;
+		edge_ns = this->edges.front().edge_ns;
+		is_falling = this->edges.front().is_falling;
+		this->edges.pop_front();
+		return true;
+	}
+
+	uint64_t get_time_ns() override {
+		return this->time_ns;
+	}
+
+	// The line changes, and the kernel queues an edge
+	void add_edge(uint64_t edge_ns, bool is_falling) {
+		this->edges.push_back({edge_ns, is_falling});
+		this->low = is_falling;
+	}
+
+	std::deque<FakeEdge> edges;
+	bool low = false;
+	uint64_t time_ns = 0;
+	int num_level_reads = 0;
+};
+
+static void test_clean_press() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(false);
+	line.time_ns = MS_TO_NS(1000);
+	line.add_edge(MS_TO_NS(1000), true);
+	debouncer.process_events(&line);
+	check(debouncer.is_pressed(), "clean press is seen");
+	check(debouncer.get_resync_timeout_ms(&line) == -1, "clean press needs no resync");
+	line.time_ns = MS_TO_NS(1200);
+	line.add_edge(MS_TO_NS(1200), false);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "clean release is seen");
+	check(line.num_level_reads == 0, "clean edges do not read the line");
+}
+
+// Bounces on press, settling low
+static void test_bounce_settles_pressed() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(false);
+	line.time_ns = MS_TO_NS(500);
+	line.add_edge(MS_TO_NS(500), true);
+	line.add_edge(MS_TO_NS(500) + 200000, false);
+	line.add_edge(MS_TO_NS(500) + 900000, true);
+	line.add_edge(MS_TO_NS(500) + 1500000, false);
+	line.add_edge(MS_TO_NS(500) + 2100000, true);
+	debouncer.process_events(&line);
+	check(debouncer.is_pressed(), "first edge of a bouncy press is taken");
+	int timeout_ms = debouncer.get_resync_timeout_ms(&line);
+	check((timeout_ms > 0) && (timeout_ms <= ((EXTRA_BUTTONS_DEBOUNCE_NS / 1000000) + 1)), "bouncy press asks to be woken up");
+	line.time_ns = MS_TO_NS(500) + EXTRA_BUTTONS_DEBOUNCE_NS;
+	debouncer.process_events(&line);
+	check(debouncer.is_pressed(), "bouncy press stays pressed after the resync");
+	check(line.num_level_reads == 1, "bouncy press reads the line once");
+	check(debouncer.get_resync_timeout_ms(&line) == -1, "bouncy press resync is done");
+}
+
+// Bounces on release, with the kernel delivering the last edges late,
+// so the accepted state is the wrong one until the resync
+static void test_bounce_settles_released() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(true);
+	line.low = true;
+	line.time_ns = MS_TO_NS(2000);
+	line.add_edge(MS_TO_NS(2000), false);
+	line.add_edge(MS_TO_NS(2000) + 300000, true);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "first edge of a bouncy release is taken");
+	line.time_ns = MS_TO_NS(2004);
+	line.add_edge(MS_TO_NS(2000) + 3000000, false);
+	line.add_edge(MS_TO_NS(2000) + 3500000, true);
+	line.add_edge(MS_TO_NS(2000) + 4000000, false);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "bounces do not change the state");
+	check(line.num_level_reads == 0, "the line is not read before it settled");
+	// Only a tiny bit before the deadline
+	line.time_ns = MS_TO_NS(2000) + EXTRA_BUTTONS_DEBOUNCE_NS - 1;
+	debouncer.process_events(&line);
+	check(line.num_level_reads == 0, "the line is not read just before the deadline");
+	check(debouncer.get_resync_timeout_ms(&line) == 1, "resync is due in the next millisecond");
+	line.time_ns = MS_TO_NS(2000) + EXTRA_BUTTONS_DEBOUNCE_NS;
+	check(debouncer.get_resync_timeout_ms(&line) == 0, "resync is due now");
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "bouncy release stays released after the resync");
+	check(line.num_level_reads == 1, "bouncy release reads the line once");
+}
+
+// A bounce gets the state wrong, and only the resync fixes it
+static void test_resync_fixes_state() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(false);
+	line.time_ns = MS_TO_NS(100);
+	line.add_edge(MS_TO_NS(100), true);
+	line.add_edge(MS_TO_NS(100) + 500000, false);
+	debouncer.process_events(&line);
+	check(debouncer.is_pressed(), "glitch is taken as a press");
+	check(!line.low, "the line settled high");
+	line.time_ns = MS_TO_NS(100) + EXTRA_BUTTONS_DEBOUNCE_NS + 1;
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "resync fixes the glitch");
+}
+
+// Edges exactly one debounce period apart are both real
+static void test_debounce_boundary() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(false);
+	line.time_ns = MS_TO_NS(300);
+	line.add_edge(MS_TO_NS(300), true);
+	line.add_edge(MS_TO_NS(300) + EXTRA_BUTTONS_DEBOUNCE_NS, false);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "edge at the debounce boundary is taken");
+	check(debouncer.get_resync_timeout_ms(&line) == -1, "edge at the debounce boundary needs no resync");
+	line.add_edge(MS_TO_NS(300) + (2 * EXTRA_BUTTONS_DEBOUNCE_NS) - 1, true);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "edge just before the debounce boundary is ignored");
+	check(debouncer.get_resync_timeout_ms(&line) >= 0, "edge just before the debounce boundary needs a resync");
+}
+
+// The kernel timestamps should never go back, but don't trust them
+static void test_edges_going_back() {
+	FakeExtraButtonLineSource line;
+	ExtraButtonDebouncer debouncer;
+	debouncer.reset(false);
+	line.time_ns = MS_TO_NS(700);
+	line.add_edge(MS_TO_NS(700), true);
+	line.add_edge(MS_TO_NS(650), false);
+	debouncer.process_events(&line);
+	check(!debouncer.is_pressed(), "edge going back in time is taken");
+}
+
+struct FakeEvent {
+	int id;
+	bool is_extra;
+};
+
+// No window has the focus while a button is pressed, then one gets it.
+// The press must not show up then.
+static void test_unconsumed_events_are_dropped() {
+	LockFreeQueue<FakeEvent, 8> source;
+	std::queue<FakeEvent> window_queue;
+	source.push({1, true});
+	source.push({2, true});
+	take_extra_button_events<FakeEvent>(source, NULL);
+	check(source.empty(), "unconsumed events are dropped");
+	source.push({3, true});
+	take_extra_button_events(source, &window_queue);
+	check((window_queue.size() == 1) && (window_queue.front().id == 3), "focused window only gets the new events");
+	check(source.empty(), "consumed events are not kept");
+}
+
+// The window stops early, with the menu changing under the events
+static void test_unprocessed_events_are_dropped() {
+	std::queue<FakeEvent> window_queue;
+	window_queue.push({1, true});
+	window_queue.push({2, false});
+	window_queue.push({3, true});
+	window_queue.push({4, false});
+	drop_unprocessed_extra_button_events(window_queue, [](const FakeEvent &event_data) { return event_data.is_extra; });
+	check(window_queue.size() == 2, "unprocessed extra button events are dropped");
+	check((window_queue.size() == 2) && (window_queue.front().id == 2) && (window_queue.back().id == 4), "other events are kept in order");
+}
+
+int main() {
+	test_clean_press();
+	test_bounce_settles_pressed();
+	test_bounce_settles_released();
+	test_resync_fixes_state();
+	test_debounce_boundary();
+	test_edges_going_back();
+	test_unconsumed_events_are_dropped();
+	test_unprocessed_events_are_dropped();
+	return get_test_result();
+}
@@ -0,0 +1,120 @@
+#include "capture_structs.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <cmath>
+
+// Feeds a simulated device frame counter to the frame period tracking.
+// Both the period estimator and the clock recovery must find the real
+// period back, through the read jitter, the counter wrapping around and
+// the lost frames.
+
+// The DS refresh rate
+#define SIMULATED_PERIOD (1.0 / 59.8261)
+#define MAX_PERIOD_ERROR 0.001
+
+static bool is_period_close(double period, double expected) {
+	return std::fabs(period - expected) < (expected * MAX_PERIOD_ERROR);
+}
+
+// The ring buffer wraps, and only the last samples are used
+static void test_fit() {
+	double frame_indexes[8];
+	double times[8];
+	for(int i = 0; i < 8; i++) {
+		frame_indexes[i] = 0.0;
+		times[i] = 1000.0;
+	}
+	// Positions 5, 6, 7, 0, 1, 2 hold a line with a period of 0.5
+	int curr_pos = 3;
+	for(int i = 0; i < 6; i++) {
+		int pos = (5 + i) % 8;
+		frame_indexes[pos] = 10.0 + i * 2;
+		times[pos] = 100.0 + (i * 2 * 0.5);
+	}
+	double period = 0.0;
+	check(fit_frame_period(frame_indexes, times, 8, curr_pos, 6, period), "fit works");
+	check(std::fabs(period - 0.5) < 0.000001, "fit finds the slope");
+	check(!fit_frame_period(frame_indexes, times, 8, curr_pos, 1, period), "fit needs two samples");
+	for(int i = 0; i < 8; i++)
+		times[i] = 100.0 - i;
+	frame_indexes[0] = 3.0;
+	frame_indexes[1] = 4.0;
+	check(!fit_frame_period(frame_indexes, times, 8, 2, 2, period), "fit refuses going back in time");
+	frame_indexes[1] = 3.0;
+	check(!fit_frame_period(frame_indexes, times, 8, 2, 2, period), "fit refuses a single frame index");
+}
+
+// An 8 bit counter, read in a loop by a thread which gets interrupted
+static void test_period_estimator(uint32_t counter_mask, double period, std::mt19937 &rng) {
+	FramePeriodEstimator estimator(counter_mask);
+	std::uniform_real_distribution<double> read_spacing(0.0005, 0.003);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	const double start_phase = unit(rng) * period;
+	double time = 0.0;
+	while(time < 20.0) {
+		// The thread gets descheduled, every now and then
+		if(unit(rng) < 0.01)
+			time += unit(rng) * 0.05;
+		else
+			time += read_spacing(rng);
+		uint32_t counter = (uint32_t)(uint64_t)((time + start_phase) / period);
+		estimator.add_read(time, counter);
+	}
+	check(estimator.has_period(), "estimator finds a period");
+	check(is_period_close(estimator.get_period(), period), "estimator finds the right period");
+	estimator.reset();
+	check(!estimator.has_period(), "estimator reset forgets the period");
+}
+
+// Frames arriving late because of the host scheduling, with some lost
+static void test_clock_recovery(bool has_device_frame_counter, std::mt19937 &rng) {
+	FrameClockRecovery frame_clock;
+	std::uniform_real_distribution<double> jitter(0.0, 0.004);
+	std::uniform_real_distribution<double> unit(0.0, 1.0);
+	uint32_t device_counter = 0x10000 - 50;
+	uint64_t total_frames = 0;
+	double last_arrival = 0.0;
+	double max_error = 0.0;
+	int num_checked = 0;
+	for(int i = 0; i < 2000; i++) {
+		uint32_t frames_elapsed = 1;
+		if(unit(rng) < 0.02)
+			frames_elapsed = 2 + (rng() % 3);
+		device_counter = (device_counter + frames_elapsed) & 0xFFFF;
+		total_frames += frames_elapsed;
+		double arrival = (total_frames * SIMULATED_PERIOD) + jitter(rng);
+		double host_frame_time = arrival - last_arrival;
+		last_arrival = arrival;
+		if(i == 0)
+			continue;
+		double smoothed_frame_time = frame_clock.update(host_frame_time, has_device_frame_counter, device_counter);
+		// Give it time to settle
+		if(i < 200)
+			continue;
+		double expected = SIMULATED_PERIOD * frames_elapsed;
+		double error = std::fabs(smoothed_frame_time - expected) / expected;
+		if(error > max_error)
+			max_error = error;
+		num_checked++;
+	}
+	check(num_checked > 0, "clock recovery is checked");
+	// The host jitter is about 25% of a frame
+	check(max_error < 0.01, "clock recovery removes the jitter");
+	// A big jump starts from scratch
+	double host_frame_time = SIMULATED_PERIOD * 100;
+	check(frame_clock.update(host_frame_time, has_device_frame_counter, (device_counter + 100) & 0xFFFF) == host_frame_time, "big jumps pass through");
+}
+
+int main() {
+	std::mt19937 rng(0xF4A3E);
+	test_fit();
+	for(int i = 0; i < 20; i++) {
+		test_period_estimator(0xFF, SIMULATED_PERIOD, rng);
+		test_period_estimator(0xFFFF, 1.0 / 120.0, rng);
+	}
+	test_clock_recovery(true, rng);
+	test_clock_recovery(false, rng);
+	return get_test_result();
+}
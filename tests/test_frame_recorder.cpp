@@ -0,0 +1,128 @@
+#include "FrameRecorder.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+// Round trips the recording video compression, and makes sure broken
+// payloads are refused instead of being read out of bounds.
+
+#define NUM_FRAMES 120
+
+// Something which looks a bit like a game: a static background,
+// some moving sprites and a small area which changes a lot.
+static void generate_frame(uint8_t* frame, size_t size, int frame_num, std::mt19937 &rng) {
+	const size_t line_size = 400 * 3;
+	for(size_t i = 0; i < size; i++)
+		frame[i] = (uint8_t)(((i % line_size) / 24) + ((i / line_size) / 16) * 8);
+	for(int s = 0; s < 8; s++) {
+		size_t sprite_pos = ((s * 70001) + (frame_num * (s + 1) * 3 * 7)) % (size - (32 * line_size));
+		for(size_t y = 0; y < 32; y++)
+			for(size_t x = 0; x < (32 * 3); x++)
+				frame[sprite_pos + (y * line_size) + x] = (uint8_t)(s * 31 + x);
+	}
+	size_t noise_pos = (frame_num * 4093) % (size - 4096);
+	for(size_t i = 0; i < 4096; i++)
+		frame[noise_pos + i] = rng() & 0xFF;
+}
+
+static bool round_trip(const uint8_t* curr, const uint8_t* prev, size_t size, uint8_t* delta, uint8_t* coded, uint8_t* decoded_delta, uint8_t* decoded, size_t &coded_size) {
+	size_t max_delta_size = get_recording_max_compressed_size(size);
+	size_t delta_size = encode_recording_delta(curr, prev, size, delta);
+	if(delta_size > max_delta_size)
+		return false;
+	coded_size = encode_recording_entropy(delta, delta_size, coded);
+	const uint8_t* to_apply = delta;
+	size_t to_apply_size = delta_size;
+	if(coded_size > 0) {
+		if(coded_size >= delta_size)
+			return false;
+		size_t decoded_delta_size = 0;
+		if(!decode_recording_entropy(coded, coded_size, decoded_delta, max_delta_size, decoded_delta_size))
+			return false;
+		if((decoded_delta_size != delta_size) || (memcmp(decoded_delta, delta, delta_size) != 0))
+			return false;
+		to_apply = decoded_delta;
+		to_apply_size = decoded_delta_size;
+	}
+	else
+		coded_size = delta_size;
+	memcpy(decoded, prev, size);
+	if(!decode_recording_delta(to_apply, to_apply_size, decoded, size))
+		return false;
+	return memcmp(decoded, curr, size) == 0;
+}
+
+int main() {
+	std::mt19937 rng(0xC0DE);
+	const size_t size = get_recording_video_raw_size(VIDEO_DATA_RGB);
+	const size_t max_delta_size = get_recording_max_compressed_size(size);
+	std::vector<uint8_t> prev(size, 0);
+	std::vector<uint8_t> curr(size);
+	std::vector<uint8_t> delta(max_delta_size);
+	std::vector<uint8_t> coded(RECORDING_ENTROPY_HEADER_SIZE + max_delta_size);
+	std::vector<uint8_t> decoded_delta(max_delta_size);
+	std::vector<uint8_t> decoded(size);
+
+	uint64_t total_coded_size = 0;
+	for(int i = 0; i < NUM_FRAMES; i++) {
+		generate_frame(curr.data(), size, i, rng);
+		// Keyframes are a difference from an empty frame
+		if((i % RECORDING_KEYFRAME_INTERVAL) == 0)
+			memset(prev.data(), 0, size);
+		size_t coded_size = 0;
+		if(!round_trip(curr.data(), prev.data(), size, delta.data(), coded.data(), decoded_delta.data(), decoded.data(), coded_size)) {
+			std::cout << "Frame " << i << " did not round trip" << std::endl;
+			count_test_failure();
+		}
+		total_coded_size += coded_size;
+		prev = curr;
+	}
+	std::cout << "Synthetic frames ratio: " << ((double)size * NUM_FRAMES) / total_coded_size << std::endl;
+
+	// Random data, odd sizes and a single repeated symbol
+	const size_t odd_sizes[] = {1, 7, 8, 9, 4095, 65537};
+	for(size_t s = 0; s < (sizeof(odd_sizes) / sizeof(odd_sizes[0])); s++) {
+		for(int kind = 0; kind < 3; kind++) {
+			size_t curr_size = odd_sizes[s];
+			for(size_t i = 0; i < curr_size; i++) {
+				if(kind == 0)
+					curr[i] = rng() & 0xFF;
+				else if(kind == 1)
+					curr[i] = 0x55;
+				else
+					curr[i] = (rng() % 16) == 0 ? (rng() & 0xFF) : prev[i];
+			}
+			size_t coded_size = 0;
+			if(!round_trip(curr.data(), prev.data(), curr_size, delta.data(), coded.data(), decoded_delta.data(), decoded.data(), coded_size)) {
+				std::cout << "Size " << curr_size << ", kind " << kind << " did not round trip" << std::endl;
+				count_test_failure();
+			}
+		}
+	}
+
+	// Broken data must be refused, or at least stay in bounds
+	for(int i = 0; i < 2000; i++) {
+		size_t broken_size = rng() % 2048;
+		for(size_t j = 0; j < broken_size; j++)
+			coded[j] = rng() & 0xFF;
+		// Valid lengths, so the decoding loop is actually reached
+		if((i % 2) && (broken_size >= RECORDING_ENTROPY_HEADER_SIZE)) {
+			memset(coded.data(), 0, RECORDING_ENTROPY_NUM_SYMBOLS / 2);
+			coded[0] = 0x11;
+			write_le32(coded.data() + (RECORDING_ENTROPY_NUM_SYMBOLS / 2), rng() % 8192);
+		}
+		size_t decoded_size = 0;
+		decode_recording_entropy(coded.data(), broken_size, decoded_delta.data(), 4096, decoded_size);
+		if(decoded_size > 4096) {
+			std::cout << "Broken data decoded out of bounds" << std::endl;
+			count_test_failure();
+		}
+		decode_recording_delta(coded.data(), broken_size, decoded.data(), 4096);
+	}
+
+	return get_test_result();
+}
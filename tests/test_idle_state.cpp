@@ -0,0 +1,176 @@
+#include "IdleState.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <vector>
+#include <cmath>
+
+// Runs the main loop and the capture thread's idle steps on a fake clock,
+// with nothing connected, and counts how many times each wakes up every
+// second. Both must keep their full rate until the idle state starts, back
+// off together once it does, and go back to the full rate on input, or
+// right away when a device connects.
+
+#define SIMULATED_SECONDS 40
+#define INPUT_TIME 20.0
+#define CONNECT_TIME 35.0
+#define FRAME_PERIOD (1.0 / USB_FPS)
+
+class FakeIdleClock : public IdleClock {
+public:
+	double now() override {
+		return this->time;
+	}
+
+	double time = 0.0;
+};
+
+struct WakeupCounts {
+	int main_loop[SIMULATED_SECONDS];
+	int capture[SIMULATED_SECONDS];
+	int draws[SIMULATED_SECONDS];
+	double capture_first_backoff_time;
+	// Of the main loop's pass which saw the device
+	double connect_time;
+	double main_wait_after_connect;
+	double capture_wake_after_connect;
+};
+
+static void simulate(WakeupCounts &counts) {
+	FakeIdleClock clock;
+	IdleState idle_state(&clock);
+	IdleBackoff main_backoff(IDLE_MIN_WAIT, IDLE_MAIN_LOOP_MAX_WAIT);
+	IdleBackoff capture_backoff(IDLE_MIN_WAIT, IDLE_CAPTURE_MAX_WAIT);
+	for(int i = 0; i < SIMULATED_SECONDS; i++) {
+		counts.main_loop[i] = 0;
+		counts.capture[i] = 0;
+		counts.draws[i] = 0;
+	}
+	counts.capture_first_backoff_time = -1.0;
+	counts.connect_time = -1.0;
+	counts.main_wait_after_connect = -1.0;
+	counts.capture_wake_after_connect = -1.0;
+	double main_next_time = 0.0;
+	double capture_next_time = 0.0;
+	bool did_input = false;
+	bool is_connected = false;
+	// Like CaptureStatus.idle
+	volatile bool published_idle = false;
+
+	while(true) {
+		bool is_main_loop = main_next_time <= capture_next_time;
+		clock.time = is_main_loop ? main_next_time : capture_next_time;
+		if(clock.time >= SIMULATED_SECONDS)
+			break;
+		int second = (int)clock.time;
+		if(is_main_loop) {
+			if((!did_input) && (clock.time >= INPUT_TIME)) {
+				idle_state.activity();
+				did_input = true;
+			}
+			bool just_connected = (!is_connected) && (clock.time >= CONNECT_TIME);
+			if(just_connected) {
+				is_connected = true;
+				counts.connect_time = clock.time;
+				// The connection_wait unlock
+				capture_next_time = clock.time;
+			}
+			counts.main_loop[second]++;
+			double wait = idle_main_loop_step(idle_state, main_backoff, is_connected, published_idle);
+			if(idle_state.should_draw())
+				counts.draws[second]++;
+			if(just_connected)
+				counts.main_wait_after_connect = wait;
+			main_next_time = clock.time + wait;
+		}
+		else {
+			// Connected, it goes to the capture loop instead
+			if(is_connected) {
+				if(counts.capture_wake_after_connect < 0)
+					counts.capture_wake_after_connect = clock.time;
+				capture_next_time = SIMULATED_SECONDS;
+				continue;
+			}
+			counts.capture[second]++;
+			double wait = idle_capture_loop_step(capture_backoff, published_idle);
+			if((wait > IDLE_MIN_WAIT) && (counts.capture_first_backoff_time < 0))
+				counts.capture_first_backoff_time = clock.time;
+			capture_next_time = clock.time + wait;
+		}
+	}
+}
+
+static void test_backoff() {
+	IdleBackoff backoff(0.01, 0.05);
+	check(backoff.get_wait(false) == 0.01, "not idle waits the minimum");
+	check(backoff.get_wait(true) == 0.01, "first idle wait is the minimum");
+	check(backoff.get_wait(true) == 0.02, "idle wait doubles");
+	check(backoff.get_wait(true) == 0.04, "idle wait doubles again");
+	check(backoff.get_wait(true) == 0.05, "idle wait is capped");
+	check(backoff.get_wait(true) == 0.05, "idle wait stays capped");
+	check(backoff.get_wait(false) == 0.01, "activity resets the wait");
+	check(backoff.get_wait(true) == 0.01, "backoff starts over");
+}
+
+static void test_idle_state() {
+	FakeIdleClock clock;
+	IdleState idle_state(&clock);
+	check(!idle_state.is_idle(), "not idle at the start");
+	clock.time = IDLE_ENTER_TIME - 0.001;
+	check(!idle_state.is_idle(), "not idle before the enter time");
+	clock.time = IDLE_ENTER_TIME + 0.001;
+	check(idle_state.is_idle(), "idle after the enter time");
+	idle_state.activity();
+	check(!idle_state.is_idle(), "activity ends the idle state");
+}
+
+static void test_wakeups() {
+	WakeupCounts counts;
+	simulate(counts);
+	const int full_rate = (int)(1.0 / IDLE_MIN_WAIT);
+	const int main_idle_rate = (int)std::round(1.0 / IDLE_MAIN_LOOP_MAX_WAIT);
+	const int capture_idle_rate = (int)std::round(1.0 / IDLE_CAPTURE_MAX_WAIT);
+	const int idle_draw_rate = (int)std::round(1.0 / IDLE_REDRAW_PERIOD);
+
+	for(int i = 0; i < SIMULATED_SECONDS; i++)
+		std::cout << "Second " << i << ": main loop " << counts.main_loop[i] << "/s, capture " << counts.capture[i] << "/s, draws " << counts.draws[i] << "/s" << std::endl;
+
+	// Right after a disconnect, nothing backs off yet
+	check(counts.capture_first_backoff_time >= IDLE_ENTER_TIME, "capture thread only backs off once idle");
+	for(int i = 0; i < (int)IDLE_ENTER_TIME; i++) {
+		std::string second = "second " + std::to_string(i);
+		check(std::abs(counts.main_loop[i] - full_rate) <= 1, "main loop at full rate before idle, " + second);
+		check(std::abs(counts.capture[i] - full_rate) <= 1, "capture thread at full rate before idle, " + second);
+		check(counts.draws[i] == counts.main_loop[i], "every pass draws before idle, " + second);
+	}
+	for(int i = (int)IDLE_ENTER_TIME + 2; i < (int)INPUT_TIME; i++) {
+		std::string second = "second " + std::to_string(i);
+		check(std::abs(counts.main_loop[i] - main_idle_rate) <= 1, "main loop backed off while idle, " + second);
+		check(std::abs(counts.capture[i] - capture_idle_rate) <= 1, "capture thread backed off while idle, " + second);
+		check(counts.draws[i] <= idle_draw_rate, "few draws while idle, " + second);
+	}
+	// The capture thread may still be in its longest wait when the input comes
+	for(int i = (int)INPUT_TIME + 1; i < (int)(INPUT_TIME + IDLE_ENTER_TIME); i++) {
+		std::string second = "second " + std::to_string(i);
+		check(std::abs(counts.main_loop[i] - full_rate) <= 1, "main loop at full rate after input, " + second);
+		check(std::abs(counts.capture[i] - full_rate) <= 1, "capture thread at full rate after input, " + second);
+	}
+	// Idle again by then
+	check(std::abs(counts.main_loop[(int)CONNECT_TIME - 1] - main_idle_rate) <= 1, "main loop backed off before connecting");
+	check(counts.connect_time >= CONNECT_TIME, "device connected");
+	check(counts.main_wait_after_connect <= FRAME_PERIOD, "main loop back to full rate within a frame of connecting");
+	check((counts.capture_wake_after_connect >= counts.connect_time) && ((counts.capture_wake_after_connect - counts.connect_time) <= FRAME_PERIOD), "capture thread woken within a frame of connecting");
+	for(int i = (int)CONNECT_TIME + 1; i < SIMULATED_SECONDS; i++) {
+		std::string second = "second " + std::to_string(i);
+		check(std::abs(counts.main_loop[i] - full_rate) <= 1, "main loop at full rate while connected, " + second);
+		check(counts.draws[i] == counts.main_loop[i], "every pass draws while connected, " + second);
+	}
+}
+
+int main() {
+	test_backoff();
+	test_idle_state();
+	test_wakeups();
+
+	return get_test_result();
+}
@@ -0,0 +1,69 @@
+#include "usb_is_device_crc32.hpp"
+#include "ccitt32_crc32_table.h"
+#include "utils.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Checks the sliced CRC32 of the IS devices against the plain
+// byte-wise version, for random data, sizes and alignments.
+
+#define NUM_RANDOM_CASES 200000
+#define MAX_RANDOM_SIZE 0x400
+#define MAX_ALIGNMENT 16
+
+static uint32_t get_crc32_data_comm_reference(const uint8_t* data, size_t size) {
+	uint32_t value = 0xFFFFFFFF;
+	for(size_t i = 0; i < size; i++) {
+		uint8_t inner_value = (value >> 24) ^ data[i];
+		value <<= 8;
+		value ^= read_le32(ccitt32_crc32_table, inner_value);
+	}
+	return ~value;
+}
+
+int main() {
+	std::mt19937 rng(0xC3C32);
+	std::vector<uint8_t> buffer(MAX_RANDOM_SIZE + MAX_ALIGNMENT + 0x10000);
+	for(size_t i = 0; i < buffer.size(); i++)
+		buffer[i] = rng() & 0xFF;
+
+	// The MSB first CRC32 with this table is CRC-32/BZIP2
+	const uint8_t check_data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+	check(get_crc32_data_comm(check_data, sizeof(check_data)) == 0xFC891918, "Check value");
+	check(get_crc32_data_comm(buffer.data(), 0) == 0, "Empty data");
+
+	for(int i = 0; i < NUM_RANDOM_CASES; i++) {
+		size_t size = rng() % MAX_RANDOM_SIZE;
+		// Mostly small packets, like the real ones
+		if((i % 4) == 0)
+			size = rng() % 0x100;
+		size_t alignment = rng() % MAX_ALIGNMENT;
+		// Change the data from time to time
+		if((i % 64) == 0)
+			for(size_t j = 0; j < 64; j++)
+				buffer[rng() % buffer.size()] = rng() & 0xFF;
+		const uint8_t* data = buffer.data() + alignment;
+		if(get_crc32_data_comm(data, size) != get_crc32_data_comm_reference(data, size)) {
+			if(test_num_failed < 16)
+				std::cout << "Size " << size << ", alignment " << alignment << " does not match" << std::endl;
+			count_test_failure();
+		}
+	}
+
+	// The packets with the biggest payloads
+	const size_t big_sizes[] = {0xB4, 0x8000, 0x10000};
+	for(size_t i = 0; i < (sizeof(big_sizes) / sizeof(big_sizes[0])); i++) {
+		for(size_t alignment = 0; alignment < MAX_ALIGNMENT; alignment++) {
+			const uint8_t* data = buffer.data() + alignment;
+			if(get_crc32_data_comm(data, big_sizes[i]) != get_crc32_data_comm_reference(data, big_sizes[i])) {
+				std::cout << "Size " << big_sizes[i] << ", alignment " << alignment << " does not match" << std::endl;
+				count_test_failure();
+			}
+		}
+	}
+
+	return get_test_result();
+}
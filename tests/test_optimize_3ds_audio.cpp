@@ -0,0 +1,232 @@
+#include "conversions_audio_optimize.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cstring>
+
+// Compares the strided Optimize 3DS audio gather with the per-column
+// LE/BE implementations it replaced.
+
+enum OptimizeAudioLayout {LAYOUT_2D, LAYOUT_3D, LAYOUT_FORCED_2D};
+
+#define MAX_OUT_SAMPLES (((TOP_WIDTH_3DS * 2) + 2) * 2 * 2)
+
+// What a Big Endian host reads from a native uint16_t field
+static uint16_t read_native_be_host(const uint8_t* data) {
+	return (data[0] << 8) | data[1];
+}
+
+static uint16_t read_native_le_host(const uint8_t* data) {
+	return data[0] | (data[1] << 8);
+}
+
+static uint16_t reverse_u16(uint16_t value) {
+	return (value >> 8) | (value << 8);
+}
+
+static USB3DSOptimizeHeaderSoundData* ref_header_2d(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565.columns_data[column].header_sound;
+	return &buffer->cypress_optimize_received_888.columns_data[column].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* ref_header_2d_extra(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565_extra_header.columns_data[column].header_sound;
+	return &buffer->cypress_optimize_received_888_extra_header.columns_data[column].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* ref_header_3d(CaptureReceived* buffer, bool is_rgb888, uint16_t column) {
+	if(!is_rgb888) {
+		int target_column = column / 2;
+		if((column % 2) == 0)
+			return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].top_r_screen_column.header_sound;
+		return &buffer->cypress_optimize_received_565_3d.columns_data[target_column].bot_top_l_screens_column.header_sound;
+	}
+	return &buffer->cypress_optimize_received_888_3d.columns_data[column / 2][column % 2].header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* ref_header_3d_extra(CaptureReceived* buffer, bool is_rgb888) {
+	if(!is_rgb888)
+		return &buffer->cypress_optimize_received_565_3d.bottom_only_column.header_sound;
+	return &buffer->cypress_optimize_received_888_3d.bottom_only_column.header_sound;
+}
+
+static USB3DSOptimizeHeaderSoundData* ref_header_forced_2d(CaptureReceived* buffer, uint16_t column) {
+	return &buffer->cypress_optimize_received_888_3d_2d.columns_data[column].header_sound;
+}
+
+// The removed copyAudioFromSoundDataOptimize3DSLE/BE.
+// The BE one is run as a Big Endian host would run it.
+static void ref_copy_sample(std::int16_t *p_out, USB3DSOptimizeSingleSoundData* sample, uint64_t& num_inserted, int& last_inserted_index, bool emulate_be_host) {
+	uint16_t read_index;
+	uint16_t sample_l;
+	uint16_t sample_r;
+	if(emulate_be_host) {
+		read_index = reverse_u16(read_native_be_host((uint8_t*)&sample->sample_index)) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
+		sample_l = reverse_u16(read_native_be_host((uint8_t*)&sample->sample_l));
+		sample_r = reverse_u16(read_native_be_host((uint8_t*)&sample->sample_r));
+	}
+	else {
+		read_index = read_native_le_host((uint8_t*)&sample->sample_index) % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
+		sample_l = read_native_le_host((uint8_t*)&sample->sample_l);
+		sample_r = read_native_le_host((uint8_t*)&sample->sample_r);
+	}
+	if(read_index == last_inserted_index)
+		return;
+	p_out[num_inserted * 2] = (std::int16_t)sample_l;
+	p_out[(num_inserted * 2) + 1] = (std::int16_t)sample_r;
+	num_inserted += 1;
+	last_inserted_index = read_index;
+}
+
+static void ref_copy_header(std::int16_t *p_out, USB3DSOptimizeHeaderSoundData* header, uint64_t& num_inserted, int& last_inserted_index, bool emulate_be_host) {
+	ref_copy_sample(p_out, &header->samples[0], num_inserted, last_inserted_index, emulate_be_host);
+	ref_copy_sample(p_out, &header->samples[1], num_inserted, last_inserted_index, emulate_be_host);
+}
+
+// The removed mixAudioToMono pass
+static void ref_mix_to_mono(std::int16_t *p_out, uint64_t n_samples) {
+	for(uint64_t i = 0; i < (n_samples / 2); i++) {
+		std::int16_t avg = mix_audio_samples_mono(p_out[i * 2], p_out[(i * 2) + 1]);
+		p_out[i * 2] = avg;
+		p_out[(i * 2) + 1] = avg;
+	}
+}
+
+static void ref_copy_audio(std::int16_t *p_out, uint64_t &n_samples, uint16_t &last_buffer_index, CaptureReceived* buffer, bool is_rgb888, OptimizeAudioLayout layout, bool force_check_extra_header, bool is_mono, bool emulate_be_host) {
+	uint64_t num_inserted = 0;
+	int last_inserted_index = last_buffer_index;
+	switch(layout) {
+		case LAYOUT_3D:
+			for(int i = 0; i < TOP_WIDTH_3DS * 2; i++)
+				ref_copy_header(p_out, ref_header_3d(buffer, is_rgb888, i), num_inserted, last_inserted_index, emulate_be_host);
+			ref_copy_header(p_out, ref_header_3d_extra(buffer, is_rgb888), num_inserted, last_inserted_index, emulate_be_host);
+			break;
+		case LAYOUT_FORCED_2D:
+			for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++)
+				ref_copy_header(p_out, ref_header_forced_2d(buffer, i), num_inserted, last_inserted_index, emulate_be_host);
+			break;
+		default:
+			for(int i = 0; i < TOP_WIDTH_3DS; i++)
+				ref_copy_header(p_out, ref_header_2d(buffer, is_rgb888, i), num_inserted, last_inserted_index, emulate_be_host);
+			if(force_check_extra_header || usb_OptimizeHasExtraHeaderSoundData(ref_header_2d(buffer, is_rgb888, 0)))
+				ref_copy_header(p_out, ref_header_2d_extra(buffer, is_rgb888, TOP_WIDTH_3DS), num_inserted, last_inserted_index, emulate_be_host);
+			break;
+	}
+	last_buffer_index = last_inserted_index;
+	n_samples = num_inserted * 2;
+	if(is_mono)
+		ref_mix_to_mono(p_out, n_samples);
+}
+
+static std::vector<USB3DSOptimizeHeaderSoundData*> get_all_headers(CaptureReceived* buffer, bool is_rgb888, OptimizeAudioLayout layout) {
+	std::vector<USB3DSOptimizeHeaderSoundData*> headers;
+	switch(layout) {
+		case LAYOUT_3D:
+			for(int i = 0; i < TOP_WIDTH_3DS * 2; i++)
+				headers.push_back(ref_header_3d(buffer, is_rgb888, i));
+			headers.push_back(ref_header_3d_extra(buffer, is_rgb888));
+			break;
+		case LAYOUT_FORCED_2D:
+			for(int i = 0; i < (TOP_WIDTH_3DS + 1); i++)
+				headers.push_back(ref_header_forced_2d(buffer, i));
+			break;
+		default:
+			for(int i = 0; i < TOP_WIDTH_3DS; i++)
+				headers.push_back(ref_header_2d(buffer, is_rgb888, i));
+			headers.push_back(ref_header_2d_extra(buffer, is_rgb888, TOP_WIDTH_3DS));
+			break;
+	}
+	return headers;
+}
+
+// Real frames carry increasing indexes, with each sample usually sent twice.
+// Make the indexes follow that, with random repeats and wrap-arounds.
+static uint16_t fill_sample_indexes(CaptureReceived* buffer, bool is_rgb888, OptimizeAudioLayout layout, std::mt19937 &rng) {
+	std::vector<USB3DSOptimizeHeaderSoundData*> headers = get_all_headers(buffer, is_rgb888, layout);
+	uint16_t first_index = rng() & 0xFFFF;
+	uint16_t curr_index = first_index;
+	for(size_t i = 0; i < headers.size(); i++) {
+		for(int j = 0; j < 2; j++) {
+			uint8_t* index_ptr = (uint8_t*)&headers[i]->samples[j].sample_index;
+			index_ptr[0] = curr_index & 0xFF;
+			index_ptr[1] = curr_index >> 8;
+			if((rng() % 3) != 0)
+				curr_index += 1 + ((rng() % 8) == 0 ? OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE : 0);
+		}
+	}
+	return first_index % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
+}
+
+static bool run_case(CaptureReceived* buffer, bool is_rgb888, OptimizeAudioLayout layout, bool structured_indexes, std::mt19937 &rng) {
+	// Only the sound headers are read, so only those need new data
+	std::vector<USB3DSOptimizeHeaderSoundData*> headers = get_all_headers(buffer, is_rgb888, layout);
+	for(size_t i = 0; i < headers.size(); i++) {
+		uint8_t* raw_header = (uint8_t*)headers[i];
+		for(size_t j = 0; j < sizeof(USB3DSOptimizeHeaderSoundData); j++)
+			raw_header[j] = rng() & 0xFF;
+	}
+	uint16_t last_buffer_index = rng() % OPTIMIZE_3DS_AUDIO_BUFFER_MAX_SIZE;
+	if(structured_indexes) {
+		uint16_t first_index = fill_sample_indexes(buffer, is_rgb888, layout, rng);
+		// Repeat the last sample of the previous frame, sometimes
+		if(rng() % 2)
+			last_buffer_index = first_index;
+	}
+	bool force_check_extra_header = rng() % 2;
+	bool is_mono = rng() % 2;
+	bool is_data_3d = layout == LAYOUT_3D;
+	bool is_forced_2d = layout == LAYOUT_FORCED_2D;
+
+	std::int16_t out_new[MAX_OUT_SAMPLES];
+	uint64_t n_samples_new = 0;
+	uint16_t last_index_new = last_buffer_index;
+	memset(out_new, 0, sizeof(out_new));
+	copyAudioOptimize3DSToOutput(out_new, n_samples_new, last_index_new, buffer, is_rgb888, is_data_3d, is_forced_2d, force_check_extra_header, is_mono);
+
+	for(int emulate_be_host = 0; emulate_be_host < 2; emulate_be_host++) {
+		std::int16_t out_ref[MAX_OUT_SAMPLES];
+		uint64_t n_samples_ref = 0;
+		uint16_t last_index_ref = last_buffer_index;
+		memset(out_ref, 0, sizeof(out_ref));
+		ref_copy_audio(out_ref, n_samples_ref, last_index_ref, buffer, is_rgb888, layout, force_check_extra_header, is_mono, emulate_be_host);
+		bool matches = (n_samples_ref == n_samples_new) && (last_index_ref == last_index_new);
+		if(matches && (n_samples_ref > 0))
+			matches = memcmp(out_ref, out_new, (size_t)(n_samples_ref * sizeof(std::int16_t))) == 0;
+		if(!matches) {
+			std::cout << "Mismatch - layout: " << layout << ", rgb888: " << is_rgb888 << ", structured: " << structured_indexes;
+			std::cout << ", mono: " << is_mono << ", BE host: " << emulate_be_host;
+			std::cout << ", samples: " << n_samples_new << " vs " << n_samples_ref << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+int main() {
+	std::mt19937 rng(0x3D5);
+	CaptureReceived* buffer = new CaptureReceived;
+	uint8_t* raw_buffer = (uint8_t*)buffer;
+	for(size_t i = 0; i < sizeof(CaptureReceived); i++)
+		raw_buffer[i] = rng() & 0xFF;
+	const int num_iters = 200;
+	for(int i = 0; i < num_iters; i++) {
+		for(int structured = 0; structured < 2; structured++) {
+			if(!run_case(buffer, false, LAYOUT_2D, structured, rng))
+				count_test_failure();
+			if(!run_case(buffer, true, LAYOUT_2D, structured, rng))
+				count_test_failure();
+			if(!run_case(buffer, false, LAYOUT_3D, structured, rng))
+				count_test_failure();
+			if(!run_case(buffer, true, LAYOUT_3D, structured, rng))
+				count_test_failure();
+			if(!run_case(buffer, true, LAYOUT_FORCED_2D, structured, rng))
+				count_test_failure();
+		}
+	}
+	delete buffer;
+	return get_test_result();
+}
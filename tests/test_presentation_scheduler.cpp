@@ -0,0 +1,124 @@
+#include "PresentationScheduler.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+
+// Runs the BFI scheduler on a fake clock. Checks it waits for the
+// deadlines, and that the miss log counts from the deadline to the
+// moment the sub-frame was shown.
+
+class FakePresentationClock : public PresentationClock {
+public:
+	double now() override {
+		// Spinning must move time forward, or it would never end
+		this->time += this->now_step;
+		this->num_now_calls++;
+		return this->time;
+	}
+
+	void sleep(double seconds) override {
+		this->time += seconds + this->oversleep;
+		this->num_sleeps++;
+	}
+
+	double time = 0.0;
+	double now_step = 0.00001;
+	double oversleep = 0.0;
+	int num_now_calls = 0;
+	int num_sleeps = 0;
+};
+
+// A fast display, a precise sleep: nothing is late
+static void test_on_time() {
+	FakePresentationClock clock;
+	PresentationScheduler scheduler(&clock);
+	const double slot_time = 1.0 / 240;
+	scheduler.start_frame(slot_time);
+	double frame_start = clock.time;
+	for(int i = 1; i < 4; i++) {
+		double lateness = scheduler.wait_until(slot_time * i);
+		check(clock.time >= (frame_start + (slot_time * i)), "wait reaches the deadline");
+		check((lateness >= 0.0) && (lateness <= clock.now_step), "wait ends right at the deadline");
+		clock.time += 0.0005;
+		double miss = scheduler.presented();
+		check((miss >= 0.0005) && (miss < 0.0006), "miss counts the display time");
+	}
+	check(clock.num_sleeps == 3, "sleeps once per sub-frame");
+	PresentationMissStats stats = scheduler.get_stats();
+	check(stats.num_deadlines == 3, "every sub-frame is logged");
+	check(stats.num_late == 0, "nothing is late");
+}
+
+// The deadlines do not drift when the sleeps overshoot
+static void test_no_drift() {
+	FakePresentationClock clock;
+	PresentationScheduler scheduler(&clock);
+	const double slot_time = 0.004;
+	clock.oversleep = 0.0015;
+	scheduler.start_frame(slot_time);
+	double frame_start = clock.time;
+	for(int i = 1; i <= 8; i++) {
+		double lateness = scheduler.wait_until(slot_time * i);
+		// Slept until the spin time, the oversleep fits in it
+		check(lateness <= clock.now_step, "oversleeping less than the spin time is absorbed");
+		check(clock.time < (frame_start + (slot_time * i) + (2 * clock.now_step)), "the deadlines do not drift");
+		scheduler.presented();
+	}
+	clock.oversleep = PRESENTATION_SPIN_TIME + 0.001;
+	double lateness = scheduler.wait_until(slot_time * 9);
+	check((lateness > 0.0009) && (lateness < 0.0011), "oversleeping past the spin time shows as lateness");
+}
+
+// Draws slower than a slot are counted as late
+static void test_late_display() {
+	FakePresentationClock clock;
+	PresentationScheduler scheduler(&clock);
+	const double slot_time = 0.004;
+	scheduler.start_frame(slot_time);
+	scheduler.wait_until(slot_time);
+	clock.time += 0.001;
+	scheduler.presented();
+	scheduler.wait_until(slot_time * 2);
+	// A swap which blocked for more than a whole slot
+	clock.time += 0.007;
+	double miss = scheduler.presented();
+	check((miss > 0.007) && (miss < 0.0071), "slow display is measured");
+	// The next deadline is already gone
+	double lateness = scheduler.wait_until(slot_time * 3);
+	check(lateness > 0.002, "a deadline in the past does not wait");
+	scheduler.presented();
+	PresentationMissStats stats = scheduler.get_stats();
+	check(stats.num_deadlines == 3, "late sub-frames are logged");
+	check(stats.num_late == 1, "only the slow display is late");
+	check((stats.max_miss > 0.007) && (stats.max_miss < 0.0071), "max miss is the slow display");
+	check((stats.avg_miss > ((0.001 + 0.007) / 3)) && (stats.avg_miss < ((0.001 + 0.007 + 0.004) / 3)), "average miss");
+}
+
+// Only the last PRESENTATION_MISS_LOG_SIZE sub-frames count
+static void test_log_wraps() {
+	FakePresentationClock clock;
+	PresentationScheduler scheduler(&clock);
+	const double slot_time = 0.004;
+	scheduler.start_frame(slot_time);
+	scheduler.wait_until(slot_time);
+	clock.time += 0.01;
+	scheduler.presented();
+	check(scheduler.get_stats().num_late == 1, "late sub-frame is counted");
+	for(int i = 0; i < PRESENTATION_MISS_LOG_SIZE; i++) {
+		scheduler.start_frame(slot_time);
+		scheduler.wait_until(slot_time);
+		scheduler.presented();
+	}
+	PresentationMissStats stats = scheduler.get_stats();
+	check(stats.num_deadlines == PRESENTATION_MISS_LOG_SIZE, "log size is capped");
+	check(stats.num_late == 0, "old late sub-frames are forgotten");
+	check(stats.max_miss < 0.001, "old max miss is forgotten");
+}
+
+int main() {
+	test_on_time();
+	test_no_drift();
+	test_late_display();
+	test_log_wraps();
+	return get_test_result();
+}
@@ -0,0 +1,103 @@
+#include "ShadersLoading.hpp"
+#include "test_utils.hpp"
+
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+// Loads the real shaders like the windows do, and presents a first frame
+// drawn with one of them. Meant to run on software GL (LIBGL_ALWAYS_SOFTWARE=1),
+// so it does not depend on a GPU.
+// The loading must be over before the first frame is presented. The first
+// frame must not be later than when the first window's constructor compiled
+// the shaders itself, both right away and after the windows' own setup.
+
+#define TEST_SKIPPED 77
+// Stands in for creating the windows, the device listing and so on
+#define WINDOWS_SETUP_TIME_MS 1000
+#define FIRST_FRAME_TOLERANCE_MS 10.0
+
+typedef std::chrono::time_point<std::chrono::steady_clock> TestTimePoint;
+
+static double get_diff_ms(TestTimePoint start, TestTimePoint end) {
+	return std::chrono::duration<double>(end - start).count() * 1000.0;
+}
+
+static int count_valid_shaders(std::vector<shader_and_data> &shaders) {
+	int num_valid = 0;
+	for(size_t i = 0; i < shaders.size(); i++)
+		if(shaders[i].is_valid)
+			num_valid++;
+	return num_valid;
+}
+
+static void present_first_frame(std::vector<shader_and_data> &shaders) {
+	sf::RenderTexture window_tex;
+	if(!window_tex.resize({400, 480}))
+		return;
+	sf::RectangleShape frame_rect({400, 480});
+	window_tex.clear();
+	if(shaders[NO_EFFECT_FRAGMENT_SHADER].is_valid)
+		window_tex.draw(frame_rect, &shaders[NO_EFFECT_FRAGMENT_SHADER].shader);
+	window_tex.display();
+	(void)window_tex.getTexture().copyToImage();
+}
+
+// How the first window's constructor used to do it
+static double get_compiled_first_frame_ms(int setup_time_ms) {
+	std::vector<shader_and_data> shaders;
+	prepare_shaders(shaders);
+	TestTimePoint start_time = std::chrono::steady_clock::now();
+	compile_shaders(shaders);
+	std::this_thread::sleep_for(std::chrono::milliseconds(setup_time_ms));
+	present_first_frame(shaders);
+	return get_diff_ms(start_time, std::chrono::steady_clock::now());
+}
+
+static double get_loaded_first_frame_ms(int setup_time_ms, int &num_valid, int &num_warmed_up) {
+	std::vector<shader_and_data> shaders;
+	ShadersLoading shaders_loading;
+	prepare_shaders(shaders);
+	TestTimePoint start_time = std::chrono::steady_clock::now();
+	shaders_loading.start(&shaders);
+	std::this_thread::sleep_for(std::chrono::milliseconds(setup_time_ms));
+	shaders_loading.wait();
+	TestTimePoint present_time = std::chrono::steady_clock::now();
+	present_first_frame(shaders);
+	double first_frame_ms = get_diff_ms(start_time, std::chrono::steady_clock::now());
+	check(shaders_loading.get_done_time() <= present_time, "loading done before the first present, setup of " + std::to_string(setup_time_ms) + " ms");
+	num_valid = count_valid_shaders(shaders);
+	num_warmed_up = shaders_loading.get_num_warmed_up();
+	std::cout << "Setup of " << setup_time_ms << " ms: compiled in " << (int)(shaders_loading.get_compile_time() * 1000) << " ms, " << num_warmed_up << "/" << num_valid << " warmed up in " << (int)(shaders_loading.get_warm_up_time() * 1000) << " ms" << std::endl;
+	return first_frame_ms;
+}
+
+static void test_first_frame(int setup_time_ms) {
+	double compiled_ms = get_compiled_first_frame_ms(setup_time_ms);
+	int num_valid = 0;
+	int num_warmed_up = 0;
+	double loaded_ms = get_loaded_first_frame_ms(setup_time_ms, num_valid, num_warmed_up);
+	std::cout << "Setup of " << setup_time_ms << " ms: first frame after " << loaded_ms << " ms, " << compiled_ms << " ms when compiled right away" << std::endl;
+	std::string setup = "setup of " + std::to_string(setup_time_ms) + " ms";
+	check(num_valid > 0, "shaders compile, " + setup);
+	check(loaded_ms <= (compiled_ms + FIRST_FRAME_TOLERANCE_MS), "first frame not later than when compiled right away, " + setup);
+	if(setup_time_ms >= WINDOWS_SETUP_TIME_MS)
+		check(num_warmed_up == num_valid, "all warmed up during the setup, " + setup);
+}
+
+int main() {
+	#if defined(__linux__)
+	// SFML aborts when it can't open a display
+	if(getenv("DISPLAY") == NULL) {
+		std::cout << "No display, skipped" << std::endl;
+		return TEST_SKIPPED;
+	}
+	#endif
+	if(!sf::Shader::isAvailable()) {
+		std::cout << "No shaders, skipped" << std::endl;
+		return TEST_SKIPPED;
+	}
+	test_first_frame(0);
+	test_first_frame(WINDOWS_SETUP_TIME_MS);
+	return get_test_result();
+}
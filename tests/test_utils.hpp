@@ -0,0 +1,33 @@
+#ifndef __TEST_UTILS_HPP
+#define __TEST_UTILS_HPP
+
+#include <iostream>
+#include <string>
+
+// Shared by the tests. The failed cases are counted, and
+// get_test_result prints the outcome and gives the exit code.
+
+inline int test_num_failed = 0;
+
+inline void check(bool condition, const std::string &description) {
+	if(condition)
+		return;
+	std::cout << "Failed: " << description << std::endl;
+	test_num_failed++;
+}
+
+// For the cases which print their own, more detailed, message
+inline void count_test_failure() {
+	test_num_failed++;
+}
+
+inline int get_test_result() {
+	if(test_num_failed > 0) {
+		std::cout << test_num_failed << " cases failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All cases passed" << std::endl;
+	return 0;
+}
+
+#endif
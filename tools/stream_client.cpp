@@ -0,0 +1,212 @@
+// Minimal client for the --stream_server output.
+// Prints what it receives. If given an output file, it also saves the stream
+// there, which can then be opened with --playback.
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+#define FILE_MAGIC "CC3DSREC"
+#define FILE_MAGIC_SIZE 8
+#define FILE_HEADER_SIZE 16
+#define RECORD_HEADER_SIZE 32
+#define MAX_PAYLOAD_SIZE (64 * 1024 * 1024)
+#define DEVICE_INFO_SIZE 128
+#define DEVICE_INFO_NAME_SIZE 64
+
+enum RecordType { RECORD_DEVICE_INFO, RECORD_VIDEO, RECORD_AUDIO };
+
+#ifdef _WIN32
+typedef SOCKET client_socket;
+#define INVALID_CLIENT_SOCKET INVALID_SOCKET
+#define close_socket closesocket
+#else
+typedef int client_socket;
+#define INVALID_CLIENT_SOCKET (-1)
+#define close_socket close
+#endif
+
+static uint64_t read_le(const uint8_t* data, int size) {
+	uint64_t value = 0;
+	for(int i = size - 1; i >= 0; i--)
+		value = (value << 8) | data[i];
+	return value;
+}
+
+static bool is_port_number(string address) {
+	if((address.size() == 0) || (address.size() > 5))
+		return false;
+	for(size_t i = 0; i < address.size(); i++)
+		if((address[i] < '0') || (address[i] > '9'))
+			return false;
+	return true;
+}
+
+static client_socket connect_to_server(string address) {
+	client_socket sock = INVALID_CLIENT_SOCKET;
+	if(is_port_number(address)) {
+		sock = socket(AF_INET, SOCK_STREAM, 0);
+		if(sock == INVALID_CLIENT_SOCKET)
+			return sock;
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)stoi(address));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+			close_socket(sock);
+			return INVALID_CLIENT_SOCKET;
+		}
+		return sock;
+	}
+	#ifdef _WIN32
+	return INVALID_CLIENT_SOCKET;
+	#else
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	if(address.size() >= sizeof(addr.sun_path))
+		return INVALID_CLIENT_SOCKET;
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, address.c_str(), sizeof(addr.sun_path) - 1);
+	sock = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(sock == INVALID_CLIENT_SOCKET)
+		return sock;
+	if(connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+		close_socket(sock);
+		return INVALID_CLIENT_SOCKET;
+	}
+	return sock;
+	#endif
+}
+
+static bool read_exact(client_socket sock, uint8_t* data, size_t size) {
+	size_t done = 0;
+	while(done < size) {
+		auto result = recv(sock, (char*)(data + done), (int)(size - done), 0);
+		if(result <= 0)
+			return false;
+		done += result;
+	}
+	return true;
+}
+
+int main(int argc, char *argv[]) {
+	if(argc < 2) {
+		cout << "Usage: " << argv[0] << " socket_path_or_port [output_file]" << endl;
+		return -1;
+	}
+
+	#ifdef _WIN32
+	WSADATA wsa_data;
+	if(WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+		cout << "Couldn't initialize sockets!" << endl;
+		return -2;
+	}
+	#endif
+
+	client_socket sock = connect_to_server(string(argv[1]));
+	if(sock == INVALID_CLIENT_SOCKET) {
+		cout << "Couldn't connect to " << argv[1] << "!" << endl;
+		return -2;
+	}
+
+	ofstream output;
+	if(argc >= 3) {
+		output.open(argv[2], ios::out | ios::binary);
+		if(!output) {
+			cout << "Couldn't open output file!" << endl;
+			close_socket(sock);
+			return -3;
+		}
+	}
+
+	uint8_t file_header[FILE_HEADER_SIZE];
+	if((!read_exact(sock, file_header, FILE_HEADER_SIZE)) || (memcmp(file_header, FILE_MAGIC, FILE_MAGIC_SIZE) != 0)) {
+		cout << "Not a cc3dsfs stream!" << endl;
+		close_socket(sock);
+		return -4;
+	}
+	if(output)
+		output.write((const char*)file_header, FILE_HEADER_SIZE);
+
+	vector<uint8_t> payload;
+	uint8_t record_header[RECORD_HEADER_SIZE];
+	uint64_t num_frames = 0;
+	uint64_t num_samples = 0;
+	uint64_t last_video_index = 0;
+	uint64_t num_skipped = 0;
+	uint16_t video_format = 0;
+	bool has_video_index = false;
+	auto last_print = chrono::steady_clock::now();
+	while(read_exact(sock, record_header, RECORD_HEADER_SIZE)) {
+		uint32_t type = (uint32_t)read_le(record_header, 4);
+		uint16_t format = (uint16_t)read_le(record_header + 6, 2);
+		uint32_t payload_size = (uint32_t)read_le(record_header + 8, 4);
+		uint64_t index = read_le(record_header + 24, 8);
+		if(payload_size > MAX_PAYLOAD_SIZE) {
+			cout << "Invalid record!" << endl;
+			break;
+		}
+		payload.resize(payload_size);
+		if(!read_exact(sock, payload.data(), payload_size))
+			break;
+		if(output) {
+			output.write((const char*)record_header, RECORD_HEADER_SIZE);
+			output.write((const char*)payload.data(), payload_size);
+		}
+		switch(type) {
+			case RECORD_DEVICE_INFO:
+				if(payload_size >= DEVICE_INFO_SIZE) {
+					const char* name = (const char*)(payload.data() + DEVICE_INFO_SIZE - DEVICE_INFO_NAME_SIZE);
+					cout << "Device: " << string(name, strnlen(name, DEVICE_INFO_NAME_SIZE)) << endl;
+				}
+				break;
+			case RECORD_VIDEO:
+				if(has_video_index && (index > (last_video_index + 1)))
+					num_skipped += index - (last_video_index + 1);
+				last_video_index = index;
+				has_video_index = true;
+				video_format = format;
+				num_frames++;
+				break;
+			case RECORD_AUDIO:
+				num_samples += payload_size / 2;
+				break;
+			default:
+				break;
+		}
+		auto curr_time = chrono::steady_clock::now();
+		double elapsed = chrono::duration<double>(curr_time - last_print).count();
+		if(elapsed >= 1.0) {
+			cout << "Video: " << (num_frames / elapsed) << " FPS (format " << video_format << "), Audio: " << (num_samples / elapsed) << " samples/s, Frames skipped: " << num_skipped << endl;
+			num_frames = 0;
+			num_samples = 0;
+			last_print = curr_time;
+		}
+	}
+
+	cout << "Stream closed." << endl;
+	close_socket(sock);
+	if(output)
+		output.close();
+	#ifdef _WIN32
+	WSACleanup();
+	#endif
+	return 0;
+}